@@ -0,0 +1,296 @@
+#pragma once
+
+#include <box2d/box2d.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// Temporary welds between touching bodies, driven by contact events. A begin
+// touch event queues a candidate, and Update welds at most budget of them per
+// step at the contact point, once the pair has slowed to a landing. A weld goes again when its contact ends, when it
+// is pulled harder than its thresholds (a joint event), or when either body
+// does (its end events). So the cost follows new and ending contacts, never
+// the pairs already resting on each other. Slots and their lookups are
+// allocated up front. Box2D has no unattached joints, though, so the joints
+// themselves are still created and destroyed per adhesion.
+class AdhesionPool
+{
+public:
+    static constexpr int kMaxPerBody = 3;
+    // Queued candidates still too fast, or without a slot, after this many
+    // steps are dropped.
+    static constexpr int kMaxPendingSteps = 30;
+
+    struct Tuning
+    {
+        float linearHertz = 6.0f;
+        float angularHertz = 4.0f;
+        float dampingRatio = 0.8f;
+        // Break thresholds per kg of the pair's reduced mass; the torque one
+        // is also scaled by the smaller body's radius of gyration.
+        float forcePerKg = 60.0f;
+        float torquePerKg = 40.0f;
+        // The pair is welded once it has settled: moving apart slower than
+        // settleSpeed (m/s) and overlapping less than settleOverlap (m). A
+        // weld made mid-bounce would hold the pair deeper than the contact
+        // lets it rest, and the two would fight until the weld broke.
+        float settleSpeed = 0.3f;
+        float settleOverlap = 0.01f;
+    };
+
+    struct Link
+    {
+        b2JointId jointId = b2_nullJointId;
+        // The contact that made it.
+        uint64_t shapeA = 0;
+        uint64_t shapeB = 0;
+        uint64_t bodyA = 0;
+        uint64_t bodyB = 0;
+    };
+
+    void Init(size_t capacity, size_t maxPending)
+    {
+        m_links.assign(capacity, Link{});
+        m_free.clear();
+        m_active.clear();
+        m_pending.clear();
+        m_free.reserve(capacity);
+        m_active.reserve(capacity);
+        m_pending.reserve(maxPending);
+        for (size_t i = capacity; i-- > 0;) m_free.push_back(static_cast<uint32_t>(i));
+        m_byShapes.clear();
+        m_byShapes.reserve(capacity);
+        m_perBody.clear();
+        m_perBody.reserve(capacity * 2);
+        m_maxPending = maxPending;
+    }
+
+    // Destroys the joints still alive; the bodies are left alone.
+    void Clear()
+    {
+        while (!m_active.empty()) Release(m_active.back());
+        m_pending.clear();
+    }
+
+    void SetTuning(const Tuning& tuning) { m_tuning = tuning; }
+
+    // A begin touch event between two shapes whose bodies may stick.
+    bool Queue(b2ShapeId a, b2ShapeId b, b2ContactId contact)
+    {
+        if (m_pending.size() >= m_maxPending) return false;
+        m_pending.push_back({a, b, contact, 0});
+        return true;
+    }
+
+    // An end touch event; the shapes may be gone.
+    void Separate(b2ShapeId a, b2ShapeId b)
+    {
+        if (m_active.empty()) return;
+        auto it = m_byShapes.find(PairKey(a, b));
+        if (it == m_byShapes.end()) return;
+        const Link& link = m_links[it->second];
+        uint64_t ka = b2StoreShapeId(a);
+        uint64_t kb = b2StoreShapeId(b);
+        if ((link.shapeA == ka && link.shapeB == kb) || (link.shapeA == kb && link.shapeB == ka)) Release(it->second);
+    }
+
+    // A joint event; ignores joints that are not adhesions. The user data
+    // comes from the event since the joint may already be gone.
+    void Overloaded(const b2JointEvent& event)
+    {
+        b2JointId joint = event.jointId;
+        auto slot = static_cast<uint32_t>(reinterpret_cast<uintptr_t>(event.userData));
+        if (slot == 0 || slot > m_links.size()) return;
+        Link& link = m_links[slot - 1];
+        if (B2_ID_EQUALS(link.jointId, joint)) Release(slot - 1);
+    }
+
+    // Drops every adhesion of a body, e.g. once it is no longer sticky.
+    void ReleaseBody(uint64_t body)
+    {
+        if (m_perBody.find(body) == m_perBody.end()) return;
+        for (size_t i = m_active.size(); i-- > 0;)
+        {
+            const Link& link = m_links[m_active[i]];
+            if (link.bodyA == body || link.bodyB == body) Release(m_active[i]);
+        }
+    }
+
+    // Welds up to budget queued candidates, oldest first.
+    void Update(b2WorldId worldId, int budget)
+    {
+        size_t kept = 0;
+        for (size_t i = 0; i < m_pending.size(); ++i)
+        {
+            Pending& p = m_pending[i];
+            Outcome outcome = Outcome::Later;
+            if (budget > 0 && !m_free.empty()) outcome = Create(worldId, p);
+            if (outcome == Outcome::Linked) --budget;
+            if (outcome == Outcome::Later && ++p.waited <= kMaxPendingSteps) m_pending[kept++] = p;
+        }
+        m_pending.resize(kept);
+    }
+
+    size_t ActiveCount() const { return m_active.size(); }
+    size_t PendingCount() const { return m_pending.size(); }
+
+    template <typename Fn>
+    void ForEachActive(Fn&& fn) const
+    {
+        for (uint32_t i : m_active) fn(m_links[i]);
+    }
+
+private:
+    struct Pending
+    {
+        b2ShapeId shapeA;
+        b2ShapeId shapeB;
+        b2ContactId contact;
+        int waited;
+    };
+
+    // Bodies this one is welded to.
+    struct Partners
+    {
+        uint64_t bodies[kMaxPerBody];
+        int count = 0;
+    };
+
+    // Both shapes are in one world, so their indices identify the pair;
+    // Separate still checks the generations.
+    static uint64_t PairKey(b2ShapeId a, b2ShapeId b)
+    {
+        auto ia = static_cast<uint32_t>(a.index1);
+        auto ib = static_cast<uint32_t>(b.index1);
+        if (ia > ib) std::swap(ia, ib);
+        return (uint64_t{ia} << 32) | ib;
+    }
+
+    const Partners* PartnersOf(uint64_t body) const
+    {
+        auto it = m_perBody.find(body);
+        return it == m_perBody.end() ? nullptr : &it->second;
+    }
+
+    // False when either body is full or the two are already welded.
+    bool CanLink(uint64_t a, uint64_t b) const
+    {
+        const Partners* pb = PartnersOf(b);
+        if (pb && pb->count >= kMaxPerBody) return false;
+        const Partners* pa = PartnersOf(a);
+        if (!pa) return true;
+        if (pa->count >= kMaxPerBody) return false;
+        return std::find(pa->bodies, pa->bodies + pa->count, b) == pa->bodies + pa->count;
+    }
+
+    void Unlink(uint64_t body, uint64_t other)
+    {
+        auto it = m_perBody.find(body);
+        if (it == m_perBody.end()) return;
+        Partners& p = it->second;
+        uint64_t* end = p.bodies + p.count;
+        uint64_t* at = std::find(p.bodies, end, other);
+        if (at == end) return;
+        *at = end[-1];
+        if (--p.count == 0) m_perBody.erase(it);
+    }
+
+    enum class Outcome
+    {
+        Linked,
+        Dropped,
+        Later, // still moving too fast, or no budget left
+    };
+
+    Outcome Create(b2WorldId worldId, const Pending& p)
+    {
+        if (!b2Shape_IsValid(p.shapeA) || !b2Shape_IsValid(p.shapeB)) return Outcome::Dropped;
+        b2BodyId a = b2Shape_GetBody(p.shapeA);
+        b2BodyId b = b2Shape_GetBody(p.shapeB);
+        if (b2Body_GetType(a) != b2_dynamicBody || b2Body_GetType(b) != b2_dynamicBody) return Outcome::Dropped;
+        uint64_t keyA = b2StoreBodyId(a);
+        uint64_t keyB = b2StoreBodyId(b);
+        uint64_t shapes = PairKey(p.shapeA, p.shapeB);
+        if (keyA == keyB || m_byShapes.count(shapes) || !CanLink(keyA, keyB)) return Outcome::Dropped;
+
+        // A contact that stopped touching since has sent its end event.
+        if (!b2Contact_IsValid(p.contact)) return Outcome::Dropped;
+        b2ContactData data = b2Contact_GetData(p.contact);
+        if (data.manifold.pointCount == 0) return Outcome::Dropped;
+
+        b2Vec2 dv = b2Sub(b2Body_GetLinearVelocity(b), b2Body_GetLinearVelocity(a));
+        if (b2LengthSquared(dv) > m_tuning.settleSpeed * m_tuning.settleSpeed) return Outcome::Later;
+
+        b2Vec2 anchor = b2Vec2_zero;
+        for (int i = 0; i < data.manifold.pointCount; ++i)
+        {
+            const b2ManifoldPoint& mp = data.manifold.points[i];
+            if (mp.separation < -m_tuning.settleOverlap) return Outcome::Later;
+            anchor = b2Add(anchor, mp.point);
+        }
+        anchor = b2MulSV(1.0f / static_cast<float>(data.manifold.pointCount), anchor);
+
+        float massA = b2Body_GetMass(a);
+        float massB = b2Body_GetMass(b);
+        if (massA <= 0.0f || massB <= 0.0f) return Outcome::Dropped;
+        float reduced = massA * massB / (massA + massB);
+        const bool smallerA = massA < massB;
+        float gyration = std::sqrt(b2Body_GetRotationalInertia(smallerA ? a : b) / (smallerA ? massA : massB));
+
+        uint32_t slot = m_free.back();
+        b2Transform frame{anchor, b2Rot_identity};
+        b2WeldJointDef def = b2DefaultWeldJointDef();
+        def.base.bodyIdA = a;
+        def.base.bodyIdB = b;
+        def.base.localFrameA = b2InvMulTransforms(b2Body_GetTransform(a), frame);
+        def.base.localFrameB = b2InvMulTransforms(b2Body_GetTransform(b), frame);
+        // The contact stays, so the pair still rests on it and its end event
+        // still comes when they come apart.
+        def.base.collideConnected = true;
+        def.base.forceThreshold = m_tuning.forcePerKg * reduced;
+        def.base.torqueThreshold = m_tuning.torquePerKg * reduced * gyration;
+        def.base.userData = reinterpret_cast<void*>(static_cast<uintptr_t>(slot) + 1);
+        def.linearHertz = m_tuning.linearHertz;
+        def.angularHertz = m_tuning.angularHertz;
+        def.linearDampingRatio = m_tuning.dampingRatio;
+        def.angularDampingRatio = m_tuning.dampingRatio;
+        b2JointId joint = b2CreateWeldJoint(worldId, &def);
+        if (!b2Joint_IsValid(joint)) return Outcome::Dropped;
+
+        m_free.pop_back();
+        m_links[slot] = {joint, b2StoreShapeId(p.shapeA), b2StoreShapeId(p.shapeB), keyA, keyB};
+        m_active.push_back(slot);
+        m_byShapes.emplace(shapes, slot);
+        Partners& pa = m_perBody[keyA];
+        pa.bodies[pa.count++] = keyB;
+        Partners& pb = m_perBody[keyB];
+        pb.bodies[pb.count++] = keyA;
+        return Outcome::Linked;
+    }
+
+    void Release(uint32_t slot)
+    {
+        Link& link = m_links[slot];
+        // Destroying either body already took the joint.
+        if (b2Joint_IsValid(link.jointId)) b2DestroyJoint(link.jointId, true);
+        m_byShapes.erase(PairKey(b2LoadShapeId(link.shapeA), b2LoadShapeId(link.shapeB)));
+        Unlink(link.bodyA, link.bodyB);
+        Unlink(link.bodyB, link.bodyA);
+        link = Link{};
+        m_active.erase(std::find(m_active.begin(), m_active.end(), slot));
+        m_free.push_back(slot);
+    }
+
+    Tuning m_tuning;
+    std::vector<Link> m_links;
+    std::vector<uint32_t> m_free;
+    std::vector<uint32_t> m_active; // oldest first
+    std::vector<Pending> m_pending;
+    std::unordered_map<uint64_t, uint32_t> m_byShapes;
+    std::unordered_map<uint64_t, Partners> m_perBody;
+    size_t m_maxPending = 0;
+};
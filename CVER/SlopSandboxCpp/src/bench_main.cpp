@@ -0,0 +1,498 @@
+// SlopSandboxBench: headless stress scenes for catching performance regressions.
+// Builds each scene from a fixed seed, steps it for a fixed number of frames
+// and prints mean/p99 frame time, throughput and peak RSS. --script runs a
+// scenario (scenario.h) instead and fails when one of its asserts does.
+
+#include "slop_sandbox.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#if !defined(_WIN32)
+#include <sys/resource.h>
+#endif
+
+SLOP_DEFINE_HEAP_ALLOC_COUNTER()
+
+namespace
+{
+
+struct BenchOptions
+{
+    int frames = 600;
+    int workers = 0;
+    unsigned seed = 1234;
+    int subSteps = 4; // pinned so runs are comparable; 0 = adaptive
+    const char* scene = nullptr;
+    const char* sceneFile = nullptr;
+    const char* replayFile = nullptr;
+    const char* recordFile = nullptr;
+    const char* traceFile = nullptr;
+    const char* simd = nullptr;
+    const char* scriptFile = nullptr;
+    bool framesGiven = false;
+    bool stateHash = false;
+    bool hibernate = false;
+};
+
+struct SceneSpec
+{
+    const char* name;
+    void (*build)(SlopSandbox&);
+};
+
+// windows.h clashes with raylib names, so RSS is only reported on POSIX.
+double PeakRssMb()
+{
+#if defined(_WIN32)
+    return 0.0;
+#else
+    rusage ru{};
+    if (getrusage(RUSAGE_SELF, &ru) != 0) return 0.0;
+#if defined(__APPLE__)
+    return static_cast<double>(ru.ru_maxrss) / (1024.0 * 1024.0);
+#else
+    return static_cast<double>(ru.ru_maxrss) / 1024.0;
+#endif
+#endif
+}
+
+// Pyramid of small boxes on land, as tall as fits above the ground.
+void BuildPyramid(SlopSandbox& app)
+{
+    const float size = 24.0f;
+    const float half = size * 0.5f;
+    std::vector<Vector2> box = {{-half, -half}, {half, -half}, {half, half}, {-half, half}};
+    float top = app.GroundTopPx();
+    int rows = std::min(40, static_cast<int>((top - 16.0f) / size));
+    float cx = app.Width() * 0.5f;
+    for (int r = 0; r < rows; ++r)
+    {
+        int count = rows - r;
+        float y = top - half - 4.0f - r * size;
+        float x0 = cx - (count - 1) * size * 0.5f;
+        for (int i = 0; i < count; ++i)
+        {
+            app.ScriptSpawnPolygon({x0 + i * size, y}, box);
+        }
+    }
+}
+
+// Columns of welded glass boxes with a ball dropped on each.
+void BuildGlassStacks(SlopSandbox& app)
+{
+    const int columns = 12;
+    const int height = 9;
+    float top = app.GroundTopPx();
+    float spacing = app.Width() / static_cast<float>(columns + 1);
+    for (int c = 0; c < columns; ++c)
+    {
+        float x = spacing * (c + 1);
+        size_t below = 0;
+        for (int h = 0; h < height; ++h)
+        {
+            float y = top - kBaseHalfPx - 4.0f - h * kBaseSizePx;
+            size_t idx = app.ScriptSpawnBox({x, y});
+            app.ScriptSetGlass(idx, true);
+            if (h > 0) app.ScriptWeld(below, idx, {x, y + kBaseHalfPx});
+            below = idx;
+        }
+        size_t ball = app.ScriptSpawnCircle({x + 6.0f, kBaseSizePx});
+        b2Body_SetLinearVelocity(app.BodyIdAt(ball), {0.0f, 12.0f});
+    }
+}
+
+// Columns of plain boxes welded with breakable welds, a ball thrown at each;
+// the welds snap near the impact and the columns fall apart.
+void BuildWeldTowers(SlopSandbox& app)
+{
+    const int columns = 12;
+    const int height = 10;
+    const float breakForce = 1500.0f;
+    app.SetJointBreakLimits(breakForce, breakForce * kBaseHalfPx * kInvPixelsPerMeter);
+    float top = app.GroundTopPx();
+    float spacing = app.Width() / static_cast<float>(columns + 1);
+    for (int c = 0; c < columns; ++c)
+    {
+        float x = spacing * (c + 1);
+        size_t below = 0;
+        for (int h = 0; h < height; ++h)
+        {
+            float y = top - kBaseHalfPx - 4.0f - h * kBaseSizePx;
+            size_t idx = app.ScriptSpawnBox({x, y});
+            if (h > 0) app.ScriptWeld(below, idx, {x, y + kBaseHalfPx});
+            below = idx;
+        }
+        size_t ball = app.ScriptSpawnCircle({x - 3.0f * kBaseSizePx, top - height * kBaseHalfPx});
+        b2Body_SetLinearVelocity(app.BodyIdAt(ball), {18.0f, -2.0f});
+    }
+}
+
+// Two-wheel carts driving toward each other in two lanes.
+void BuildVehicles(SlopSandbox& app)
+{
+    const int perLane = 8;
+    const float chassisHalfW = 70.0f;
+    const float chassisHalfH = 12.0f;
+    std::vector<Vector2> chassis = {
+        {-chassisHalfW, -chassisHalfH}, {chassisHalfW, -chassisHalfH}, {chassisHalfW, chassisHalfH}, {-chassisHalfW, chassisHalfH}};
+
+    float top = app.GroundTopPx();
+    float spacing = app.Width() / static_cast<float>(perLane + 1);
+    for (int lane = 0; lane < 2; ++lane)
+    {
+        float wheelY = top - kBaseHalfPx - 4.0f - lane * 260.0f;
+        float dir = lane == 0 ? 1.0f : -1.0f;
+        for (int i = 0; i < perLane; ++i)
+        {
+            float x = spacing * (i + 1);
+            auto body = app.ScriptSpawnPolygon({x, wheelY - kBaseHalfPx - chassisHalfH - 2.0f}, chassis);
+            if (!body) continue;
+            for (float side : {-1.0f, 1.0f})
+            {
+                size_t wheel = app.ScriptSpawnCircle({x + side * (chassisHalfW - kBaseHalfPx), wheelY});
+                app.ScriptAttachWheel(*body, wheel);
+                b2Body_SetAngularVelocity(app.BodyIdAt(wheel), 8.0f * dir);
+            }
+            b2Body_SetLinearVelocity(app.BodyIdAt(*body), {3.0f * dir, 0.0f});
+        }
+    }
+}
+
+// 1k+ small boxes and balls dropped onto the water.
+void BuildWaterBodies(SlopSandbox& app, SceneLocation location)
+{
+    app.SetSceneLocation(location);
+    const float step = 26.0f;
+    const float half = 10.0f;
+    std::vector<Vector2> square = {{-half, -half}, {half, -half}, {half, half}, {-half, half}};
+    std::vector<Vector2> ball;
+    for (int i = 0; i < B2_MAX_POLYGON_VERTICES; ++i)
+    {
+        float a = 2.0f * PI * static_cast<float>(i) / static_cast<float>(B2_MAX_POLYGON_VERTICES);
+        ball.push_back({std::cos(a) * half, std::sin(a) * half});
+    }
+
+    int n = 0;
+    for (float y = app.WaterBaselinePx() - 30.0f; y > 30.0f; y -= step)
+    {
+        for (float x = step; x < app.Width() - step; x += step)
+        {
+            app.ScriptSpawnPolygon({x + static_cast<float>(GetRandomValue(-3, 3)), y}, (n++ % 3 == 0) ? ball : square);
+        }
+    }
+}
+
+// Small pyramids along a world ten windows wide, for --hibernate: once they
+// settle, all but the ones near the first window can leave the world.
+void BuildWidePiles(SlopSandbox& app)
+{
+    app.SetWorldWidth(10.0f * static_cast<float>(app.Width()));
+    const float size = 24.0f;
+    const float half = size * 0.5f;
+    const int rows = 12;
+    std::vector<Vector2> box = {{-half, -half}, {half, -half}, {half, half}, {-half, half}};
+    float top = app.GroundTopPx();
+    for (float cx = 400.0f; cx < app.WorldWidth() - 400.0f; cx += 600.0f)
+    {
+        for (int r = 0; r < rows; ++r)
+        {
+            int count = rows - r;
+            float y = top - half - 4.0f - r * size;
+            float x0 = cx - (count - 1) * size * 0.5f;
+            for (int i = 0; i < count; ++i) app.ScriptSpawnPolygon({x0 + i * size, y}, box);
+        }
+    }
+}
+
+void BuildWater(SlopSandbox& app) { BuildWaterBodies(app, SceneLocation::Water); }
+void BuildShallow(SlopSandbox& app) { BuildWaterBodies(app, SceneLocation::Shallow); }
+
+// Scene saved from the sandbox with F5 (or SlopSandbox::SaveScene).
+const char* g_sceneFile = nullptr;
+
+void BuildFromFile(SlopSandbox& app)
+{
+    if (!app.LoadScene(g_sceneFile)) std::fprintf(stderr, "failed to load scene file %s\n", g_sceneFile);
+}
+
+const SceneSpec kScenes[] = {
+    {"pyramid", &BuildPyramid},
+    {"glass_stacks", &BuildGlassStacks},
+    {"weld_towers", &BuildWeldTowers},
+    {"vehicles", &BuildVehicles},
+    {"water_1k", &BuildWater},
+    {"shallow_1k", &BuildShallow},
+    {"wide_piles", &BuildWidePiles},
+};
+
+void PrintStats(const char* name, const SlopSandbox& app, size_t bodies, const std::vector<double>& frameMs, double totalS)
+{
+    double sum = 0.0;
+    for (double ms : frameMs) sum += ms;
+    std::vector<double> sorted = frameMs;
+    std::sort(sorted.begin(), sorted.end());
+    size_t p99 = sorted.empty() ? 0 : static_cast<size_t>(std::ceil(0.99 * static_cast<double>(sorted.size()))) - 1;
+
+    double mean = frameMs.empty() ? 0.0 : sum / static_cast<double>(frameMs.size());
+    double stepsPerS = totalS > 0.0 ? static_cast<double>(frameMs.size()) / totalS : 0.0;
+    b2Counters counters = b2World_GetCounters(app.WorldId());
+    std::printf("%-14s %7zu %7d %8.3f %8.3f %8.3f %9.1f %12.0f %9.1f %9.1f\n", name, bodies, counters.jointCount, mean,
+                sorted.empty() ? 0.0 : sorted[p99], sorted.empty() ? 0.0 : sorted.back(), stepsPerS,
+                stepsPerS * static_cast<double>(bodies), PeakRssMb(), box2d_heap::Heap::Instance().Total().peakBytes / 1048576.0);
+    std::fflush(stdout);
+}
+
+// A scenario script in an empty world runs until it ends unless --frames is
+// given: at most ten simulated minutes.
+constexpr int kScriptMaxFrames = 33000;
+
+void BuildEmpty(SlopSandbox&) {}
+
+// False when a scenario assert failed.
+bool RunScene(const SceneSpec& scene, const BenchOptions& opt)
+{
+    using Clock = std::chrono::steady_clock;
+
+    SetRandomSeed(opt.seed);
+    SlopSandbox app(1536, 960, opt.workers);
+    app.SetFixedSubSteps(opt.subSteps);
+    app.SetStateHashing(opt.stateHash);
+    scene.build(app);
+    if (opt.scriptFile && !app.StartScenario(opt.scriptFile))
+    {
+        std::fprintf(stderr, "%s: %s\n", opt.scriptFile, app.Scenario().Error().c_str());
+        return false;
+    }
+    size_t bodies = app.BodyCount();
+    if (opt.hibernate)
+    {
+        // As if the camera stayed on the first window.
+        app.ScriptSetView({0.0f, 0.0f, static_cast<float>(app.Width()), static_cast<float>(app.Height())});
+        app.SetRegionHibernation(true);
+    }
+    if (opt.recordFile && !app.StartRecording(opt.recordFile, opt.seed)) std::fprintf(stderr, "failed to record to %s\n", opt.recordFile);
+
+    std::vector<double> frameMs;
+    frameMs.reserve(static_cast<size_t>(opt.frames));
+    const float dt = SlopSandbox::FixedDt();
+    auto start = Clock::now();
+    uint64_t steadyAllocs = 0;
+    for (int f = 0; f < opt.frames; ++f)
+    {
+        // The second half is steady state: warm-up growth is over.
+        if (f == opt.frames / 2) steadyAllocs = heap_stats::AllocCount();
+        auto t0 = Clock::now();
+        app.StepHeadless(dt);
+        frameMs.push_back(std::chrono::duration<double, std::milli>(Clock::now() - t0).count());
+        if (opt.scriptFile && app.Scenario().Finished()) break;
+    }
+    double totalS = std::chrono::duration<double>(Clock::now() - start).count();
+    steadyAllocs = heap_stats::AllocCount() - steadyAllocs;
+    app.StopRecording();
+    // Scripts start empty, so the count that matters is the end one.
+    PrintStats(scene.name, app, opt.scriptFile ? app.BodyCount() : bodies, frameMs, totalS);
+    if (opt.hibernate)
+    {
+        std::printf("  hibernated %zu bodies in %zu regions, %zu in the world\n", app.HibernatedBodyCount(), app.HibernatedRegionCount(),
+                    app.BodyCount());
+    }
+    if (app.JointBreakCount() > 0) std::printf("  joints broken %llu\n", static_cast<unsigned long long>(app.JointBreakCount()));
+    if (opt.stateHash)
+    {
+        std::printf("  state hash %016llx after %llu steps\n", static_cast<unsigned long long>(app.StateHash()),
+                    static_cast<unsigned long long>(app.HashedSteps()));
+    }
+    if (heap_stats::kEnabled)
+    {
+        int steadyFrames = opt.frames - opt.frames / 2;
+        std::printf("  heap allocs/step (steady) %.2f\n", static_cast<double>(steadyAllocs) / std::max(1, steadyFrames));
+    }
+    if (!opt.scriptFile) return true;
+
+    const scenario::Runner& script = app.Scenario();
+    for (const std::string& line : script.LogLines()) std::printf("  %s\n", line.c_str());
+    for (const scenario::Failure& f : script.Failures()) std::printf("  FAILED line %u: %s (was %g)\n", f.line, f.text.c_str(), f.actual);
+    if (!script.Finished()) std::printf("  script stopped after %d frames, before its end\n", static_cast<int>(frameMs.size()));
+    std::printf("  asserts passed %zu, failed %zu\n", script.AssertsPassed(), script.Failures().size());
+    return script.Failures().empty() && script.Finished();
+}
+
+// Replays a recording made with the sandbox's --record / F6 or with --record
+// here. Steps come from the stream, so --frames and --substeps do not apply.
+// A recording with state hashes is checked step by step against them, e.g.
+// under a different --workers; false if it diverged.
+bool RunReplay(const BenchOptions& opt)
+{
+    using Clock = std::chrono::steady_clock;
+
+    SlopSandbox app(1536, 960, opt.workers);
+    if (!app.BeginReplay(opt.replayFile))
+    {
+        std::fprintf(stderr, "failed to open replay %s\n", opt.replayFile);
+        return false;
+    }
+
+    std::vector<double> frameMs;
+    size_t peakBodies = app.BodyCount();
+    auto start = Clock::now();
+    for (;;)
+    {
+        auto t0 = Clock::now();
+        if (!app.ReplayNextFrame()) break;
+        frameMs.push_back(std::chrono::duration<double, std::milli>(Clock::now() - t0).count());
+        peakBodies = std::max(peakBodies, app.BodyCount());
+    }
+    double totalS = std::chrono::duration<double>(Clock::now() - start).count();
+    PrintStats("replay", app, peakBodies, frameMs, totalS);
+    if (app.ReplayDesyncs() > 0) std::printf("replay desynced on %d frames\n", app.ReplayDesyncs());
+    if (!app.StateHashing()) return true;
+    if (app.ReplayDivergentStep() >= 0)
+    {
+        std::printf("state hash diverged at step %lld of %llu\n", static_cast<long long>(app.ReplayDivergentStep()),
+                    static_cast<unsigned long long>(app.ReplayHashedSteps()));
+        return false;
+    }
+    std::printf("state hash matched over %llu steps\n", static_cast<unsigned long long>(app.ReplayHashedSteps()));
+    return true;
+}
+
+bool LoadStateHashes(const char* path, std::vector<uint64_t>& out)
+{
+    ReplayReader reader;
+    if (!reader.Open(path) || !(reader.Header().flags & kReplayFlagStateHash)) return false;
+    ReplayEvent ev;
+    while (reader.Next(ev))
+    {
+        if (ev.type == ReplayEventType::Hash) out.insert(out.end(), ev.hashes, ev.hashes + ev.hashCount);
+    }
+    return true;
+}
+
+// Compares the state hashes two recordings carry without simulating either.
+// 0 when identical, 1 when they diverge, 2 when one has no hashes.
+int RunHashDiff(const char* pathA, const char* pathB)
+{
+    std::vector<uint64_t> a;
+    std::vector<uint64_t> b;
+    for (auto [path, out] : {std::make_pair(pathA, &a), std::make_pair(pathB, &b)})
+    {
+        if (LoadStateHashes(path, *out)) continue;
+        std::fprintf(stderr, "%s is not a recording with state hashes (record with --state-hash)\n", path);
+        return 2;
+    }
+    size_t n = std::min(a.size(), b.size());
+    for (size_t i = 0; i < n; ++i)
+    {
+        if (a[i] == b[i]) continue;
+        std::printf("first divergent step %zu: %016llx vs %016llx\n", i, static_cast<unsigned long long>(a[i]),
+                    static_cast<unsigned long long>(b[i]));
+        return 1;
+    }
+    if (a.size() != b.size())
+    {
+        std::printf("identical for %zu steps, then only one recording goes on (%zu vs %zu steps)\n", n, a.size(), b.size());
+        return 1;
+    }
+    std::printf("identical over %zu steps\n", n);
+    return 0;
+}
+
+void PrintUsage()
+{
+    std::printf("usage: SlopSandboxBench [--frames N] [--workers N] [--seed N] [--scene NAME] [--substeps N|0=adaptive] [--scene-file PATH] [--replay PATH] [--simd sse2|avx2]\n"
+                "                        [--script PATH] [--state-hash] [--record PATH] [--hash-diff PATH PATH] [--trace PATH] [--hibernate]\nscenes:");
+    for (const SceneSpec& s : kScenes) std::printf(" %s", s.name);
+    std::printf("\n");
+}
+
+int RunBench(const BenchOptions& opt)
+{
+    if (opt.replayFile) return RunReplay(opt) ? 0 : 1;
+    if (opt.scriptFile)
+    {
+        BenchOptions scripted = opt;
+        if (!opt.framesGiven) scripted.frames = kScriptMaxFrames;
+        g_sceneFile = opt.sceneFile;
+        return RunScene({"script", opt.sceneFile ? &BuildFromFile : &BuildEmpty}, scripted) ? 0 : 1;
+    }
+    if (opt.sceneFile)
+    {
+        g_sceneFile = opt.sceneFile;
+        RunScene({"file", &BuildFromFile}, opt);
+        return 0;
+    }
+
+    bool ran = false;
+    for (const SceneSpec& s : kScenes)
+    {
+        if (opt.scene && std::strcmp(opt.scene, s.name) != 0) continue;
+        RunScene(s, opt);
+        ran = true;
+    }
+    if (!ran)
+    {
+        PrintUsage();
+        return 1;
+    }
+    return 0;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    BenchOptions opt;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--frames") == 0 && i + 1 < argc)
+        {
+            opt.frames = std::max(1, std::atoi(argv[++i]));
+            opt.framesGiven = true;
+        }
+        else if (std::strcmp(argv[i], "--workers") == 0 && i + 1 < argc) opt.workers = std::atoi(argv[++i]);
+        else if (std::strcmp(argv[i], "--seed") == 0 && i + 1 < argc) opt.seed = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+        else if (std::strcmp(argv[i], "--scene") == 0 && i + 1 < argc) opt.scene = argv[++i];
+        else if (std::strcmp(argv[i], "--scene-file") == 0 && i + 1 < argc) opt.sceneFile = argv[++i];
+        else if (std::strcmp(argv[i], "--replay") == 0 && i + 1 < argc) opt.replayFile = argv[++i];
+        else if (std::strcmp(argv[i], "--script") == 0 && i + 1 < argc) opt.scriptFile = argv[++i];
+        else if (std::strcmp(argv[i], "--substeps") == 0 && i + 1 < argc) opt.subSteps = std::max(0, std::atoi(argv[++i]));
+        else if (std::strcmp(argv[i], "--simd") == 0 && i + 1 < argc) opt.simd = argv[++i];
+        else if (std::strcmp(argv[i], "--state-hash") == 0) opt.stateHash = true;
+        else if (std::strcmp(argv[i], "--record") == 0 && i + 1 < argc) opt.recordFile = argv[++i];
+        else if (std::strcmp(argv[i], "--trace") == 0 && i + 1 < argc) opt.traceFile = argv[++i];
+        else if (std::strcmp(argv[i], "--hibernate") == 0) opt.hibernate = true;
+        else if (std::strcmp(argv[i], "--hash-diff") == 0 && i + 2 < argc)
+        {
+            const char* a = argv[++i];
+            return RunHashDiff(a, argv[++i]);
+        }
+        else
+        {
+            PrintUsage();
+            return 1;
+        }
+    }
+
+    if (opt.simd)
+    {
+        // Anything but avx2 (or avx2 on a CPU without it) gets the compiled-in baseline.
+        b2SetSimdLevel(std::strcmp(opt.simd, "avx2") == 0 ? b2_simdAVX2 : b2_simdSSE2);
+    }
+
+    SetTraceLogLevel(LOG_WARNING);
+    std::printf("frames %d, substeps %s, workers %d, seed %u, solver %s\n", opt.frames, opt.subSteps > 0 ? std::to_string(opt.subSteps).c_str() : "adaptive", opt.workers > 0 ? std::min(opt.workers, TaskScheduler::kMaxWorkers) : TaskScheduler::DefaultWorkerCount(), opt.seed, SimdLevelName(b2GetSimdLevel()));
+    std::printf("%-14s %7s %7s %8s %8s %8s %9s %12s %9s %9s\n", "scene", "bodies", "joints", "mean_ms", "p99_ms", "max_ms",
+                "steps/s", "body-steps/s", "rss_mb", "b2peak_mb");
+
+    // Every world, and with it its job workers, is gone when RunBench
+    // returns, so their zones are in the file before it is closed.
+    if (opt.traceFile && !trace::kBackend) std::fprintf(stderr, "--trace: this build has no trace zones (configure with -DSLOP_TRACE=CHROME)\n");
+    else if (opt.traceFile && !trace::Open(opt.traceFile)) std::fprintf(stderr, "cannot write trace %s\n", opt.traceFile);
+    SLOP_TRACE_THREAD("bench");
+    int result = RunBench(opt);
+    trace::Close();
+    return result;
+}
@@ -0,0 +1,184 @@
+#pragma once
+
+#include <raylib.h>
+#include <rlgl.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+// Level-of-detail thresholds for bodies, in on-screen px of the body's size
+// (diameter, or twice its bounding radius). Below pointPx a body is a square
+// dot merged with any other in the same pointPx cell, below boxPx its bounding
+// box, below outlinePx a fill without outline, and below detailPx it loses the
+// selection halo and wheel hub. Circles get a segment per circleSegmentPx of
+// on-screen circumference. Scaled() trades fidelity for frame rate; 0 keeps
+// full detail everywhere.
+struct BodyLod
+{
+    float pointPx = 2.0f;
+    float boxPx = 5.0f;
+    float outlinePx = 9.0f;
+    float detailPx = 16.0f;
+    float circleSegmentPx = 4.0f;
+
+    BodyLod Scaled(float f) const
+    {
+        f = std::max(0.0f, f);
+        return {pointPx * f, boxPx * f, outlinePx * f, detailPx * f, circleSegmentPx * f};
+    }
+};
+
+// CPU-side triangle list for body fills and outlines. Shapes are appended in
+// draw order during the frame and submitted to the rlgl batch in one pass by
+// Flush, so the whole body layer costs a handful of draw calls instead of one
+// DrawTriangle/DrawLineEx per primitive.
+class BodyBatch
+{
+public:
+    static constexpr int kCircleSegments = 36;
+
+    // Stride into the 36-segment circle so the segments are at least
+    // segmentPx long for a circle of screenRadius px; always a divisor of 36.
+    static int CircleStep(float screenRadius, float segmentPx)
+    {
+        if (segmentPx <= 0.0f) return 1;
+        float wanted = 2.0f * PI * screenRadius / segmentPx;
+        for (int step : {6, 4, 3, 2})
+        {
+            if (static_cast<float>(kCircleSegments / step) >= wanted) return step;
+        }
+        return 1;
+    }
+
+    BodyBatch()
+    {
+        for (int i = 0; i <= kCircleSegments; ++i)
+        {
+            float a = 2.0f * PI * static_cast<float>(i) / static_cast<float>(kCircleSegments);
+            m_unitCircle[static_cast<size_t>(i)] = {std::cos(a), std::sin(a)};
+        }
+    }
+
+    void Clear() { m_verts.clear(); }
+    size_t VertexCount() const { return m_verts.size(); }
+
+    // rlgl culls back faces; triangles are flipped to raylib's expected winding.
+    void AddTriangle(Vector2 a, Vector2 b, Vector2 c, Color color)
+    {
+        float cross = (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+        if (cross > 0.0f) std::swap(b, c);
+        m_verts.push_back({a.x, a.y, color});
+        m_verts.push_back({b.x, b.y, color});
+        m_verts.push_back({c.x, c.y, color});
+    }
+
+    void AddConvexFill(const Vector2* pts, size_t n, Color color)
+    {
+        for (size_t i = 1; i + 1 < n; ++i)
+        {
+            AddTriangle(pts[0], pts[i], pts[i + 1], color);
+        }
+    }
+
+    // Same geometry as DrawLineEx: a quad per segment, no joins.
+    void AddLine(Vector2 a, Vector2 b, float thick, Color color)
+    {
+        float dx = b.x - a.x;
+        float dy = b.y - a.y;
+        float len = std::sqrt(dx * dx + dy * dy);
+        if (len <= 0.0f) return;
+        float s = 0.5f * thick / len;
+        Vector2 off{-dy * s, dx * s};
+        Vector2 a0{a.x + off.x, a.y + off.y};
+        Vector2 a1{a.x - off.x, a.y - off.y};
+        Vector2 b0{b.x + off.x, b.y + off.y};
+        Vector2 b1{b.x - off.x, b.y - off.y};
+        AddTriangle(a0, a1, b1, color);
+        AddTriangle(a0, b1, b0, color);
+    }
+
+    void AddClosedOutline(const Vector2* pts, size_t n, float thick, Color color)
+    {
+        for (size_t i = 0; i < n; ++i)
+        {
+            AddLine(pts[i], pts[(i + 1) % n], thick, color);
+        }
+    }
+
+    // Axis-aligned rectangle; the dot and bounding-box levels of detail.
+    void AddRect(float x0, float y0, float x1, float y1, Color color)
+    {
+        AddTriangle({x0, y0}, {x0, y1}, {x1, y1}, color);
+        AddTriangle({x0, y0}, {x1, y1}, {x1, y0}, color);
+    }
+
+    // step is from CircleStep; 1 is the full 36 segments.
+    void AddCircleFill(Vector2 c, float r, Color color, int step = 1)
+    {
+        for (int i = 0; i < kCircleSegments; i += step)
+        {
+            AddTriangle(c, CirclePoint(c, r, i), CirclePoint(c, r, i + step), color);
+        }
+    }
+
+    void AddCircleOutline(Vector2 c, float r, float thick, Color color, int step = 1)
+    {
+        float ri = r - 0.5f * thick;
+        float ro = r + 0.5f * thick;
+        for (int i = 0; i < kCircleSegments; i += step)
+        {
+            Vector2 i0 = CirclePoint(c, ri, i);
+            Vector2 i1 = CirclePoint(c, ri, i + step);
+            Vector2 o0 = CirclePoint(c, ro, i);
+            Vector2 o1 = CirclePoint(c, ro, i + step);
+            AddTriangle(i0, o0, o1, color);
+            AddTriangle(i0, o1, i1, color);
+        }
+    }
+
+    void Flush()
+    {
+        Submit();
+        m_verts.clear();
+    }
+
+    // Draws the list and keeps it, for layers rebuilt only when they change.
+    void Submit() const
+    {
+        if (m_verts.empty()) return;
+        rlSetTexture(0);
+        rlBegin(RL_TRIANGLES);
+        for (size_t i = 0; i + 2 < m_verts.size(); i += 3)
+        {
+            rlCheckRenderBatchLimit(3);
+            for (size_t k = i; k < i + 3; ++k)
+            {
+                const Vertex& v = m_verts[k];
+                rlColor4ub(v.color.r, v.color.g, v.color.b, v.color.a);
+                rlVertex2f(v.x, v.y);
+            }
+        }
+        rlEnd();
+    }
+
+private:
+    struct Vertex
+    {
+        float x;
+        float y;
+        Color color;
+    };
+
+    Vector2 CirclePoint(Vector2 c, float r, int i) const
+    {
+        const Vector2& u = m_unitCircle[static_cast<size_t>(i)];
+        return {c.x + u.x * r, c.y + u.y * r};
+    }
+
+    std::array<Vector2, kCircleSegments + 1> m_unitCircle{};
+    std::vector<Vertex> m_verts;
+};
@@ -0,0 +1,326 @@
+#pragma once
+
+#include <box2d/box2d.h>
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <mutex>
+
+// Process-wide heap behind b2SetAllocator. Blocks up to kMaxPooled bytes come
+// from per-size-class free lists carved out of 64 KiB chunks, so the spawn and
+// shatter bursts that grow and shrink Box2D's arrays reuse the same memory
+// instead of fragmenting malloc; larger blocks pass through to the aligned
+// system heap. Chunks are kept for the life of the process.
+//
+// Every block carries a 32-byte header naming the subsystem that was current
+// when it was allocated, so live and peak bytes split by who asked. The
+// current subsystem is one process-wide value set with Scope by the thread
+// driving the world; Box2D's workers allocate under whatever it set.
+// Creating and destroying worlds goes through CreateWorld and DestroyWorld.
+namespace box2d_heap
+{
+
+enum class Subsystem : uint8_t
+{
+    Other,
+    World,
+    Edit,
+    Step,
+    Glass,
+    Count
+};
+
+inline const char* SubsystemName(Subsystem s)
+{
+    switch (s)
+    {
+        case Subsystem::Other: return "other";
+        case Subsystem::World: return "world";
+        case Subsystem::Edit: return "edit";
+        case Subsystem::Step: return "step";
+        case Subsystem::Glass: return "glass";
+        case Subsystem::Count: break;
+    }
+    return "?";
+}
+
+struct Stats
+{
+    int64_t liveBytes = 0;
+    int64_t peakBytes = 0;
+    uint64_t allocs = 0; // ever
+};
+
+inline std::atomic<Subsystem> g_current{Subsystem::Other};
+inline std::atomic<bool> g_attribution{true};
+
+// Off when several threads drive worlds at once (SlopSweep): their scopes
+// would overwrite each other's, so everything counts as Other instead.
+inline void SetAttribution(bool enabled) { g_attribution.store(enabled, std::memory_order_relaxed); }
+
+class Scope
+{
+public:
+    explicit Scope(Subsystem s) : m_active(g_attribution.load(std::memory_order_relaxed))
+    {
+        if (m_active) m_prev = g_current.exchange(s, std::memory_order_relaxed);
+    }
+    ~Scope()
+    {
+        if (m_active) g_current.store(m_prev, std::memory_order_relaxed);
+    }
+
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+
+private:
+    Subsystem m_prev = Subsystem::Other;
+    bool m_active;
+};
+
+// Box2D's world registry has no lock: b2CreateWorld claims the first free
+// slot and b2DestroyWorld releases one, so two threads doing either at once
+// can be handed the same world id. Every world in the process is made and
+// torn down through these, under one mutex.
+inline std::mutex g_worldMutex;
+
+inline b2WorldId CreateWorld(const b2WorldDef& def)
+{
+    std::lock_guard<std::mutex> lock(g_worldMutex);
+    Scope scope(Subsystem::World);
+    return b2CreateWorld(&def);
+}
+
+inline void DestroyWorld(b2WorldId world)
+{
+    std::lock_guard<std::mutex> lock(g_worldMutex);
+    Scope scope(Subsystem::World);
+    b2DestroyWorld(world);
+}
+
+class Heap
+{
+public:
+    static constexpr size_t kHeaderBytes = 32; // keeps Box2D's 32-byte alignment
+    static constexpr size_t kChunkBytes = size_t{64} << 10;
+    static constexpr int kClassCount = 9; // 64 B .. 16 KiB blocks, header included
+    static constexpr size_t kMinBlock = 64;
+    static constexpr size_t kMaxPooled = kMinBlock << (kClassCount - 1);
+
+    // Never destroyed, so worlds torn down during static destruction still
+    // have somewhere to free into.
+    static Heap& Instance()
+    {
+        static Heap* heap = new Heap();
+        return *heap;
+    }
+
+    // Registers the heap with Box2D. Only possible while Box2D holds no
+    // memory from another allocator; true once installed.
+    static bool Install()
+    {
+        static std::mutex mutex;
+        static bool installed = false;
+        std::lock_guard<std::mutex> lock(mutex);
+        if (installed) return true;
+        if (b2GetByteCount() != 0) return false;
+        Instance();
+        b2SetAllocator(&AllocFcn, &FreeFcn);
+        installed = true;
+        return true;
+    }
+
+    void* Allocate(size_t size)
+    {
+        size_t total = RoundUp(size + kHeaderBytes, kHeaderBytes);
+        int sizeClass = ClassOf(total);
+        char* block = sizeClass >= 0 ? PopBlock(sizeClass) : static_cast<char*>(AlignedAlloc(total));
+        if (!block) return nullptr;
+
+        Subsystem s = g_current.load(std::memory_order_relaxed);
+        Header* h = reinterpret_cast<Header*>(block);
+        h->bytes = size;
+        h->subsystem = s;
+        h->sizeClass = static_cast<int8_t>(sizeClass);
+        Record(s, static_cast<int64_t>(size));
+        return block + kHeaderBytes;
+    }
+
+    void Free(void* mem)
+    {
+        if (!mem) return;
+        char* block = static_cast<char*>(mem) - kHeaderBytes;
+        const Header* h = reinterpret_cast<const Header*>(block);
+        Record(h->subsystem, -static_cast<int64_t>(h->bytes));
+        if (h->sizeClass >= 0) PushBlock(h->sizeClass, block);
+        else AlignedFree(block);
+    }
+
+    Stats SubsystemStats(Subsystem s) const
+    {
+        const Counters& c = m_counters[static_cast<size_t>(s)];
+        return {c.live.load(std::memory_order_relaxed), c.peak.load(std::memory_order_relaxed), c.allocs.load(std::memory_order_relaxed)};
+    }
+
+    Stats Total() const
+    {
+        return {m_total.live.load(std::memory_order_relaxed), m_total.peak.load(std::memory_order_relaxed), m_total.allocs.load(std::memory_order_relaxed)};
+    }
+
+    // Bytes held in pool chunks, used or not.
+    size_t PooledBytes() const { return m_chunkCount.load(std::memory_order_relaxed) * kChunkBytes; }
+
+private:
+    struct Header
+    {
+        size_t bytes;
+        Subsystem subsystem;
+        int8_t sizeClass; // -1 for passthrough blocks
+    };
+    static_assert(sizeof(Header) <= kHeaderBytes, "header must fit the alignment pad");
+
+    struct FreeBlock
+    {
+        FreeBlock* next;
+    };
+
+    struct Pool
+    {
+        std::mutex mutex;
+        FreeBlock* free = nullptr;
+        char* bump = nullptr;
+        char* bumpEnd = nullptr;
+    };
+
+    struct Counters
+    {
+        std::atomic<int64_t> live{0};
+        std::atomic<int64_t> peak{0};
+        std::atomic<uint64_t> allocs{0};
+
+        void Add(int64_t bytes)
+        {
+            int64_t now = live.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+            if (bytes <= 0) return;
+            allocs.fetch_add(1, std::memory_order_relaxed);
+            int64_t seen = peak.load(std::memory_order_relaxed);
+            while (now > seen && !peak.compare_exchange_weak(seen, now, std::memory_order_relaxed)) {}
+        }
+    };
+
+    Heap() = default;
+
+    static void* AllocFcn(unsigned int size, int alignment)
+    {
+        (void)alignment; // Box2D only asks for 32, which the header preserves
+        return Instance().Allocate(size);
+    }
+
+    static void FreeFcn(void* mem, unsigned int) { Instance().Free(mem); }
+
+    static size_t RoundUp(size_t n, size_t to) { return (n + to - 1) & ~(to - 1); }
+
+    static int ClassOf(size_t total)
+    {
+        if (total > kMaxPooled) return -1;
+        int c = 0;
+        for (size_t block = kMinBlock; block < total; block <<= 1) ++c;
+        return c;
+    }
+
+    static void* AlignedAlloc(size_t bytes)
+    {
+#if defined(_WIN32)
+        return _aligned_malloc(bytes, kHeaderBytes);
+#else
+        return std::aligned_alloc(kHeaderBytes, bytes);
+#endif
+    }
+
+    static void AlignedFree(void* p)
+    {
+#if defined(_WIN32)
+        _aligned_free(p);
+#else
+        std::free(p);
+#endif
+    }
+
+    char* PopBlock(int sizeClass)
+    {
+        Pool& pool = m_pools[static_cast<size_t>(sizeClass)];
+        size_t blockBytes = kMinBlock << sizeClass;
+        std::lock_guard<std::mutex> lock(pool.mutex);
+        if (pool.free)
+        {
+            FreeBlock* b = pool.free;
+            pool.free = b->next;
+            return reinterpret_cast<char*>(b);
+        }
+        if (pool.bump == pool.bumpEnd)
+        {
+            pool.bump = static_cast<char*>(AlignedAlloc(kChunkBytes));
+            if (!pool.bump)
+            {
+                pool.bumpEnd = nullptr;
+                return nullptr;
+            }
+            pool.bumpEnd = pool.bump + kChunkBytes;
+            m_chunkCount.fetch_add(1, std::memory_order_relaxed);
+        }
+        char* block = pool.bump;
+        pool.bump += blockBytes;
+        return block;
+    }
+
+    void PushBlock(int sizeClass, char* block)
+    {
+        Pool& pool = m_pools[static_cast<size_t>(sizeClass)];
+        std::lock_guard<std::mutex> lock(pool.mutex);
+        FreeBlock* b = reinterpret_cast<FreeBlock*>(block);
+        b->next = pool.free;
+        pool.free = b;
+    }
+
+    void Record(Subsystem s, int64_t bytes)
+    {
+        m_counters[static_cast<size_t>(s)].Add(bytes);
+        m_total.Add(bytes);
+    }
+
+    std::array<Pool, kClassCount> m_pools;
+    std::array<Counters, static_cast<size_t>(Subsystem::Count)> m_counters;
+    Counters m_total;
+    std::atomic<size_t> m_chunkCount{0};
+};
+
+// Allocations per second per subsystem over the last whole second.
+class AllocRate
+{
+public:
+    void Sample(double nowSeconds)
+    {
+        if (m_lastSample >= 0.0 && nowSeconds - m_lastSample < 1.0) return;
+        const Heap& heap = Heap::Instance();
+        double span = nowSeconds - m_lastSample;
+        for (size_t i = 0; i < m_allocs.size(); ++i)
+        {
+            uint64_t allocs = heap.SubsystemStats(static_cast<Subsystem>(i)).allocs;
+            m_perSecond[i] = m_lastSample >= 0.0 ? static_cast<float>(static_cast<double>(allocs - m_allocs[i]) / span) : 0.0f;
+            m_allocs[i] = allocs;
+        }
+        m_lastSample = nowSeconds;
+    }
+
+    float PerSecond(Subsystem s) const { return m_perSecond[static_cast<size_t>(s)]; }
+
+private:
+    double m_lastSample = -1.0;
+    std::array<uint64_t, static_cast<size_t>(Subsystem::Count)> m_allocs{};
+    std::array<float, static_cast<size_t>(Subsystem::Count)> m_perSecond{};
+};
+
+} // namespace box2d_heap
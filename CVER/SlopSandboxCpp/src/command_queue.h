@@ -0,0 +1,59 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <utility>
+
+// Bounded lock-free single-producer/single-consumer queue. The producer
+// calls TryPush, the consumer TryPop; each side owns one counter and
+// publishes it with a release store the other acquires. The counters run
+// freely and are masked into the ring, so all Capacity slots are usable.
+// Each side caches the other's counter and only reloads it when the ring
+// looks full (or empty), so a push or pop normally touches no shared line.
+template <typename T, size_t Capacity>
+class SpscQueue
+{
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "capacity must be a power of two");
+
+public:
+    // False when full; value is left untouched then.
+    bool TryPush(T&& value)
+    {
+        size_t tail = m_tail.load(std::memory_order_relaxed);
+        if (tail - m_headCache == Capacity)
+        {
+            m_headCache = m_head.load(std::memory_order_acquire);
+            if (tail - m_headCache == Capacity) return false;
+        }
+        m_slots[tail & kMask] = std::move(value);
+        m_tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool TryPop(T& out)
+    {
+        size_t head = m_head.load(std::memory_order_relaxed);
+        if (head == m_tailCache)
+        {
+            m_tailCache = m_tail.load(std::memory_order_acquire);
+            if (head == m_tailCache) return false;
+        }
+        out = std::move(m_slots[head & kMask]);
+        m_head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Exact only on the consumer side.
+    bool Empty() const { return m_head.load(std::memory_order_acquire) == m_tail.load(std::memory_order_acquire); }
+
+private:
+    static constexpr size_t kMask = Capacity - 1;
+
+    // Producer line, consumer line, then the slots.
+    alignas(64) std::atomic<size_t> m_tail{0};
+    size_t m_headCache = 0;
+    alignas(64) std::atomic<size_t> m_head{0};
+    size_t m_tailCache = 0;
+    alignas(64) std::array<T, Capacity> m_slots{};
+};
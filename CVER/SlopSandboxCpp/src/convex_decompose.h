@@ -0,0 +1,292 @@
+#pragma once
+
+#include <box2d/box2d.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Convex decomposition of simple polygons: ear-clipping triangulation, then
+// Hertel-Mehlhorn merging of neighbouring pieces while the union stays
+// convex and within B2_MAX_POLYGON_VERTICES. At most four times the optimal
+// piece count and O(n^3) in the worst case, which is nothing for the 48-point
+// strokes it is fed. Geometry is in the caller's units; polygons may come in
+// either winding and leave counter-clockwise (positive signed area).
+namespace decompose
+{
+
+constexpr int kMaxPieceVerts = B2_MAX_POLYGON_VERTICES;
+
+struct Piece
+{
+    b2Vec2 verts[kMaxPieceVerts];
+    int count = 0;
+    // Pieces it shares a diagonal with, and that diagonal's midpoint.
+    std::vector<std::pair<int, b2Vec2>> neighbours;
+};
+
+inline float SignedArea(const std::vector<b2Vec2>& p)
+{
+    float twice = 0.0f;
+    for (size_t i = 0; i < p.size(); ++i) twice += b2Cross(p[i], p[(i + 1) % p.size()]);
+    return twice * 0.5f;
+}
+
+// Drops vertices closer than minEdge to the previous one and those that are
+// nearly collinear with their neighbours, then makes the winding positive.
+inline void Clean(std::vector<b2Vec2>& p, float minEdge)
+{
+    bool changed = true;
+    while (changed && p.size() >= 3)
+    {
+        changed = false;
+        for (size_t i = 0; i < p.size() && p.size() >= 3; ++i)
+        {
+            size_t n = p.size();
+            const b2Vec2& prev = p[(i + n - 1) % n];
+            const b2Vec2& next = p[(i + 1) % n];
+            b2Vec2 e0 = b2Sub(p[i], prev);
+            b2Vec2 e1 = b2Sub(next, p[i]);
+            float len = b2Length(e0) * b2Length(e1);
+            if (b2Length(e0) < minEdge || len <= 0.0f || std::abs(b2Cross(e0, e1)) < 0.02f * len)
+            {
+                p.erase(p.begin() + static_cast<std::ptrdiff_t>(i));
+                changed = true;
+            }
+        }
+    }
+    if (p.size() >= 3 && SignedArea(p) < 0.0f) std::reverse(p.begin(), p.end());
+}
+
+inline bool SegmentsCross(b2Vec2 a, b2Vec2 b, b2Vec2 c, b2Vec2 d)
+{
+    float d1 = b2Cross(b2Sub(b, a), b2Sub(c, a));
+    float d2 = b2Cross(b2Sub(b, a), b2Sub(d, a));
+    float d3 = b2Cross(b2Sub(d, c), b2Sub(a, c));
+    float d4 = b2Cross(b2Sub(d, c), b2Sub(b, c));
+    return ((d1 > 0.0f) != (d2 > 0.0f)) && ((d3 > 0.0f) != (d4 > 0.0f));
+}
+
+// No two non-adjacent edges cross.
+inline bool IsSimple(const std::vector<b2Vec2>& p)
+{
+    size_t n = p.size();
+    for (size_t i = 0; i < n; ++i)
+    {
+        for (size_t j = i + 2; j < n; ++j)
+        {
+            if (i == 0 && j == n - 1) continue;
+            if (SegmentsCross(p[i], p[(i + 1) % n], p[j], p[(j + 1) % n])) return false;
+        }
+    }
+    return true;
+}
+
+inline bool InTriangle(b2Vec2 p, b2Vec2 a, b2Vec2 b, b2Vec2 c)
+{
+    return b2Cross(b2Sub(b, a), b2Sub(p, a)) >= 0.0f && b2Cross(b2Sub(c, b), b2Sub(p, b)) >= 0.0f &&
+           b2Cross(b2Sub(a, c), b2Sub(p, c)) >= 0.0f;
+}
+
+// Ear clipping of a counter-clockwise simple polygon into n - 2 triangles of
+// vertex indices. False when no ear is left, which only a degenerate
+// polygon gets to.
+inline bool Triangulate(const std::vector<b2Vec2>& p, std::vector<std::array<int, 3>>& tris)
+{
+    tris.clear();
+    std::vector<int> ring(p.size());
+    for (size_t i = 0; i < p.size(); ++i) ring[i] = static_cast<int>(i);
+    while (ring.size() > 3)
+    {
+        size_t n = ring.size();
+        bool clipped = false;
+        for (size_t i = 0; i < n && !clipped; ++i)
+        {
+            int ia = ring[(i + n - 1) % n];
+            int ib = ring[i];
+            int ic = ring[(i + 1) % n];
+            b2Vec2 a = p[ia], b = p[ib], c = p[ic];
+            if (b2Cross(b2Sub(b, a), b2Sub(c, b)) <= 0.0f) continue; // reflex
+            bool ear = true;
+            for (size_t k = 0; k < n && ear; ++k)
+            {
+                int iv = ring[k];
+                if (iv == ia || iv == ib || iv == ic) continue;
+                if (InTriangle(p[iv], a, b, c)) ear = false;
+            }
+            if (!ear) continue;
+            tris.push_back({ia, ib, ic});
+            ring.erase(ring.begin() + static_cast<std::ptrdiff_t>(i));
+            clipped = true;
+        }
+        if (!clipped) return false;
+    }
+    tris.push_back({ring[0], ring[1], ring[2]});
+    return true;
+}
+
+inline bool IsConvex(const std::vector<b2Vec2>& p, const std::vector<int>& poly)
+{
+    size_t n = poly.size();
+    for (size_t i = 0; i < n; ++i)
+    {
+        b2Vec2 a = p[poly[(i + n - 1) % n]];
+        b2Vec2 b = p[poly[i]];
+        b2Vec2 c = p[poly[(i + 1) % n]];
+        if (b2Cross(b2Sub(b, a), b2Sub(c, b)) < 0.0f) return false;
+    }
+    return true;
+}
+
+// Position of edge a -> b in poly, or -1.
+inline int FindEdge(const std::vector<int>& poly, int a, int b)
+{
+    size_t n = poly.size();
+    for (size_t i = 0; i < n; ++i)
+    {
+        if (poly[i] == a && poly[(i + 1) % n] == b) return static_cast<int>(i);
+    }
+    return -1;
+}
+
+// Decomposes a counter-clockwise simple polygon. False when it cannot be
+// triangulated.
+inline bool ConvexPieces(const std::vector<b2Vec2>& p, std::vector<Piece>& out)
+{
+    out.clear();
+    std::vector<std::array<int, 3>> tris;
+    if (p.size() < 3 || !Triangulate(p, tris)) return false;
+
+    std::vector<std::vector<int>> polys;
+    polys.reserve(tris.size());
+    for (const auto& t : tris) polys.push_back({t[0], t[1], t[2]});
+
+    // Greedy Hertel-Mehlhorn: drop every diagonal whose removal keeps both
+    // of its ends convex.
+    bool merged = true;
+    while (merged)
+    {
+        merged = false;
+        for (size_t i = 0; i < polys.size() && !merged; ++i)
+        {
+            const std::vector<int>& a = polys[i];
+            for (size_t e = 0; e < a.size() && !merged; ++e)
+            {
+                int u = a[e];
+                int v = a[(e + 1) % a.size()];
+                for (size_t j = 0; j < polys.size() && !merged; ++j)
+                {
+                    if (j == i) continue;
+                    int f = FindEdge(polys[j], v, u);
+                    if (f < 0) continue;
+                    const std::vector<int>& b = polys[j];
+                    if (a.size() + b.size() - 2 > static_cast<size_t>(kMaxPieceVerts)) continue;
+                    // a from v round to u, then b past u up to (not including) v.
+                    std::vector<int> joined;
+                    for (size_t k = 0; k < a.size(); ++k) joined.push_back(a[(e + 1 + k) % a.size()]);
+                    for (size_t k = 0; k < b.size() - 2; ++k) joined.push_back(b[(static_cast<size_t>(f) + 2 + k) % b.size()]);
+                    if (!IsConvex(p, joined)) continue;
+                    polys[i] = std::move(joined);
+                    polys.erase(polys.begin() + static_cast<std::ptrdiff_t>(j));
+                    merged = true;
+                }
+            }
+        }
+    }
+
+    out.resize(polys.size());
+    for (size_t i = 0; i < polys.size(); ++i)
+    {
+        out[i].count = static_cast<int>(polys[i].size());
+        for (int k = 0; k < out[i].count; ++k) out[i].verts[k] = p[polys[i][static_cast<size_t>(k)]];
+        for (size_t j = 0; j < polys.size(); ++j)
+        {
+            if (j == i) continue;
+            for (size_t e = 0; e < polys[i].size(); ++e)
+            {
+                int u = polys[i][e];
+                int v = polys[i][(e + 1) % polys[i].size()];
+                if (FindEdge(polys[j], v, u) >= 0) out[i].neighbours.push_back({static_cast<int>(j), b2Lerp(p[u], p[v], 0.5f)});
+            }
+        }
+    }
+    return true;
+}
+
+// Douglas-Peucker on a closed polygon, split at the vertex farthest from p[0].
+inline void Simplify(const std::vector<b2Vec2>& p, float tolerance, std::vector<b2Vec2>& out)
+{
+    out.clear();
+    size_t n = p.size();
+    if (n < 4)
+    {
+        out = p;
+        return;
+    }
+    size_t far = 0;
+    for (size_t i = 1; i < n; ++i)
+    {
+        if (b2DistanceSquared(p[i], p[0]) > b2DistanceSquared(p[far], p[0])) far = i;
+    }
+    std::vector<char> keep(n, 0);
+    keep[0] = keep[far] = 1;
+    std::vector<std::pair<size_t, size_t>> stack{{0, far}, {far, n}};
+    while (!stack.empty())
+    {
+        auto [first, last] = stack.back();
+        stack.pop_back();
+        b2Vec2 a = p[first];
+        b2Vec2 b = p[last % n];
+        b2Vec2 ab = b2Sub(b, a);
+        float len = b2Length(ab);
+        size_t worst = first;
+        float worstDist = tolerance;
+        for (size_t i = first + 1; i < last; ++i)
+        {
+            b2Vec2 ap = b2Sub(p[i], a);
+            float d = len > 0.0f ? std::abs(b2Cross(ab, ap)) / len : b2Length(ap);
+            if (d > worstDist)
+            {
+                worstDist = d;
+                worst = i;
+            }
+        }
+        if (worst == first) continue;
+        keep[worst] = 1;
+        stack.push_back({first, worst});
+        stack.push_back({worst, last});
+    }
+    for (size_t i = 0; i < n; ++i)
+    {
+        if (keep[i]) out.push_back(p[i]);
+    }
+}
+
+// The polygon's pieces, simplified with a doubling tolerance until there are
+// at most maxPieces. False (out empty) for polygons that are convex once
+// simplified, not simple, or cannot be brought under the bound; the caller
+// uses the hull for those.
+inline bool Decompose(std::vector<b2Vec2> p, float minEdge, float tolerance, int maxPieces, std::vector<Piece>& out)
+{
+    out.clear();
+    Clean(p, minEdge);
+    if (p.size() < 3 || !IsSimple(p)) return false;
+    std::vector<b2Vec2> simplified;
+    for (int attempt = 0; attempt < 6; ++attempt, tolerance *= 2.0f)
+    {
+        Simplify(p, tolerance, simplified);
+        Clean(simplified, minEdge);
+        if (simplified.size() < 3 || !IsSimple(simplified)) break;
+        std::vector<int> ring(simplified.size());
+        for (size_t i = 0; i < ring.size(); ++i) ring[i] = static_cast<int>(i);
+        if (IsConvex(simplified, ring) || !ConvexPieces(simplified, out)) break;
+        if (static_cast<int>(out.size()) <= maxPieces) return true;
+    }
+    out.clear();
+    return false;
+}
+
+} // namespace decompose
@@ -0,0 +1,305 @@
+#pragma once
+
+#include <box2d/box2d.h>
+
+#include "sim_types.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Convex Voronoi fracture. All geometry is in the caller's units and local to
+// the shape being broken.
+namespace fracture
+{
+
+constexpr int kMaxCellVerts = B2_MAX_POLYGON_VERTICES;
+constexpr int kMaxSeeds = 8;
+// Each clip against a half-plane adds at most one vertex.
+constexpr int kClipCapacity = kMaxCellVerts + kMaxSeeds + 1;
+
+// Sutherland-Hodgman: keeps the part of in[0..n) where dot(p, normal) <= offset.
+inline int ClipHalfPlane(const b2Vec2* in, int n, b2Vec2 normal, float offset, b2Vec2* out)
+{
+    int count = 0;
+    for (int i = 0; i < n && count < kClipCapacity - 1; ++i)
+    {
+        b2Vec2 a = in[i];
+        b2Vec2 b = in[(i + 1) % n];
+        float da = b2Dot(a, normal) - offset;
+        float db = b2Dot(b, normal) - offset;
+        if (da <= 0.0f) out[count++] = a;
+        if ((da <= 0.0f) != (db <= 0.0f)) out[count++] = b2Lerp(a, b, da / (da - db));
+    }
+    return count;
+}
+
+inline float PolygonArea(const b2Vec2* p, int n)
+{
+    float twice = 0.0f;
+    for (int i = 0; i < n; ++i) twice += b2Cross(p[i], p[(i + 1) % n]);
+    return std::abs(twice) * 0.5f;
+}
+
+inline b2Vec2 PolygonCentroid(const b2Vec2* p, int n)
+{
+    b2Vec2 c = b2Vec2_zero;
+    float twice = 0.0f;
+    for (int i = 0; i < n; ++i)
+    {
+        b2Vec2 a = p[i];
+        b2Vec2 b = p[(i + 1) % n];
+        float cr = b2Cross(a, b);
+        twice += cr;
+        c = b2MulAdd(c, cr, b2Add(a, b));
+    }
+    if (std::abs(twice) < 1e-9f)
+    {
+        c = b2Vec2_zero;
+        for (int i = 0; i < n; ++i) c = b2Add(c, p[i]);
+        return b2MulSV(1.0f / static_cast<float>(std::max(1, n)), c);
+    }
+    return b2MulSV(1.0f / (3.0f * twice), c);
+}
+
+// Point of fan triangle (p[0], p[tri + 1], p[tri + 2]) from two uniforms in [0, 1].
+inline b2Vec2 PointInFan(const b2Vec2* p, int n, int tri, float s, float t)
+{
+    tri = std::clamp(tri, 0, std::max(0, n - 3));
+    if (s + t > 1.0f)
+    {
+        s = 1.0f - s;
+        t = 1.0f - t;
+    }
+    b2Vec2 a = p[0];
+    b2Vec2 e1 = b2Sub(p[tri + 1], a);
+    b2Vec2 e2 = b2Sub(p[tri + 2], a);
+    return b2Add(a, b2Add(b2MulSV(s, e1), b2MulSV(t, e2)));
+}
+
+// The cell of seeds[cell] inside the convex polygon, at most kMaxCellVerts
+// vertices. Returns 0 when the cell is empty.
+inline int VoronoiCell(const b2Vec2* poly, int n, const b2Vec2* seeds, int seedCount, int cell, b2Vec2* out)
+{
+    b2Vec2 bufA[kClipCapacity];
+    b2Vec2 bufB[kClipCapacity];
+    n = std::min(n, kMaxCellVerts);
+    std::copy(poly, poly + n, bufA);
+    b2Vec2* cur = bufA;
+    b2Vec2* next = bufB;
+    b2Vec2 s = seeds[cell];
+    for (int j = 0; j < seedCount && n >= 3; ++j)
+    {
+        if (j == cell) continue;
+        b2Vec2 normal = b2Sub(seeds[j], s);
+        if (b2LengthSquared(normal) < 1e-12f) continue;
+        float offset = b2Dot(normal, b2Lerp(s, seeds[j], 0.5f));
+        n = ClipHalfPlane(cur, n, normal, offset, next);
+        std::swap(cur, next);
+    }
+    if (n < 3) return 0;
+
+    // Dropping the flattest corner keeps a convex polygon convex.
+    while (n > kMaxCellVerts)
+    {
+        int flattest = 0;
+        float best = INFINITY;
+        for (int i = 0; i < n; ++i)
+        {
+            b2Vec2 prev = cur[(i + n - 1) % n];
+            b2Vec2 nextV = cur[(i + 1) % n];
+            float a = std::abs(b2Cross(b2Sub(cur[i], prev), b2Sub(nextV, cur[i])));
+            if (a < best)
+            {
+                best = a;
+                flattest = i;
+            }
+        }
+        std::copy(cur + flattest + 1, cur + n, cur + flattest);
+        --n;
+    }
+    std::copy(cur, cur + n, out);
+    return n;
+}
+
+} // namespace fracture
+
+// One queued fragment: a polygon local to its centroid plus the state to give
+// the body when it is enabled.
+struct DebrisSpawn
+{
+    b2Polygon polygon{};
+    b2Vec2 position{0.0f, 0.0f};
+    b2Rot rotation = b2Rot_identity;
+    b2Vec2 linearVelocity{0.0f, 0.0f};
+    float angularVelocity = 0.0f;
+    float density = 1.0f;
+    float life = 3.0f;
+    Color fill{};
+};
+
+// Fixed set of dynamic bodies created disabled up front, one polygon shape
+// each. A fragment takes a free body, swaps in its polygon and enables it, so
+// shattering never creates or destroys bodies. Enabling still inserts a
+// broad-phase proxy; Update spreads that over steps with a per-step budget.
+// Debris does not collide with other debris.
+class DebrisPool
+{
+public:
+    static constexpr uint64_t kCategory = uint64_t{1} << 1;
+    static constexpr float kFadeSeconds = 0.6f;
+    // Queued fragments that could not get a body this soon are dropped.
+    static constexpr int kMaxPendingSteps = 8;
+
+    struct Piece
+    {
+        b2BodyId bodyId = b2_nullBodyId;
+        b2ShapeId shapeId = b2_nullShapeId;
+        b2Polygon polygon{};
+        float life = 0.0f;
+        Color fill{};
+        uint32_t serial = 0; // changes on every reuse, for snapshot keys
+
+        float Alpha() const { return std::clamp(life / kFadeSeconds, 0.0f, 1.0f); }
+    };
+
+    // Creates the bodies in worldId. Call again whenever the world is recreated;
+    // the old ids are forgotten, not destroyed.
+    void Init(b2WorldId worldId, size_t capacity, size_t maxPending)
+    {
+        m_pieces.assign(capacity, Piece{});
+        m_free.clear();
+        m_active.clear();
+        m_pending.clear();
+        m_free.reserve(capacity);
+        m_active.reserve(capacity);
+        m_pending.reserve(maxPending);
+        m_maxPending = maxPending;
+
+        b2BodyDef bodyDef = b2DefaultBodyDef();
+        bodyDef.type = b2_dynamicBody;
+        bodyDef.isEnabled = false;
+        bodyDef.linearDamping = 0.08f;
+        bodyDef.angularDamping = 0.6f;
+
+        b2ShapeDef shapeDef = b2DefaultShapeDef();
+        shapeDef.density = 1.0f;
+        shapeDef.material.friction = 0.7f;
+        shapeDef.filter.categoryBits = kCategory;
+        shapeDef.filter.maskBits = ~kCategory;
+        b2Polygon placeholder = b2MakeSquare(0.05f);
+
+        for (size_t i = capacity; i-- > 0;)
+        {
+            Piece& p = m_pieces[i];
+            p.bodyId = b2CreateBody(worldId, &bodyDef);
+            p.shapeId = b2CreatePolygonShape(p.bodyId, &shapeDef, &placeholder);
+            m_free.push_back(static_cast<uint32_t>(i));
+        }
+    }
+
+    // Returns every piece to the pool and drops queued fragments.
+    void Clear()
+    {
+        for (uint32_t i : m_active) Release(i);
+        m_active.clear();
+        m_pending.clear();
+    }
+
+    bool Queue(const DebrisSpawn& spawn)
+    {
+        if (m_pending.size() >= m_maxPending) return false;
+        m_pending.push_back({spawn, 0});
+        return true;
+    }
+
+    // Ages pieces, returns expired ones, then enables up to budget queued
+    // fragments. Sleeping pieces skip straight to their fade-out.
+    void Update(float dt, int budget)
+    {
+        size_t keep = 0;
+        for (uint32_t i : m_active)
+        {
+            Piece& p = m_pieces[i];
+            p.life -= dt;
+            if (p.life > kFadeSeconds && !b2Body_IsAwake(p.bodyId)) p.life = kFadeSeconds;
+            if (p.life > 0.0f) m_active[keep++] = i;
+            else Release(i);
+        }
+        m_active.resize(keep);
+
+        size_t done = 0;
+        for (; done < m_pending.size(); ++done)
+        {
+            if (budget <= 0 || m_free.empty()) break;
+            Activate(m_pending[done].spawn);
+            --budget;
+        }
+        size_t kept = 0;
+        for (size_t i = done; i < m_pending.size(); ++i)
+        {
+            if (++m_pending[i].waited <= kMaxPendingSteps) m_pending[kept++] = m_pending[i];
+        }
+        m_pending.resize(kept);
+    }
+
+    size_t ActiveCount() const { return m_active.size(); }
+    size_t PendingCount() const { return m_pending.size(); }
+
+    size_t AwakeCount() const
+    {
+        size_t n = 0;
+        for (uint32_t i : m_active) n += b2Body_IsAwake(m_pieces[i].bodyId) ? 1 : 0;
+        return n;
+    }
+
+    template <typename Fn>
+    void ForEachActive(Fn&& fn) const
+    {
+        for (uint32_t i : m_active) fn(m_pieces[i]);
+    }
+
+private:
+    struct Pending
+    {
+        DebrisSpawn spawn;
+        int waited = 0;
+    };
+
+    void Activate(const DebrisSpawn& s)
+    {
+        uint32_t i = m_free.back();
+        m_free.pop_back();
+        Piece& p = m_pieces[i];
+        p.polygon = s.polygon;
+        p.life = s.life;
+        p.fill = s.fill;
+        ++p.serial;
+
+        // Shape and transform changes on a disabled body touch no proxies.
+        b2Shape_SetDensity(p.shapeId, s.density, false);
+        b2Shape_SetPolygon(p.shapeId, &s.polygon);
+        b2Body_SetTransform(p.bodyId, s.position, s.rotation);
+        b2Body_ApplyMassFromShapes(p.bodyId);
+        b2Body_Enable(p.bodyId);
+        b2Body_SetLinearVelocity(p.bodyId, s.linearVelocity);
+        b2Body_SetAngularVelocity(p.bodyId, s.angularVelocity);
+        m_active.push_back(i);
+    }
+
+    void Release(uint32_t i)
+    {
+        Piece& p = m_pieces[i];
+        if (b2Body_IsValid(p.bodyId)) b2Body_Disable(p.bodyId);
+        p.life = 0.0f;
+        m_free.push_back(i);
+    }
+
+    std::vector<Piece> m_pieces;
+    std::vector<uint32_t> m_free;
+    std::vector<uint32_t> m_active; // oldest first
+    std::vector<Pending> m_pending;
+    size_t m_maxPending = 0;
+};
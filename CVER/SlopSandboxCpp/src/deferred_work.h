@@ -0,0 +1,112 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+enum class DeferredPriority : uint8_t
+{
+    Low,
+    Normal,
+    High,
+};
+
+// What one DeferredQueue::Run did.
+struct DeferredStats
+{
+    uint32_t ran = 0;
+    uint32_t forced = 0; // ran past the budget because they were due
+    uint32_t dropped = 0;
+    uint32_t pending = 0; // left for later calls
+    double ms = 0.0;
+};
+
+// Follow-up work a burst leaves behind that may wait a few frames. Each job
+// has a priority and a deadline, counted in Run calls. Run spends at most its
+// budget per call, highest priority first and oldest first within one. A job
+// past its deadline runs regardless of the budget, unless it is only worth
+// doing on time, in which case it is dropped.
+template <typename Job>
+class DeferredQueue
+{
+public:
+    // The job is due deadlineFrames Run calls after the next one.
+    void Push(const Job& job, DeferredPriority priority, uint32_t deadlineFrames, bool dropWhenLate)
+    {
+        m_entries.push_back({job, m_frame + 1 + deadlineFrames, m_nextSeq++, priority, dropWhenLate});
+    }
+
+    size_t Size() const { return m_entries.size(); }
+    const DeferredStats& LastStats() const { return m_stats; }
+
+    void Clear() { m_entries.clear(); }
+
+    // run(job) may push more jobs; they wait for the next call.
+    template <typename Fn>
+    void Run(double budgetMs, Fn&& run)
+    {
+        using Clock = std::chrono::steady_clock;
+        Clock::time_point start = Clock::now();
+        Clock::time_point end = start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double, std::milli>(budgetMs));
+        ++m_frame;
+        m_stats = {};
+
+        std::swap(m_running, m_entries);
+        m_entries.clear();
+        std::sort(m_running.begin(), m_running.end(), [](const Entry& a, const Entry& b) {
+            return a.priority != b.priority ? a.priority > b.priority : a.seq < b.seq;
+        });
+
+        // Required jobs that are due go first, so a full budget never makes
+        // them late.
+        for (Entry& e : m_running)
+        {
+            if (e.deadline > m_frame || e.dropWhenLate) continue;
+            run(e.job);
+            ++m_stats.forced;
+            e.done = true;
+        }
+
+        bool spent = false;
+        for (Entry& e : m_running)
+        {
+            if (e.done) continue;
+            if (!spent && Clock::now() < end)
+            {
+                run(e.job);
+                ++m_stats.ran;
+                continue;
+            }
+            spent = true;
+            if (e.dropWhenLate && e.deadline <= m_frame)
+            {
+                ++m_stats.dropped;
+                continue;
+            }
+            m_entries.push_back(std::move(e));
+        }
+        m_running.clear();
+
+        m_stats.pending = static_cast<uint32_t>(m_entries.size());
+        m_stats.ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    }
+
+private:
+    struct Entry
+    {
+        Job job;
+        uint64_t deadline;
+        uint64_t seq;
+        DeferredPriority priority;
+        bool dropWhenLate;
+        bool done = false;
+    };
+
+    std::vector<Entry> m_entries;
+    std::vector<Entry> m_running;
+    uint64_t m_frame = 0;
+    uint64_t m_nextSeq = 0;
+    DeferredStats m_stats;
+};
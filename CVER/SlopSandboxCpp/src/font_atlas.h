@@ -0,0 +1,179 @@
+#pragma once
+
+#include <raylib.h>
+
+#include "scene_file.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+// Baked UI font: the glyph metrics and atlas LoadFontEx builds from a TTF,
+// cached in one file so later launches skip rasterizing. Layout:
+//   FontAtlasHeader
+//   FontAtlasGlyph[glyphCount]
+//   uint8_t alpha[width * height]   coverage; the texture is white with it as alpha
+// The header keys the cache to the source TTF (size and modification time),
+// the pixel size and the codepoint list; any mismatch bakes it again. When
+// the source is gone the cache is used as is. Native byte order.
+namespace font_atlas
+{
+
+constexpr char kMagic[8] = {'S', 'L', 'O', 'P', 'F', 'N', 'T', '\0'};
+constexpr uint32_t kVersion = 1;
+constexpr int kGlyphPadding = 4; // LoadFontEx's
+
+struct FontAtlasHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t headerSize;
+    uint32_t baseSize;
+    uint32_t glyphCount;
+    uint32_t width;
+    uint32_t height;
+    uint32_t codepointHash;
+    uint32_t sourceBytes;
+    int64_t sourceModTime;
+};
+
+struct FontAtlasGlyph
+{
+    int32_t value;
+    int32_t offsetX;
+    int32_t offsetY;
+    int32_t advanceX;
+    float rec[4]; // x, y, width, height in the atlas
+};
+
+static_assert(sizeof(FontAtlasHeader) == 48, "font atlas header layout");
+static_assert(sizeof(FontAtlasGlyph) == 32, "font atlas glyph layout");
+
+// FNV-1a over the codepoints and the pixel size.
+inline uint32_t KeyHash(const int* codepoints, int count, int baseSize)
+{
+    uint32_t h = 2166136261u;
+    auto mix = [&h](uint32_t v) {
+        for (int i = 0; i < 4; ++i)
+        {
+            h = (h ^ ((v >> (8 * i)) & 0xFFu)) * 16777619u;
+        }
+    };
+    mix(static_cast<uint32_t>(baseSize));
+    for (int i = 0; i < count; ++i) mix(static_cast<uint32_t>(codepoints[i]));
+    return h;
+}
+
+// Font owning MemAlloc'd glyphs and recs, as UnloadFont expects; glyph images
+// stay empty since the UI only draws from the atlas texture.
+inline Font MakeFont(int baseSize, const FontAtlasGlyph* glyphs, int count, const uint8_t* alpha, int width, int height)
+{
+    Font font{};
+    font.baseSize = baseSize;
+    font.glyphCount = count;
+    font.glyphPadding = kGlyphPadding;
+    font.glyphs = static_cast<GlyphInfo*>(MemAlloc(static_cast<unsigned int>(sizeof(GlyphInfo) * static_cast<size_t>(count))));
+    font.recs = static_cast<Rectangle*>(MemAlloc(static_cast<unsigned int>(sizeof(Rectangle) * static_cast<size_t>(count))));
+    for (int i = 0; i < count; ++i)
+    {
+        const FontAtlasGlyph& g = glyphs[i];
+        font.glyphs[i] = GlyphInfo{g.value, g.offsetX, g.offsetY, g.advanceX, Image{}};
+        font.recs[i] = Rectangle{g.rec[0], g.rec[1], g.rec[2], g.rec[3]};
+    }
+
+    std::vector<uint8_t> pixels(static_cast<size_t>(width) * static_cast<size_t>(height) * 2);
+    for (size_t i = 0; i < pixels.size() / 2; ++i)
+    {
+        pixels[2 * i] = 255;
+        pixels[2 * i + 1] = alpha[i];
+    }
+    Image image{pixels.data(), width, height, 1, PIXELFORMAT_UNCOMPRESSED_GRAY_ALPHA};
+    font.texture = LoadTextureFromImage(image);
+    return font;
+}
+
+// Reads the cache with one mapping. sourcePath may be null (no TTF found);
+// otherwise the cache must have been baked from that file as it is now.
+inline bool Load(const char* cachePath, const char* sourcePath, const int* codepoints, int count, int baseSize, Font& out)
+{
+    MappedFile file;
+    if (!file.Open(cachePath) || file.Size() < sizeof(FontAtlasHeader)) return false;
+    const auto* h = reinterpret_cast<const FontAtlasHeader*>(file.Data());
+    if (std::memcmp(h->magic, kMagic, sizeof(kMagic)) != 0 || h->version != kVersion || h->headerSize != sizeof(FontAtlasHeader)) return false;
+    if (h->baseSize != static_cast<uint32_t>(baseSize) || h->codepointHash != KeyHash(codepoints, count, baseSize)) return false;
+    if (sourcePath &&
+        (h->sourceBytes != static_cast<uint32_t>(GetFileLength(sourcePath)) || h->sourceModTime != static_cast<int64_t>(GetFileModTime(sourcePath))))
+    {
+        return false;
+    }
+
+    uint64_t need = sizeof(FontAtlasHeader) + uint64_t{h->glyphCount} * sizeof(FontAtlasGlyph) + uint64_t{h->width} * h->height;
+    if (h->glyphCount == 0 || h->width == 0 || h->height == 0 || need != file.Size()) return false;
+
+    const auto* glyphs = reinterpret_cast<const FontAtlasGlyph*>(file.Data() + sizeof(FontAtlasHeader));
+    const uint8_t* alpha = reinterpret_cast<const uint8_t*>(glyphs + h->glyphCount);
+    out = MakeFont(baseSize, glyphs, static_cast<int>(h->glyphCount), alpha, static_cast<int>(h->width), static_cast<int>(h->height));
+    return out.texture.id > 0;
+}
+
+// Rasterizes sourcePath the way LoadFontEx does and writes the cache; a
+// failed write still returns the font.
+inline bool Bake(const char* sourcePath, const int* codepoints, int count, int baseSize, const char* cachePath, Font& out)
+{
+    int dataSize = 0;
+    unsigned char* data = LoadFileData(sourcePath, &dataSize);
+    if (!data) return false;
+    GlyphInfo* glyphs = LoadFontData(data, dataSize, baseSize, const_cast<int*>(codepoints), count, FONT_DEFAULT);
+    UnloadFileData(data);
+    if (!glyphs) return false;
+
+    Rectangle* recs = nullptr;
+    Image atlas = GenImageFontAtlas(glyphs, &recs, count, baseSize, kGlyphPadding, 0);
+    bool ok = atlas.data && recs && atlas.format == PIXELFORMAT_UNCOMPRESSED_GRAY_ALPHA;
+    if (ok)
+    {
+        std::vector<FontAtlasGlyph> records(static_cast<size_t>(count));
+        for (int i = 0; i < count; ++i)
+        {
+            records[i] = {glyphs[i].value, glyphs[i].offsetX, glyphs[i].offsetY, glyphs[i].advanceX, {recs[i].x, recs[i].y, recs[i].width, recs[i].height}};
+        }
+        size_t pixelCount = static_cast<size_t>(atlas.width) * static_cast<size_t>(atlas.height);
+        std::vector<uint8_t> alpha(pixelCount);
+        const auto* src = static_cast<const uint8_t*>(atlas.data);
+        for (size_t i = 0; i < pixelCount; ++i) alpha[i] = src[2 * i + 1];
+
+        out = MakeFont(baseSize, records.data(), count, alpha.data(), atlas.width, atlas.height);
+        ok = out.texture.id > 0;
+
+        FontAtlasHeader header{};
+        std::memcpy(header.magic, kMagic, sizeof(kMagic));
+        header.version = kVersion;
+        header.headerSize = sizeof(FontAtlasHeader);
+        header.baseSize = static_cast<uint32_t>(baseSize);
+        header.glyphCount = static_cast<uint32_t>(count);
+        header.width = static_cast<uint32_t>(atlas.width);
+        header.height = static_cast<uint32_t>(atlas.height);
+        header.codepointHash = KeyHash(codepoints, count, baseSize);
+        header.sourceBytes = static_cast<uint32_t>(GetFileLength(sourcePath));
+        header.sourceModTime = static_cast<int64_t>(GetFileModTime(sourcePath));
+
+        std::vector<uint8_t> bytes;
+        bytes.reserve(sizeof(header) + records.size() * sizeof(FontAtlasGlyph) + alpha.size());
+        auto put = [&bytes](const void* p, size_t n) {
+            const auto* b = static_cast<const uint8_t*>(p);
+            bytes.insert(bytes.end(), b, b + n);
+        };
+        put(&header, sizeof(header));
+        put(records.data(), records.size() * sizeof(FontAtlasGlyph));
+        put(alpha.data(), alpha.size());
+        if (ok && cachePath) WriteFileAtomic(cachePath, bytes);
+    }
+
+    UnloadImage(atlas);
+    MemFree(recs);
+    UnloadFontData(glyphs, count);
+    return ok;
+}
+
+} // namespace font_atlas
@@ -0,0 +1,155 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+// Linear allocator for scratch data that never outlives a frame (or a fixed
+// step on the physics thread). Allocation bumps a pointer; Reset rewinds it.
+// When a frame overflows the block, extra blocks are chained and the next
+// Reset replaces them with one block sized to the high-water mark, so steady
+// state makes no heap allocations at all.
+class FrameArena
+{
+public:
+    explicit FrameArena(size_t initialBytes = 64 * 1024) : m_blockBytes(initialBytes) {}
+    FrameArena(const FrameArena&) = delete;
+    FrameArena& operator=(const FrameArena&) = delete;
+    ~FrameArena() { Release(); }
+
+    void* Allocate(size_t bytes, size_t align)
+    {
+        uintptr_t p = (m_cursor + (align - 1)) & ~uintptr_t(align - 1);
+        if (m_cursor == 0 || p + bytes > m_end)
+        {
+            Grow(bytes + align);
+            p = (m_cursor + (align - 1)) & ~uintptr_t(align - 1);
+        }
+        m_cursor = p + bytes;
+        m_used += bytes;
+        return reinterpret_cast<void*>(p);
+    }
+
+    // Invalidates everything handed out since the last Reset.
+    void Reset()
+    {
+        m_highWater = m_used > m_highWater ? m_used : m_highWater;
+        if (m_blocks.size() > 1)
+        {
+            Release();
+            m_blockBytes = m_highWater + m_highWater / 2;
+        }
+        if (!m_blocks.empty())
+        {
+            m_cursor = reinterpret_cast<uintptr_t>(m_blocks[0].data);
+            m_end = m_cursor + m_blocks[0].bytes;
+        }
+        m_used = 0;
+    }
+
+    size_t BytesUsed() const { return m_used; }
+    size_t HighWater() const { return m_highWater; }
+
+private:
+    struct Block
+    {
+        void* data;
+        size_t bytes;
+    };
+
+    void Grow(size_t minBytes)
+    {
+        size_t bytes = m_blocks.empty() ? m_blockBytes : m_blocks.back().bytes * 2;
+        if (bytes < minBytes) bytes = minBytes;
+        void* data = std::malloc(bytes);
+        if (!data) throw std::bad_alloc();
+        m_blocks.push_back({data, bytes});
+        m_cursor = reinterpret_cast<uintptr_t>(data);
+        m_end = m_cursor + bytes;
+    }
+
+    void Release()
+    {
+        for (const Block& b : m_blocks) std::free(b.data);
+        m_blocks.clear();
+        m_cursor = 0;
+        m_end = 0;
+    }
+
+    std::vector<Block> m_blocks;
+    uintptr_t m_cursor = 0;
+    uintptr_t m_end = 0;
+    size_t m_used = 0;
+    size_t m_highWater = 0;
+    size_t m_blockBytes;
+};
+
+// STL allocator over a FrameArena. Deallocation is a no-op; memory comes back
+// on the arena's Reset, so containers using it must not outlive the frame.
+template <typename T>
+class ArenaAllocator
+{
+public:
+    using value_type = T;
+
+    explicit ArenaAllocator(FrameArena& arena) noexcept : m_arena(&arena) {}
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U>& other) noexcept : m_arena(other.Arena())
+    {
+    }
+
+    T* allocate(size_t n) { return static_cast<T*>(m_arena->Allocate(n * sizeof(T), alignof(T))); }
+    void deallocate(T*, size_t) noexcept {}
+
+    FrameArena* Arena() const noexcept { return m_arena; }
+
+    template <typename U>
+    bool operator==(const ArenaAllocator<U>& o) const noexcept { return m_arena == o.Arena(); }
+    template <typename U>
+    bool operator!=(const ArenaAllocator<U>& o) const noexcept { return m_arena != o.Arena(); }
+
+private:
+    FrameArena* m_arena;
+};
+
+template <typename T>
+using ArenaVector = std::vector<T, ArenaAllocator<T>>;
+
+// Global operator new counter. Builds with SLOP_COUNT_HEAP_ALLOCS expand
+// SLOP_DEFINE_HEAP_ALLOC_COUNTER() once, at namespace scope in the file with
+// main(); elsewhere the count reads as zero.
+namespace heap_stats
+{
+
+inline std::atomic<uint64_t> g_allocs{0};
+
+constexpr bool kEnabled =
+#if defined(SLOP_COUNT_HEAP_ALLOCS)
+    true;
+#else
+    false;
+#endif
+
+inline uint64_t AllocCount() { return g_allocs.load(std::memory_order_relaxed); }
+
+} // namespace heap_stats
+
+#if defined(SLOP_COUNT_HEAP_ALLOCS)
+#define SLOP_DEFINE_HEAP_ALLOC_COUNTER()                                                                                   \
+    void* operator new(std::size_t n)                                                                                      \
+    {                                                                                                                      \
+        heap_stats::g_allocs.fetch_add(1, std::memory_order_relaxed);                                                      \
+        if (void* p = std::malloc(n ? n : 1)) return p;                                                                    \
+        throw std::bad_alloc();                                                                                            \
+    }                                                                                                                      \
+    void* operator new[](std::size_t n) { return ::operator new(n); }                                                      \
+    void operator delete(void* p) noexcept { std::free(p); }                                                               \
+    void operator delete[](void* p) noexcept { std::free(p); }                                                             \
+    void operator delete(void* p, std::size_t) noexcept { std::free(p); }                                                  \
+    void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+#else
+#define SLOP_DEFINE_HEAP_ALLOC_COUNTER()
+#endif
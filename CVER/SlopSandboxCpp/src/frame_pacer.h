@@ -0,0 +1,95 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <thread>
+
+// Frame timing for the low-latency mode, in place of SetTargetFPS. raylib
+// sleeps out the rest of the frame after the swap, so input is sampled right
+// after it and then waits a whole frame of work and vsync to be seen. The
+// pacer instead sleeps before the frame: until its deadline minus the work it
+// is predicted to take, after which the caller samples input and renders.
+// The prediction is a high percentile of the last kHistory frames plus a
+// margin, so one slow frame raises it at once and it settles over the window.
+class FramePacer
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    static constexpr int kHistory = 32;
+    // The last stretch of a wait spins; sleeps overshoot by about that much.
+    static constexpr double kSpinMs = 1.0;
+
+    // 0 leaves frames unpaced.
+    void SetTargetFps(int fps)
+    {
+        m_period = fps > 0 ? std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / fps)) : Clock::duration::zero();
+    }
+
+    void SetMarginMs(double ms) { m_margin = ToDuration(ms); }
+
+    // Call before sampling input.
+    void Wait()
+    {
+        Clock::time_point now = Clock::now();
+        m_waitMs = 0.0;
+        if (m_period != Clock::duration::zero() && m_paced)
+        {
+            Clock::time_point start = m_deadline - ToDuration(PredictedMs()) - m_margin;
+            if (start > now) SleepUntil(start);
+            Clock::time_point woke = Clock::now();
+            m_waitMs = std::chrono::duration<double, std::milli>(woke - now).count();
+            now = woke;
+        }
+        m_workStart = now;
+    }
+
+    // Call once the frame has been handed to the swap.
+    void Presented()
+    {
+        Clock::time_point now = Clock::now();
+        m_work[static_cast<size_t>(m_head)] = std::chrono::duration<double, std::milli>(now - m_workStart).count();
+        m_head = (m_head + 1) % kHistory;
+        m_count = std::min(m_count + 1, kHistory);
+        // A late frame, or a swap that blocked on vsync, moves the grid.
+        m_deadline = (!m_paced || now > m_deadline) ? now + m_period : m_deadline + m_period;
+        m_paced = true;
+    }
+
+    // Work the next frame is expected to take, in ms.
+    double PredictedMs() const
+    {
+        if (m_count == 0) return 0.0;
+        std::array<double, kHistory> sorted = m_work;
+        auto end = sorted.begin() + m_count;
+        auto at = sorted.begin() + (m_count * 9) / 10;
+        std::nth_element(sorted.begin(), at, end);
+        return *at;
+    }
+
+    double LastWaitMs() const { return m_waitMs; }
+
+private:
+    static Clock::duration ToDuration(double ms)
+    {
+        return std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double, std::milli>(ms));
+    }
+
+    static void SleepUntil(Clock::time_point t)
+    {
+        Clock::time_point coarse = t - ToDuration(kSpinMs);
+        if (Clock::now() < coarse) std::this_thread::sleep_until(coarse);
+        while (Clock::now() < t) std::this_thread::yield();
+    }
+
+    Clock::duration m_period = Clock::duration::zero();
+    Clock::duration m_margin = ToDuration(1.0);
+    Clock::time_point m_deadline;
+    Clock::time_point m_workStart;
+    bool m_paced = false;
+    double m_waitMs = 0.0;
+    std::array<double, kHistory> m_work{};
+    int m_head = 0;
+    int m_count = 0;
+};
@@ -0,0 +1,318 @@
+#pragma once
+
+#include "frame_arena.h"
+
+#include <box2d/box2d.h>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+
+enum class ProfileStage : int
+{
+    Input,
+    Wave,
+    Physics,
+    Glass,
+    Particles,
+    Cleanup,
+    Draw,
+    Count
+};
+
+// Per-frame timing record. Stage times accumulate over every fixed step taken
+// in the frame; the Box2D fields sum b2World_GetProfile over those steps.
+struct FrameStats
+{
+    double frameMs = 0.0; // wall time between frames, including vsync
+    double cpuMs = 0.0;   // BeginFrame..EndFrame
+    // Input sample behind the drawn frame to its swap; 0 when unknown.
+    double inputLatencyMs = 0.0;
+    std::array<double, static_cast<size_t>(ProfileStage::Count)> stageMs{};
+    int physicsSteps = 0;
+    int subSteps = 0; // substeps of the last step in the frame
+
+    float b2Step = 0.0f;
+    float b2Pairs = 0.0f;
+    float b2Collide = 0.0f;
+    float b2Solve = 0.0f;
+    float b2Refit = 0.0f;
+    float b2Continuous = 0.0f;
+    float b2Sleep = 0.0f;
+
+    int bodyCount = 0;
+    int awakeBodyCount = 0;
+    int contactCount = 0;
+    int jointCount = 0;
+    int islandCount = 0;
+    int taskCount = 0;
+    int bulletCount = 0;         // bodies tagged for dynamic sweeps
+    uint64_t bulletEvictions = 0; // tags dropped for the budget, ever
+
+    // operator new calls between BeginFrame and EndFrame, on any thread.
+    // Always 0 unless built with SLOP_COUNT_HEAP_ALLOCS.
+    double heapAllocs = 0.0;
+};
+
+// Rolling frame statistics with an optional per-frame CSV dump. Stage and
+// world-step samples may come from the physics thread; everything else is
+// called from the render thread.
+class FrameProfiler
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    static constexpr int kHistory = 240;
+    static constexpr int kHistogramBuckets = 12;
+    static constexpr double kHistogramBucketMs = 4.0;
+
+    class Scope
+    {
+    public:
+        Scope(FrameProfiler& profiler, ProfileStage stage)
+            : m_profiler(profiler), m_stage(stage), m_start(Clock::now())
+        {
+        }
+
+        ~Scope()
+        {
+            m_profiler.AddStage(m_stage, MsSince(m_start));
+        }
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        FrameProfiler& m_profiler;
+        ProfileStage m_stage;
+        Clock::time_point m_start;
+    };
+
+    ~FrameProfiler() { CloseCsv(); }
+
+    static const char* StageName(ProfileStage stage)
+    {
+        switch (stage)
+        {
+            case ProfileStage::Input: return "input";
+            case ProfileStage::Wave: return "wave";
+            case ProfileStage::Physics: return "physics";
+            case ProfileStage::Glass: return "glass";
+            case ProfileStage::Particles: return "particles";
+            case ProfileStage::Cleanup: return "cleanup";
+            case ProfileStage::Draw: return "draw";
+            case ProfileStage::Count: break;
+        }
+        return "?";
+    }
+
+    void BeginFrame()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_current = FrameStats{};
+        m_frameStart = Clock::now();
+        m_allocsAtStart = heap_stats::AllocCount();
+    }
+
+    void AddStage(ProfileStage stage, double ms)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_current.stageMs[static_cast<size_t>(stage)] += ms;
+    }
+
+    void AddWorldStep(const b2Profile& p, int subSteps)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        ++m_current.physicsSteps;
+        m_current.subSteps = subSteps;
+        m_current.b2Step += p.step;
+        m_current.b2Pairs += p.pairs;
+        m_current.b2Collide += p.collide;
+        m_current.b2Solve += p.solve;
+        m_current.b2Refit += p.refit;
+        m_current.b2Continuous += p.bullets;
+        m_current.b2Sleep += p.sleepIslands;
+    }
+
+    // Reads world counters; call wherever the world is not being stepped.
+    void SampleWorld(b2WorldId worldId)
+    {
+        if (!b2World_IsValid(worldId)) return;
+        b2Counters c = b2World_GetCounters(worldId);
+        int awake = b2World_GetAwakeBodyCount(worldId);
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_world.bodyCount = c.bodyCount;
+        m_world.contactCount = c.contactCount;
+        m_world.jointCount = c.jointCount;
+        m_world.islandCount = c.islandCount;
+        m_world.taskCount = c.taskCount;
+        m_world.awakeBodyCount = awake;
+    }
+
+    void SampleBullets(int count, uint64_t evictions)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_world.bulletCount = count;
+        m_world.bulletEvictions = evictions;
+    }
+
+    void SetInputLatency(double ms)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_current.inputLatencyMs = ms;
+    }
+
+    void EndFrame(double frameMs)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_current.frameMs = frameMs;
+        m_current.cpuMs = MsSince(m_frameStart);
+        m_current.heapAllocs = static_cast<double>(heap_stats::AllocCount() - m_allocsAtStart);
+        m_current.bodyCount = m_world.bodyCount;
+        m_current.contactCount = m_world.contactCount;
+        m_current.jointCount = m_world.jointCount;
+        m_current.islandCount = m_world.islandCount;
+        m_current.taskCount = m_world.taskCount;
+        m_current.awakeBodyCount = m_world.awakeBodyCount;
+        m_current.bulletCount = m_world.bulletCount;
+        m_current.bulletEvictions = m_world.bulletEvictions;
+
+        m_history[static_cast<size_t>(m_head)] = m_current;
+        m_head = (m_head + 1) % kHistory;
+        m_count = std::min(m_count + 1, kHistory);
+        ++m_frameIndex;
+        RecomputeMean();
+
+        if (m_csv) WriteCsvRow(m_current);
+    }
+
+    int SampleCount() const { return m_count; }
+    const FrameStats& Last() const { return m_history[static_cast<size_t>((m_head + kHistory - 1) % kHistory)]; }
+    // Rolling means over the last SampleCount() frames; counters are from the last frame.
+    const FrameStats& Mean() const { return m_mean; }
+
+    double MaxFrameMs() const
+    {
+        double m = 0.0;
+        for (int i = 0; i < m_count; ++i) m = std::max(m, m_history[static_cast<size_t>(i)].frameMs);
+        return m;
+    }
+
+    double MaxInputLatencyMs() const
+    {
+        double m = 0.0;
+        for (int i = 0; i < m_count; ++i) m = std::max(m, m_history[static_cast<size_t>(i)].inputLatencyMs);
+        return m;
+    }
+
+    std::array<int, kHistogramBuckets> FrameHistogram() const
+    {
+        std::array<int, kHistogramBuckets> h{};
+        for (int i = 0; i < m_count; ++i)
+        {
+            int b = static_cast<int>(m_history[static_cast<size_t>(i)].frameMs / kHistogramBucketMs);
+            ++h[static_cast<size_t>(std::clamp(b, 0, kHistogramBuckets - 1))];
+        }
+        return h;
+    }
+
+    bool OpenCsv(const char* path)
+    {
+        CloseCsv();
+        m_csv = std::fopen(path, "w");
+        if (!m_csv) return false;
+        std::fprintf(m_csv, "frame,frame_ms,cpu_ms,input_latency_ms");
+        for (int s = 0; s < static_cast<int>(ProfileStage::Count); ++s)
+        {
+            std::fprintf(m_csv, ",%s_ms", StageName(static_cast<ProfileStage>(s)));
+        }
+        std::fprintf(m_csv, ",steps,substeps,b2_step_ms,b2_pairs_ms,b2_collide_ms,b2_solve_ms,b2_refit_ms,b2_continuous_ms,b2_sleep_ms");
+        std::fprintf(m_csv, ",bodies,awake,contacts,joints,islands,tasks,bullets,bullet_evictions,heap_allocs\n");
+        return true;
+    }
+
+    void CloseCsv()
+    {
+        if (!m_csv) return;
+        std::fclose(m_csv);
+        m_csv = nullptr;
+    }
+
+    bool CsvOpen() const { return m_csv != nullptr; }
+
+private:
+    static double MsSince(Clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    }
+
+    void RecomputeMean()
+    {
+        FrameStats sum;
+        double steps = 0.0;
+        int latencyFrames = 0;
+        for (int i = 0; i < m_count; ++i)
+        {
+            const FrameStats& f = m_history[static_cast<size_t>(i)];
+            sum.frameMs += f.frameMs;
+            sum.cpuMs += f.cpuMs;
+            sum.inputLatencyMs += f.inputLatencyMs;
+            latencyFrames += f.inputLatencyMs > 0.0 ? 1 : 0;
+            sum.heapAllocs += f.heapAllocs;
+            for (size_t s = 0; s < sum.stageMs.size(); ++s) sum.stageMs[s] += f.stageMs[s];
+            steps += f.physicsSteps;
+            sum.b2Step += f.b2Step;
+            sum.b2Pairs += f.b2Pairs;
+            sum.b2Collide += f.b2Collide;
+            sum.b2Solve += f.b2Solve;
+            sum.b2Refit += f.b2Refit;
+            sum.b2Continuous += f.b2Continuous;
+            sum.b2Sleep += f.b2Sleep;
+        }
+
+        double inv = m_count > 0 ? 1.0 / m_count : 0.0;
+        float invf = static_cast<float>(inv);
+        m_mean = Last();
+        m_mean.frameMs = sum.frameMs * inv;
+        m_mean.cpuMs = sum.cpuMs * inv;
+        m_mean.inputLatencyMs = latencyFrames > 0 ? sum.inputLatencyMs / latencyFrames : 0.0;
+        m_mean.heapAllocs = sum.heapAllocs * inv;
+        for (size_t s = 0; s < sum.stageMs.size(); ++s) m_mean.stageMs[s] = sum.stageMs[s] * inv;
+        m_mean.physicsSteps = static_cast<int>(steps * inv + 0.5);
+        m_mean.b2Step = sum.b2Step * invf;
+        m_mean.b2Pairs = sum.b2Pairs * invf;
+        m_mean.b2Collide = sum.b2Collide * invf;
+        m_mean.b2Solve = sum.b2Solve * invf;
+        m_mean.b2Refit = sum.b2Refit * invf;
+        m_mean.b2Continuous = sum.b2Continuous * invf;
+        m_mean.b2Sleep = sum.b2Sleep * invf;
+    }
+
+    void WriteCsvRow(const FrameStats& f)
+    {
+        std::fprintf(m_csv, "%llu,%.4f,%.4f,%.4f", static_cast<unsigned long long>(m_frameIndex), f.frameMs, f.cpuMs, f.inputLatencyMs);
+        for (double ms : f.stageMs) std::fprintf(m_csv, ",%.4f", ms);
+        std::fprintf(m_csv, ",%d,%d,%.4f,%.4f,%.4f,%.4f,%.4f,%.4f,%.4f", f.physicsSteps, f.subSteps, f.b2Step, f.b2Pairs, f.b2Collide,
+                     f.b2Solve, f.b2Refit, f.b2Continuous, f.b2Sleep);
+        std::fprintf(m_csv, ",%d,%d,%d,%d,%d,%d,%d,%llu,%.0f\n", f.bodyCount, f.awakeBodyCount, f.contactCount, f.jointCount,
+                     f.islandCount, f.taskCount, f.bulletCount, static_cast<unsigned long long>(f.bulletEvictions), f.heapAllocs);
+    }
+
+    std::mutex m_mutex;
+    FrameStats m_current;
+    FrameStats m_world;
+    Clock::time_point m_frameStart = Clock::now();
+
+    std::array<FrameStats, kHistory> m_history{};
+    int m_head = 0;
+    int m_count = 0;
+    uint64_t m_frameIndex = 0;
+    uint64_t m_allocsAtStart = 0;
+
+    FrameStats m_mean;
+
+    std::FILE* m_csv = nullptr;
+};
@@ -0,0 +1,389 @@
+#pragma once
+
+#include "gpu_spawn_queue.h"
+#include "particle_pool.h"
+
+#include <raylib.h>
+#include <rlgl.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+// Optional GPU path for the cosmetic effects: particle state lives in shader
+// storage buffers, a compute shader integrates it and the particles are drawn
+// straight from those buffers; the water surface is drawn from an uploaded copy
+// of the height field. Needs raylib built for OpenGL 4.3 (SLOP_GPU_COMPUTE);
+// otherwise, or when the context is older, Init fails and the CPU pools stay
+// in use.
+//
+// The wave columns themselves stay on the CPU. They are a few hundred floats,
+// buoyancy, replays and scene files depend on them bit for bit, and they are
+// stepped on the physics thread while the GL context belongs to the render
+// thread. Particles never feed back into the simulation, so they can run on
+// the GPU at render time.
+
+#if defined(SLOP_GPU_COMPUTE)
+// raylib's desktop platform links GLFW; only this one entry point is needed.
+typedef void (*GLFWglproc)(void);
+extern "C" GLFWglproc glfwGetProcAddress(const char* procname);
+#endif
+
+class GpuEffects
+{
+public:
+    static constexpr int kLanes = GpuSpawnQueue::kLanes;
+
+    struct LaneParams
+    {
+        float gravity = 0.0f;
+        float dragX60 = 1.0f;
+        float dragY60 = 1.0f;
+        // Particles leaving [minX, maxX] or sinking below maxY die.
+        float minX = -1e30f;
+        float maxX = 1e30f;
+        float maxY = 1e30f;
+    };
+
+    // Needs a current GL context. Returns false, leaving nothing loaded, when
+    // the build or the driver has no compute shaders.
+    bool Init(size_t laneCapacity, size_t maxColumns)
+    {
+#if defined(SLOP_GPU_COMPUTE)
+        if (rlGetVersion() != RL_OPENGL_43) return false;
+        unsigned int compute = rlCompileShader(kIntegrateSource, RL_COMPUTE_SHADER);
+        if (compute == 0) return false;
+        m_integrate = rlLoadComputeShaderProgram(compute);
+        m_drawParticles = rlLoadShaderCode(kParticleVertexSource, kFragmentSource);
+        m_drawSurface = rlLoadShaderCode(kSurfaceVertexSource, kFragmentSource);
+        m_vao = rlLoadVertexArray();
+        if (m_integrate == 0 || m_drawParticles == 0 || m_drawSurface == 0 || m_vao == 0)
+        {
+            Unload();
+            return false;
+        }
+
+        m_locStep = rlGetLocationUniform(m_integrate, "u_step");
+        m_locBounds = rlGetLocationUniform(m_integrate, "u_bounds");
+        m_locCount = rlGetLocationUniform(m_integrate, "u_count");
+        m_locParticleView = rlGetLocationUniform(m_drawParticles, "u_modelview");
+        m_locParticleProj = rlGetLocationUniform(m_drawParticles, "u_projection");
+        m_locParticleColor = rlGetLocationUniform(m_drawParticles, "u_color");
+        m_locParticleTex = rlGetLocationUniform(m_drawParticles, "texture0");
+        m_locSurfaceView = rlGetLocationUniform(m_drawSurface, "u_modelview");
+        m_locSurfaceProj = rlGetLocationUniform(m_drawSurface, "u_projection");
+        m_locSurfaceColor = rlGetLocationUniform(m_drawSurface, "u_color");
+        m_locSurfaceGeom = rlGetLocationUniform(m_drawSurface, "u_geom");
+        m_locSurfaceTex = rlGetLocationUniform(m_drawSurface, "texture0");
+
+        for (Lane& lane : m_lanes)
+        {
+            lane = Lane{};
+            lane.capacity = laneCapacity;
+            lane.ssbo = rlLoadShaderBuffer(static_cast<unsigned int>(laneCapacity * sizeof(GpuParticle)), nullptr, RL_DYNAMIC_COPY);
+        }
+        m_columns = maxColumns;
+        m_surfaceSsbo = rlLoadShaderBuffer(static_cast<unsigned int>(maxColumns * sizeof(float)), nullptr, RL_DYNAMIC_DRAW);
+        m_memoryBarrier = reinterpret_cast<MemoryBarrierFn>(glfwGetProcAddress("glMemoryBarrier"));
+        m_loaded = true;
+        return true;
+#else
+        (void)laneCapacity;
+        (void)maxColumns;
+        return false;
+#endif
+    }
+
+    void Unload()
+    {
+#if defined(SLOP_GPU_COMPUTE)
+        for (Lane& lane : m_lanes)
+        {
+            if (lane.ssbo != 0) rlUnloadShaderBuffer(lane.ssbo);
+            lane = Lane{};
+        }
+        if (m_surfaceSsbo != 0) rlUnloadShaderBuffer(m_surfaceSsbo);
+        if (m_integrate != 0) rlUnloadShaderProgram(m_integrate);
+        if (m_drawParticles != 0) rlUnloadShaderProgram(m_drawParticles);
+        if (m_drawSurface != 0) rlUnloadShaderProgram(m_drawSurface);
+        if (m_vao != 0) rlUnloadVertexArray(m_vao);
+        m_surfaceSsbo = m_integrate = m_drawParticles = m_drawSurface = m_vao = 0;
+#endif
+        m_loaded = false;
+    }
+
+    bool Loaded() const { return m_loaded; }
+
+    void SetLaneParams(int lane, const LaneParams& params) { m_lanes[static_cast<size_t>(lane)].params = params; }
+
+    // Slots written so far; dead particles keep theirs until overwritten.
+    size_t Resident(int lane) const { return m_lanes[static_cast<size_t>(lane)].used; }
+
+    // Integrates what is on the GPU by batch.elapsed, then appends the new
+    // spawns. When a lane is full the oldest particles are overwritten.
+    void Apply(const GpuSpawnQueue::Batch& batch)
+    {
+#if defined(SLOP_GPU_COMPUTE)
+        if (!m_loaded) return;
+        for (int l = 0; l < kLanes; ++l)
+        {
+            Lane& lane = m_lanes[static_cast<size_t>(l)];
+            if (batch.clear[static_cast<size_t>(l)])
+            {
+                lane.head = 0;
+                lane.used = 0;
+            }
+            if (batch.elapsed > 0.0f) Integrate(lane, std::min(batch.elapsed, kMaxElapsed));
+            Append(lane, batch.spawns[static_cast<size_t>(l)]);
+        }
+        Barrier();
+#else
+        (void)batch;
+#endif
+    }
+
+    // One draw call per lane with the particle sprite; alpha fades with life.
+    void DrawParticles(int lane, Color base, unsigned int textureId)
+    {
+#if defined(SLOP_GPU_COMPUTE)
+        const Lane& l = m_lanes[static_cast<size_t>(lane)];
+        if (!m_loaded || l.used == 0) return;
+        rlDrawRenderBatchActive();
+        rlEnableShader(m_drawParticles);
+        SetCommonUniforms(m_locParticleView, m_locParticleProj, m_locParticleColor, m_locParticleTex, base);
+        rlActiveTextureSlot(0);
+        rlEnableTexture(textureId);
+        rlBindShaderBuffer(l.ssbo, 0);
+        rlEnableVertexArray(m_vao);
+        rlDrawVertexArray(0, static_cast<int>(l.used * 6));
+        rlDisableVertexArray();
+        rlDisableTexture();
+        rlDisableShader();
+#else
+        (void)lane;
+        (void)base;
+        (void)textureId;
+#endif
+    }
+
+    // The filled water body under disp (count columns step px apart from x = x0,
+    // heights relative to baselineY) down to bottomY, then the surface line.
+    void DrawSurface(const float* disp, size_t count, float x0, float step, float baselineY, float bottomY, Color fill, Color line,
+                     float lineWidth)
+    {
+#if defined(SLOP_GPU_COMPUTE)
+        if (!m_loaded || count < 2) return;
+        count = std::min(count, m_columns);
+        rlUpdateShaderBuffer(m_surfaceSsbo, disp, static_cast<unsigned int>(count * sizeof(float)), 0);
+        rlDrawRenderBatchActive();
+        rlEnableShader(m_drawSurface);
+        rlActiveTextureSlot(0);
+        rlEnableTexture(rlGetTextureIdDefault());
+        rlBindShaderBuffer(m_surfaceSsbo, 0);
+        rlEnableVertexArray(m_vao);
+        int vertices = static_cast<int>((count - 1) * 6);
+        // u_geom: step, baseline, bottom (or -half width for a line band), first x.
+        float fillGeom[4] = {step, baselineY, bottomY, x0};
+        SetCommonUniforms(m_locSurfaceView, m_locSurfaceProj, m_locSurfaceColor, m_locSurfaceTex, fill);
+        rlSetUniform(m_locSurfaceGeom, fillGeom, RL_SHADER_UNIFORM_VEC4, 1);
+        rlDrawVertexArray(0, vertices);
+        float lineGeom[4] = {step, baselineY, -0.5f * lineWidth, x0};
+        SetCommonUniforms(m_locSurfaceView, m_locSurfaceProj, m_locSurfaceColor, m_locSurfaceTex, line);
+        rlSetUniform(m_locSurfaceGeom, lineGeom, RL_SHADER_UNIFORM_VEC4, 1);
+        rlDrawVertexArray(0, vertices);
+        rlDisableVertexArray();
+        rlDisableTexture();
+        rlDisableShader();
+#else
+        (void)disp;
+        (void)count;
+        (void)x0;
+        (void)step;
+        (void)baselineY;
+        (void)bottomY;
+        (void)fill;
+        (void)line;
+        (void)lineWidth;
+#endif
+    }
+
+private:
+    // A render hitch should not launch particles off screen in one step.
+    static constexpr float kMaxElapsed = 0.1f;
+    static constexpr unsigned int kGroupSize = 256;
+
+    struct Lane
+    {
+        unsigned int ssbo = 0;
+        size_t capacity = 0;
+        size_t head = 0; // next slot to write
+        size_t used = 0;
+        LaneParams params;
+    };
+
+#if defined(SLOP_GPU_COMPUTE)
+    // rlgl has no wrapper for it; the writes of a dispatch are only
+    // guaranteed visible to later shader reads after the barrier.
+    using MemoryBarrierFn = void (*)(unsigned int);
+    static constexpr unsigned int kShaderStorageBarrierBit = 0x00002000;
+
+    void Barrier()
+    {
+        if (m_memoryBarrier) m_memoryBarrier(kShaderStorageBarrierBit);
+    }
+
+    void Integrate(const Lane& lane, float dt)
+    {
+        if (lane.used == 0) return;
+        const LaneParams& p = lane.params;
+        float step[4] = {dt, p.gravity * dt, std::pow(p.dragX60, dt * 60.0f), std::pow(p.dragY60, dt * 60.0f)};
+        float bounds[4] = {p.minX, p.maxX, p.maxY, 0.0f};
+        int count = static_cast<int>(lane.used);
+        rlEnableShader(m_integrate);
+        rlSetUniform(m_locStep, step, RL_SHADER_UNIFORM_VEC4, 1);
+        rlSetUniform(m_locBounds, bounds, RL_SHADER_UNIFORM_VEC4, 1);
+        rlSetUniform(m_locCount, &count, RL_SHADER_UNIFORM_INT, 1);
+        rlBindShaderBuffer(lane.ssbo, 0);
+        rlComputeShaderDispatch((static_cast<unsigned int>(lane.used) + kGroupSize - 1) / kGroupSize, 1, 1);
+        rlDisableShader();
+    }
+
+    void Append(Lane& lane, const std::vector<GpuParticle>& spawns)
+    {
+        // Only the newest capacity's worth can survive anyway.
+        size_t n = std::min(spawns.size(), lane.capacity);
+        const GpuParticle* src = spawns.data() + (spawns.size() - n);
+        while (n > 0)
+        {
+            size_t run = std::min(n, lane.capacity - lane.head);
+            rlUpdateShaderBuffer(lane.ssbo, src, static_cast<unsigned int>(run * sizeof(GpuParticle)),
+                                 static_cast<unsigned int>(lane.head * sizeof(GpuParticle)));
+            src += run;
+            n -= run;
+            lane.head = (lane.head + run) % lane.capacity;
+            lane.used = std::min(lane.capacity, lane.used + run);
+        }
+    }
+
+    void SetCommonUniforms(int locView, int locProj, int locColor, int locTex, Color c)
+    {
+        float color[4] = {c.r / 255.0f, c.g / 255.0f, c.b / 255.0f, c.a / 255.0f};
+        int slot = 0;
+        rlSetUniformMatrix(locView, rlGetMatrixModelview());
+        rlSetUniformMatrix(locProj, rlGetMatrixProjection());
+        rlSetUniform(locColor, color, RL_SHADER_UNIFORM_VEC4, 1);
+        rlSetUniform(locTex, &slot, RL_SHADER_UNIFORM_SAMPLER2D, 1);
+    }
+
+    static constexpr const char* kIntegrateSource = R"(#version 430
+layout(local_size_x = 256) in;
+struct Particle { vec4 posVel; vec4 radiusLife; };
+layout(std430, binding = 0) buffer Particles { Particle p[]; };
+uniform vec4 u_step;   // dt, gravity * dt, x drag, y drag
+uniform vec4 u_bounds; // min x, max x, max y
+uniform int u_count;
+void main()
+{
+    uint i = gl_GlobalInvocationID.x;
+    if (i >= uint(u_count)) return;
+    vec4 pv = p[i].posVel;
+    vec4 rl = p[i].radiusLife;
+    if (rl.y <= 0.0) return;
+    pv.z *= u_step.z;
+    pv.w = (pv.w + u_step.y) * u_step.w;
+    pv.xy += pv.zw * u_step.x;
+    rl.y -= u_step.x;
+    if (pv.x < u_bounds.x || pv.x > u_bounds.y || pv.y > u_bounds.z) rl.y = 0.0;
+    p[i].posVel = pv;
+    p[i].radiusLife = rl;
+}
+)";
+
+    // Six vertices per particle from gl_VertexID; dead ones collapse to a point.
+    static constexpr const char* kParticleVertexSource = R"(#version 430
+struct Particle { vec4 posVel; vec4 radiusLife; };
+layout(std430, binding = 0) readonly buffer Particles { Particle p[]; };
+uniform mat4 u_modelview;
+uniform mat4 u_projection;
+uniform vec4 u_color;
+out vec2 fragTexCoord;
+out vec4 fragColor;
+const vec2 kCorner[6] = vec2[6](vec2(-1, -1), vec2(-1, 1), vec2(1, 1), vec2(-1, -1), vec2(1, 1), vec2(1, -1));
+void main()
+{
+    Particle q = p[gl_VertexID / 6];
+    vec2 c = kCorner[gl_VertexID % 6];
+    float life = clamp(q.radiusLife.y * q.radiusLife.z, 0.0, 1.0);
+    float r = life > 0.0 ? q.radiusLife.x : 0.0;
+    fragTexCoord = c * 0.5 + 0.5;
+    fragColor = vec4(u_color.rgb, u_color.a * life);
+    gl_Position = u_projection * u_modelview * vec4(q.posVel.xy + c * r, 0.0, 1.0);
+}
+)";
+
+    // Two triangles per column pair: down to u_geom.z, or a band of half
+    // width -u_geom.z around the surface when it is negative.
+    static constexpr const char* kSurfaceVertexSource = R"(#version 430
+layout(std430, binding = 0) readonly buffer Heights { float disp[]; };
+uniform mat4 u_modelview;
+uniform mat4 u_projection;
+uniform vec4 u_color;
+uniform vec4 u_geom;
+out vec2 fragTexCoord;
+out vec4 fragColor;
+const ivec2 kCorner[6] = ivec2[6](ivec2(0, 0), ivec2(0, 1), ivec2(1, 1), ivec2(0, 0), ivec2(1, 1), ivec2(1, 0));
+void main()
+{
+    int i = gl_VertexID / 6;
+    ivec2 c = kCorner[gl_VertexID % 6];
+    int column = i + c.x;
+    float x = u_geom.w + float(column) * u_geom.x;
+    float surface = u_geom.y + disp[column];
+    float y;
+    if (u_geom.z >= 0.0) y = c.y == 0 ? surface : u_geom.z;
+    else y = surface + (c.y == 0 ? u_geom.z : -u_geom.z);
+    fragTexCoord = vec2(0.5);
+    fragColor = u_color;
+    gl_Position = u_projection * u_modelview * vec4(x, y, 0.0, 1.0);
+}
+)";
+
+    static constexpr const char* kFragmentSource = R"(#version 430
+in vec2 fragTexCoord;
+in vec4 fragColor;
+uniform sampler2D texture0;
+out vec4 finalColor;
+void main()
+{
+    finalColor = texture(texture0, fragTexCoord) * fragColor;
+}
+)";
+
+    MemoryBarrierFn m_memoryBarrier = nullptr;
+#endif
+
+    std::array<Lane, kLanes> m_lanes{};
+    size_t m_columns = 0;
+    unsigned int m_surfaceSsbo = 0;
+    unsigned int m_integrate = 0;
+    unsigned int m_drawParticles = 0;
+    unsigned int m_drawSurface = 0;
+    unsigned int m_vao = 0;
+    int m_locStep = -1;
+    int m_locBounds = -1;
+    int m_locCount = -1;
+    int m_locParticleView = -1;
+    int m_locParticleProj = -1;
+    int m_locParticleColor = -1;
+    int m_locParticleTex = -1;
+    int m_locSurfaceView = -1;
+    int m_locSurfaceProj = -1;
+    int m_locSurfaceColor = -1;
+    int m_locSurfaceGeom = -1;
+    int m_locSurfaceTex = -1;
+    bool m_loaded = false;
+};
@@ -0,0 +1,79 @@
+#pragma once
+
+#include "particle_pool.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+// std430 layout of one particle: two vec4s.
+struct GpuParticle
+{
+    float x, y, vx, vy;
+    float radius, life, invMaxLife, pad;
+};
+
+// Hands freshly emitted particles from the simulation to the render thread.
+// The simulation accumulates into its CPU pools as usual and posts them every
+// publish instead of integrating them; the render thread takes everything
+// posted since its last frame. Unlike the snapshot triple buffer nothing is
+// dropped when the renderer falls behind.
+class GpuSpawnQueue
+{
+public:
+    static constexpr int kLanes = 2;
+
+    struct Batch
+    {
+        std::array<std::vector<GpuParticle>, kLanes> spawns;
+        std::array<bool, kLanes> clear{};
+        float elapsed = 0.0f; // simulated seconds since the last take
+
+        void Reset()
+        {
+            for (std::vector<GpuParticle>& s : spawns) s.clear();
+            clear.fill(false);
+            elapsed = 0.0f;
+        }
+    };
+
+    // Moves the pool's particles into lane. A Clear of the pool since the last
+    // post drops the lane on the GPU as well.
+    void Post(int lane, const ParticlePool& pool)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        std::vector<GpuParticle>& out = m_pending.spawns[static_cast<size_t>(lane)];
+        uint32_t generation = pool.Generation();
+        if (generation != m_generation[static_cast<size_t>(lane)])
+        {
+            m_generation[static_cast<size_t>(lane)] = generation;
+            m_pending.clear[static_cast<size_t>(lane)] = true;
+            out.clear();
+        }
+        for (size_t i = 0; i < pool.size(); ++i)
+        {
+            out.push_back({pool.X(i), pool.Y(i), pool.VX(i), pool.VY(i), pool.Radius(i), pool.Life(i), pool.InvMaxLife(i), 0.0f});
+        }
+    }
+
+    void AddElapsed(float dt)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_pending.elapsed += dt;
+    }
+
+    // out must have been Reset; its storage is reused for the next posts.
+    void Take(Batch& out)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        std::swap(m_pending, out);
+    }
+
+private:
+    std::mutex m_mutex;
+    Batch m_pending;
+    std::array<uint32_t, kLanes> m_generation{};
+};
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <rlgl.h>
+
+#include <array>
+#include <cstdint>
+
+// raylib's desktop platform links GLFW; the query entry points come from it
+// since raylib keeps its GL loader to itself.
+typedef void (*GLFWglproc)(void);
+extern "C" GLFWglproc glfwGetProcAddress(const char* procname);
+
+// GPU time of a stretch of frame, from GL_TIME_ELAPSED queries (core since
+// OpenGL 3.3). A result is only read once the GPU has it, a frame or two
+// later, so timing never stalls the pipeline; with every query still in
+// flight a frame simply goes untimed. Init fails on older contexts.
+class GpuFrameTimer
+{
+public:
+    static constexpr int kQueries = 4;
+
+    bool Init()
+    {
+        if (m_loaded) return true;
+        int version = rlGetVersion();
+        if (version != RL_OPENGL_33 && version != RL_OPENGL_43) return false;
+        m_gen = reinterpret_cast<GenQueriesFn>(glfwGetProcAddress("glGenQueries"));
+        m_delete = reinterpret_cast<DeleteQueriesFn>(glfwGetProcAddress("glDeleteQueries"));
+        m_begin = reinterpret_cast<BeginQueryFn>(glfwGetProcAddress("glBeginQuery"));
+        m_end = reinterpret_cast<EndQueryFn>(glfwGetProcAddress("glEndQuery"));
+        m_getInt = reinterpret_cast<GetQueryObjectivFn>(glfwGetProcAddress("glGetQueryObjectiv"));
+        m_getU64 = reinterpret_cast<GetQueryObjectui64vFn>(glfwGetProcAddress("glGetQueryObjectui64v"));
+        if (!m_gen || !m_delete || !m_begin || !m_end || !m_getInt || !m_getU64) return false;
+        m_gen(kQueries, m_queries.data());
+        m_pending.fill(false);
+        m_next = 0;
+        m_lastMs = -1.0f;
+        m_loaded = true;
+        return true;
+    }
+
+    void Unload()
+    {
+        if (m_loaded) m_delete(kQueries, m_queries.data());
+        m_loaded = false;
+        m_timing = false;
+    }
+
+    bool Loaded() const { return m_loaded; }
+
+    // Collects finished results, then starts timing unless the next query is
+    // still in flight. Pair with End in the same frame; the two do not nest.
+    void Begin()
+    {
+        if (!m_loaded || m_timing) return;
+        Collect();
+        if (m_pending[static_cast<size_t>(m_next)]) return;
+        m_begin(kTimeElapsed, m_queries[static_cast<size_t>(m_next)]);
+        m_timing = true;
+    }
+
+    // rlgl batches draws; flush it first so they are inside the query.
+    void End()
+    {
+        if (!m_timing) return;
+        rlDrawRenderBatchActive();
+        m_end(kTimeElapsed);
+        m_pending[static_cast<size_t>(m_next)] = true;
+        m_next = (m_next + 1) % kQueries;
+        m_timing = false;
+    }
+
+    // The latest finished measurement in ms; negative until there is one.
+    float LastMs() const { return m_lastMs; }
+
+private:
+    static constexpr unsigned int kTimeElapsed = 0x88BF;
+    static constexpr unsigned int kQueryResult = 0x8866;
+    static constexpr unsigned int kQueryResultAvailable = 0x8867;
+
+    using GenQueriesFn = void (*)(int, unsigned int*);
+    using DeleteQueriesFn = void (*)(int, const unsigned int*);
+    using BeginQueryFn = void (*)(unsigned int, unsigned int);
+    using EndQueryFn = void (*)(unsigned int);
+    using GetQueryObjectivFn = void (*)(unsigned int, unsigned int, int*);
+    using GetQueryObjectui64vFn = void (*)(unsigned int, unsigned int, uint64_t*);
+
+    // Oldest first, stopping at the first one the GPU has not finished.
+    void Collect()
+    {
+        for (int i = 0; i < kQueries; ++i)
+        {
+            auto slot = static_cast<size_t>((m_next + i) % kQueries);
+            if (!m_pending[slot]) continue;
+            int available = 0;
+            m_getInt(m_queries[slot], kQueryResultAvailable, &available);
+            if (!available) return;
+            uint64_t ns = 0;
+            m_getU64(m_queries[slot], kQueryResult, &ns);
+            m_lastMs = static_cast<float>(static_cast<double>(ns) * 1e-6);
+            m_pending[slot] = false;
+        }
+    }
+
+    GenQueriesFn m_gen = nullptr;
+    DeleteQueriesFn m_delete = nullptr;
+    BeginQueryFn m_begin = nullptr;
+    EndQueryFn m_end = nullptr;
+    GetQueryObjectivFn m_getInt = nullptr;
+    GetQueryObjectui64vFn m_getU64 = nullptr;
+    std::array<unsigned int, kQueries> m_queries{};
+    std::array<bool, kQueries> m_pending{};
+    int m_next = 0;
+    bool m_timing = false;
+    bool m_loaded = false;
+    float m_lastMs = -1.0f;
+};
@@ -0,0 +1,299 @@
+// SlopMicrobench: Google Benchmark timings of single sandbox hot paths, for
+// measuring an optimization of one of them on its own. The sandbox is built
+// headless and never stepped unless a benchmark says so.
+//   SlopMicrobench --benchmark_out=new.json --benchmark_out_format=json
+//   tools/compare_microbench.py old.json new.json
+
+#include "slop_sandbox.h"
+
+#include <benchmark/benchmark.h>
+
+#include <cmath>
+#include <memory>
+#include <vector>
+
+// Access to SlopSandbox's private members; it is a friend.
+struct SandboxProbe
+{
+    static void SetWaveStep(SlopSandbox& app, float stepPx)
+    {
+        app.m_waveStep = stepPx;
+        app.InitWave();
+    }
+
+    // Every column moving, so the spring and spread passes do real work.
+    static void DisturbWave(SlopSandbox& app)
+    {
+        for (size_t i = 0; i < app.m_waveDisp.size(); ++i)
+        {
+            app.m_waveDisp[i] = 6.0f * std::sin(static_cast<float>(i) * 0.37f);
+            app.m_waveVel[i] = 2.0f * std::cos(static_cast<float>(i) * 0.11f);
+        }
+    }
+
+    static void UpdateWave(SlopSandbox& app) { app.UpdateWave(SlopSandbox::kFixedDt); }
+    static size_t WaveColumns(const SlopSandbox& app) { return app.m_waveDisp.size(); }
+    static float WaterHeightAt(const SlopSandbox& app, float xPx) { return app.WaterHeightAt(xPx); }
+    static std::optional<size_t> PickBody(SlopSandbox& app, Vector2 px) { return app.PickBody(px); }
+    static void SelectByRect(SlopSandbox& app, const Rectangle& rect) { app.SelectByRect(rect); }
+    static size_t LinkedCount(SlopSandbox& app, size_t idx) { return app.BodiesLinkedTo(idx).size(); }
+    static void ApplyBodySurface(SlopSandbox& app, size_t idx) { app.ApplyBodySurface(idx); }
+    static float MeasureTextUi(const SlopSandbox& app, TextId id, float size) { return app.MeasureTextUi(id, size); }
+
+    // Swaps in pools big enough for the run; the originals hold a few thousand.
+    static ParticlePool& Shards(SlopSandbox& app, size_t capacity)
+    {
+        app.m_shards = ParticlePool(capacity);
+        return app.m_shards;
+    }
+
+    static ParticlePool& WaterChunks(SlopSandbox& app, size_t capacity)
+    {
+        app.m_waterChunks = ParticlePool(capacity);
+        return app.m_waterChunks;
+    }
+
+    static void UpdateShards(SlopSandbox& app) { app.UpdateShards(SlopSandbox::kFixedDt); }
+    static void UpdateWaterChunks(SlopSandbox& app) { app.UpdateWaterChunks(SlopSandbox::kFixedDt); }
+    static void BuildParticleGrids(SlopSandbox& app) { app.BuildParticleGrids(); }
+};
+
+namespace
+{
+
+constexpr int kWidth = 1536;
+constexpr int kHeight = 960;
+constexpr float kPackedBoxPx = 8.0f;
+constexpr float kPackedPitchPx = 10.0f;
+
+std::unique_ptr<SlopSandbox> MakeSandbox()
+{
+    SetRandomSeed(1234);
+    auto app = std::make_unique<SlopSandbox>(kWidth, kHeight, 1);
+    app->SetPhysicsThreadEnabled(false);
+    return app;
+}
+
+// count small boxes in rows above the ground, 125 to a row so 10k still fit.
+void SpawnPacked(SlopSandbox& app, int count)
+{
+    const float h = kPackedBoxPx * 0.5f;
+    const std::vector<Vector2> box = {{-h, -h}, {h, -h}, {h, h}, {-h, h}};
+    const int cols = std::min(count, 125);
+    float top = app.GroundTopPx();
+    for (int i = 0; i < count; ++i)
+    {
+        float x = 100.0f + static_cast<float>(i % cols) * kPackedPitchPx;
+        float y = top - h - 2.0f - static_cast<float>(i / cols) * kPackedPitchPx;
+        app.ScriptSpawnPolygon({x, y}, box);
+    }
+}
+
+// Points spread over the packed block, cycled through by the query loops.
+std::vector<Vector2> QueryPoints(const SlopSandbox& app, int count)
+{
+    const int cols = std::min(count, 125);
+    int rows = (count + cols - 1) / cols;
+    float top = app.GroundTopPx();
+    SimRandom rng(99);
+    std::vector<Vector2> points(1024);
+    for (Vector2& p : points)
+    {
+        p.x = 100.0f + static_cast<float>(rng.Range(0, cols * 10 - 1)) * kPackedPitchPx * 0.1f;
+        p.y = top - static_cast<float>(rng.Range(0, rows * 10 - 1)) * kPackedPitchPx * 0.1f;
+    }
+    return points;
+}
+
+void BM_UpdateWave(benchmark::State& state)
+{
+    auto app = MakeSandbox();
+    app->SetSceneLocation(SceneLocation::Water);
+    SandboxProbe::SetWaveStep(*app, static_cast<float>(state.range(0)));
+    SandboxProbe::DisturbWave(*app);
+    for (auto _ : state) SandboxProbe::UpdateWave(*app);
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(SandboxProbe::WaveColumns(*app)));
+}
+BENCHMARK(BM_UpdateWave)->ArgName("stepPx")->Arg(2)->Arg(4)->Arg(8)->Arg(16);
+
+void BM_WaterHeightAt(benchmark::State& state)
+{
+    auto app = MakeSandbox();
+    app->SetSceneLocation(SceneLocation::Water);
+    SandboxProbe::DisturbWave(*app);
+    std::vector<float> xs(1024);
+    SimRandom rng(7);
+    for (float& x : xs) x = static_cast<float>(rng.Range(0, kWidth * 4)) * 0.25f;
+    for (auto _ : state)
+    {
+        float sum = 0.0f;
+        for (float x : xs) sum += SandboxProbe::WaterHeightAt(*app, x);
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(xs.size()));
+}
+BENCHMARK(BM_WaterHeightAt);
+
+void BM_PickBody(benchmark::State& state)
+{
+    auto app = MakeSandbox();
+    int count = static_cast<int>(state.range(0));
+    SpawnPacked(*app, count);
+    std::vector<Vector2> points = QueryPoints(*app, count);
+    size_t i = 0;
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(SandboxProbe::PickBody(*app, points[i]));
+        i = (i + 1) % points.size();
+    }
+}
+BENCHMARK(BM_PickBody)->ArgName("bodies")->Arg(100)->Arg(1000)->Arg(10000);
+
+// A 60x40 px box, so a few dozen bodies per query whatever the total.
+void BM_SelectByRect(benchmark::State& state)
+{
+    auto app = MakeSandbox();
+    int count = static_cast<int>(state.range(0));
+    SpawnPacked(*app, count);
+    std::vector<Vector2> points = QueryPoints(*app, count);
+    size_t i = 0;
+    for (auto _ : state)
+    {
+        SandboxProbe::SelectByRect(*app, {points[i].x - 30.0f, points[i].y - 20.0f, 60.0f, 40.0f});
+        i = (i + 1) % points.size();
+    }
+}
+BENCHMARK(BM_SelectByRect)->ArgName("bodies")->Arg(100)->Arg(1000)->Arg(10000);
+
+// One chain of welded boxes, walked from its first link.
+void BM_BodiesLinkedTo(benchmark::State& state)
+{
+    auto app = MakeSandbox();
+    int length = static_cast<int>(state.range(0));
+    SpawnPacked(*app, length);
+    for (int i = 1; i < length; ++i)
+    {
+        b2Vec2 a = b2Body_GetPosition(app->BodyIdAt(static_cast<size_t>(i - 1)));
+        b2Vec2 b = b2Body_GetPosition(app->BodyIdAt(static_cast<size_t>(i)));
+        app->ScriptWeld(static_cast<size_t>(i - 1), static_cast<size_t>(i), {(a.x + b.x) * 0.5f * kPixelsPerMeter, (a.y + b.y) * 0.5f * kPixelsPerMeter});
+    }
+    for (auto _ : state) benchmark::DoNotOptimize(SandboxProbe::LinkedCount(*app, 0));
+    state.SetItemsProcessed(state.iterations() * length);
+}
+BENCHMARK(BM_BodiesLinkedTo)->ArgName("chain")->Arg(16)->Arg(256)->Arg(4096);
+
+// Particles that stay alive and on screen; topped up (untimed) if a cull
+// takes any.
+template <bool Water>
+void BM_UpdateParticles(benchmark::State& state)
+{
+    auto app = MakeSandbox();
+    if (Water) app->SetSceneLocation(SceneLocation::Water);
+    size_t count = static_cast<size_t>(state.range(0));
+    ParticlePool& pool = Water ? SandboxProbe::WaterChunks(*app, count) : SandboxProbe::Shards(*app, count);
+    SimRandom rng(5);
+    auto refill = [&]() {
+        pool.Clear();
+        for (size_t i = 0; i < count; ++i)
+        {
+            float x = static_cast<float>(rng.Range(100, kWidth - 100));
+            float y = static_cast<float>(rng.Range(100, kHeight / 2));
+            pool.Emit(x, y, static_cast<float>(rng.Range(-50, 50)), static_cast<float>(rng.Range(-200, 0)), 2.0f, 1e6f);
+        }
+    };
+    refill();
+    int steps = 0;
+    for (auto _ : state)
+    {
+        if (Water) SandboxProbe::UpdateWaterChunks(*app);
+        else SandboxProbe::UpdateShards(*app);
+        // About half a second of fall, well before anything leaves the screen.
+        if (++steps == 30 || pool.size() < count)
+        {
+            state.PauseTiming();
+            refill();
+            steps = 0;
+            state.ResumeTiming();
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(count));
+}
+BENCHMARK_TEMPLATE(BM_UpdateParticles, false)->Name("BM_UpdateShards")->ArgName("particles")->Arg(10000)->Arg(100000);
+BENCHMARK_TEMPLATE(BM_UpdateParticles, true)->Name("BM_UpdateWaterChunks")->ArgName("particles")->Arg(10000)->Arg(100000);
+
+// Shards raining onto a packed block of awake bodies: the grid rebuild plus
+// the integrate and collide pass, per frame.
+void BM_CollideShards(benchmark::State& state)
+{
+    auto app = MakeSandbox();
+    int bodies = static_cast<int>(state.range(0));
+    SpawnPacked(*app, bodies);
+    app->StepHeadless(SlopSandbox::FixedDt());
+    const size_t count = 20000;
+    ParticlePool& pool = SandboxProbe::Shards(*app, count);
+    int rows = (bodies + 124) / 125;
+    float top = app->GroundTopPx() - static_cast<float>(rows) * kPackedPitchPx;
+    SimRandom rng(7);
+    auto refill = [&]() {
+        pool.Clear();
+        for (size_t i = 0; i < count; ++i)
+        {
+            float x = 100.0f + static_cast<float>(rng.Range(0, 1250));
+            float y = top - static_cast<float>(rng.Range(0, 200));
+            pool.Emit(x, y, static_cast<float>(rng.Range(-50, 50)), static_cast<float>(rng.Range(0, 300)), 2.0f, 1e6f);
+        }
+    };
+    refill();
+    int steps = 0;
+    for (auto _ : state)
+    {
+        SandboxProbe::BuildParticleGrids(*app);
+        SandboxProbe::UpdateShards(*app);
+        if (++steps == 30)
+        {
+            state.PauseTiming();
+            refill();
+            steps = 0;
+            state.ResumeTiming();
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(count));
+}
+BENCHMARK(BM_CollideShards)->ArgName("bodies")->Arg(1000)->Arg(10000);
+
+// Every UI string at the panel's sizes, all from the width cache after the
+// first pass. Without a window raylib measures with its default font.
+void BM_MeasureTextUiCached(benchmark::State& state)
+{
+    auto app = MakeSandbox();
+    const float sizes[] = {14.0f, 16.0f, 20.0f};
+    auto measureAll = [&]() {
+        float sum = 0.0f;
+        for (size_t t = 0; t < ui_text::kTextCount; ++t)
+        {
+            for (float s : sizes) sum += SandboxProbe::MeasureTextUi(*app, static_cast<TextId>(t), s);
+        }
+        return sum;
+    };
+    measureAll();
+    for (auto _ : state) benchmark::DoNotOptimize(measureAll());
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(ui_text::kTextCount * 3));
+}
+BENCHMARK(BM_MeasureTextUiCached);
+
+void BM_ApplyBodySurface(benchmark::State& state)
+{
+    auto app = MakeSandbox();
+    SpawnPacked(*app, 1000);
+    size_t i = 0;
+    for (auto _ : state)
+    {
+        SandboxProbe::ApplyBodySurface(*app, i);
+        i = (i + 1) % 1000;
+    }
+}
+BENCHMARK(BM_ApplyBodySurface);
+
+} // namespace
+
+BENCHMARK_MAIN();
@@ -0,0 +1,330 @@
+#pragma once
+
+#include "net_stream.h"
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#if !defined(_WIN32)
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+// Non-blocking TCP transport for the netstream messages. Nothing here ever
+// waits: reads take what the socket has, writes queue and go out as the
+// socket drains. TCP keeps frames in order, which the deltas rely on. POSIX
+// only; Windows builds compile but Listen and Connect fail (as telemetry.h).
+namespace netstream
+{
+
+class Connection
+{
+public:
+    Connection() = default;
+    explicit Connection(int fd) : m_fd(fd) {}
+    Connection(const Connection&) = delete;
+    Connection& operator=(const Connection&) = delete;
+    ~Connection() { Close(); }
+
+    bool Open() const { return m_fd >= 0; }
+
+    // Takes over a connected socket, closing the one held before.
+    void Adopt(int fd)
+    {
+        Close();
+        m_fd = fd;
+    }
+
+    void Close()
+    {
+#if !defined(_WIN32)
+        if (m_fd >= 0) ::close(m_fd);
+#endif
+        m_fd = -1;
+        m_in.clear();
+        m_read = 0;
+        m_out.clear();
+        m_sent = 0;
+    }
+
+    // Queues whole messages; kept until the socket takes them.
+    void Queue(const std::vector<uint8_t>& bytes) { m_out.insert(m_out.end(), bytes.begin(), bytes.end()); }
+    size_t Pending() const { return m_out.size() - m_sent; }
+
+    // Writes what the socket takes and reads what it has. False once the
+    // peer is gone or sent something that is not a message.
+    bool Pump()
+    {
+#if defined(_WIN32)
+        return false;
+#else
+        if (m_fd < 0) return false;
+        while (m_sent < m_out.size())
+        {
+            ssize_t n = ::send(m_fd, m_out.data() + m_sent, m_out.size() - m_sent, kSendFlags);
+            if (n > 0)
+            {
+                m_sent += static_cast<size_t>(n);
+                continue;
+            }
+            if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+            if (n < 0 && errno == EINTR) continue;
+            return false;
+        }
+        if (m_sent == m_out.size())
+        {
+            m_out.clear();
+            m_sent = 0;
+        }
+        uint8_t buf[16384];
+        for (;;)
+        {
+            ssize_t n = ::recv(m_fd, buf, sizeof(buf), 0);
+            if (n > 0)
+            {
+                m_in.insert(m_in.end(), buf, buf + n);
+                continue;
+            }
+            if (n == 0) return false;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+            if (errno == EINTR) continue;
+            return false;
+        }
+        return HeaderValid();
+#endif
+    }
+
+    // The next complete message received; its payload stays valid until the
+    // next call.
+    bool NextMessage(MessageType& type, const uint8_t*& payload, size_t& size)
+    {
+        if (m_read > 0)
+        {
+            m_in.erase(m_in.begin(), m_in.begin() + static_cast<std::ptrdiff_t>(m_read));
+            m_read = 0;
+        }
+        if (m_in.size() < kHeaderBytes || !HeaderValid()) return false;
+        uint32_t length = 0;
+        for (int i = 0; i < 4; ++i) length |= uint32_t{m_in[static_cast<size_t>(i)]} << (8 * i);
+        if (m_in.size() < kHeaderBytes + length) return false;
+        type = static_cast<MessageType>(m_in[4]);
+        payload = m_in.data() + kHeaderBytes;
+        size = length;
+        m_read = kHeaderBytes + length;
+        return true;
+    }
+
+private:
+#if defined(MSG_NOSIGNAL)
+    static constexpr int kSendFlags = MSG_NOSIGNAL;
+#else
+    static constexpr int kSendFlags = 0; // SO_NOSIGPIPE is set instead
+#endif
+
+    bool HeaderValid() const
+    {
+        if (m_in.size() - m_read < kHeaderBytes) return true;
+        const uint8_t* h = m_in.data() + m_read;
+        uint32_t length = 0;
+        for (int i = 0; i < 4; ++i) length |= uint32_t{h[i]} << (8 * i);
+        return length <= kMaxMessageBytes && h[4] >= static_cast<uint8_t>(MessageType::Hello) && h[4] <= static_cast<uint8_t>(MessageType::Command);
+    }
+
+    int m_fd = -1;
+    std::vector<uint8_t> m_in;
+    size_t m_read = 0; // consumed by the last NextMessage
+    std::vector<uint8_t> m_out;
+    size_t m_sent = 0;
+};
+
+#if !defined(_WIN32)
+inline void ConfigureSocket(int fd)
+{
+    ::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+    int one = 1;
+    ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+#if defined(SO_NOSIGPIPE)
+    ::setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &one, sizeof(one));
+#endif
+}
+#endif
+
+// Accepts viewers and fans frames out to them. A viewer whose queue grows
+// past kMaxPendingBytes stops getting frames until it has drained, then gets
+// a keyframe, so a slow link costs its own viewer smoothness and never the
+// server memory or the other viewers their frames.
+class StreamServer
+{
+public:
+    static constexpr size_t kMaxPendingBytes = 4u << 20;
+
+    StreamServer() = default;
+    StreamServer(const StreamServer&) = delete;
+    StreamServer& operator=(const StreamServer&) = delete;
+    ~StreamServer() { Close(); }
+
+    bool Listen(uint16_t port)
+    {
+        Close();
+#if defined(_WIN32)
+        (void)port;
+        return false;
+#else
+        int fd = ::socket(AF_INET6, SOCK_STREAM, 0);
+        if (fd < 0) return false;
+        int one = 1;
+        int zero = 0;
+        ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        ::setsockopt(fd, IPPROTO_IPV6, IPV6_V6ONLY, &zero, sizeof(zero));
+        sockaddr_in6 addr{};
+        addr.sin6_family = AF_INET6;
+        addr.sin6_addr = in6addr_any;
+        addr.sin6_port = htons(port);
+        if (::bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 || ::listen(fd, 16) != 0)
+        {
+            ::close(fd);
+            return false;
+        }
+        ::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+        m_listen = fd;
+        return true;
+#endif
+    }
+
+    void Close()
+    {
+#if !defined(_WIN32)
+        if (m_listen >= 0) ::close(m_listen);
+#endif
+        m_listen = -1;
+        m_viewers.clear();
+    }
+
+    // Accepts, sends and receives. hello is queued to each new viewer;
+    // onMessage(type, payload, size) sees what viewers sent.
+    template <typename Fn>
+    void Poll(const std::vector<uint8_t>& hello, Fn&& onMessage)
+    {
+#if !defined(_WIN32)
+        for (int fd; m_listen >= 0 && (fd = ::accept(m_listen, nullptr, nullptr)) >= 0;)
+        {
+            ConfigureSocket(fd);
+            auto viewer = std::make_unique<Viewer>(fd);
+            viewer->connection.Queue(hello);
+            m_viewers.push_back(std::move(viewer));
+        }
+#endif
+        for (size_t i = 0; i < m_viewers.size();)
+        {
+            Connection& c = m_viewers[i]->connection;
+            bool alive = c.Pump();
+            MessageType type;
+            const uint8_t* payload = nullptr;
+            size_t size = 0;
+            while (alive && c.NextMessage(type, payload, size)) onMessage(type, payload, size);
+            if (alive)
+            {
+                ++i;
+                continue;
+            }
+            m_viewers[i] = std::move(m_viewers.back());
+            m_viewers.pop_back();
+        }
+    }
+
+    // frame is this frame's delta; keyframe(ByteWriter&) writes a full one,
+    // asked for only when some viewer needs it, and at most once.
+    template <typename Fn>
+    void Broadcast(const std::vector<uint8_t>& frame, Fn&& keyframe)
+    {
+        bool built = false;
+        for (std::unique_ptr<Viewer>& v : m_viewers)
+        {
+            if (v->connection.Pending() > kMaxPendingBytes)
+            {
+                if (v->synced) ++m_resyncs;
+                v->synced = false;
+                continue;
+            }
+            if (!v->synced)
+            {
+                if (v->connection.Pending() > 0) continue;
+                if (!built)
+                {
+                    m_keyframe.Clear();
+                    keyframe(m_keyframe);
+                    built = true;
+                }
+                v->connection.Queue(m_keyframe.Bytes());
+                m_bytesQueued += m_keyframe.Size();
+                v->synced = true;
+                continue;
+            }
+            v->connection.Queue(frame);
+            m_bytesQueued += frame.size();
+        }
+    }
+
+    size_t ViewerCount() const { return m_viewers.size(); }
+    uint64_t BytesQueued() const { return m_bytesQueued; }
+    uint64_t Resyncs() const { return m_resyncs; }
+
+private:
+    struct Viewer
+    {
+        explicit Viewer(int fd) : connection(fd) {}
+        Connection connection;
+        bool synced = false; // has had a keyframe and every frame since
+    };
+
+    int m_listen = -1;
+    std::vector<std::unique_ptr<Viewer>> m_viewers;
+    ByteWriter m_keyframe;
+    uint64_t m_bytesQueued = 0;
+    uint64_t m_resyncs = 0;
+};
+
+// Blocking connect, then non-blocking like the server's side.
+inline bool ConnectTo(Connection& out, const std::string& host, uint16_t port)
+{
+#if defined(_WIN32)
+    (void)out;
+    (void)host;
+    (void)port;
+    return false;
+#else
+    addrinfo hints{};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo* found = nullptr;
+    std::string service = std::to_string(port);
+    if (::getaddrinfo(host.c_str(), service.c_str(), &hints, &found) != 0) return false;
+    int fd = -1;
+    for (addrinfo* a = found; a && fd < 0; a = a->ai_next)
+    {
+        fd = ::socket(a->ai_family, a->ai_socktype, a->ai_protocol);
+        if (fd >= 0 && ::connect(fd, a->ai_addr, a->ai_addrlen) != 0)
+        {
+            ::close(fd);
+            fd = -1;
+        }
+    }
+    ::freeaddrinfo(found);
+    if (fd < 0) return false;
+    ConfigureSocket(fd);
+    out.Adopt(fd);
+    return true;
+#endif
+}
+
+} // namespace netstream
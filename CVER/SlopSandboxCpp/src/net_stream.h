@@ -0,0 +1,659 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <unordered_map>
+#include <vector>
+
+// Wire format of the simulation stream (SlopServer to its viewers). Every
+// message is a u32 payload length, a u8 MessageType and the payload; scalars
+// are little endian, counts and ids varints. A frame is a delta against the
+// one before it on the same connection:
+//
+//   varint serial, u8 FrameFlags
+//   [kFrameWorld]  f32 world width, f32 ground top, u8 location,
+//                  f32 wave step, f32 wave baseline, varint water columns
+//   varint shapes,     each varint id, u8 n, n x (f32 x, f32 y)
+//   varint removals,   each varint net id
+//   varint identities, each varint net id, u8 kind, u8 flags, varint shape,
+//                      varint radius
+//   varint moves,      each varint net id, zigzag dx, dy, dangle
+//   varint water runs, each varint skip, varint n, n x zigzag dheight
+//
+// Bodies go by small net ids instead of their 64-bit keys; an id is only
+// reused a frame after its removal went out. Positions, radii and heights
+// are in 1/kUnitsPerPx px, angles in 1/65536 turn with the delta wrapping.
+// A keyframe is the same thing taken against an empty world, so joining or
+// falling behind costs one frame the size of the world and nothing else does.
+namespace netstream
+{
+
+inline constexpr uint32_t kVersion = 1;
+inline constexpr uint16_t kDefaultPort = 7420;
+inline constexpr float kUnitsPerPx = 16.0f;
+// Beyond this a message is treated as garbage and the connection dropped.
+inline constexpr uint32_t kMaxMessageBytes = 64u << 20;
+inline constexpr size_t kHeaderBytes = 5;
+
+enum class MessageType : uint8_t
+{
+    Hello = 1,   // server: u32 version, f32 fixed dt, u16 frames per second
+    Frame = 2,   // server: see above
+    Command = 3, // viewer: one SimCommand (EncodeCommand in slop_sandbox.h)
+};
+
+enum FrameFlags : uint8_t
+{
+    kFrameKeyframe = 1u << 0, // start from an empty world
+    kFrameWorld = 1u << 1,
+};
+
+class ByteWriter
+{
+public:
+    void Clear() { m_bytes.clear(); }
+    bool Empty() const { return m_bytes.empty(); }
+    size_t Size() const { return m_bytes.size(); }
+    const std::vector<uint8_t>& Bytes() const { return m_bytes; }
+
+    void U8(uint8_t v) { m_bytes.push_back(v); }
+
+    void U16(uint16_t v)
+    {
+        U8(static_cast<uint8_t>(v));
+        U8(static_cast<uint8_t>(v >> 8));
+    }
+
+    void U32(uint32_t v)
+    {
+        for (int i = 0; i < 4; ++i) U8(static_cast<uint8_t>(v >> (8 * i)));
+    }
+
+    void F32(float v)
+    {
+        uint32_t bits;
+        std::memcpy(&bits, &v, sizeof(bits));
+        U32(bits);
+    }
+
+    void Varint(uint64_t v)
+    {
+        while (v >= 0x80)
+        {
+            U8(static_cast<uint8_t>(v | 0x80));
+            v >>= 7;
+        }
+        U8(static_cast<uint8_t>(v));
+    }
+
+    void Zigzag(int64_t v) { Varint((static_cast<uint64_t>(v) << 1) ^ static_cast<uint64_t>(v >> 63)); }
+
+    void Append(const ByteWriter& other) { m_bytes.insert(m_bytes.end(), other.m_bytes.begin(), other.m_bytes.end()); }
+
+    // Message framing: BeginMessage, the payload, EndMessage.
+    size_t BeginMessage(MessageType type)
+    {
+        size_t at = m_bytes.size();
+        U32(0);
+        U8(static_cast<uint8_t>(type));
+        return at;
+    }
+
+    void EndMessage(size_t at)
+    {
+        auto length = static_cast<uint32_t>(m_bytes.size() - at - kHeaderBytes);
+        for (int i = 0; i < 4; ++i) m_bytes[at + static_cast<size_t>(i)] = static_cast<uint8_t>(length >> (8 * i));
+    }
+
+private:
+    std::vector<uint8_t> m_bytes;
+};
+
+// Bounds-checked; once a read runs past the end every later one fails too.
+class ByteReader
+{
+public:
+    ByteReader(const uint8_t* data, size_t size) : m_data(data), m_size(size) {}
+
+    bool Ok() const { return m_ok; }
+    bool AtEnd() const { return m_at == m_size; }
+
+    bool U8(uint8_t& v)
+    {
+        if (!m_ok || m_at >= m_size) return m_ok = false;
+        v = m_data[m_at++];
+        return true;
+    }
+
+    bool U16(uint16_t& v)
+    {
+        uint8_t lo = 0, hi = 0;
+        if (!U8(lo) || !U8(hi)) return false;
+        v = static_cast<uint16_t>(lo | (hi << 8));
+        return true;
+    }
+
+    bool U32(uint32_t& v)
+    {
+        v = 0;
+        for (int i = 0; i < 4; ++i)
+        {
+            uint8_t b = 0;
+            if (!U8(b)) return false;
+            v |= uint32_t{b} << (8 * i);
+        }
+        return true;
+    }
+
+    bool F32(float& v)
+    {
+        uint32_t bits = 0;
+        if (!U32(bits)) return false;
+        std::memcpy(&v, &bits, sizeof(v));
+        return std::isfinite(v) || (m_ok = false);
+    }
+
+    bool Varint(uint64_t& v)
+    {
+        v = 0;
+        for (int shift = 0; shift < 64; shift += 7)
+        {
+            uint8_t b = 0;
+            if (!U8(b)) return false;
+            v |= uint64_t{b & 0x7fu} << shift;
+            if ((b & 0x80) == 0) return true;
+        }
+        return m_ok = false;
+    }
+
+    // A varint that must stay below limit, e.g. a count.
+    bool Count(uint32_t& v, uint32_t limit)
+    {
+        uint64_t raw = 0;
+        if (!Varint(raw) || raw >= limit) return m_ok = false;
+        v = static_cast<uint32_t>(raw);
+        return true;
+    }
+
+    bool Zigzag(int64_t& v)
+    {
+        uint64_t raw = 0;
+        if (!Varint(raw)) return false;
+        v = static_cast<int64_t>(raw >> 1) ^ -static_cast<int64_t>(raw & 1);
+        return true;
+    }
+
+private:
+    const uint8_t* m_data;
+    size_t m_size;
+    size_t m_at = 0;
+    bool m_ok = true;
+};
+
+inline int32_t Quantize(float px) { return static_cast<int32_t>(std::lround(std::clamp(px * kUnitsPerPx, -2.0e9f, 2.0e9f))); }
+inline float Dequantize(int32_t q) { return static_cast<float>(q) / kUnitsPerPx; }
+
+inline uint16_t QuantizeAngle(float c, float s)
+{
+    constexpr float kTurn = 65536.0f / 6.28318530718f;
+    return static_cast<uint16_t>(static_cast<int32_t>(std::lround(std::atan2(s, c) * kTurn)) & 0xffff);
+}
+
+struct WorldInfo
+{
+    float width = 0.0f;
+    float groundTop = 0.0f;
+    uint8_t location = 0;
+    float waveStep = 0.0f;
+    float waveBaseline = 0.0f;
+
+    bool operator==(const WorldInfo& o) const
+    {
+        return width == o.width && groundTop == o.groundTop && location == o.location && waveStep == o.waveStep && waveBaseline == o.waveBaseline;
+    }
+};
+
+// Server side: remembers what the stream last said about every body, so a
+// frame carries only what changed since. Fed per frame by the simulation
+// (SandboxCore::EncodeStreamFrame): the bodies that moved, every body when
+// the scene was edited, and the wave heights.
+class FrameEncoder
+{
+public:
+    struct Stats
+    {
+        uint32_t shapes = 0;
+        uint32_t removals = 0;
+        uint32_t identities = 0;
+        uint32_t moves = 0;
+        uint32_t waterColumns = 0;
+        size_t bytes = 0;
+    };
+
+    void Begin(uint64_t serial)
+    {
+        m_serial = serial;
+        m_worldChanged = false;
+        m_shapeSec.Clear();
+        m_removeSec.Clear();
+        m_identitySec.Clear();
+        m_moveSec.Clear();
+        m_waterSec.Clear();
+        m_stats = Stats{};
+        m_waterRuns = 0;
+        m_ids.insert(m_ids.end(), m_releasedIds.begin(), m_releasedIds.end());
+        m_releasedIds.clear();
+    }
+
+    void World(const WorldInfo& world)
+    {
+        if (world == m_world) return;
+        m_world = world;
+        m_worldChanged = true;
+    }
+
+    bool NeedsShape(uint32_t id) const { return id != 0 && m_shapes.find(id) == m_shapes.end(); }
+
+    // xy: count x, y pairs in the body's frame.
+    void AddShape(uint32_t id, const float* xy, uint32_t count)
+    {
+        if (!NeedsShape(id)) return;
+        std::vector<float>& outline = m_shapes[id];
+        outline.assign(xy, xy + 2 * count);
+        WriteShape(m_shapeSec, id, outline);
+        ++m_stats.shapes;
+    }
+
+    // Identity for every body, then EndIdentityPass; bodies left out were removed.
+    void BeginIdentityPass() { ++m_pass; }
+
+    void Identity(uint64_t key, uint8_t kind, uint8_t flags, uint32_t shape, float radiusPx, float x, float y, float c, float s)
+    {
+        auto [it, added] = m_sent.try_emplace(key);
+        Sent& sent = it->second;
+        sent.pass = m_pass;
+        auto radius = static_cast<uint32_t>(std::max(0, Quantize(radiusPx)));
+        if (added) sent.netId = TakeId();
+        if (added || sent.kind != kind || sent.flags != flags || sent.shape != shape || sent.radius != radius)
+        {
+            sent.kind = kind;
+            sent.flags = flags;
+            sent.shape = shape;
+            sent.radius = radius;
+            WriteIdentity(m_identitySec, sent);
+            ++m_stats.identities;
+        }
+        MoveSent(sent, x, y, c, s);
+    }
+
+    void EndIdentityPass()
+    {
+        for (auto it = m_sent.begin(); it != m_sent.end();)
+        {
+            if (it->second.pass == m_pass)
+            {
+                ++it;
+                continue;
+            }
+            m_removeSec.Varint(it->second.netId);
+            ++m_stats.removals;
+            m_releasedIds.push_back(it->second.netId);
+            it = m_sent.erase(it);
+        }
+    }
+
+    // Bodies the stream has not announced yet are skipped; the identity
+    // pass brings them in.
+    void Move(uint64_t key, float x, float y, float c, float s)
+    {
+        auto it = m_sent.find(key);
+        if (it != m_sent.end()) MoveSent(it->second, x, y, c, s);
+    }
+
+    // Heights relative to the baseline, as runs of changed columns; runs
+    // closer than kWaterRunGap merge, since a zero delta is a byte. A new
+    // column count (an empty list clears the water) restarts from zero.
+    void Water(const float* heights, size_t count)
+    {
+        if (m_water.size() != count)
+        {
+            m_water.assign(count, 0);
+            m_waterResized = true;
+        }
+        size_t last = 0; // one past the previous run
+        size_t begin = 0;
+        size_t end = 0; // of the open run; begin == end when none is open
+        for (size_t i = 0; i < count; ++i)
+        {
+            if (Quantize(heights[i]) == m_water[i]) continue;
+            if (begin != end && i - end > kWaterRunGap)
+            {
+                WriteWaterRun(m_waterSec, heights, begin, end, last);
+                begin = end;
+            }
+            if (begin == end) begin = i;
+            end = i + 1;
+        }
+        if (begin != end) WriteWaterRun(m_waterSec, heights, begin, end, last);
+    }
+
+    // The framed message for this frame's changes.
+    const std::vector<uint8_t>& Finish()
+    {
+        m_message.Clear();
+        size_t at = m_message.BeginMessage(MessageType::Frame);
+        m_message.Varint(m_serial);
+        bool world = m_worldChanged || m_waterResized;
+        m_message.U8(world ? kFrameWorld : 0);
+        if (world) WriteWorld(m_message);
+        m_waterResized = false;
+        WriteSections(m_message, m_stats.shapes, m_shapeSec, m_stats.removals, m_removeSec, m_stats.identities, m_identitySec, m_stats.moves, m_moveSec,
+                      m_waterRuns, m_waterSec);
+        m_message.EndMessage(at);
+        m_stats.bytes = m_message.Size();
+        return m_message.Bytes();
+    }
+
+    // Everything the stream has said so far as one frame, for a viewer that
+    // joins or has to start over. Costs the whole world, unlike Finish.
+    void Keyframe(ByteWriter& out) const
+    {
+        ByteWriter shapes, removals, identities, moves, water;
+        for (const auto& [id, outline] : m_shapes) WriteShape(shapes, id, outline);
+        for (const auto& [key, sent] : m_sent)
+        {
+            WriteIdentity(identities, sent);
+            moves.Varint(sent.netId);
+            moves.Zigzag(sent.qx);
+            moves.Zigzag(sent.qy);
+            moves.Zigzag(static_cast<int16_t>(sent.qa));
+        }
+        uint32_t runs = 0;
+        if (!m_water.empty())
+        {
+            water.Varint(0);
+            water.Varint(m_water.size());
+            for (int32_t h : m_water) water.Zigzag(h);
+            runs = 1;
+        }
+        size_t at = out.BeginMessage(MessageType::Frame);
+        out.Varint(m_serial);
+        out.U8(kFrameKeyframe | kFrameWorld);
+        WriteWorld(out);
+        auto count = static_cast<uint32_t>(m_sent.size());
+        WriteSections(out, static_cast<uint32_t>(m_shapes.size()), shapes, 0, removals, count, identities, count, moves, runs, water);
+        out.EndMessage(at);
+    }
+
+    const Stats& LastStats() const { return m_stats; }
+    size_t BodyCount() const { return m_sent.size(); }
+
+private:
+    static constexpr size_t kWaterRunGap = 2;
+
+    struct Sent
+    {
+        uint32_t netId = 0;
+        uint32_t pass = 0;
+        int32_t qx = 0;
+        int32_t qy = 0;
+        uint16_t qa = 0;
+        uint8_t kind = 0;
+        uint8_t flags = 0;
+        uint32_t shape = 0;
+        uint32_t radius = 0;
+    };
+
+    uint32_t TakeId()
+    {
+        if (m_ids.empty()) return m_nextId++;
+        uint32_t id = m_ids.back();
+        m_ids.pop_back();
+        return id;
+    }
+
+    void MoveSent(Sent& sent, float x, float y, float c, float s)
+    {
+        int32_t qx = Quantize(x);
+        int32_t qy = Quantize(y);
+        uint16_t qa = QuantizeAngle(c, s);
+        if (qx == sent.qx && qy == sent.qy && qa == sent.qa) return;
+        m_moveSec.Varint(sent.netId);
+        m_moveSec.Zigzag(int64_t{qx} - sent.qx);
+        m_moveSec.Zigzag(int64_t{qy} - sent.qy);
+        m_moveSec.Zigzag(static_cast<int16_t>(static_cast<uint16_t>(qa - sent.qa)));
+        sent.qx = qx;
+        sent.qy = qy;
+        sent.qa = qa;
+        ++m_stats.moves;
+    }
+
+    void WriteWaterRun(ByteWriter& out, const float* heights, size_t begin, size_t end, size_t& last)
+    {
+        out.Varint(begin - last);
+        out.Varint(end - begin);
+        for (size_t i = begin; i < end; ++i)
+        {
+            int32_t q = Quantize(heights[i]);
+            out.Zigzag(int64_t{q} - m_water[i]);
+            m_water[i] = q;
+        }
+        last = end;
+        ++m_waterRuns;
+        m_stats.waterColumns += static_cast<uint32_t>(end - begin);
+    }
+
+    static void WriteShape(ByteWriter& out, uint32_t id, const std::vector<float>& outline)
+    {
+        out.Varint(id);
+        out.U8(static_cast<uint8_t>(outline.size() / 2));
+        for (float v : outline) out.F32(v);
+    }
+
+    static void WriteIdentity(ByteWriter& out, const Sent& sent)
+    {
+        out.Varint(sent.netId);
+        out.U8(sent.kind);
+        out.U8(sent.flags);
+        out.Varint(sent.shape);
+        out.Varint(sent.radius);
+    }
+
+    void WriteWorld(ByteWriter& out) const
+    {
+        out.F32(m_world.width);
+        out.F32(m_world.groundTop);
+        out.U8(m_world.location);
+        out.F32(m_world.waveStep);
+        out.F32(m_world.waveBaseline);
+        out.Varint(m_water.size());
+    }
+
+    static void WriteSections(ByteWriter& out, uint32_t shapes, const ByteWriter& shapeSec, uint32_t removals, const ByteWriter& removeSec,
+                              uint32_t identities, const ByteWriter& identitySec, uint32_t moves, const ByteWriter& moveSec, uint32_t runs,
+                              const ByteWriter& waterSec)
+    {
+        out.Varint(shapes);
+        out.Append(shapeSec);
+        out.Varint(removals);
+        out.Append(removeSec);
+        out.Varint(identities);
+        out.Append(identitySec);
+        out.Varint(moves);
+        out.Append(moveSec);
+        out.Varint(runs);
+        out.Append(waterSec);
+    }
+
+    std::unordered_map<uint64_t, Sent> m_sent;
+    std::unordered_map<uint32_t, std::vector<float>> m_shapes;
+    std::vector<uint32_t> m_ids; // free net ids
+    std::vector<uint32_t> m_releasedIds; // freed this frame, free from the next
+    uint32_t m_nextId = 0;
+    uint32_t m_pass = 0;
+    std::vector<int32_t> m_water;
+    bool m_waterResized = false;
+    WorldInfo m_world;
+    bool m_worldChanged = false;
+    uint64_t m_serial = 0;
+    ByteWriter m_shapeSec;
+    ByteWriter m_removeSec;
+    ByteWriter m_identitySec;
+    ByteWriter m_moveSec;
+    ByteWriter m_waterSec;
+    uint32_t m_waterRuns = 0;
+    ByteWriter m_message;
+    Stats m_stats;
+};
+
+// Viewer side: the world as the frames so far describe it.
+class StreamMirror
+{
+public:
+    static constexpr uint32_t kMaxBodies = 1u << 22;
+    static constexpr uint32_t kMaxWaterColumns = 1u << 20;
+
+    struct Body
+    {
+        bool live = false;
+        uint8_t kind = 0;
+        uint8_t flags = 0;
+        uint32_t shape = 0;
+        int32_t qx = 0;
+        int32_t qy = 0;
+        uint16_t qa = 0;
+        uint32_t radius = 0;
+
+        float X() const { return Dequantize(qx); }
+        float Y() const { return Dequantize(qy); }
+        float RadiusPx() const { return static_cast<float>(radius) / kUnitsPerPx; }
+        float Angle() const { return static_cast<float>(static_cast<int16_t>(qa)) * (6.28318530718f / 65536.0f); }
+    };
+
+    // A frame's payload. False on malformed input, which leaves the mirror
+    // partly updated; the connection should be dropped then.
+    bool Apply(ByteReader& r)
+    {
+        uint64_t serial = 0;
+        uint8_t flags = 0;
+        if (!r.Varint(serial) || !r.U8(flags)) return false;
+        if (flags & kFrameKeyframe) Clear();
+        if (flags & kFrameWorld)
+        {
+            uint32_t columns = 0;
+            if (!r.F32(m_world.width) || !r.F32(m_world.groundTop) || !r.U8(m_world.location) || !r.F32(m_world.waveStep) || !r.F32(m_world.waveBaseline) ||
+                !r.Count(columns, kMaxWaterColumns))
+                return false;
+            if (columns != m_water.size()) m_water.assign(columns, 0);
+        }
+        uint32_t count = 0;
+        if (!r.Count(count, kMaxBodies)) return false;
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            uint32_t id = 0;
+            uint8_t n = 0;
+            if (!r.Count(id, UINT32_MAX) || !r.U8(n)) return false;
+            std::vector<float>& outline = m_shapes[id];
+            outline.resize(2 * size_t{n});
+            for (float& v : outline)
+            {
+                if (!r.F32(v)) return false;
+            }
+        }
+        if (!r.Count(count, kMaxBodies)) return false;
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            Body* b = ReadBody(r, false);
+            if (!b) return false;
+            if (b->live) --m_live;
+            *b = Body{};
+        }
+        if (!r.Count(count, kMaxBodies)) return false;
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            Body* b = ReadBody(r, true);
+            uint64_t shape = 0, radius = 0;
+            if (!b || !r.U8(b->kind) || !r.U8(b->flags) || !r.Varint(shape) || !r.Varint(radius)) return false;
+            if (!b->live) ++m_live;
+            b->live = true;
+            b->shape = static_cast<uint32_t>(shape);
+            b->radius = static_cast<uint32_t>(radius);
+        }
+        if (!r.Count(count, kMaxBodies)) return false;
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            Body* b = ReadBody(r, false);
+            int64_t dx = 0, dy = 0, da = 0;
+            if (!b || !r.Zigzag(dx) || !r.Zigzag(dy) || !r.Zigzag(da)) return false;
+            b->qx = static_cast<int32_t>(b->qx + dx);
+            b->qy = static_cast<int32_t>(b->qy + dy);
+            b->qa = static_cast<uint16_t>(b->qa + da);
+        }
+        if (!r.Count(count, kMaxWaterColumns)) return false;
+        size_t column = 0;
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            uint32_t skip = 0, n = 0;
+            if (!r.Count(skip, kMaxWaterColumns) || !r.Count(n, kMaxWaterColumns)) return false;
+            column += skip;
+            if (column + n > m_water.size()) return false;
+            for (uint32_t k = 0; k < n; ++k, ++column)
+            {
+                int64_t d = 0;
+                if (!r.Zigzag(d)) return false;
+                m_water[column] = static_cast<int32_t>(m_water[column] + d);
+            }
+        }
+        m_serial = serial;
+        return r.Ok() && r.AtEnd();
+    }
+
+    void Clear()
+    {
+        m_bodies.clear();
+        m_shapes.clear();
+        m_water.clear();
+        m_live = 0;
+    }
+
+    const std::vector<Body>& Bodies() const { return m_bodies; } // by net id; skip !live
+    size_t LiveCount() const { return m_live; }
+    const WorldInfo& World() const { return m_world; }
+    uint64_t Serial() const { return m_serial; }
+
+    const std::vector<float>* Outline(uint32_t shape) const
+    {
+        auto it = m_shapes.find(shape);
+        return it == m_shapes.end() ? nullptr : &it->second;
+    }
+
+    size_t WaterColumns() const { return m_water.size(); }
+    float WaterHeight(size_t column) const { return Dequantize(m_water[column]); }
+
+private:
+    // grow: identities may introduce a net id, removals and moves may not.
+    Body* ReadBody(ByteReader& r, bool grow)
+    {
+        uint32_t id = 0;
+        if (!r.Count(id, kMaxBodies)) return nullptr;
+        if (id >= m_bodies.size())
+        {
+            if (!grow) return nullptr;
+            m_bodies.resize(size_t{id} + 1);
+        }
+        Body& b = m_bodies[id];
+        return (grow || b.live) ? &b : nullptr;
+    }
+
+    std::vector<Body> m_bodies;
+    std::unordered_map<uint32_t, std::vector<float>> m_shapes;
+    std::vector<int32_t> m_water;
+    size_t m_live = 0;
+    WorldInfo m_world;
+    uint64_t m_serial = 0;
+};
+
+} // namespace netstream
@@ -0,0 +1,254 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Uniform spatial hash of convex body outlines, for pushing particles out of
+// bodies. The owner adds world-space outlines, then Build bins their bounds
+// into cells with a counting sort: no per-cell lists, and nothing allocated
+// once the arrays have grown. A query reads the one cell under the particle;
+// bodies are binned over their bounds grown by the largest particle radius,
+// so that cell holds every body the particle can touch. Cells hash into a
+// power-of-two table, and a hash collision only adds candidates that the
+// bounds test then drops.
+class ParticleGrid
+{
+public:
+    void Clear()
+    {
+        m_bodies.clear();
+        m_planes.clear();
+        m_cellStart.clear();
+        m_items.clear();
+        m_minX = m_minY = INFINITY;
+        m_maxX = m_maxY = -INFINITY;
+    }
+
+    void AddCircle(float x, float y, float r)
+    {
+        Body b;
+        b.minX = x - r;
+        b.minY = y - r;
+        b.maxX = x + r;
+        b.maxY = y + r;
+        b.cx = x;
+        b.cy = y;
+        b.radius = r;
+        m_bodies.push_back(b);
+    }
+
+    // Convex outline as x, y pairs, either winding; degenerate ones are skipped.
+    void AddPolygon(const float* xy, int count)
+    {
+        if (count < 3) return;
+        float area = 0.0f;
+        Body b;
+        b.minX = b.maxX = xy[0];
+        b.minY = b.maxY = xy[1];
+        for (int i = 0; i < count; ++i)
+        {
+            int j = (i + 1) % count;
+            area += xy[2 * i] * xy[2 * j + 1] - xy[2 * j] * xy[2 * i + 1];
+            b.minX = std::min(b.minX, xy[2 * i]);
+            b.maxX = std::max(b.maxX, xy[2 * i]);
+            b.minY = std::min(b.minY, xy[2 * i + 1]);
+            b.maxY = std::max(b.maxY, xy[2 * i + 1]);
+        }
+        if (std::fabs(area) < 1e-3f) return;
+        float sign = area > 0.0f ? 1.0f : -1.0f;
+        b.first = static_cast<uint32_t>(m_planes.size());
+        for (int i = 0; i < count; ++i)
+        {
+            int j = (i + 1) % count;
+            float ex = xy[2 * j] - xy[2 * i];
+            float ey = xy[2 * j + 1] - xy[2 * i + 1];
+            float len = std::sqrt(ex * ex + ey * ey);
+            if (len < 1e-4f) continue;
+            // Outward normal of a counter-clockwise edge, flipped for clockwise.
+            float nx = sign * ey / len;
+            float ny = -sign * ex / len;
+            m_planes.push_back({nx, ny, nx * xy[2 * i] + ny * xy[2 * i + 1]});
+        }
+        b.count = static_cast<uint32_t>(m_planes.size()) - b.first;
+        if (b.count < 3)
+        {
+            m_planes.resize(b.first);
+            return;
+        }
+        m_bodies.push_back(b);
+    }
+
+    // Bins everything added since Clear. margin is the largest particle radius
+    // a body must be found by. Cells are sized to the mean grown body, which
+    // keeps both the cells per body and the bodies per cell small.
+    void Build(float margin)
+    {
+        float extent = 0.0f;
+        for (const Body& b : m_bodies) extent += std::max(b.maxX - b.minX, b.maxY - b.minY);
+        extent = m_bodies.empty() ? 0.0f : extent / static_cast<float>(m_bodies.size());
+        m_invCell = 1.0f / std::clamp(extent + 2.0f * margin, kMinCellPx, kMaxCellPx);
+
+        for (const Body& b : m_bodies)
+        {
+            m_minX = std::min(m_minX, b.minX);
+            m_minY = std::min(m_minY, b.minY);
+            m_maxX = std::max(m_maxX, b.maxX);
+            m_maxY = std::max(m_maxY, b.maxY);
+        }
+        size_t entries = 0;
+        ForEachCell(margin, [&](uint32_t, int, int) { ++entries; });
+        size_t table = 64;
+        while (table < entries * 2) table <<= 1;
+        m_mask = static_cast<uint32_t>(table - 1);
+
+        // Count per cell, prefix sum into starts, then place each body in
+        // every cell of its grown bounds. Placing advances each start to its
+        // cell's end, so the starts shift down one slot afterwards.
+        m_cellStart.assign(table + 1, 0);
+        ForEachCell(margin, [&](uint32_t, int cx, int cy) { ++m_cellStart[Hash(cx, cy) + 1]; });
+        for (size_t i = 1; i <= table; ++i) m_cellStart[i] += m_cellStart[i - 1];
+        m_items.resize(entries);
+        ForEachCell(margin, [&](uint32_t k, int cx, int cy) {
+            const Body& b = m_bodies[k];
+            m_items[m_cellStart[Hash(cx, cy)]++] = {b.minX, b.minY, b.maxX, b.maxY, k};
+        });
+        for (size_t i = table; i > 0; --i) m_cellStart[i] = m_cellStart[i - 1];
+        m_cellStart[0] = 0;
+    }
+
+    // Moves a disc of radius r at (x, y) out of the body it sinks deepest into
+    // and gives that surface's outward normal. False when it touches none.
+    bool Resolve(float& x, float& y, float r, float& nx, float& ny) const
+    {
+        if (x + r < m_minX || x - r > m_maxX || y + r < m_minY || y - r > m_maxY) return false;
+        uint32_t h = Hash(Cell(x), Cell(y));
+        float best = 0.0f;
+        for (uint32_t i = m_cellStart[h]; i < m_cellStart[h + 1]; ++i)
+        {
+            const Item& item = m_items[i];
+            if (x + r < item.minX || x - r > item.maxX || y + r < item.minY || y - r > item.maxY) continue;
+            const Body& b = m_bodies[item.body];
+            float depth;
+            float bx;
+            float by;
+            if (b.count == 0)
+            {
+                float dx = x - b.cx;
+                float dy = y - b.cy;
+                float reach = b.radius + r;
+                float d2 = dx * dx + dy * dy;
+                if (d2 >= reach * reach) continue;
+                float d = std::sqrt(d2);
+                depth = reach - d;
+                if (depth <= best) continue;
+                bx = d > 1e-4f ? dx / d : 0.0f;
+                by = d > 1e-4f ? dy / d : -1.0f;
+            }
+            else
+            {
+                // Separation is the largest edge-plane distance; it is a slight
+                // overestimate of the gap near corners, which never matters here.
+                const Plane* planes = m_planes.data() + b.first;
+                float sep = -INFINITY;
+                bx = 0.0f;
+                by = -1.0f;
+                for (uint32_t e = 0; e < b.count; ++e)
+                {
+                    float s = planes[e].nx * x + planes[e].ny * y - planes[e].d;
+                    if (s <= sep) continue;
+                    sep = s;
+                    bx = planes[e].nx;
+                    by = planes[e].ny;
+                }
+                depth = r - sep;
+                if (depth <= best) continue;
+            }
+            best = depth;
+            nx = bx;
+            ny = by;
+        }
+        if (best <= 0.0f) return false;
+        x += nx * best;
+        y += ny * best;
+        return true;
+    }
+
+    size_t size() const { return m_bodies.size(); }
+    bool empty() const { return m_bodies.empty(); }
+
+private:
+    static constexpr float kMinCellPx = 8.0f;
+    static constexpr float kMaxCellPx = 256.0f;
+
+    struct Body
+    {
+        float minX = 0.0f;
+        float minY = 0.0f;
+        float maxX = 0.0f;
+        float maxY = 0.0f;
+        float cx = 0.0f;
+        float cy = 0.0f;
+        float radius = 0.0f;
+        uint32_t first = 0;
+        uint32_t count = 0; // edge planes; 0 for a circle
+    };
+
+    // A body's bounds copied into each of its cells, so the bounds test
+    // reads the cell's entries in order.
+    struct Item
+    {
+        float minX;
+        float minY;
+        float maxX;
+        float maxY;
+        uint32_t body;
+    };
+
+    struct Plane
+    {
+        float nx;
+        float ny;
+        float d;
+    };
+
+    // Floor without the libm call std::floor is on plain SSE2.
+    int Cell(float v) const
+    {
+        float f = v * m_invCell;
+        int i = static_cast<int>(f);
+        return i - (f < static_cast<float>(i) ? 1 : 0);
+    }
+    template <typename Fn>
+    void ForEachCell(float margin, Fn&& fn) const
+    {
+        for (uint32_t k = 0; k < m_bodies.size(); ++k)
+        {
+            const Body& b = m_bodies[k];
+            int x0 = Cell(b.minX - margin);
+            int x1 = Cell(b.maxX + margin);
+            int y0 = Cell(b.minY - margin);
+            int y1 = Cell(b.maxY + margin);
+            for (int cy = y0; cy <= y1; ++cy)
+            {
+                for (int cx = x0; cx <= x1; ++cx) fn(k, cx, cy);
+            }
+        }
+    }
+
+    uint32_t Hash(int cx, int cy) const { return ((static_cast<uint32_t>(cx) * 73856093u) ^ (static_cast<uint32_t>(cy) * 19349663u)) & m_mask; }
+
+    std::vector<Body> m_bodies;
+    std::vector<Plane> m_planes;
+    std::vector<uint32_t> m_cellStart;
+    std::vector<Item> m_items;
+    // Union of the body bounds; most particles are nowhere near a body.
+    float m_minX = INFINITY;
+    float m_minY = INFINITY;
+    float m_maxX = -INFINITY;
+    float m_maxY = -INFINITY;
+    float m_invCell = 1.0f;
+    uint32_t m_mask = 0;
+};
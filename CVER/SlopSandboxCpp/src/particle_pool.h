@@ -0,0 +1,243 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define SLOP_PARTICLE_SSE2 1
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define SLOP_PARTICLE_NEON 1
+#endif
+
+// What a collision callback found for one particle: nothing, a surface to
+// bounce off, or one that swallows it (Collide ends its life).
+enum class ParticleContact : uint8_t
+{
+    None,
+    Bounce,
+    Absorb,
+};
+
+// Read-only copy of a pool for the renderer: position, radius and remaining
+// life fraction per particle.
+struct ParticleFrame
+{
+    std::vector<float> x;
+    std::vector<float> y;
+    std::vector<float> radius;
+    std::vector<float> life;
+
+    size_t size() const { return x.size(); }
+    bool empty() const { return x.empty(); }
+};
+
+// Fixed-capacity structure-of-arrays pool for short-lived cosmetic particles
+// (glass shards, water spray). Storage is allocated once; Emit drops new
+// particles when the pool is full and Cull compacts with swap-and-pop, so
+// draw order is not preserved.
+class ParticlePool
+{
+public:
+    explicit ParticlePool(size_t capacity)
+        : m_capacity(capacity)
+    {
+        for (std::vector<float>* a : {&m_x, &m_y, &m_vx, &m_vy, &m_radius, &m_life, &m_invMaxLife})
+        {
+            a->resize(capacity);
+        }
+    }
+
+    bool Emit(float x, float y, float vx, float vy, float radius, float life)
+    {
+        if (m_count == m_capacity) return false;
+        size_t i = m_count++;
+        m_x[i] = x;
+        m_y[i] = y;
+        m_vx[i] = vx;
+        m_vy[i] = vy;
+        m_radius[i] = radius;
+        m_life[i] = life;
+        m_invMaxLife[i] = 1.0f / std::max(0.001f, life);
+        return true;
+    }
+
+    // Gravity first, then per-frame drag (factors given at 60 Hz) and position.
+    void Integrate(float dt, float gravity, float dragX60, float dragY60)
+    {
+        const float fx = std::pow(dragX60, dt * 60.0f);
+        const float fy = std::pow(dragY60, dt * 60.0f);
+        const float gdt = gravity * dt;
+        float* x = m_x.data();
+        float* y = m_y.data();
+        float* vx = m_vx.data();
+        float* vy = m_vy.data();
+        float* life = m_life.data();
+        const size_t n = m_count;
+
+        size_t i = 0;
+#if defined(SLOP_PARTICLE_SSE2)
+        const __m128 vdt = _mm_set1_ps(dt);
+        const __m128 vg = _mm_set1_ps(gdt);
+        const __m128 vfx = _mm_set1_ps(fx);
+        const __m128 vfy = _mm_set1_ps(fy);
+        for (; i + 4 <= n; i += 4)
+        {
+            __m128 u = _mm_mul_ps(_mm_loadu_ps(vx + i), vfx);
+            __m128 v = _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(vy + i), vg), vfy);
+            _mm_storeu_ps(vx + i, u);
+            _mm_storeu_ps(vy + i, v);
+            _mm_storeu_ps(x + i, _mm_add_ps(_mm_loadu_ps(x + i), _mm_mul_ps(u, vdt)));
+            _mm_storeu_ps(y + i, _mm_add_ps(_mm_loadu_ps(y + i), _mm_mul_ps(v, vdt)));
+            _mm_storeu_ps(life + i, _mm_sub_ps(_mm_loadu_ps(life + i), vdt));
+        }
+#elif defined(SLOP_PARTICLE_NEON)
+        const float32x4_t vdt = vdupq_n_f32(dt);
+        const float32x4_t vg = vdupq_n_f32(gdt);
+        const float32x4_t vfx = vdupq_n_f32(fx);
+        const float32x4_t vfy = vdupq_n_f32(fy);
+        for (; i + 4 <= n; i += 4)
+        {
+            float32x4_t u = vmulq_f32(vld1q_f32(vx + i), vfx);
+            float32x4_t v = vmulq_f32(vaddq_f32(vld1q_f32(vy + i), vg), vfy);
+            vst1q_f32(vx + i, u);
+            vst1q_f32(vy + i, v);
+            vst1q_f32(x + i, vmlaq_f32(vld1q_f32(x + i), u, vdt));
+            vst1q_f32(y + i, vmlaq_f32(vld1q_f32(y + i), v, vdt));
+            vst1q_f32(life + i, vsubq_f32(vld1q_f32(life + i), vdt));
+        }
+#endif
+        for (; i < n; ++i)
+        {
+            vx[i] *= fx;
+            vy[i] = (vy[i] + gdt) * fy;
+            x[i] += vx[i] * dt;
+            y[i] += vy[i] * dt;
+            life[i] -= dt;
+        }
+    }
+
+    // Hands each particle to contact(x, y, radius, vx, vy, nx, ny), which may
+    // move it out of whatever it overlaps and give that surface's normal. A
+    // bounce reflects the velocity into the surface, scaled by restitution,
+    // and keeps friction's share of the sliding part; an absorb expires the
+    // particle for the next Cull.
+    template <typename Fn>
+    void Collide(float restitution, float friction, Fn&& contact)
+    {
+        for (size_t i = 0; i < m_count; ++i)
+        {
+            float nx = 0.0f;
+            float ny = 0.0f;
+            ParticleContact c = contact(m_x[i], m_y[i], m_radius[i], m_vx[i], m_vy[i], nx, ny);
+            if (c == ParticleContact::None) continue;
+            if (c == ParticleContact::Absorb)
+            {
+                m_life[i] = 0.0f;
+                continue;
+            }
+            float vn = m_vx[i] * nx + m_vy[i] * ny;
+            if (vn >= 0.0f) continue;
+            float tx = m_vx[i] - vn * nx;
+            float ty = m_vy[i] - vn * ny;
+            m_vx[i] = tx * friction - vn * restitution * nx;
+            m_vy[i] = ty * friction - vn * restitution * ny;
+        }
+    }
+
+    // Removes expired particles and those outside [minX, maxX] or below maxY.
+    void Cull(float minX = -std::numeric_limits<float>::max(),
+              float maxX = std::numeric_limits<float>::max(),
+              float maxY = std::numeric_limits<float>::max())
+    {
+        size_t i = 0;
+        while (i < m_count)
+        {
+            if (m_life[i] > 0.0f && m_x[i] >= minX && m_x[i] <= maxX && m_y[i] <= maxY)
+            {
+                ++i;
+                continue;
+            }
+            size_t last = --m_count;
+            m_x[i] = m_x[last];
+            m_y[i] = m_y[last];
+            m_vx[i] = m_vx[last];
+            m_vy[i] = m_vy[last];
+            m_radius[i] = m_radius[last];
+            m_life[i] = m_life[last];
+            m_invMaxLife[i] = m_invMaxLife[last];
+        }
+    }
+
+    void Clear()
+    {
+        m_count = 0;
+        ++m_generation;
+    }
+
+    // Empties the pool after its particles were handed to a mirror (the GPU
+    // path), without counting as a Clear.
+    void Consume() { m_count = 0; }
+
+    // Bumped by every Clear, so a mirror knows to drop its copy.
+    uint32_t Generation() const { return m_generation; }
+
+    void CopyTo(ParticleFrame& out) const
+    {
+        out.x.assign(m_x.begin(), m_x.begin() + static_cast<std::ptrdiff_t>(m_count));
+        out.y.assign(m_y.begin(), m_y.begin() + static_cast<std::ptrdiff_t>(m_count));
+        out.radius.assign(m_radius.begin(), m_radius.begin() + static_cast<std::ptrdiff_t>(m_count));
+        out.life.resize(m_count);
+        for (size_t i = 0; i < m_count; ++i) out.life[i] = LifeFraction(i);
+    }
+
+    // Only the particles whose quad touches [minX, maxX] x [minY, maxY].
+    void CopyTo(ParticleFrame& out, float minX, float minY, float maxX, float maxY) const
+    {
+        out.x.clear();
+        out.y.clear();
+        out.radius.clear();
+        out.life.clear();
+        for (size_t i = 0; i < m_count; ++i)
+        {
+            float r = m_radius[i];
+            if (m_x[i] + r < minX || m_x[i] - r > maxX || m_y[i] + r < minY || m_y[i] - r > maxY) continue;
+            out.x.push_back(m_x[i]);
+            out.y.push_back(m_y[i]);
+            out.radius.push_back(r);
+            out.life.push_back(LifeFraction(i));
+        }
+    }
+
+    size_t size() const { return m_count; }
+    size_t capacity() const { return m_capacity; }
+    bool empty() const { return m_count == 0; }
+
+    float X(size_t i) const { return m_x[i]; }
+    float Y(size_t i) const { return m_y[i]; }
+    float VX(size_t i) const { return m_vx[i]; }
+    float VY(size_t i) const { return m_vy[i]; }
+    float Radius(size_t i) const { return m_radius[i]; }
+    // Remaining life in seconds, and the reciprocal of the life it started with.
+    float Life(size_t i) const { return m_life[i]; }
+    float InvMaxLife(size_t i) const { return m_invMaxLife[i]; }
+    // Remaining life in [0, 1].
+    float LifeFraction(size_t i) const { return std::clamp(m_life[i] * m_invMaxLife[i], 0.0f, 1.0f); }
+
+private:
+    size_t m_capacity = 0;
+    size_t m_count = 0;
+    uint32_t m_generation = 0;
+    std::vector<float> m_x;
+    std::vector<float> m_y;
+    std::vector<float> m_vx;
+    std::vector<float> m_vy;
+    std::vector<float> m_radius;
+    std::vector<float> m_life;
+    std::vector<float> m_invMaxLife;
+};
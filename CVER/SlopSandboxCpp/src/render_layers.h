@@ -0,0 +1,359 @@
+#pragma once
+
+#include <raylib.h>
+#include <rlgl.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// Render texture that is repainted only when its key changes and otherwise
+// just blitted. Painting uses premultiplied colour with straight coverage
+// alpha (as the panel label cache does), so translucent content composites
+// the same as drawing it directly. Needs a GL context; Unload before closing
+// the window.
+class CachedLayer
+{
+public:
+    // Builds a key from the values a layer's content depends on.
+    class Key
+    {
+    public:
+        Key& Add(uint64_t v)
+        {
+            m_hash = (m_hash ^ v) * 0x100000001b3ull;
+            return *this;
+        }
+        Key& Add(float v)
+        {
+            uint32_t bits = 0;
+            std::memcpy(&bits, &v, sizeof(bits));
+            return Add(static_cast<uint64_t>(bits));
+        }
+        Key& Add(Color c) { return Add(static_cast<uint64_t>(c.r) | (c.g << 8) | (c.b << 16) | (static_cast<uint64_t>(c.a) << 24)); }
+        uint64_t Value() const { return m_hash; }
+
+    private:
+        uint64_t m_hash = 0xcbf29ce484222325ull;
+    };
+
+    // Draws the layer with its top-left at `at`, first calling paint(), in
+    // layer-local coordinates, when key or size changed since the last repaint.
+    template <typename Paint>
+    void Draw(uint64_t key, int width, int height, Vector2 at, Paint&& paint)
+    {
+        if (width <= 0 || height <= 0) return;
+        if (m_loaded && (m_target.texture.width != width || m_target.texture.height != height))
+        {
+            UnloadRenderTexture(m_target);
+            m_loaded = false;
+        }
+        if (!m_loaded)
+        {
+            m_target = LoadRenderTexture(width, height);
+            m_loaded = m_target.id != 0;
+            if (!m_loaded) return;
+            m_valid = false;
+        }
+        if (!m_valid || key != m_key)
+        {
+            BeginTextureMode(m_target);
+            ClearBackground(BLANK);
+            rlSetBlendFactorsSeparate(RL_SRC_ALPHA, RL_ONE_MINUS_SRC_ALPHA, RL_ONE, RL_ONE_MINUS_SRC_ALPHA, RL_FUNC_ADD, RL_FUNC_ADD);
+            BeginBlendMode(BLEND_CUSTOM_SEPARATE);
+            paint();
+            EndBlendMode();
+            EndTextureMode();
+            m_key = key;
+            m_valid = true;
+            ++m_repaints;
+        }
+
+        Blit(at);
+    }
+
+    // Draws the last painted content without repainting, e.g. inside another
+    // texture mode. False when there is nothing painted yet.
+    bool Blit(Vector2 at)
+    {
+        if (!m_loaded || !m_valid) return false;
+        const Texture2D& tex = m_target.texture;
+        Rectangle src{0.0f, 0.0f, static_cast<float>(tex.width), -static_cast<float>(tex.height)};
+        BeginBlendMode(BLEND_ALPHA_PREMULTIPLY);
+        DrawTextureRec(tex, src, at, WHITE);
+        EndBlendMode();
+        return true;
+    }
+
+    // Forces a repaint on the next Draw.
+    void Invalidate() { m_valid = false; }
+
+    void Unload()
+    {
+        if (m_loaded) UnloadRenderTexture(m_target);
+        m_loaded = false;
+        m_valid = false;
+    }
+
+    bool Loaded() const { return m_loaded; }
+    uint64_t Repaints() const { return m_repaints; }
+
+private:
+    RenderTexture2D m_target{};
+    uint64_t m_key = 0;
+    uint64_t m_repaints = 0;
+    bool m_loaded = false;
+    bool m_valid = false;
+};
+
+// The water body as one indexed mesh: per column a fill edge from the surface
+// down to the bottom and a band around the surface for the line. Indices and
+// colours are uploaded once; each frame only rewrites the vertex positions, and
+// the whole surface is a single draw call. Indices go segment by segment, so
+// drawing fewer columns than the mesh holds is just a shorter index range.
+class WaterMesh
+{
+public:
+    // count columns step px apart from x = x0, heights relative to baselineY;
+    // the fill reaches down to bottomY. The mesh grows when count outgrows it.
+    // Returns false without drawing when the mesh could not be uploaded; the
+    // caller then draws immediate-mode geometry instead.
+    bool Draw(const float* disp, size_t count, float x0, float step, float baselineY, float bottomY, Color fill, Color line,
+              float lineWidth)
+    {
+        if (count < 2 || count > kMaxColumns) return false;
+        if (count > m_capacity) Build(std::min(kMaxColumns, std::max(count, m_capacity * 2)));
+        if (m_mesh.vaoId == 0) return false;
+
+        float half = 0.5f * lineWidth;
+        float* v = m_mesh.vertices;
+        for (size_t i = 0; i < count; ++i)
+        {
+            float x = x0 + static_cast<float>(i) * step;
+            float y = baselineY + disp[i];
+            float ys[kVertsPerColumn] = {y, bottomY, y - half, y + half};
+            for (size_t k = 0; k < kVertsPerColumn; ++k)
+            {
+                *v++ = x;
+                *v++ = ys[k];
+                *v++ = 0.0f;
+            }
+        }
+        UpdateMeshBuffer(m_mesh, 0, m_mesh.vertices, static_cast<int>(count * kVertsPerColumn * 3 * sizeof(float)), 0);
+
+        if (std::memcmp(&fill, &m_fill, sizeof(Color)) != 0 || std::memcmp(&line, &m_line, sizeof(Color)) != 0)
+        {
+            m_fill = fill;
+            m_line = line;
+            unsigned char* c = m_mesh.colors;
+            for (size_t i = 0; i < m_capacity; ++i)
+            {
+                for (size_t k = 0; k < kVertsPerColumn; ++k)
+                {
+                    Color col = (k < 2) ? fill : line;
+                    *c++ = col.r;
+                    *c++ = col.g;
+                    *c++ = col.b;
+                    *c++ = col.a;
+                }
+            }
+            UpdateMeshBuffer(m_mesh, 3, m_mesh.colors, m_mesh.vertexCount * 4, 0);
+        }
+
+        // Meshes bypass the rlgl batch; flush it first to keep draw order.
+        rlDrawRenderBatchActive();
+        Matrix identity{1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1};
+        m_mesh.triangleCount = static_cast<int>((count - 1) * kTrianglesPerSegment);
+        DrawMesh(m_mesh, m_material, identity);
+        return true;
+    }
+
+    void Unload()
+    {
+        if (m_capacity == 0) return;
+        UnloadMesh(m_mesh);
+        m_mesh = Mesh{};
+        if (m_materialLoaded) UnloadMaterial(m_material);
+        m_materialLoaded = false;
+        m_capacity = 0;
+    }
+
+private:
+    static constexpr size_t kVertsPerColumn = 4; // fill top, fill bottom, line top, line bottom
+    static constexpr size_t kTrianglesPerSegment = 4;
+    static constexpr size_t kMaxColumns = 65535 / kVertsPerColumn; // 16-bit indices
+
+    void Build(size_t count)
+    {
+        Unload();
+        m_capacity = count;
+        m_fill = m_line = Color{0, 0, 0, 0};
+        m_mesh.vertexCount = static_cast<int>(count * kVertsPerColumn);
+        m_mesh.triangleCount = static_cast<int>((count - 1) * kTrianglesPerSegment);
+        m_mesh.vertices = static_cast<float*>(MemAlloc(static_cast<unsigned int>(m_mesh.vertexCount * 3 * sizeof(float))));
+        m_mesh.colors = static_cast<unsigned char*>(MemAlloc(static_cast<unsigned int>(m_mesh.vertexCount * 4)));
+        m_mesh.indices = static_cast<unsigned short*>(MemAlloc(static_cast<unsigned int>(m_mesh.triangleCount * 3 * sizeof(unsigned short))));
+
+        // Counter-clockwise on screen, the winding rlgl keeps with culling on.
+        unsigned short* idx = m_mesh.indices;
+        for (size_t i = 0; i + 1 < count; ++i)
+        {
+            for (int band = 0; band < 2; ++band)
+            {
+                auto top = [&](size_t c) { return static_cast<unsigned short>(c * kVertsPerColumn + band * 2); };
+                auto bottom = [&](size_t c) { return static_cast<unsigned short>(c * kVertsPerColumn + band * 2 + 1); };
+                *idx++ = top(i);
+                *idx++ = bottom(i);
+                *idx++ = bottom(i + 1);
+                *idx++ = top(i);
+                *idx++ = bottom(i + 1);
+                *idx++ = top(i + 1);
+            }
+        }
+        std::memset(m_mesh.vertices, 0, static_cast<size_t>(m_mesh.vertexCount) * 3 * sizeof(float));
+        std::memset(m_mesh.colors, 0, static_cast<size_t>(m_mesh.vertexCount) * 4);
+        UploadMesh(&m_mesh, true);
+        if (!m_materialLoaded)
+        {
+            m_material = LoadMaterialDefault();
+            m_materialLoaded = true;
+        }
+    }
+
+    Mesh m_mesh{};
+    Material m_material{};
+    size_t m_capacity = 0;
+    bool m_materialLoaded = false;
+    Color m_fill{};
+    Color m_line{};
+};
+
+// Block size for the pixelate effect from the frame rate: 3 px normally, 4
+// below 58 fps and 5 below 45. The rate is smoothed and a level only changes
+// after it has stayed past the threshold for a while (longer, and by a margin,
+// when going back to finer blocks), so load near a threshold does not flip
+// the size every few frames.
+class PixelSizeGovernor
+{
+public:
+    static constexpr int kMinSize = 3;
+    static constexpr int kMaxSize = 5;
+
+    int Update(float dt)
+    {
+        if (dt <= 0.0f) return m_size;
+        m_fps += (1.0f / dt - m_fps) * std::min(1.0f, dt * kSmoothingPerSecond);
+
+        int wanted = m_size;
+        if (m_size < kMaxSize && m_fps < Threshold(m_size)) wanted = m_size + 1;
+        else if (m_size > kMinSize && m_fps > Threshold(m_size - 1) + kRecoverMargin) wanted = m_size - 1;
+        if (wanted == m_size)
+        {
+            m_pending = 0.0f;
+            return m_size;
+        }
+
+        m_pending += dt;
+        if (m_pending >= (wanted > m_size ? kCoarsenSeconds : kRefineSeconds))
+        {
+            m_size = wanted;
+            m_pending = 0.0f;
+        }
+        return m_size;
+    }
+
+    int Size() const { return m_size; }
+
+private:
+    static constexpr float kSmoothingPerSecond = 4.0f;
+    static constexpr float kRecoverMargin = 1.5f;
+    static constexpr float kCoarsenSeconds = 0.5f;
+    static constexpr float kRefineSeconds = 2.0f;
+
+    // Below this rate, size + 1 is used instead of size.
+    static float Threshold(int size) { return size <= kMinSize ? 58.0f : 45.0f; }
+
+    int m_size = kMinSize;
+    float m_fps = 60.0f;
+    float m_pending = 0.0f;
+};
+
+// Scale of the dynamic-resolution target from measured GPU frame time. Fill
+// cost goes with the pixel count, so the scale that would meet the target is
+// the current one times sqrt(target / smoothed time), in kStep steps. Going
+// coarser happens soon after the time passes the target; going finer waits
+// longer and aims at kRefineHeadroom of the target, so a scale that just meets
+// it is kept. The model counts the UI as scaled too, which only makes finer
+// steps cautious. After a change the measurements are given kSettleSeconds to
+// catch up before the next one.
+class ResolutionScaleGovernor
+{
+public:
+    static constexpr float kMinScale = 0.5f;
+    static constexpr float kMaxScale = 1.0f;
+    static constexpr float kStep = 0.05f;
+
+    void SetTargetMs(float ms) { m_targetMs = std::max(0.5f, ms); }
+
+    // gpuMs below 0 (no measurement yet) leaves the scale alone.
+    float Update(float gpuMs, float dt)
+    {
+        if (gpuMs < 0.0f || dt <= 0.0f) return m_scale;
+        m_ms = m_measured ? m_ms + (gpuMs - m_ms) * std::min(1.0f, dt * kSmoothingPerSecond) : gpuMs;
+        m_measured = true;
+        if (m_settle > 0.0f)
+        {
+            m_settle -= dt;
+            return m_scale;
+        }
+
+        float wanted = m_scale;
+        if (m_ms > m_targetMs) wanted = Quantize(m_scale * std::sqrt(m_targetMs / m_ms));
+        else if (m_scale < kMaxScale) wanted = std::max(m_scale, Quantize(m_scale * std::sqrt(m_targetMs * kRefineHeadroom / std::max(m_ms, 0.01f))));
+        if (std::fabs(wanted - m_scale) < kStep * 0.5f)
+        {
+            m_pending = 0.0f;
+            return m_scale;
+        }
+
+        m_pending += dt;
+        if (m_pending >= (wanted < m_scale ? kCoarsenSeconds : kRefineSeconds))
+        {
+            m_scale = wanted;
+            m_pending = 0.0f;
+            m_settle = kSettleSeconds;
+        }
+        return m_scale;
+    }
+
+    float Scale() const { return m_scale; }
+    float SmoothedMs() const { return m_measured ? m_ms : 0.0f; }
+    float TargetMs() const { return m_targetMs; }
+
+    void Reset()
+    {
+        m_scale = kMaxScale;
+        m_measured = false;
+        m_pending = 0.0f;
+        m_settle = 0.0f;
+    }
+
+private:
+    static constexpr float kSmoothingPerSecond = 6.0f;
+    static constexpr float kRefineHeadroom = 0.85f;
+    static constexpr float kCoarsenSeconds = 0.25f;
+    static constexpr float kRefineSeconds = 1.5f;
+    static constexpr float kSettleSeconds = 0.3f;
+
+    // Down to a whole step, within the range.
+    static float Quantize(float scale) { return std::clamp(std::floor(scale / kStep + 1e-3f) * kStep, kMinScale, kMaxScale); }
+
+    float m_targetMs = 12.0f;
+    float m_scale = kMaxScale;
+    float m_ms = 0.0f;
+    bool m_measured = false;
+    float m_pending = 0.0f;
+    float m_settle = 0.0f;
+};
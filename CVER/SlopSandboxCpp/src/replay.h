@@ -0,0 +1,333 @@
+#pragma once
+
+#include "scene_file.h"
+#include "sim_types.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Keys the sandbox reads. Each is its bit in InputFrame's key masks, so new
+// ones go at the end; the front-end maps its own key codes onto them.
+enum class InputKey : uint8_t
+{
+    LeftShift, RightShift, Backspace, Z, Space, G, H, Eight,
+    One, Two, Three, Four, Five, Six, Seven,
+    R, T, Y, U, Q, W, E, A, D,
+    F3, F4, F5, F6, F9, S, X, C, V, B,
+    Comma, Period, F, Nine,
+    Count
+};
+
+enum class InputButton : uint8_t
+{
+    Left,
+    Right,
+};
+
+constexpr uint64_t InputKeyBit(InputKey key) { return uint64_t{1} << static_cast<unsigned>(key); }
+
+// Tooling keys (profiler, CSV, save/load, recording) never reach a recording.
+constexpr uint64_t kReplayIgnoredKeys = InputKeyBit(InputKey::F3) | InputKeyBit(InputKey::F4) | InputKeyBit(InputKey::F5) |
+                                        InputKeyBit(InputKey::F6) | InputKeyBit(InputKey::F9);
+
+// One frame of polled input. All input handling reads from this instead of
+// the window so a recording can drive it without one.
+struct InputFrame
+{
+    Vector2 mouse{0.0f, 0.0f};
+    // The mouse in world pixels, through the view camera at capture time.
+    Vector2 world{0.0f, 0.0f};
+    float time = 0.0f;
+    uint8_t mouseDown = 0;
+    uint8_t mousePressed = 0;
+    uint8_t mouseReleased = 0;
+    uint64_t keysDown = 0;
+    uint64_t keysPressed = 0;
+
+    // Adds the presses and releases of an earlier capture in the same frame,
+    // which a second poll before this one would otherwise have dropped.
+    void KeepEdgesOf(const InputFrame& earlier)
+    {
+        mousePressed |= earlier.mousePressed;
+        mouseReleased |= earlier.mouseReleased;
+        keysPressed |= earlier.keysPressed;
+    }
+
+    static constexpr uint8_t MouseBit(InputButton button) { return static_cast<uint8_t>(1u << static_cast<unsigned>(button)); }
+
+    bool KeyDown(InputKey key) const { return (keysDown & InputKeyBit(key)) != 0; }
+    bool KeyPressed(InputKey key) const { return (keysPressed & InputKeyBit(key)) != 0; }
+    bool MouseDown(InputButton button) const { return (mouseDown & MouseBit(button)) != 0; }
+    bool MousePressed(InputButton button) const { return (mousePressed & MouseBit(button)) != 0; }
+    bool MouseReleased(InputButton button) const { return (mouseReleased & MouseBit(button)) != 0; }
+};
+
+// Deterministic stand-in for raylib's GetRandomValue (splitmix64), owned by
+// the simulation so a replay sees the same splashes and shards.
+class SimRandom
+{
+public:
+    explicit SimRandom(uint64_t seed = 0x5eed) : m_state(seed) {}
+
+    void Seed(uint64_t seed) { m_state = seed; }
+
+    uint64_t State() const { return m_state; }
+
+    uint64_t Next()
+    {
+        uint64_t z = (m_state += 0x9e3779b97f4a7c15ull);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+        return z ^ (z >> 31);
+    }
+
+    // Inclusive on both ends, like GetRandomValue.
+    int Range(int min, int max)
+    {
+        if (max < min) std::swap(min, max);
+        uint64_t span = static_cast<uint64_t>(static_cast<int64_t>(max) - min) + 1;
+        return static_cast<int>(min + static_cast<int64_t>(Next() % span));
+    }
+
+private:
+    uint64_t m_state;
+};
+
+// Recording stream, version 3:
+//   ReplayHeader, scene image (scene_file.h) of sceneBytes, then tagged events
+//   until end of file. Input frames only carry fields that changed. Version 2
+//   is the same without Hash events and still reads.
+constexpr char kReplayMagic[8] = {'S', 'L', 'O', 'P', 'R', 'P', 'L', '\0'};
+constexpr uint32_t kReplayVersion = 3;
+constexpr uint32_t kReplayMinVersion = 2;
+constexpr int kReplayMaxSteps = 8;
+// ReplayHeader::flags: every Step event is followed by a Hash event.
+constexpr uint32_t kReplayFlagStateHash = 1;
+
+struct ReplayHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t sceneBytes;
+    uint64_t seed;
+    float timeScale;
+    uint8_t paused;
+    uint8_t tool;
+    uint8_t drawTool;
+    uint8_t panelCollapsed;
+    float panelX;
+    float panelY;
+    uint32_t flags;
+    uint32_t reserved;
+};
+
+static_assert(sizeof(ReplayHeader) == 48, "replay header layout");
+
+enum class ReplayEventType : uint8_t
+{
+    Input = 1, // input frame applied by HandleKeyboard/HandleMouse
+    Step = 2,  // one SimulateFrame: dt, step cap and the substeps of each step
+    Panel = 3, // panel drag/collapse handling ran against the current input
+    Ui = 4,    // a panel button command
+    Hash = 5   // state hash after each step of the Step event before it
+};
+
+struct ReplayEvent
+{
+    ReplayEventType type = ReplayEventType::Input;
+    InputFrame input;
+    float dt = 0.0f;
+    uint8_t stepCap = 0;
+    uint8_t stepCount = 0;
+    uint8_t subSteps[kReplayMaxSteps] = {};
+    uint8_t command = 0;
+    uint8_t arg = 0;
+    uint8_t hashCount = 0;
+    uint64_t hashes[kReplayMaxSteps] = {};
+};
+
+class ReplayWriter
+{
+public:
+    ~ReplayWriter() { Close(); }
+
+    bool Open(const std::string& path, const ReplayHeader& header, const std::vector<uint8_t>& sceneImage)
+    {
+        Close();
+        m_file = std::fopen(path.c_str(), "wb");
+        if (!m_file) return false;
+        m_last = InputFrame{};
+        m_buffer.clear();
+        m_stateHashes = (header.flags & kReplayFlagStateHash) != 0;
+        Put(&header, sizeof(header));
+        Put(sceneImage.data(), sceneImage.size());
+        return true;
+    }
+
+    bool IsOpen() const { return m_file != nullptr; }
+    bool WritesStateHashes() const { return m_file && m_stateHashes; }
+
+    void Close()
+    {
+        if (!m_file) return;
+        Flush();
+        std::fclose(m_file);
+        m_file = nullptr;
+    }
+
+    void WriteInput(InputFrame f)
+    {
+        f.keysDown &= ~kReplayIgnoredKeys;
+        f.keysPressed &= ~kReplayIgnoredKeys;
+        uint8_t mask = 0;
+        if (f.mouse.x != m_last.mouse.x || f.mouse.y != m_last.mouse.y) mask |= kMouse;
+        if (f.mouseDown != m_last.mouseDown || f.mousePressed != m_last.mousePressed || f.mouseReleased != m_last.mouseReleased) mask |= kButtons;
+        if (f.keysDown != m_last.keysDown) mask |= kKeysDown;
+        if (f.keysPressed != m_last.keysPressed) mask |= kKeysPressed;
+        if (f.world.x != m_last.world.x || f.world.y != m_last.world.y) mask |= kWorld;
+
+        PutByte(static_cast<uint8_t>(ReplayEventType::Input));
+        PutByte(mask);
+        Put(&f.time, sizeof(f.time));
+        if (mask & kMouse) Put(&f.mouse, sizeof(f.mouse));
+        if (mask & kButtons)
+        {
+            PutByte(f.mouseDown);
+            PutByte(f.mousePressed);
+            PutByte(f.mouseReleased);
+        }
+        if (mask & kKeysDown) Put(&f.keysDown, sizeof(f.keysDown));
+        if (mask & kKeysPressed) Put(&f.keysPressed, sizeof(f.keysPressed));
+        if (mask & kWorld) Put(&f.world, sizeof(f.world));
+        m_last = f;
+    }
+
+    void WriteStep(float dt, int cap, const uint8_t* subSteps, int count)
+    {
+        PutByte(static_cast<uint8_t>(ReplayEventType::Step));
+        Put(&dt, sizeof(dt));
+        PutByte(static_cast<uint8_t>(cap));
+        PutByte(static_cast<uint8_t>(count));
+        Put(subSteps, static_cast<size_t>(count));
+    }
+
+    void WriteHashes(const uint64_t* hashes, int count)
+    {
+        PutByte(static_cast<uint8_t>(ReplayEventType::Hash));
+        PutByte(static_cast<uint8_t>(count));
+        Put(hashes, sizeof(uint64_t) * static_cast<size_t>(count));
+    }
+
+    void WritePanel() { PutByte(static_cast<uint8_t>(ReplayEventType::Panel)); }
+
+    void WriteUi(uint8_t command, uint8_t arg)
+    {
+        PutByte(static_cast<uint8_t>(ReplayEventType::Ui));
+        PutByte(command);
+        PutByte(arg);
+    }
+
+    static constexpr uint8_t kMouse = 1;
+    static constexpr uint8_t kButtons = 2;
+    static constexpr uint8_t kKeysDown = 4;
+    static constexpr uint8_t kKeysPressed = 8;
+    static constexpr uint8_t kWorld = 16;
+
+private:
+    static constexpr size_t kFlushBytes = 64 * 1024;
+
+    void PutByte(uint8_t b) { Put(&b, 1); }
+
+    void Put(const void* p, size_t bytes)
+    {
+        const auto* b = static_cast<const uint8_t*>(p);
+        m_buffer.insert(m_buffer.end(), b, b + bytes);
+        if (m_buffer.size() >= kFlushBytes) Flush();
+    }
+
+    void Flush()
+    {
+        if (m_file && !m_buffer.empty()) std::fwrite(m_buffer.data(), 1, m_buffer.size(), m_file);
+        m_buffer.clear();
+    }
+
+    FILE* m_file = nullptr;
+    std::vector<uint8_t> m_buffer;
+    InputFrame m_last;
+    bool m_stateHashes = false;
+};
+
+class ReplayReader
+{
+public:
+    bool Open(const std::string& path)
+    {
+        if (!m_file.Open(path.c_str()) || m_file.Size() < sizeof(ReplayHeader)) return false;
+        std::memcpy(&m_header, m_file.Data(), sizeof(m_header));
+        if (std::memcmp(m_header.magic, kReplayMagic, sizeof(kReplayMagic)) != 0) return false;
+        if (m_header.version < kReplayMinVersion || m_header.version > kReplayVersion) return false;
+        if (m_file.Size() - sizeof(ReplayHeader) < m_header.sceneBytes) return false;
+        m_offset = sizeof(ReplayHeader) + m_header.sceneBytes;
+        m_input = InputFrame{};
+        return true;
+    }
+
+    const ReplayHeader& Header() const { return m_header; }
+    const uint8_t* SceneImage() const { return m_file.Data() + sizeof(ReplayHeader); }
+    size_t SceneBytes() const { return m_header.sceneBytes; }
+
+    // False at the end of the stream or on a truncated/corrupt event.
+    bool Next(ReplayEvent& ev)
+    {
+        uint8_t tag = 0;
+        if (!Get(&tag, 1)) return false;
+        ev.type = static_cast<ReplayEventType>(tag);
+        switch (ev.type)
+        {
+            case ReplayEventType::Input:
+            {
+                uint8_t mask = 0;
+                if (!Get(&mask, 1) || !Get(&m_input.time, sizeof(m_input.time))) return false;
+                if ((mask & ReplayWriter::kMouse) && !Get(&m_input.mouse, sizeof(m_input.mouse))) return false;
+                if ((mask & ReplayWriter::kButtons) &&
+                    !(Get(&m_input.mouseDown, 1) && Get(&m_input.mousePressed, 1) && Get(&m_input.mouseReleased, 1))) return false;
+                if ((mask & ReplayWriter::kKeysDown) && !Get(&m_input.keysDown, sizeof(m_input.keysDown))) return false;
+                if ((mask & ReplayWriter::kKeysPressed) && !Get(&m_input.keysPressed, sizeof(m_input.keysPressed))) return false;
+                if ((mask & ReplayWriter::kWorld) && !Get(&m_input.world, sizeof(m_input.world))) return false;
+                ev.input = m_input;
+                return true;
+            }
+            case ReplayEventType::Step:
+                if (!Get(&ev.dt, sizeof(ev.dt)) || !Get(&ev.stepCap, 1) || !Get(&ev.stepCount, 1)) return false;
+                if (ev.stepCount > kReplayMaxSteps) return false;
+                return Get(ev.subSteps, ev.stepCount);
+            case ReplayEventType::Panel:
+                return true;
+            case ReplayEventType::Ui:
+                return Get(&ev.command, 1) && Get(&ev.arg, 1);
+            case ReplayEventType::Hash:
+                if (!Get(&ev.hashCount, 1) || ev.hashCount > kReplayMaxSteps) return false;
+                return Get(ev.hashes, sizeof(uint64_t) * ev.hashCount);
+        }
+        return false;
+    }
+
+private:
+    bool Get(void* out, size_t bytes)
+    {
+        if (m_file.Size() - m_offset < bytes) return false;
+        std::memcpy(out, m_file.Data() + m_offset, bytes);
+        m_offset += bytes;
+        return true;
+    }
+
+    MappedFile m_file;
+    ReplayHeader m_header{};
+    size_t m_offset = 0;
+    InputFrame m_input;
+};
@@ -0,0 +1,289 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <utility>
+#include <vector>
+
+// What the rewind buffer keeps per body: pose as an angle so a delta is one
+// number, centre-of-mass velocity, and whether it was asleep.
+struct RewindState
+{
+    float px = 0.0f;
+    float py = 0.0f;
+    float angle = 0.0f;
+    float vx = 0.0f;
+    float vy = 0.0f;
+    float w = 0.0f;
+    bool asleep = false;
+};
+
+// Rolling history of the scene in a fixed memory budget. A segment starts
+// with a keyframe (a scene image plus every body's state, by slot) and holds
+// the frames captured after it while the set of bodies stays the same; each
+// frame stores only the slots that moved since the one before. Moves are
+// quantized against the state the decoder will have reconstructed, so error
+// does not build up along a segment, and anything out of the int16 range is
+// stored in full. Seeking decodes at most one segment. The budget is enforced
+// by dropping whole segments from the front, never the newest.
+class RewindBuffer
+{
+public:
+    struct Segment
+    {
+        uint64_t step = 0;
+        std::vector<uint8_t> image;
+        std::vector<uint32_t> recordSlots; // slot of each body record in image
+        std::vector<RewindState> base;     // by slot
+        std::vector<uint64_t> frameSteps;  // frame 0 is the keyframe itself
+        std::vector<uint32_t> frameOffsets; // into deltas, one per frame after 0
+        std::vector<uint8_t> deltas;
+
+        size_t Bytes() const
+        {
+            return image.size() + recordSlots.size() * sizeof(uint32_t) + base.size() * sizeof(RewindState) +
+                   frameSteps.size() * sizeof(uint64_t) + frameOffsets.size() * sizeof(uint32_t) + deltas.size();
+        }
+    };
+
+    explicit RewindBuffer(size_t budgetBytes = size_t{32} << 20) : m_budget(budgetBytes) {}
+
+    void SetBudget(size_t bytes)
+    {
+        m_budget = bytes;
+        EnforceBudget();
+    }
+
+    void Clear()
+    {
+        m_segments.clear();
+        m_bytes = 0;
+        m_frameCount = 0;
+        m_cursor = 0;
+        m_shadow.clear();
+    }
+
+    size_t Bytes() const { return m_bytes; }
+    size_t Budget() const { return m_budget; }
+    size_t FrameCount() const { return m_frameCount; }
+    size_t Cursor() const { return m_cursor; }
+    size_t KeyframeCount() const { return m_segments.size(); }
+    bool Empty() const { return m_frameCount == 0; }
+    // Frames a delta could still join: the newest segment's, unless a seek
+    // left the cursor behind the head (the next capture truncates then).
+    size_t FramesSinceKeyframe() const { return m_segments.empty() ? 0 : m_segments.back().frameSteps.size(); }
+    bool AtHead() const { return m_frameCount == 0 || m_cursor + 1 == m_frameCount; }
+
+    uint64_t StepAt(size_t frame) const
+    {
+        auto [seg, local] = Locate(frame);
+        return m_segments[seg].frameSteps[local];
+    }
+
+    void PushKeyframe(uint64_t step, std::vector<uint8_t>&& image, std::vector<uint32_t>&& recordSlots, std::vector<RewindState>&& base)
+    {
+        TruncateAfterCursor();
+        Segment seg;
+        seg.step = step;
+        seg.image = std::move(image);
+        seg.recordSlots = std::move(recordSlots);
+        seg.base = std::move(base);
+        seg.frameSteps.push_back(step);
+        m_shadow = seg.base;
+        m_bytes += seg.Bytes();
+        m_segments.push_back(std::move(seg));
+        ++m_frameCount;
+        m_cursor = m_frameCount - 1;
+        EnforceBudget();
+    }
+
+    // states[i] belongs to slots[i]; slots must be among the keyframe's.
+    // False (nothing stored) without a keyframe to join.
+    bool PushDelta(uint64_t step, const uint32_t* slots, const RewindState* states, size_t count)
+    {
+        if (!AtHead() || m_segments.empty()) return false;
+        Segment& seg = m_segments.back();
+        size_t before = seg.Bytes();
+        seg.frameOffsets.push_back(static_cast<uint32_t>(seg.deltas.size()));
+        seg.frameSteps.push_back(step);
+        uint32_t n = 0;
+        size_t countAt = seg.deltas.size();
+        seg.deltas.resize(countAt + sizeof(n));
+        for (size_t i = 0; i < count; ++i)
+        {
+            if (slots[i] >= m_shadow.size()) continue;
+            Encode(slots[i], states[i], seg.deltas);
+            ++n;
+        }
+        std::memcpy(seg.deltas.data() + countAt, &n, sizeof(n));
+        m_bytes += seg.Bytes() - before;
+        ++m_frameCount;
+        m_cursor = m_frameCount - 1;
+        EnforceBudget();
+        return true;
+    }
+
+    // Reconstructs every slot's state at frame and moves the cursor there.
+    // Returns the segment whose image to load, or nullptr past the end.
+    const Segment* Seek(size_t frame, std::vector<RewindState>& states)
+    {
+        if (frame >= m_frameCount) return nullptr;
+        auto [segIndex, local] = Locate(frame);
+        const Segment& seg = m_segments[segIndex];
+        states = seg.base;
+        for (size_t f = 1; f <= local; ++f) Decode(seg, f, states);
+        m_cursor = frame;
+        return &seg;
+    }
+
+private:
+    static constexpr uint32_t kFullRecord = 1u << 31;
+    static constexpr uint32_t kAsleep = 1u << 30;
+    static constexpr uint32_t kSlotMask = kAsleep - 1;
+    // Units per meter, radian, meter/second and radian/second.
+    static constexpr float kPosScale = 4096.0f;
+    static constexpr float kAngleScale = 8192.0f;
+    static constexpr float kVelScale = 256.0f;
+
+    static bool Quantize(float d, float scale, int16_t& out)
+    {
+        float q = std::nearbyint(d * scale);
+        if (!(std::abs(q) <= 32767.0f)) return false;
+        out = static_cast<int16_t>(q);
+        return true;
+    }
+
+    // Shared by encoder and decoder so both land on the same floats.
+    static void ApplyQuantized(RewindState& s, const int16_t q[6])
+    {
+        s.px += static_cast<float>(q[0]) / kPosScale;
+        s.py += static_cast<float>(q[1]) / kPosScale;
+        s.angle += static_cast<float>(q[2]) / kAngleScale;
+        s.vx += static_cast<float>(q[3]) / kVelScale;
+        s.vy += static_cast<float>(q[4]) / kVelScale;
+        s.w += static_cast<float>(q[5]) / kVelScale;
+    }
+
+    void Encode(uint32_t slot, const RewindState& s, std::vector<uint8_t>& out)
+    {
+        RewindState& prev = m_shadow[slot];
+        float dAngle = std::remainder(s.angle - prev.angle, 6.28318531f);
+        int16_t q[6];
+        bool fits = Quantize(s.px - prev.px, kPosScale, q[0]) && Quantize(s.py - prev.py, kPosScale, q[1]) &&
+                    Quantize(dAngle, kAngleScale, q[2]) && Quantize(s.vx - prev.vx, kVelScale, q[3]) &&
+                    Quantize(s.vy - prev.vy, kVelScale, q[4]) && Quantize(s.w - prev.w, kVelScale, q[5]);
+        uint32_t tag = (slot & kSlotMask) | (s.asleep ? kAsleep : 0u) | (fits ? 0u : kFullRecord);
+        size_t at = out.size();
+        if (fits)
+        {
+            out.resize(at + sizeof(tag) + sizeof(q));
+            std::memcpy(out.data() + at + sizeof(tag), q, sizeof(q));
+            ApplyQuantized(prev, q);
+        }
+        else
+        {
+            const float full[6] = {s.px, s.py, s.angle, s.vx, s.vy, s.w};
+            out.resize(at + sizeof(tag) + sizeof(full));
+            std::memcpy(out.data() + at + sizeof(tag), full, sizeof(full));
+            prev = s;
+        }
+        std::memcpy(out.data() + at, &tag, sizeof(tag));
+        prev.asleep = s.asleep;
+    }
+
+    static void Decode(const Segment& seg, size_t frame, std::vector<RewindState>& states)
+    {
+        const uint8_t* p = seg.deltas.data() + seg.frameOffsets[frame - 1];
+        uint32_t n;
+        std::memcpy(&n, p, sizeof(n));
+        p += sizeof(n);
+        for (uint32_t i = 0; i < n; ++i)
+        {
+            uint32_t tag;
+            std::memcpy(&tag, p, sizeof(tag));
+            p += sizeof(tag);
+            RewindState& s = states[tag & kSlotMask];
+            if (tag & kFullRecord)
+            {
+                float full[6];
+                std::memcpy(full, p, sizeof(full));
+                p += sizeof(full);
+                s.px = full[0];
+                s.py = full[1];
+                s.angle = full[2];
+                s.vx = full[3];
+                s.vy = full[4];
+                s.w = full[5];
+            }
+            else
+            {
+                int16_t q[6];
+                std::memcpy(q, p, sizeof(q));
+                p += sizeof(q);
+                ApplyQuantized(s, q);
+            }
+            s.asleep = (tag & kAsleep) != 0;
+        }
+    }
+
+    std::pair<size_t, size_t> Locate(size_t frame) const
+    {
+        size_t seg = 0;
+        while (frame >= m_segments[seg].frameSteps.size())
+        {
+            frame -= m_segments[seg].frameSteps.size();
+            ++seg;
+        }
+        return {seg, frame};
+    }
+
+    // A capture after seeking back forks history: the frames past the
+    // cursor are gone, and the next capture has to be a keyframe since the
+    // seek rebuilt the scene.
+    void TruncateAfterCursor()
+    {
+        if (AtHead()) return;
+        auto [segIndex, local] = Locate(m_cursor);
+        while (m_segments.size() > segIndex + 1)
+        {
+            m_bytes -= m_segments.back().Bytes();
+            m_frameCount -= m_segments.back().frameSteps.size();
+            m_segments.pop_back();
+        }
+        Segment& seg = m_segments.back();
+        size_t before = seg.Bytes();
+        m_frameCount -= seg.frameSteps.size() - (local + 1);
+        seg.frameSteps.resize(local + 1);
+        if (local < seg.frameOffsets.size())
+        {
+            seg.deltas.resize(seg.frameOffsets[local]);
+            seg.frameOffsets.resize(local);
+        }
+        m_bytes -= before - seg.Bytes();
+        m_shadow.clear();
+    }
+
+    void EnforceBudget()
+    {
+        while (m_bytes > m_budget && m_segments.size() > 1)
+        {
+            size_t frames = m_segments.front().frameSteps.size();
+            m_bytes -= m_segments.front().Bytes();
+            m_frameCount -= frames;
+            m_cursor = m_cursor >= frames ? m_cursor - frames : 0;
+            m_segments.pop_front();
+        }
+    }
+
+    std::deque<Segment> m_segments;
+    size_t m_budget;
+    size_t m_bytes = 0;
+    size_t m_frameCount = 0;
+    size_t m_cursor = 0;
+    // Encoder's copy of what the decoder has for the newest segment.
+    std::vector<RewindState> m_shadow;
+};
@@ -0,0 +1,6462 @@
+#pragma once
+
+#include <box2d/box2d.h>
+
+#include "adhesion_pool.h"
+#include "box2d_heap.h"
+#include "command_queue.h"
+#include "convex_decompose.h"
+#include "debris_pool.h"
+#include "deferred_work.h"
+#include "frame_arena.h"
+#include "frame_profiler.h"
+#include "gpu_spawn_queue.h"
+#include "net_stream.h"
+#include "particle_grid.h"
+#include "particle_pool.h"
+#include "replay.h"
+#include "rewind_buffer.h"
+#include "scene_file.h"
+#include "scenario.h"
+#include "scene_loader.h"
+#include "shallow_water.h"
+#include "shape_table.h"
+#include "sim_types.h"
+#include "slot_map.h"
+#include "state_hash.h"
+#include "step_controller.h"
+#include "task_scheduler.h"
+#include "telemetry.h"
+#include "trace_zones.h"
+#include "transform_export.h"
+#include "triple_buffer.h"
+#include "ui_text.h"
+#include "wave_kernels.h"
+#include "water_stage.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+enum class Theme
+{
+    Dark,
+    Light
+};
+
+enum class SceneLocation
+{
+    Water, // 1D spring surface
+    Land,
+    Shallow // shallow-water columns with volume and Archimedes buoyancy
+};
+
+enum class BodyKind : uint8_t
+{
+    Box,
+    Circle,
+    Triangle,
+    Polygon,
+    Compound // merged weld group; parts in BodyCold::parts, shape is their hull
+};
+
+enum class Tool
+{
+    Cursor,
+    Weld,
+    Wheel,
+    Bounce,
+    Slip,
+    Sticky,
+    Glass,
+    Blast
+};
+
+enum class DrawTool
+{
+    None,
+    Quad,
+    Circle,
+    Triangle,
+    Freeform
+};
+
+// Panel button actions; recorded so a replay can apply them without the UI.
+enum class UiCommand : uint8_t
+{
+    Defaults,
+    ResetScene,
+    SpawnBox,
+    SpawnCircle,
+    SpawnTriangle,
+    SetTool,     // arg: Tool
+    SetDrawTool, // arg: DrawTool
+    SetLocation, // arg: SceneLocation
+    TogglePause,
+    ToggleLanguage,
+    ToggleTheme,
+    TogglePixelate,
+    SpawnGrid, // arg: SpawnShape
+    SpawnRain  // arg: SpawnShape
+};
+
+// Shapes the Q/W/E keys and the batch tools spawn.
+enum class SpawnShape : uint8_t
+{
+    Box,
+    Circle,
+    Triangle
+};
+
+// World mutations the input pass asks for. Input handlers only enqueue
+// them; the simulation applies them in order at the start of its frame, so
+// input never touches the world. Whatever a command needs from the frame's
+// input (cursor, tool, time) travels with it.
+enum class SimCommandType : uint8_t
+{
+    View,        // rect: visible area for snapshot culling
+    Ui,          // arg: UiCommand, arg2: its argument, a: cursor
+    ResetScene,
+    UndoSpawn,
+    ToggleRigid, // a
+    Copy,
+    Paste,       // a, flag: array
+    Duplicate,   // flag: array
+    Spawn,       // arg: SpawnShape, a, flag: grid
+    Rain,        // arg: SpawnShape, a
+    Spray,       // arg: SpawnShape, a
+    Rotate,      // value: radians, flag: snap to 15 degrees
+    WaveKick,    // a, flag: key kick rather than the A/D ripple
+    WaterPoke,   // a, value: wave impulse, value2: splash energy or 0
+    Delete,      // a
+    DrawSpawn,   // arg: DrawTool, a -> b, flag: perfect circle
+    Stroke,      // points
+    DragBegin,   // a, value: input time
+    DragTo,      // a, value: input time
+    DragEnd,
+    ToolClick,   // arg: Tool, a, value: input time
+    Rewind,      // value: captures to move, negative is back
+    FastForward  // value: simulated seconds, 0 until asleep; flag: stop instead
+};
+
+struct SimCommand
+{
+    SimCommandType type = SimCommandType::View;
+    uint8_t arg = 0;
+    uint8_t arg2 = 0;
+    bool flag = false;
+    float value = 0.0f;
+    float value2 = 0.0f;
+    Vector2 a{0, 0};
+    Vector2 b{0, 0};
+    Rectangle rect{0, 0, 0, 0};
+    // View: the render frame's input sample, echoed back in the snapshot.
+    uint32_t serial = 0;
+    std::vector<Vector2> points;
+};
+
+// A SimCommand as a netstream Command message, from a remote viewer.
+inline void EncodeCommand(const SimCommand& c, netstream::ByteWriter& out)
+{
+    size_t at = out.BeginMessage(netstream::MessageType::Command);
+    out.U8(static_cast<uint8_t>(c.type));
+    out.U8(c.arg);
+    out.U8(c.arg2);
+    out.U8(c.flag ? 1 : 0);
+    for (float v : {c.value, c.value2, c.a.x, c.a.y, c.b.x, c.b.y, c.rect.x, c.rect.y, c.rect.width, c.rect.height}) out.F32(v);
+    out.Varint(c.points.size());
+    for (const Vector2& p : c.points)
+    {
+        out.F32(p.x);
+        out.F32(p.y);
+    }
+    out.EndMessage(at);
+}
+
+inline constexpr uint32_t kMaxRemoteCommandPoints = 4096;
+
+// False for malformed payloads and for View, which belongs to the local
+// render loop.
+inline bool DecodeCommand(const uint8_t* payload, size_t size, SimCommand& c)
+{
+    netstream::ByteReader r(payload, size);
+    uint8_t type = 0, flag = 0;
+    if (!r.U8(type) || type > static_cast<uint8_t>(SimCommandType::FastForward) || type == static_cast<uint8_t>(SimCommandType::View)) return false;
+    c = SimCommand{};
+    c.type = static_cast<SimCommandType>(type);
+    r.U8(c.arg);
+    r.U8(c.arg2);
+    r.U8(flag);
+    c.flag = flag != 0;
+    for (float* v : {&c.value, &c.value2, &c.a.x, &c.a.y, &c.b.x, &c.b.y, &c.rect.x, &c.rect.y, &c.rect.width, &c.rect.height}) r.F32(*v);
+    uint32_t count = 0;
+    if (!r.Count(count, kMaxRemoteCommandPoints + 1)) return false;
+    c.points.resize(count);
+    for (Vector2& p : c.points)
+    {
+        r.F32(p.x);
+        r.F32(p.y);
+    }
+    return r.Ok() && r.AtEnd();
+}
+
+// Packed feature bits of BodyEntry::features.
+enum BodyFeature : uint8_t
+{
+    kFeatureWheel = 1u << 0,
+    kFeatureBouncy = 1u << 1,
+    kFeatureSlippery = 1u << 2,
+    kFeatureSticky = 1u << 3,
+    kFeatureGlass = 1u << 4,
+    kFeatureSelected = 1u << 5
+};
+
+// Transform export flags: the feature bits plus whether the body is awake.
+static constexpr uint8_t kExportFeatureMask = 0x3f;
+static constexpr uint8_t kExportAwake = 1u << 7;
+// Streamed flags: the feature bits without the selection, which is the
+// server's own.
+static constexpr uint8_t kStreamFeatureMask = 0x1f;
+
+// Hot per-body data walked by every per-frame loop. State that only some
+// bodies or some passes need lives in BodyCold.
+struct BodyEntry
+{
+    b2BodyId bodyId = b2_nullBodyId;
+    ShapeTable::Id shape = ShapeTable::kEmpty; // outline in SandboxCore::m_shapes
+    float radiusPx = 0.0f;
+    BodyKind kind = BodyKind::Box;
+    uint8_t features = 0;
+
+    bool Has(uint8_t f) const { return (features & f) != 0; }
+    void Set(uint8_t f, bool on) { features = static_cast<uint8_t>(on ? (features | f) : (features & ~f)); }
+};
+
+static_assert(sizeof(BodyEntry) <= 20, "keep BodyEntry hot and small");
+
+// One former body inside a compound, placed in the compound's local frame.
+struct RigidPart
+{
+    b2Transform local = b2Transform_identity;
+    b2ShapeId shapeId = b2_nullShapeId;
+    ShapeTable::Id shape = ShapeTable::kEmpty;
+    float radiusPx = 0.0f;
+    float density = 1.0f;
+    BodyKind kind = BodyKind::Box;
+    uint8_t features = 0;
+};
+
+// A joint between two parts of a compound, restored when it splits. Frames
+// are in each part's own local space.
+struct RigidJoint
+{
+    uint32_t partA = 0;
+    uint32_t partB = 0;
+    b2Transform frameA = b2Transform_identity;
+    b2Transform frameB = b2Transform_identity;
+    bool wheel = false;
+};
+
+// A concave freeform outline cut into convex parts, cached by stroke so a
+// repeated or duplicated stroke skips the decomposition. No parts means the
+// stroke spawns as a single hull.
+struct FreeformPieces
+{
+    std::vector<RigidPart> parts; // shapeId unset
+    std::vector<RigidJoint> welds;
+    ShapeTable::Id hull = ShapeTable::kEmpty;
+    float radiusPx = 0.0f;
+};
+
+// Bodies lifted out of the world for copy/paste and duplicate. Transforms
+// are relative to the clip's origin; outlines stay interned ids and Box2D
+// geometry is kept as created, so pasting never rebuilds a hull.
+struct ClipBody
+{
+    b2Transform xf = b2Transform_identity;
+    BodyKind kind = BodyKind::Box;
+    uint8_t features = 0;
+    ShapeTable::Id shape = ShapeTable::kEmpty;
+    float radiusPx = 0.0f;
+    float density = 1.0f;
+    b2Polygon polygon{};
+    b2Circle circle{};
+    std::vector<RigidPart> parts; // Compounds only, shapeId unset
+    std::vector<RigidJoint> partJoints;
+};
+
+// A joint between two clip bodies, by index.
+struct ClipJoint
+{
+    uint32_t bodyA = 0;
+    uint32_t bodyB = 0;
+    b2Transform frameA = b2Transform_identity;
+    b2Transform frameB = b2Transform_identity;
+    bool wheel = false;
+};
+
+struct BodyClip
+{
+    std::vector<ClipBody> bodies;
+    std::vector<ClipJoint> joints;
+    Vector2 halfExtentPx{0.0f, 0.0f}; // of the copied bodies' bounds
+};
+
+// Cold per-body state, indexed by the body's slot in SandboxCore::m_bodies
+// (fixed for its lifetime) so erasing a body never moves it.
+struct BodyCold
+{
+    float glassStress = 0.0f;
+    int glassGraceFrames = 0;
+    bool glassActive = false; // in SandboxCore::m_activeGlass
+
+    // Transform from the last step's move event (or insertion). Exact for
+    // resting bodies, which is what the snapshot reads it for.
+    b2Transform xf = b2Transform_identity;
+
+    // Entered the water sensor and not yet wet: the first wet step decides
+    // whether it splashes.
+    bool waterEntry = false;
+
+    // Handles into SandboxCore::m_joints for joints attached to this body.
+    std::vector<SlotHandle> joints;
+    uint32_t visitMark = 0;
+    // Spawn sequence number. Later bodies draw on top and win picks; dense
+    // order stops matching it once a delete swaps the last body into a hole.
+    uint64_t order = 0;
+
+    // Compounds only.
+    std::vector<RigidPart> parts;
+    std::vector<RigidJoint> partJoints;
+};
+
+// Geometry and surface for one SpawnShape, built once and shared by every body
+// spawned from it. The surface matches what ApplyBodySurface gives a plain body.
+struct SpawnTemplate
+{
+    BodyKind kind = BodyKind::Box;
+    b2ShapeDef shapeDef{};
+    b2Polygon polygon{};
+    b2Circle circle{};
+    ShapeTable::Id shape = ShapeTable::kEmpty;
+    float radiusPx = 0.0f;
+    float halfWidthPx = 0.0f;
+    float halfHeightPx = 0.0f;
+    float linearDamping = 0.08f;
+    float angularDamping = 1.2f;
+};
+
+// World-wide tuning that SlopSweep varies between runs; the defaults are the
+// sandbox's own. Damping scales multiply the per-surface values.
+struct SimTuning
+{
+    float glassBreakScale = 1.0f;
+    float contactHertz = 45.0f;
+    float contactDampingRatio = 1.2f;
+    float contactPushMaxVelocity = 2.0f; // m/s
+    float linearDampingScale = 1.0f;
+    float angularDampingScale = 1.0f;
+};
+
+struct JointEntry
+{
+    b2JointId jointId = b2_nullJointId;
+    uint64_t bodyA = 0;
+    uint64_t bodyB = 0;
+    bool isWheelJoint = false;
+    // Limits past which the joint breaks; 0 never breaks.
+    float breakForce = 0.0f; // N
+    float breakTorque = 0.0f; // N*m
+};
+
+// A joint that broke during the last step. Box2D checks the limits in its
+// joint solve, so only joints between awake bodies ever break.
+struct JointBreakEvent
+{
+    uint64_t bodyA = 0;
+    uint64_t bodyB = 0;
+    Vector2 anchorPx{};
+    bool wheel = false;
+};
+
+// Everything the renderer needs from one simulation tick. Built by the thread
+// that owns the world and handed to the render thread via a TripleBuffer.
+struct SnapshotBody
+{
+    uint64_t key = 0;
+    b2Transform xf{};
+    BodyKind kind = BodyKind::Box;
+    float radiusPx = 0.0f;
+    Color fill{};
+    bool selected = false;
+    bool isWheel = false;
+    bool isDebris = false; // shape indexes RenderSnapshot::debrisShapes
+    ShapeTable::Id shape = ShapeTable::kEmpty;
+};
+
+struct RenderSnapshot
+{
+    double wallTime = 0.0;
+    std::vector<SnapshotBody> bodies; // awake bodies and debris, interpolated
+    // Sleeping bodies. Only rebuilt when restingVersion falls behind the
+    // sandbox's, so a settled pile costs nothing per publish.
+    std::vector<SnapshotBody> resting;
+    uint32_t restingVersion = 0;
+    // Copy of the interned table; it only grows, so publishing appends the tail.
+    std::vector<ShapeGeometry> shapes;
+    std::vector<ShapeGeometry> debrisShapes;
+    ParticleFrame shards;
+    ParticleFrame waterChunks;
+    std::vector<float> waveDisp;
+    float worldWidth = 0.0f; // px; the camera follows it
+    bool pendingWeldValid = false;
+    bool selecting = false;
+    Rectangle selectionRect{0, 0, 0, 0};
+    // Seconds the scene was rewound behind the newest capture, and how much
+    // history the buffer holds.
+    float rewindBehindS = 0.0f;
+    float rewindSpanS = 0.0f;
+    size_t rewindBytes = 0;
+    int workerCount = 1;
+    // Step controller state after the frame's last step.
+    int subSteps = 4;
+    int catchUpSteps = 0;
+    float stepBudgetMs = 0.0f;
+    StepController::Decision stepDecision = StepController::Decision::Hold;
+    int bulletBudget = 0;
+    // Box2D heap counters, read on the physics thread.
+    box2d_heap::Stats b2HeapTotal;
+    size_t b2HeapPooledBytes = 0;
+    std::array<box2d_heap::Stats, static_cast<size_t>(box2d_heap::Subsystem::Count)> b2HeapSubsystems{};
+    std::array<float, static_cast<size_t>(box2d_heap::Subsystem::Count)> b2AllocsPerSecond{};
+    // Bodies kept out of the world by region hibernation, and their images' size.
+    size_t hibernatedBodies = 0;
+    size_t hibernatedRegions = 0;
+    size_t hibernatedBytes = 0;
+    bool hibernation = false;
+    size_t adhesions = 0;
+    size_t adhesionsQueued = 0;
+    DeferredStats deferred; // last frame's particle jobs
+    float sceneLoad = -1.0f; // background load progress, 0..1; < 0 without one
+    uint32_t inputSerial = 0; // last input sample whose commands it includes
+    bool fastForward = false;
+    float fastForwardS = 0.0f; // simulated so far
+};
+
+static constexpr float kPixelsPerMeter = 50.0f;
+static constexpr float kInvPixelsPerMeter = 1.0f / kPixelsPerMeter;
+static constexpr float kBaseSizePx = 56.0f;
+// Convex parts a freeform stroke may become before it is simplified harder.
+static constexpr int kMaxFreeformPieces = 8;
+static constexpr size_t kFreeformCacheSize = 256;
+static constexpr float kBaseHalfPx = kBaseSizePx * 0.5f;
+static constexpr size_t kMaxGlassShards = 4096;
+static constexpr size_t kMaxWaterChunks = 4096;
+// Idle rendering: frames without input before a scene at rest stops being
+// stepped and drawn, the column speed (px/s) under which the water counts
+// as still, and how long GPU particles outlive their last emission.
+static constexpr int kIdleEnterFrames = 30;
+static constexpr float kIdleWaveSpeedPx = 0.5f;
+static constexpr float kIdleParticleLingerS = 1.0f;
+// Particle radius the collision grids are sure to find bodies for; the rare
+// bigger shard only sinks a little further in before it is pushed out.
+static constexpr float kParticleGridMarginPx = 4.0f;
+// Shards slower than this into the water sink instead of skipping off it.
+static constexpr float kShardSkimSpeedPx = 260.0f;
+static constexpr size_t kDebrisPoolSize = 256;
+static constexpr int kDebrisActivationsPerStep = 48;
+static constexpr size_t kAdhesionPoolSize = 512;
+static constexpr int kAdhesionsPerStep = 24;
+// Per frame for particle emission left over from bursts.
+static constexpr double kDeferredBudgetMs = 0.5;
+// Per frame for inserting a background scene load; records between clock reads.
+static constexpr double kSceneInsertBudgetMs = 6.0;
+static constexpr size_t kSceneInsertBatch = 32;
+static constexpr float kGroundHalfThicknessPx = 24.0f;
+
+static b2Vec2 ToMeters(Vector2 p)
+{
+    return {p.x * kInvPixelsPerMeter, p.y * kInvPixelsPerMeter};
+}
+
+static Vector2 ToPixels(b2Vec2 p)
+{
+    return {p.x * kPixelsPerMeter, p.y * kPixelsPerMeter};
+}
+
+// Contact solver variant Box2D picked at first step (see b2SetSimdLevel).
+static const char* SimdLevelName(b2SimdLevel level)
+{
+    switch (level)
+    {
+    case b2_simdAVX2: return "avx2";
+    case b2_simdSSE2: return "sse2";
+    case b2_simdNEON: return "neon";
+    default: return "scalar";
+    }
+}
+
+static uint64_t BodyKey(b2BodyId id)
+{
+    return b2StoreBodyId(id);
+}
+
+// Snapshot keys for debris pieces. Body keys keep the index in the high half,
+// which never reaches the top bit.
+static constexpr uint64_t kDebrisSnapshotKey = uint64_t{1} << 63;
+
+static float CombineFrictionMax(float frictionA, uint64_t, float frictionB, uint64_t)
+{
+    return std::max(frictionA, frictionB);
+}
+
+static float CombineRestitutionMin(float restitutionA, uint64_t, float restitutionB, uint64_t)
+{
+    return std::min(restitutionA, restitutionB);
+}
+
+// The simulation side of the sandbox: Box2D world, bodies, joints, water,
+// glass, the tools driven by InputFrame, recording and replay, and the
+// snapshots the renderer draws. Needs no window or raylib; SlopSandbox
+// (slop_sandbox.h) adds those on top, and the headless tools use it as is.
+class SandboxCore
+{
+public:
+    // workerCount <= 0 picks a worker count from hardware concurrency.
+    explicit SandboxCore(int width, int height, int workerCount = 0)
+        : m_width(width), m_height(height), m_worldWidth(static_cast<float>(width))
+    {
+        m_scheduler = std::make_unique<TaskScheduler>(workerCount);
+        for (SpawnShape shape : {SpawnShape::Box, SpawnShape::Circle, SpawnShape::Triangle})
+        {
+            m_spawnTemplates[static_cast<size_t>(shape)] = MakeSpawnTemplate(shape, m_shapes);
+        }
+        InitWorld();
+        ApplyWorldWidth(m_worldWidth);
+        m_panel.x = 10.0f;
+        m_panel.y = 10.0f;
+        m_panel.w = 390.0f;
+    }
+
+    ~SandboxCore()
+    {
+        StopPhysicsThread();
+        if (b2World_IsValid(m_worldId))
+        {
+            box2d_heap::DestroyWorld(m_worldId);
+        }
+    }
+
+    SandboxCore(const SandboxCore&) = delete;
+    SandboxCore& operator=(const SandboxCore&) = delete;
+
+    // Pins Box2D substeps; 0 lets the step controller adapt them to the budget.
+    void SetFixedSubSteps(int subSteps) { m_stepController.Pin(subSteps); }
+
+    // When off, Run() steps physics on the render thread like the headless path.
+    void SetPhysicsThreadEnabled(bool enabled) { m_physicsThreaded = enabled; }
+
+    // Rows for the per-frame transform export (transform_export.h); 0, the
+    // default, turns it off. Set before Run or between headless steps.
+    void SetTransformExportCapacity(uint32_t capacity)
+    {
+        m_transformExport.Allocate(capacity);
+        m_exportMoved.clear();
+        m_exportMovedPrev.clear();
+    }
+    const TransformExport& Transforms() const { return m_transformExport; }
+
+    // Network stream (net_stream.h, served by SlopServer): while on, move
+    // events are kept for the next EncodeStreamFrame.
+    void SetStreaming(bool on)
+    {
+        m_streaming = on;
+        m_streamMoved.clear();
+        m_streamEdits = m_sceneEdits - 1;
+    }
+
+    // Between steps: the changes since the last call. Only bodies with move
+    // events since then are looked at, plus every body once the scene has
+    // been edited (spawns, removals, features), which is how removals show.
+    void EncodeStreamFrame(netstream::FrameEncoder& enc)
+    {
+        SLOP_ZONE("EncodeStreamFrame");
+        enc.Begin(++m_streamSerial);
+        netstream::WorldInfo world;
+        world.width = m_worldWidth;
+        world.groundTop = ActiveGroundTopYPx();
+        world.location = static_cast<uint8_t>(m_sceneLocation);
+        world.waveStep = m_waveStep;
+        world.waveBaseline = m_waveBaselineY;
+        enc.World(world);
+        if (m_streamEdits != m_sceneEdits)
+        {
+            enc.BeginIdentityPass();
+            for (size_t i = 0; i < m_bodies.size(); ++i)
+            {
+                const BodyEntry& e = m_bodies[i];
+                if (enc.NeedsShape(e.shape))
+                {
+                    const ShapeGeometry& g = m_shapes[e.shape];
+                    float xy[2 * ShapeGeometry::kMaxVerts];
+                    for (uint32_t v = 0; v < g.count; ++v)
+                    {
+                        xy[2 * v] = g.verts[v].x;
+                        xy[2 * v + 1] = g.verts[v].y;
+                    }
+                    enc.AddShape(e.shape, xy, g.count);
+                }
+                const b2Transform& xf = m_bodyCold[m_bodies.SlotIndexAt(i)].xf;
+                Vector2 p = ToPixels(xf.p);
+                enc.Identity(BodyKey(e.bodyId), static_cast<uint8_t>(e.kind), static_cast<uint8_t>(e.features & kStreamFeatureMask), e.shape, e.radiusPx, p.x,
+                             p.y, xf.q.c, xf.q.s);
+            }
+            enc.EndIdentityPass();
+            m_streamEdits = m_sceneEdits;
+        }
+        for (uint32_t slot : m_streamMoved)
+        {
+            auto idx = m_bodies.DenseIndexOfSlot(slot);
+            if (!idx) continue;
+            const b2Transform& xf = m_bodyCold[slot].xf;
+            Vector2 p = ToPixels(xf.p);
+            enc.Move(BodyKey(m_bodies[*idx].bodyId), p.x, p.y, xf.q.c, xf.q.s);
+        }
+        m_streamMoved.clear();
+        if (InWater()) enc.Water(m_waveDisp.data(), m_waveDisp.size());
+        else enc.Water(nullptr, 0);
+    }
+
+    // A command from a remote viewer, applied at the start of the next step
+    // like local input.
+    void SubmitRemoteCommand(SimCommand&& c) { Submit(std::move(c)); }
+
+    // Per-step stats into a shared memory ring for other processes
+    // (telemetry.h; read with SlopTelemetry). False when it cannot be created.
+    bool OpenTelemetry(const std::string& name) { return m_telemetry.Open(name); }
+    void CloseTelemetry() { m_telemetry.Close(); }
+
+    // Starts per-frame CSV recording immediately (also toggled with F4).
+    bool OpenProfileCsv(const std::string& path)
+    {
+        m_profileCsvPath = path;
+        return m_profiler.OpenCsv(path.c_str());
+    }
+
+    // Binary scene snapshots (F5 saves, F9 loads m_sceneFilePath in the
+    // background). Both loads validate the whole file before touching the
+    // current scene. Saving fails while a background load is in flight.
+    void SetSceneFilePath(const std::string& path) { m_sceneFilePath = path; }
+
+    bool SaveScene(const std::string& path)
+    {
+        if (m_sceneLoader.Busy()) return false;
+        RestoreAllRegions();
+        std::vector<uint8_t> image;
+        BuildSceneImage(image);
+        return WriteFileAtomic(path, image);
+    }
+
+    bool LoadScene(const std::string& path)
+    {
+        MappedFile file;
+        return file.Open(path.c_str()) && LoadSceneImage(file.Data(), file.Size());
+    }
+
+    // The file is read and prepared on a worker thread, then inserted between
+    // frames kSceneInsertBudgetMs at a time, with the world held still until
+    // it is all in. Replaces a load already in flight. Call with the world
+    // owned, like the commands; a file that fails to load leaves the scene.
+    void LoadSceneAsync(const std::string& path)
+    {
+        CancelSceneLoad();
+        m_sceneLoader.Start(path, &PrepareSceneBody);
+    }
+
+    bool SceneLoading() const { return m_sceneLoader.Busy(); }
+
+    // recordSlots, when given, gets the m_bodies slot of every body record.
+    // only, when given, limits the image to those dense indices and the
+    // joints between them, without wave samples.
+    void BuildSceneImage(std::vector<uint8_t>& out, std::vector<uint32_t>* recordSlots = nullptr, const std::vector<size_t>* only = nullptr)
+    {
+        std::vector<uint32_t> recordOf(m_bodies.size(), UINT32_MAX);
+        std::vector<SceneBodyRecord> bodies;
+        std::vector<float> verts;
+        bodies.reserve(m_bodies.size());
+        verts.reserve(m_bodies.size() * 8);
+        auto addBody = [&](BodyKind kind, uint8_t features, ShapeTable::Id shape, float radiusPx, float density, b2Transform xf, b2Vec2 v,
+                           float w, bool awake, const BodyCold& cold) {
+            SceneBodyRecord r{};
+            r.kind = static_cast<uint32_t>(kind);
+            r.flags = ((features & kFeatureWheel) ? kSceneBodyWheel : 0u) | ((features & kFeatureBouncy) ? kSceneBodyBouncy : 0u) |
+                      ((features & kFeatureSlippery) ? kSceneBodySlippery : 0u) | ((features & kFeatureSticky) ? kSceneBodySticky : 0u) |
+                      ((features & kFeatureGlass) ? kSceneBodyGlass : 0u) | (awake ? kSceneBodyAwake : 0u);
+            r.radiusPx = radiusPx;
+            r.density = density;
+            r.glassStress = cold.glassStress;
+            r.glassGraceFrames = cold.glassGraceFrames;
+            r.vertStart = static_cast<uint32_t>(verts.size() / 2);
+            if (kind != BodyKind::Circle)
+            {
+                const ShapeGeometry& outline = m_shapes[shape];
+                r.vertCount = static_cast<uint32_t>(outline.size());
+                for (const Vector2& p : outline)
+                {
+                    verts.push_back(p.x);
+                    verts.push_back(p.y);
+                }
+            }
+            r.position[0] = xf.p.x;
+            r.position[1] = xf.p.y;
+            r.rotation[0] = xf.q.c;
+            r.rotation[1] = xf.q.s;
+            r.linearVelocity[0] = v.x;
+            r.linearVelocity[1] = v.y;
+            r.angularVelocity = w;
+            bodies.push_back(r);
+        };
+        size_t bodyCount = only ? only->size() : m_bodies.size();
+        for (size_t n = 0; n < bodyCount; ++n)
+        {
+            size_t i = only ? (*only)[n] : n;
+            const BodyEntry& e = m_bodies[i];
+            if (!IsValid(e.bodyId)) continue;
+            b2Transform xf = b2Body_GetTransform(e.bodyId);
+            b2Vec2 v = b2Body_GetLinearVelocity(e.bodyId);
+            float w = b2Body_GetAngularVelocity(e.bodyId);
+            bool awake = b2Body_IsAwake(e.bodyId);
+            if (e.kind == BodyKind::Compound)
+            {
+                // Saved as its parts; the joints between them are flagged rigid.
+                recordOf[i] = static_cast<uint32_t>(bodies.size());
+                b2Vec2 com = b2Body_GetWorldCenterOfMass(e.bodyId);
+                for (const RigidPart& p : Cold(i).parts)
+                {
+                    b2Transform pxf = b2MulTransforms(xf, p.local);
+                    addBody(p.kind, p.features, p.shape, p.radiusPx, p.density, pxf, b2Add(v, b2CrossSV(w, b2Sub(pxf.p, com))), w, awake, Cold(i));
+                }
+                if (recordSlots) recordSlots->resize(bodies.size(), m_bodies.SlotIndexAt(i));
+                continue;
+            }
+            const ShapeGeometry& outline = m_shapes[e.shape];
+            if (e.kind != BodyKind::Circle && (outline.size() < 3 || outline.size() > kSceneMaxPolygonVerts)) continue;
+
+            b2ShapeId shape = b2_nullShapeId;
+            float density = (b2Body_GetShapes(e.bodyId, &shape, 1) == 1) ? b2Shape_GetDensity(shape) : 1.0f;
+            recordOf[i] = static_cast<uint32_t>(bodies.size());
+            addBody(e.kind, e.features, e.shape, e.radiusPx, density, xf, v, w, awake, Cold(i));
+            if (recordSlots) recordSlots->resize(bodies.size(), m_bodies.SlotIndexAt(i));
+        }
+
+        std::vector<SceneJointRecord> joints;
+        joints.reserve(m_joints.size());
+        auto addJoint = [&joints](uint32_t bodyA, uint32_t bodyB, b2Transform fa, b2Transform fb, uint32_t flags) {
+            SceneJointRecord r{};
+            r.bodyA = bodyA;
+            r.bodyB = bodyB;
+            r.flags = flags;
+            const float a[4] = {fa.p.x, fa.p.y, fa.q.c, fa.q.s};
+            const float b[4] = {fb.p.x, fb.p.y, fb.q.c, fb.q.s};
+            std::memcpy(r.frameA, a, sizeof(a));
+            std::memcpy(r.frameB, b, sizeof(b));
+            joints.push_back(r);
+        };
+        // A joint on a compound is saved on the part nearest its anchor.
+        auto jointEnd = [this, &recordOf](size_t idx, b2Transform frame) {
+            if (m_bodies[idx].kind != BodyKind::Compound) return std::make_pair(recordOf[idx], frame);
+            const std::vector<RigidPart>& parts = Cold(idx).parts;
+            uint32_t p = NearestPart(parts, 0, parts.size(), frame.p);
+            return std::make_pair(recordOf[idx] + p, b2InvMulTransforms(parts[p].local, frame));
+        };
+        for (const JointEntry& j : m_joints)
+        {
+            if (!b2Joint_IsValid(j.jointId)) continue;
+            auto ia = BodyIndexByKey(j.bodyA);
+            auto ib = BodyIndexByKey(j.bodyB);
+            if (!ia || !ib || recordOf[*ia] == UINT32_MAX || recordOf[*ib] == UINT32_MAX) continue;
+            auto a = jointEnd(*ia, b2Joint_GetLocalFrameA(j.jointId));
+            auto b = jointEnd(*ib, b2Joint_GetLocalFrameB(j.jointId));
+            addJoint(a.first, b.first, a.second, b.second, j.isWheelJoint ? kSceneJointWheel : 0u);
+        }
+        for (size_t i = 0; i < m_bodies.size(); ++i)
+        {
+            if (recordOf[i] == UINT32_MAX || m_bodies[i].kind != BodyKind::Compound) continue;
+            for (const RigidJoint& j : Cold(i).partJoints)
+            {
+                addJoint(recordOf[i] + j.partA, recordOf[i] + j.partB, j.frameA, j.frameB, kSceneJointRigid | (j.wheel ? kSceneJointWheel : 0u));
+            }
+        }
+
+        SceneFileHeader header{};
+        std::memcpy(header.magic, kSceneFileMagic, sizeof(kSceneFileMagic));
+        header.version = kSceneFileVersion;
+        header.headerSize = sizeof(SceneFileHeader);
+        header.bodyCount = static_cast<uint32_t>(bodies.size());
+        header.jointCount = static_cast<uint32_t>(joints.size());
+        header.vertCount = static_cast<uint32_t>(verts.size() / 2);
+        header.waveSamples = only ? 0u : static_cast<uint32_t>(m_waveDisp.size());
+        header.sceneLocation = static_cast<uint32_t>(m_sceneLocation);
+        header.width = static_cast<int32_t>(m_worldWidth);
+        header.height = m_height;
+        if (only)
+        {
+            AppendSceneImage(out, header, bodies, joints, verts, {}, {});
+        }
+        else if (m_sceneLocation == SceneLocation::Shallow)
+        {
+            AppendSceneImage(out, header, bodies, joints, verts, m_shallow.Depths(), m_shallow.Velocities());
+        }
+        else
+        {
+            AppendSceneImage(out, header, bodies, joints, verts, m_waveDisp, m_waveVel);
+        }
+    }
+
+    // recordBodies, when given, gets the body each record ended up in (null
+    // for skipped records; compound parts share the merged body).
+    bool LoadSceneImage(const uint8_t* data, size_t size, std::vector<b2BodyId>* recordBodies = nullptr)
+    {
+        SceneView view;
+        if (!ParseSceneFile(data, size, view)) return false;
+        CancelSceneLoad();
+        BeginSceneImage(view);
+        std::vector<b2BodyId> bodyIds;
+        AddSceneRecords(view, bodyIds, true);
+        RestoreSceneWaves(view);
+        if (recordBodies) *recordBodies = std::move(bodyIds);
+        return true;
+    }
+
+    // Creates the image's bodies and joints next to whatever the world holds;
+    // bodyIds gets the body of each record as LoadSceneImage describes.
+    // undoable puts them on the undo order.
+    void AddSceneRecords(const SceneView& view, std::vector<b2BodyId>& bodyIds, bool undoable)
+    {
+        const SceneFileHeader& h = *view.header;
+        m_bodies.Reserve(m_bodies.size() + h.bodyCount);
+        m_joints.Reserve(m_joints.size() + h.jointCount);
+
+        // Records are created in file order straight from the mapping; bodyIds
+        // maps record index -> new body for the joint pass.
+        bodyIds.assign(h.bodyCount, b2_nullBodyId);
+        PreparedSceneBody prepared;
+        for (uint32_t i = 0; i < h.bodyCount; ++i)
+        {
+            prepared = PreparedSceneBody{};
+            if (PrepareSceneBody(view, i, prepared)) bodyIds[i] = AddPreparedBody(view, prepared, undoable);
+        }
+
+        SceneRigidGroups groups;
+        groups.Reset(h.bodyCount);
+        for (uint32_t i = 0; i < h.jointCount; ++i) AddSceneJoint(view, i, bodyIds, groups);
+        MergeSceneGroups(bodyIds, groups, undoable);
+    }
+
+    // Turns a record into Box2D definitions without touching the world, so the
+    // background loader can run it on its thread. False skips the record.
+    static bool PrepareSceneBody(const SceneView& view, uint32_t record, PreparedSceneBody& out)
+    {
+        const SceneBodyRecord& r = view.bodies[record];
+        if (r.kind > static_cast<uint32_t>(BodyKind::Polygon)) return false;
+        BodyKind kind = static_cast<BodyKind>(r.kind);
+        if (kind == BodyKind::Circle ? r.radiusPx <= 0.0f : r.vertCount < 3) return false;
+
+        out.record = record;
+        out.bodyDef = DynamicBodyDef({r.position[0], r.position[1]});
+        out.bodyDef.rotation = b2NormalizeRot({r.rotation[0], r.rotation[1]});
+        out.bodyDef.linearVelocity = {r.linearVelocity[0], r.linearVelocity[1]};
+        out.bodyDef.angularVelocity = r.angularVelocity;
+        out.bodyDef.isAwake = (r.flags & kSceneBodyAwake) != 0;
+        out.shapeDef = BodyShapeDef();
+        out.shapeDef.density = r.density;
+        if (kind == BodyKind::Circle)
+        {
+            out.isCircle = true;
+            out.circle.radius = r.radiusPx * kInvPixelsPerMeter;
+            return true;
+        }
+        const float* src = view.verts + size_t{r.vertStart} * 2;
+        b2Vec2 pts[kSceneMaxPolygonVerts];
+        for (uint32_t k = 0; k < r.vertCount; ++k)
+        {
+            pts[k] = {src[2 * k] * kInvPixelsPerMeter, src[2 * k + 1] * kInvPixelsPerMeter};
+        }
+        b2Hull hull = b2ComputeHull(pts, static_cast<int>(r.vertCount));
+        if (hull.count < 3) return false;
+        out.polygon = b2MakePolygon(&hull, 0.0f);
+        return true;
+    }
+
+    b2BodyId AddPreparedBody(const SceneView& view, const PreparedSceneBody& p, bool undoable)
+    {
+        const SceneBodyRecord& r = view.bodies[p.record];
+        b2BodyId body = b2CreateBody(m_worldId, &p.bodyDef);
+        b2Body_SetSleepThreshold(body, kBodySleepThreshold);
+        if (p.isCircle) b2CreateCircleShape(body, &p.shapeDef, &p.circle);
+        else b2CreatePolygonShape(body, &p.shapeDef, &p.polygon);
+
+        BodyEntry entry;
+        entry.bodyId = body;
+        entry.kind = static_cast<BodyKind>(r.kind);
+        entry.radiusPx = r.radiusPx;
+        entry.Set(kFeatureWheel, (r.flags & kSceneBodyWheel) != 0);
+        entry.Set(kFeatureBouncy, (r.flags & kSceneBodyBouncy) != 0);
+        entry.Set(kFeatureSlippery, (r.flags & kSceneBodySlippery) != 0);
+        entry.Set(kFeatureSticky, (r.flags & kSceneBodySticky) != 0);
+        entry.Set(kFeatureGlass, (r.flags & kSceneBodyGlass) != 0);
+        const float* src = view.verts + size_t{r.vertStart} * 2;
+        Vector2 outline[ShapeGeometry::kMaxVerts];
+        for (uint32_t k = 0; k < r.vertCount; ++k) outline[k] = {src[2 * k], src[2 * k + 1]};
+        entry.shape = m_shapes.Intern(outline, r.vertCount);
+        size_t idx = InsertBody(std::move(entry));
+        Cold(idx).glassStress = r.glassStress;
+        Cold(idx).glassGraceFrames = r.glassGraceFrames;
+        ApplyBodySurface(idx);
+        if (undoable) PushSpawnOrder(body);
+        return body;
+    }
+
+    // Records joined by rigid joints were one compound: they are unioned, in
+    // file order, as their joints are created, and each group is merged once
+    // all of them exist.
+    struct SceneRigidGroups
+    {
+        std::vector<uint32_t> group;
+        bool any = false;
+
+        void Reset(uint32_t count)
+        {
+            group.resize(count);
+            for (uint32_t i = 0; i < count; ++i) group[i] = i;
+            any = false;
+        }
+
+        uint32_t Root(uint32_t i)
+        {
+            while (group[i] != i) i = group[i] = group[group[i]];
+            return i;
+        }
+    };
+
+    // Bodies since deleted, e.g. during a background load, leave the joint out.
+    void AddSceneJoint(const SceneView& view, uint32_t joint, const std::vector<b2BodyId>& bodyIds, SceneRigidGroups& groups)
+    {
+        const SceneJointRecord& r = view.joints[joint];
+        b2BodyId a = bodyIds[r.bodyA];
+        b2BodyId b = bodyIds[r.bodyB];
+        if (!b2Body_IsValid(a) || !b2Body_IsValid(b)) return;
+        b2Transform fa{{r.frameA[0], r.frameA[1]}, b2NormalizeRot({r.frameA[2], r.frameA[3]})};
+        b2Transform fb{{r.frameB[0], r.frameB[1]}, b2NormalizeRot({r.frameB[2], r.frameB[3]})};
+        CreateJointWithFrames(a, b, fa, fb, (r.flags & kSceneJointWheel) != 0);
+        if (!(r.flags & kSceneJointRigid)) return;
+        uint32_t ra = groups.Root(r.bodyA);
+        uint32_t rb = groups.Root(r.bodyB);
+        groups.group[std::max(ra, rb)] = std::min(ra, rb);
+        groups.any = true;
+    }
+
+    void MergeSceneGroups(std::vector<b2BodyId>& bodyIds, SceneRigidGroups& groups, bool undoable)
+    {
+        if (!groups.any) return;
+        std::vector<std::pair<uint32_t, uint32_t>> members; // (group root, record)
+        for (uint32_t i = 0; i < bodyIds.size(); ++i)
+        {
+            if (!B2_IS_NULL(bodyIds[i])) members.push_back({groups.Root(i), i});
+        }
+        std::sort(members.begin(), members.end());
+        std::vector<size_t> indices;
+        for (size_t k = 0; k < members.size();)
+        {
+            size_t end = k;
+            indices.clear();
+            for (; end < members.size() && members[end].first == members[k].first; ++end)
+            {
+                if (auto idx = BodyIndexById(bodyIds[members[end].second])) indices.push_back(*idx);
+            }
+            std::optional<size_t> merged = indices.size() > 1 ? RigidifyBodies(indices) : std::nullopt;
+            if (merged)
+            {
+                for (size_t m = k; m < end; ++m) bodyIds[members[m].second] = m_bodies[*merged].bodyId;
+                if (!undoable) m_spawnOrder.pop_back();
+            }
+            k = end;
+        }
+    }
+
+    void CancelSceneLoad()
+    {
+        m_sceneLoader.Cancel();
+        m_sceneInsert = SceneInsert{};
+    }
+
+    // Adds a Ready background load to the world, kSceneInsertBudgetMs of it
+    // per call. True until it is all in; the caller does not step meanwhile,
+    // or bodies inserted late would land among ones that had moved.
+    bool InsertLoadedScene()
+    {
+        SceneLoader::State state = m_sceneLoader.GetState();
+        if (state == SceneLoader::State::Failed) m_sceneLoader.Cancel();
+        if (state != SceneLoader::State::Ready) return false;
+        SLOP_ZONE("InsertLoadedScene");
+        using Clock = std::chrono::steady_clock;
+        const Clock::time_point end = Clock::now() + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double, std::milli>(kSceneInsertBudgetMs));
+        const SceneView& view = m_sceneLoader.View();
+        const SceneFileHeader& h = *view.header;
+        const std::vector<PreparedSceneBody>& prepared = m_sceneLoader.Bodies();
+        SceneInsert& s = m_sceneInsert;
+        if (!s.started)
+        {
+            BeginSceneImage(view);
+            m_bodies.Reserve(m_bodies.size() + prepared.size());
+            m_joints.Reserve(m_joints.size() + h.jointCount);
+            s.bodyIds.assign(h.bodyCount, b2_nullBodyId);
+            s.groups.Reset(h.bodyCount);
+            s.started = true;
+        }
+        // One record takes microseconds, so the clock is only read per batch.
+        while (s.nextBody < prepared.size())
+        {
+            const PreparedSceneBody& p = prepared[s.nextBody++];
+            s.bodyIds[p.record] = AddPreparedBody(view, p, true);
+            if (s.nextBody % kSceneInsertBatch == 0 && Clock::now() >= end) return true;
+        }
+        while (s.nextJoint < h.jointCount)
+        {
+            AddSceneJoint(view, s.nextJoint++, s.bodyIds, s.groups);
+            if (s.nextJoint % kSceneInsertBatch == 0 && Clock::now() >= end) return true;
+        }
+        MergeSceneGroups(s.bodyIds, s.groups, true);
+        RestoreSceneWaves(view);
+        CancelSceneLoad();
+        return false;
+    }
+
+    // 0..1 through a background load, -1 without one. Preparing a record
+    // counts a quarter of it, inserting it the rest.
+    float SceneLoadProgress() const
+    {
+        if (!m_sceneLoader.Busy()) return -1.0f;
+        uint32_t records = m_sceneLoader.RecordCount();
+        if (records == 0) return 0.0f;
+        float prepared = static_cast<float>(m_sceneLoader.PreparedCount()) / static_cast<float>(records);
+        float inserted = 0.0f;
+        if (m_sceneInsert.started)
+        {
+            size_t total = m_sceneLoader.Bodies().size() + m_sceneLoader.View().header->jointCount;
+            inserted = total ? static_cast<float>(m_sceneInsert.nextBody + m_sceneInsert.nextJoint) / static_cast<float>(total) : 1.0f;
+        }
+        return 0.25f * prepared + 0.75f * inserted;
+    }
+
+    // The start of every load: a fresh scene of the image's size and location.
+    void BeginSceneImage(const SceneView& view)
+    {
+        const SceneFileHeader& h = *view.header;
+        SetWorldWidth(static_cast<float>(h.width));
+        ResetScene();
+        m_sceneLocation = ClampSceneLocation(h.sceneLocation);
+        m_spawnOrder.reserve(h.bodyCount);
+    }
+
+    // Wave samples depend on the window width; a mismatched snapshot starts calm.
+    void RestoreSceneWaves(const SceneView& view)
+    {
+        const SceneFileHeader& h = *view.header;
+        if (h.waveSamples == m_waveDisp.size() && m_sceneLocation == SceneLocation::Shallow)
+        {
+            m_shallow.Restore(view.waveDisp, view.waveVel);
+        }
+        else if (h.waveSamples == m_waveDisp.size())
+        {
+            std::copy(view.waveDisp, view.waveDisp + h.waveSamples, m_waveDisp.begin());
+            std::copy(view.waveVel, view.waveVel + h.waveSamples, m_waveVel.begin());
+        }
+    }
+
+    // Input recording (F6 toggles). The world is rebuilt from the snapshot
+    // embedded in the stream, so the live run and its replay start identical.
+    void SetReplayPath(const std::string& path) { m_replayPath = path; }
+    bool IsRecording() const { return m_recorder.IsOpen(); }
+
+    // seed 0 picks one from the clock; two recordings only compare step by
+    // step (SlopSandboxBench --hash-diff) when they share one.
+    bool StartRecording(const std::string& path, uint64_t seed = 0)
+    {
+        if (m_sceneLoader.Busy()) return false;
+        RestoreAllRegions();
+        std::vector<uint8_t> image;
+        BuildSceneImage(image);
+        if (seed == 0) seed = static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+
+        ReplayHeader header{};
+        std::memcpy(header.magic, kReplayMagic, sizeof(kReplayMagic));
+        header.version = kReplayVersion;
+        header.sceneBytes = static_cast<uint32_t>(image.size());
+        header.seed = seed;
+        header.timeScale = m_timeScale;
+        header.paused = m_paused ? 1 : 0;
+        header.tool = static_cast<uint8_t>(m_tool);
+        header.drawTool = static_cast<uint8_t>(m_drawTool);
+        header.panelCollapsed = m_panel.collapsed ? 1 : 0;
+        header.panelX = m_panel.x;
+        header.panelY = m_panel.y;
+        header.flags = m_stateHashing ? kReplayFlagStateHash : 0u;
+        if (!m_recorder.Open(path, header, image)) return false;
+        BeginDeterministicRun(header, image.data(), image.size());
+        return true;
+    }
+
+    void StopRecording() { m_recorder.Close(); }
+
+    // Headless replay: BeginReplay, then ReplayNextFrame until it returns false.
+    bool BeginReplay(const std::string& path)
+    {
+        auto reader = std::make_unique<ReplayReader>();
+        if (!reader->Open(path)) return false;
+        if (!BeginDeterministicRun(reader->Header(), reader->SceneImage(), reader->SceneBytes())) return false;
+        if (reader->Header().flags & kReplayFlagStateHash) SetStateHashing(true);
+        m_replay = std::move(reader);
+        m_replayDesyncs = 0;
+        m_replayHashedSteps = 0;
+        m_replayDivergentStep = -1;
+        return true;
+    }
+
+    // Applies events up to and including the next simulated frame.
+    bool ReplayNextFrame()
+    {
+        if (!m_replay) return false;
+        ReplayEvent ev;
+        while (m_replay->Next(ev))
+        {
+            switch (ev.type)
+            {
+                case ReplayEventType::Input:
+                    m_input = ev.input;
+                    HandleKeyboard();
+                    HandleMouse();
+                    break;
+                case ReplayEventType::Panel:
+                    HandlePanelDrag();
+                    break;
+                case ReplayEventType::Ui:
+                    if (ev.command <= static_cast<uint8_t>(UiCommand::TogglePixelate)) ApplyUiCommand(static_cast<UiCommand>(ev.command), ev.arg);
+                    break;
+                case ReplayEventType::Step:
+                    m_replayStep = &ev;
+                    SimulateFrame(ev.dt, ev.stepCap);
+                    m_replayStep = nullptr;
+                    if (m_stepLogCount != ev.stepCount) ++m_replayDesyncs;
+                    return true;
+                case ReplayEventType::Hash:
+                    // The frame it follows has been simulated, nothing since.
+                    for (int i = 0; i < ev.hashCount && i < m_frameHashCount; ++i)
+                    {
+                        if (m_replayDivergentStep < 0 && ev.hashes[i] != m_frameHashes[i])
+                        {
+                            m_replayDivergentStep = static_cast<int64_t>(m_replayHashedSteps) + i;
+                        }
+                    }
+                    m_replayHashedSteps += ev.hashCount;
+                    break;
+            }
+        }
+        m_replay.reset();
+        return false;
+    }
+
+    // Frames whose step count differed from the recording.
+    int ReplayDesyncs() const { return m_replayDesyncs; }
+
+    // Replaying a recording made with state hashing: the first step, counted
+    // from the start of the recording, whose hash differs (-1 while none
+    // has), and how many steps were compared.
+    int64_t ReplayDivergentStep() const { return m_replayDivergentStep; }
+    uint64_t ReplayHashedSteps() const { return m_replayHashedSteps; }
+
+    // Per-step hash of body transforms, velocities, sleep and features, joint
+    // forces, glass stress, the wave and the simulation RNG, for checking that
+    // runs are bit-identical. Only bodies that moved are rehashed, on the
+    // scheduler's workers. Recordings started with it on carry the hashes.
+    void SetStateHashing(bool on)
+    {
+        m_stateHashing = on;
+        m_hashEdits = UINT64_MAX;
+        m_hashSlots.clear();
+    }
+
+    bool StateHashing() const { return m_stateHashing; }
+
+    // Takes settled regions far from the view out of the world, and puts them
+    // back as the view or an awake body comes near; see HibernatedRegion.
+    // Headless runs have a view covering everything unless ScriptSetView
+    // narrows it. Saving or recording brings every region back first, and
+    // each region taken out or put back starts the rewind history over.
+    void SetRegionHibernation(bool on)
+    {
+        m_hibernation = on;
+        m_hibernateCountdown = 0;
+        if (!on) RestoreAllRegions();
+    }
+
+    bool RegionHibernation() const { return m_hibernation; }
+    size_t HibernatedRegionCount() const { return m_hibernated.size(); }
+    size_t HibernatedBodyCount() const { return m_hibernatedBodies; }
+
+    // World area the headless simulation treats as on screen.
+    void ScriptSetView(Rectangle worldRectPx) { m_viewRect = worldRectPx; }
+    // After the last step; 0 before the first one hashed.
+    uint64_t StateHash() const { return m_stateHash; }
+    uint64_t HashedSteps() const { return m_hashedSteps; }
+
+    // Headless scripting surface: scene setup and stepping without a window.
+    // Used by SlopSandboxBench; spawn helpers return the new body's dense index.
+    void SetSceneLocation(SceneLocation location) { SetLocation(location); }
+    void SetWaterSprayEnabled(bool enabled) { m_waterSprayEnabled = enabled; }
+    b2WorldId WorldId() const { return m_worldId; }
+    size_t BodyCount() const { return m_bodies.size(); }
+    b2BodyId BodyIdAt(size_t idx) const { return m_bodies[idx].bodyId; }
+    const BodyEntry& BodyAt(size_t idx) const { return m_bodies[idx]; }
+    std::optional<size_t> FindBody(uint64_t key) const { return BodyIndexByKey(key); }
+    const ShapeTable& Shapes() const { return m_shapes; }
+    const std::vector<float>& WaveDisplacement() const { return m_waveDisp; }
+    float WaveStepPx() const { return m_waveStep; }
+    float GroundTopPx() const { return ActiveGroundTopYPx(); }
+    float WaterBaselinePx() const { return m_waveBaselineY; }
+    static float FixedDt() { return kFixedDt; }
+    int Width() const { return m_width; }
+    int Height() const { return m_height; }
+    float WorldWidth() const { return m_worldWidth; }
+
+    // Widens the world past the window, which the camera then pans over; it is
+    // never narrower than the window nor wider than a scene file may be.
+    // Changing it clears the scene.
+    void SetWorldWidth(float widthPx)
+    {
+        widthPx = ClampWorldWidth(widthPx);
+        if (widthPx == m_worldWidth) return;
+        ResetScene();
+        if (b2Body_IsValid(m_groundBody)) b2DestroyBody(m_groundBody);
+        if (b2Body_IsValid(m_waterSensorBody)) b2DestroyBody(m_waterSensorBody);
+        ApplyWorldWidth(widthPx);
+        CreateGround();
+        CreateWaterSensor();
+    }
+
+    size_t ScriptSpawnBox(Vector2 posPx)
+    {
+        SpawnBox(posPx);
+        return m_bodies.size() - 1;
+    }
+
+    size_t ScriptSpawnCircle(Vector2 posPx)
+    {
+        SpawnCircle(posPx);
+        return m_bodies.size() - 1;
+    }
+
+    size_t ScriptSpawnTriangle(Vector2 posPx)
+    {
+        SpawnTriangle(posPx);
+        return m_bodies.size() - 1;
+    }
+
+    // Grid of cols x rows bodies centred on centerPx, lifted above the ground.
+    // Returns the number spawned; they are the last entries in dense order.
+    size_t ScriptSpawnGrid(SpawnShape shape, Vector2 centerPx, int cols, int rows)
+    {
+        return SpawnGrid(shape, centerPx, cols, rows);
+    }
+
+    std::optional<size_t> ScriptSpawnPolygon(Vector2 centerPx, const std::vector<Vector2>& localVerticesPx)
+    {
+        size_t before = m_bodies.size();
+        SpawnPolygonBody(centerPx, localVerticesPx);
+        if (m_bodies.size() == before) return std::nullopt;
+        return m_bodies.size() - 1;
+    }
+
+    void ScriptSetGlass(size_t idx, bool on) { ScriptSetFeature(idx, Tool::Glass, on); }
+
+    // Tool::Bounce, Slip, Sticky or Glass; other tools have no body feature.
+    void ScriptSetFeature(size_t idx, Tool tool, bool on) { SetFeature(&idx, 1, tool, on); }
+
+    void ScriptSetFeature(const std::vector<size_t>& indices, Tool tool, bool on) { SetFeature(indices.data(), indices.size(), tool, on); }
+
+    // Most bodies tagged as bullets at once (0 turns tagging off); lowering it
+    // untags the oldest.
+    void SetBulletBudget(int budget)
+    {
+        m_bulletBudget = std::max(0, budget);
+        if (m_bullets.size() > static_cast<size_t>(m_bulletBudget)) EvictBullets(m_bullets.size() - static_cast<size_t>(m_bulletBudget));
+    }
+
+    size_t BulletCount() const { return m_bullets.size(); }
+
+    // Re-applies damping to every body and to later spawns.
+    void SetSimTuning(const SimTuning& tuning)
+    {
+        m_tuning = tuning;
+        b2World_SetContactTuning(m_worldId, tuning.contactHertz, tuning.contactDampingRatio, tuning.contactPushMaxVelocity);
+        for (SpawnTemplate& t : m_spawnTemplates)
+        {
+            const SurfaceEntry& s = SurfaceOf(t.kind, 0);
+            t.linearDamping = s.linearDamping * tuning.linearDampingScale;
+            t.angularDamping = s.angularDamping * tuning.angularDampingScale;
+        }
+        for (size_t i = 0; i < m_bodies.size(); ++i) ApplyBodySurface(i);
+    }
+    const SimTuning& Tuning() const { return m_tuning; }
+
+    uint64_t GlassBreakCount() const { return m_glassBreakCount; }
+
+    // Limits given to joints made from now on by the tools, scripts, paste
+    // and LoadScene (scene files keep no limits); 0 never breaks.
+    void SetJointBreakLimits(float forceN, float torqueNm)
+    {
+        m_jointBreakForce = std::max(0.0f, forceN);
+        m_jointBreakTorque = std::max(0.0f, torqueNm);
+    }
+    const std::vector<JointBreakEvent>& JointBreaks() const { return m_jointBreaks; }
+    uint64_t JointBreakCount() const { return m_jointBreakCount; }
+    size_t RestingBodyCount() const { return m_restingSet.Count(); }
+    // Every body asleep except those that fell off the ground.
+    bool Settled() const { return SceneSettled(); }
+    bool FellOffGround(size_t idx) const { return b2Body_GetPosition(m_bodies[idx].bodyId).y > FallenBelowM(); }
+
+    // Memory the rewind history may use; the oldest keyframes go first.
+    void SetRewindBudget(size_t bytes) { m_rewind.SetBudget(bytes); }
+    const RewindBuffer& Rewind() const { return m_rewind; }
+    // Moves through the history by captures (negative is back) and pauses.
+    void ScriptRewind(int captures) { RewindBy(captures); }
+
+    // Steps as fast as the machine allows, a slice per frame, for simSeconds
+    // of simulated time or (<= 0) until every body sleeps, at most five
+    // simulated minutes.
+    void ScriptFastForward(float simSeconds) { StartFastForward(simSeconds); }
+    bool FastForwarding() const { return m_fastForward; }
+
+    // Merges the weld group of idx into one compound body; see RigidifyBodies.
+    std::optional<size_t> ScriptRigidify(size_t idx) { return RigidifyGroup(idx); }
+
+    // Returns the number of bodies a compound split into (0 if idx is not one).
+    size_t ScriptSplit(size_t idx) { return SplitCompound(idx); }
+
+    const std::vector<RigidPart>& PartsAt(size_t idx) const { return Cold(idx).parts; }
+
+    // Blast centred at atPx; radiusPx at full strength, fading out over as
+    // far again. impulsePerLength is per meter of outline facing the blast.
+    void ScriptExplode(Vector2 atPx, float radiusPx, float impulsePerLength)
+    {
+        float radiusM = std::max(0.0f, radiusPx) * kInvPixelsPerMeter;
+        Explode(ToMeters(atPx), radiusM, radiusM, impulsePerLength);
+    }
+
+    // Copies indices into a cols x rows array beside them (the originals fill
+    // the first cell), welds, wheels and features included. Returns the number
+    // of bodies made; they are the last entries in dense order.
+    size_t ScriptDuplicate(const std::vector<size_t>& indices, int cols, int rows)
+    {
+        return DuplicateBodies(indices.data(), indices.size(), cols, rows);
+    }
+
+    void ScriptRemoveBody(size_t idx)
+    {
+        if (idx < m_bodies.size()) DeleteBodyIndex(idx);
+    }
+
+    void ScriptResetScene() { ResetScene(); }
+
+    bool ScriptWeld(size_t a, size_t b, Vector2 anchorPx)
+    {
+        return CreateWeldJoint(m_bodies[a].bodyId, m_bodies[b].bodyId, ToMeters(anchorPx));
+    }
+
+    // Limits of every joint between a and b; 0 never breaks. False if they
+    // are not joined.
+    bool ScriptSetJointBreakLimits(size_t a, size_t b, float forceN, float torqueNm)
+    {
+        if (a >= m_bodies.size() || b >= m_bodies.size()) return false;
+        uint64_t keyA = BodyKey(m_bodies[a].bodyId);
+        uint64_t keyB = BodyKey(m_bodies[b].bodyId);
+        bool found = false;
+        for (SlotHandle jh : Cold(a).joints)
+        {
+            JointEntry* j = m_joints.Get(jh);
+            if (!j || !b2Joint_IsValid(j->jointId)) continue;
+            if (!((j->bodyA == keyA && j->bodyB == keyB) || (j->bodyA == keyB && j->bodyB == keyA))) continue;
+            ApplyBreakLimits(*j, forceN, torqueNm);
+            found = true;
+        }
+        return found;
+    }
+
+    bool ScriptAttachWheel(size_t host, size_t wheel)
+    {
+        if (!CreateWheelJoint(m_bodies[host].bodyId, m_bodies[wheel].bodyId, b2Body_GetPosition(m_bodies[wheel].bodyId))) return false;
+        m_bodies[wheel].Set(kFeatureWheel, true);
+        ++m_restingVersion;
+        return true;
+    }
+
+    // Runs a scenario script (scenario.h) from the next step on, on whichever
+    // thread steps the world. False, with Scenario().Error() saying why, when
+    // it cannot be read.
+    bool StartScenario(const char* path)
+    {
+        m_scenarioGroup.clear();
+        m_scenarioGlassBreaks = m_glassBreakCount;
+        m_scenarioJointBreaks = m_jointBreakCount;
+        return m_scenario.Load(path);
+    }
+    const scenario::Runner& Scenario() const { return m_scenario; }
+
+    // One frame of simulation without input handling or drawing.
+    void StepHeadless(float dt)
+    {
+        SimulateFrame(dt, kMaxPhysicsStepsPerFrame);
+    }
+
+protected:
+    // src/microbench_main.cpp times private hot paths through this.
+    friend struct SandboxProbe;
+
+    int m_width = 1400;
+    int m_height = 900;
+    // World extent in px; x runs from 0 to m_worldWidth, y from 0 to m_height.
+    float m_worldWidth = 1400.0f;
+    Rectangle m_viewRect{-1e9f, -1e9f, 2e9f, 2e9f};
+    // World area the published resting list covers when m_restingCulled; see
+    // PublishSnapshot.
+    Rectangle m_restingBounds{0, 0, 0, 0};
+    bool m_restingCulled = false;
+    std::vector<size_t> m_cullScratch;
+
+    FrameProfiler m_profiler;
+    box2d_heap::AllocRate m_b2AllocRate;
+    bool m_showProfiler = false;
+    StepController m_stepController{StepController::Config{6.5f, kFixedDt * 1000.0f}};
+
+    // Physics thread. m_worldMutex guards the world, m_bodies/m_joints, water
+    // and particles. The render thread hands input over through m_commands
+    // and draws from m_snapshots; it only takes the lock while recording and
+    // for the file keys, and then applies its commands itself.
+    bool m_physicsThreaded = true;
+    float m_particleQuietS = 0.0f; // simulation side
+    std::atomic<bool> m_sceneAtRest{false};
+    std::atomic<bool> m_physicsIdle{false};
+    uint32_t m_appliedInputSerial = 0; // simulation side
+    std::thread m_physicsThread;
+    std::atomic<bool> m_physicsStop{false};
+    std::mutex m_worldMutex;
+    static constexpr size_t kCommandQueueSize = 1024;
+    SpscQueue<SimCommand, kCommandQueueSize> m_commands;
+    bool m_commandsInline = false; // render thread holds m_worldMutex
+    TripleBuffer<RenderSnapshot> m_snapshots;
+    std::string m_profileCsvPath = "slop_profile.csv";
+    std::string m_sceneFilePath = "slop_scene.bin";
+    // Background load (LoadSceneAsync) and how far its insertion has got.
+    struct SceneInsert
+    {
+        bool started = false;
+        size_t nextBody = 0; // into the loader's prepared bodies
+        uint32_t nextJoint = 0;
+        std::vector<b2BodyId> bodyIds;
+        SceneRigidGroups groups;
+    };
+    SceneLoader m_sceneLoader;
+    SceneInsert m_sceneInsert;
+
+    // Input and randomness for everything the simulation sees; see replay.h.
+    InputFrame m_input;
+    SimRandom m_rng;
+    ReplayWriter m_recorder;
+    std::string m_replayPath = "slop_replay.bin";
+    std::unique_ptr<ReplayReader> m_replay;
+    const ReplayEvent* m_replayStep = nullptr;
+    int m_replayDesyncs = 0;
+    // Step cap and substeps of the last UpdateSimulation, for the recorder.
+    int m_stepLogCap = 0;
+    int m_stepLogCount = 0;
+    uint8_t m_stepLog[kReplayMaxSteps] = {};
+    // State hashing: per-body hashes by dense index, rebuilt whenever the
+    // scene was edited and otherwise updated for the bodies that moved.
+    bool m_stateHashing = false;
+    StateHashSum m_bodyHashes;
+    uint64_t m_hashEdits = UINT64_MAX;
+    std::vector<uint32_t> m_hashSlots;
+    std::vector<size_t> m_hashIndices;
+    std::vector<uint64_t> m_hashScratch;
+    uint64_t m_stateHash = 0;
+    uint64_t m_hashedSteps = 0;
+    uint64_t m_frameHashes[kReplayMaxSteps] = {};
+    int m_frameHashCount = 0;
+    static constexpr int kHashParallelMin = 256; // fewer moved bodies hash inline
+    uint64_t m_replayHashedSteps = 0;
+    int64_t m_replayDivergentStep = -1;
+
+    // Declared before the world so it is destroyed after b2DestroyWorld.
+    std::unique_ptr<TaskScheduler> m_scheduler;
+    b2WorldId m_worldId = b2_nullWorldId;
+    b2BodyId m_groundBody = b2_nullBodyId;
+
+    // Interned body outlines; declared before anything that stores ids into it.
+    ShapeTable m_shapes;
+    SlotMap<BodyEntry> m_bodies;
+    SlotMap<JointEntry> m_joints;
+    ParticlePool m_shards{kMaxGlassShards};
+    ParticlePool m_waterChunks{kMaxWaterChunks};
+    // Body outlines the CPU particles bounce off: resting bodies rebuilt only
+    // when the resting set or the scene changes, awake ones every frame.
+    ParticleGrid m_restingGrid;
+    ParticleGrid m_awakeGrid;
+    uint32_t m_restingGridVersion = 0;
+    uint64_t m_restingGridEdits = 0;
+    // Physical glass fragments; the bodies live in m_worldId but not in m_bodies.
+    DebrisPool m_debris;
+    // Temporary welds of sticky bodies; not in m_joints, so never saved.
+    AdhesionPool m_adhesion;
+    // Particle emission queued by the simulation and run under
+    // kDeferredBudgetMs. Each job draws from its own seed, taken from m_rng
+    // when queued, so when it runs never changes what the simulation sees.
+    enum class DeferredJobType : uint8_t
+    {
+        GlassShards,
+        WaterSplash,
+        EntrySplash,
+    };
+    struct DeferredJob
+    {
+        DeferredJobType type = DeferredJobType::GlassShards;
+        Vector2 at{0, 0};       // px; the surface for an entry splash
+        Vector2 velocity{0, 0}; // px/s for shards, m/s for an entry splash
+        float amount = 0.0f;    // pane area in px^2, or splash energy
+        uint64_t seed = 0;
+    };
+    DeferredQueue<DeferredJob> m_deferred;
+    // GPU particles: set once in Run before the physics thread starts. The
+    // pools above then only collect emits between publishes.
+    static constexpr int kShardLane = 0;
+    static constexpr int kSprayLane = 1;
+    bool m_gpuEffects = false;
+    GpuSpawnQueue m_gpuSpawns;
+
+    // Box2D body index (b2BodyId::index1) -> stable handle into m_bodies.
+    std::vector<SlotHandle> m_handleByBodyIndex;
+
+    std::vector<uint64_t> m_spawnOrder;
+
+    SceneLocation m_sceneLocation = SceneLocation::Land;
+    Tool m_tool = Tool::Cursor;
+    DrawTool m_drawTool = DrawTool::None;
+
+    Language m_language = Language::RU;
+    Theme m_theme = Theme::Dark;
+
+    // Set by the render thread, read by the simulation's.
+    std::atomic<bool> m_paused{false};
+    std::atomic<bool> m_fastForward{false};
+    uint64_t m_fastForwardLeft = 0; // steps
+    uint64_t m_fastForwardDone = 0;
+    bool m_fastForwardUntilAsleep = false;
+    std::atomic<float> m_timeScale{1.0f};
+    bool m_pixelate = false;
+
+    bool m_drawing = false;
+    Vector2 m_drawStart{0, 0};
+    Vector2 m_drawCurrent{0, 0};
+    std::vector<Vector2> m_freeformPoints;
+    std::unordered_map<uint64_t, FreeformPieces> m_freeformCache;
+
+    // Simulation side; the render thread draws the snapshot's copy.
+    bool m_selecting = false;
+    Rectangle m_selectionRect{0, 0, 0, 0};
+
+    SlotHandle m_pendingWeldBody;
+    Vector2 m_weldCursor{0, 0};
+
+    // Dragging pulls each selected body toward the kinematic m_dragHandle,
+    // which follows the mouse, with a motor joint spring kept for the drag.
+    struct DragLink
+    {
+        uint64_t body = 0;
+        b2JointId joint = b2_nullJointId;
+    };
+    bool m_draggingBodies = false;
+    b2BodyId m_dragHandle = b2_nullBodyId;
+    std::vector<DragLink> m_dragLinks;
+    static constexpr float kDragHertz = 10.0f;
+    static constexpr float kDragDampingRatio = 0.9f;
+    static constexpr float kDragMaxAccel = 150.0f; // m/s^2 per kg of the dragged assembly
+    static constexpr float kDragMaxAngularAccel = 120.0f; // rad/s^2
+    // Box2D sweeps every fast body against static geometry; bullets are also
+    // swept against dynamic bodies, which only pays for throws. A released
+    // body that covers more than kBulletTravel of its smallest half extent a
+    // step is tagged until it slows to half that or kBulletMaxSteps pass. At
+    // most m_bulletBudget at a time; the oldest gives up its tag first.
+    struct BulletTag
+    {
+        uint64_t body = 0;
+        float minExtentM = 0.0f;
+        int steps = 0;
+    };
+    std::vector<BulletTag> m_bullets;
+    int m_bulletBudget = kDefaultBulletBudget;
+    uint64_t m_bulletEvictions = 0;
+    static constexpr int kDefaultBulletBudget = 16;
+    static constexpr float kBulletTravel = 0.5f;
+    static constexpr int kBulletMaxSteps = 240;
+
+    // Rewind history: a capture every kRewindCaptureSteps steps, a keyframe
+    // every kRewindKeyframeFrames captures or when bodies, joints or
+    // features changed (m_sceneEdits), since deltas are keyed by slot.
+    RewindBuffer m_rewind;
+    SlotBitset m_rewindDirty; // moved or slept since the last capture
+    uint64_t m_sceneEdits = 0;
+    uint64_t m_rewindEdits = UINT64_MAX;
+    uint64_t m_rewindStep = 0;
+    std::vector<uint32_t> m_rewindSlots;
+    std::vector<RewindState> m_rewindStates;
+    static constexpr int kRewindCaptureSteps = 4;
+    static constexpr size_t kRewindKeyframeFrames = 32;
+
+    // Region hibernation (SetRegionHibernation). The world is cut into
+    // kHibernateRegionPx wide strips; one whose bodies all sleep, far from the
+    // view and from anything awake, is kept as a scene image instead of in the
+    // world. It comes back, still asleep, once the view or an awake body gets
+    // within kHibernateMarginPx of what it held.
+    struct HibernatedRegion
+    {
+        Rectangle boundsPx{0, 0, 0, 0};
+        size_t bodyCount = 0;
+        std::vector<uint8_t> image;
+    };
+    std::vector<HibernatedRegion> m_hibernated;
+    size_t m_hibernatedBodies = 0;
+    bool m_hibernation = false;
+    int m_hibernateCountdown = 0;
+    std::vector<std::vector<size_t>> m_regionMembers;
+    std::vector<uint32_t> m_regionOfBody; // by dense index; UINT32_MAX when not a candidate
+    std::vector<uint8_t> m_regionBlocked;
+    std::vector<uint32_t> m_regionParent; // union-find over strips
+    static constexpr float kHibernateRegionPx = 768.0f;
+    static constexpr float kHibernateMarginPx = 320.0f;
+    static constexpr int kHibernateCheckFrames = 30;
+    static constexpr size_t kHibernateMinBodies = 16;
+    Vector2 m_prevDragMouse{0, 0};
+    float m_prevDragTime = 0.0f;
+    b2Vec2 m_dragReleaseVelM{0.0f, 0.0f};
+
+    float m_accumulator = 0.0f;
+    static constexpr float kFixedDt = 1.0f / 55.0f;
+    // Shallow water: density in Box2D units (plain bodies are 1, so they float
+    // half under), body drag relative to the spring surface, linear flow
+    // damping per second, and wave velocity per poke.
+    static constexpr float kShallowWaterDensity = 2.0f;
+    static constexpr float kShallowDragScale = 6.0f;
+    static constexpr float kShallowDamping = 0.35f;
+    static constexpr float kShallowPokeGain = 1500.0f;
+    static constexpr int kMaxPhysicsStepsPerFrame = 1;
+    // Fast-forward steps for this long per frame; with the physics thread the
+    // window drops to kFastForwardFps to leave the cores to the workers.
+    static constexpr double kFastForwardSliceMs = 200.0;
+    static constexpr int kFastForwardFps = 5;
+    static constexpr float kFastForwardKeySeconds = 10.0f;
+    // Settling gives up here, say on a pile that keeps creeping.
+    static constexpr float kFastForwardSettleMaxSeconds = 300.0f;
+    // The physics thread catches up after a late tick instead of dropping time.
+    static constexpr int kMaxCatchUpSteps = 4;
+    static constexpr float kCullMarginPx = 64.0f;
+    static constexpr float kBodySleepThreshold = 0.06f;
+
+    struct
+    {
+        float x = 10.0f;
+        float y = 10.0f;
+        float w = 390.0f;
+        bool collapsed = false;
+        bool dragging = false;
+        Vector2 dragOffset{0, 0};
+    } m_panel;
+
+    // Water model
+    std::vector<float> m_waveDisp;
+    std::vector<float> m_waveVel;
+    std::vector<float> m_waveDelta; // spread scratch, written from m_waveDisp each pass
+    std::vector<float> m_waveImpulse; // body disturbances for the step, applied at once
+    ShallowWater m_shallow; // SceneLocation::Shallow; drives m_waveDisp instead of the springs
+    float m_waveBaselineY = 0.0f;
+    float m_waveStep = 8.0f;
+    bool m_waterSprayEnabled = true;
+    float m_groundCenterCachePx = -1.0f;
+    std::vector<size_t> m_waterCandidates;
+    std::vector<water::BodySample> m_waterSamples; // parallel to m_waterCandidates
+    water::Surface m_waterSurface;
+    b2BodyId m_waterSensorBody = b2_nullBodyId;
+    b2ShapeId m_waterSensorShape = b2_nullShapeId;
+    float m_waterSensorTopPx = -FLT_MAX;
+    std::vector<b2ShapeId> m_waterOverlaps;
+    std::vector<uint32_t> m_waterFreshSlots; // inserted since the sensor last looked
+    static constexpr float kWaterSensorHeadroomPx = kBaseHalfPx;
+    std::vector<SlotHandle> m_linkScratch;
+    std::vector<size_t> m_linkedScratch;
+    uint32_t m_visitEpoch = 0;
+    std::vector<b2ContactData> m_contactScratch;
+    // Transient containers; reset at the start of each simulation frame.
+    FrameArena m_frameArena;
+    // Cold side table and feature sets, indexed by m_bodies slot.
+    std::vector<BodyCold> m_bodyCold;
+    // Body handles in spawn order. Erasing a body leaves its handle behind
+    // until CompactDrawOrder drops it.
+    std::vector<SlotHandle> m_drawOrder;
+    uint64_t m_nextBodyOrder = 0;
+    SlotBitset m_glassSet;
+    SlotBitset m_selectedSet;
+    // Bodies Box2D put to sleep; bumping m_restingVersion republishes them.
+    SlotBitset m_restingSet;
+    uint32_t m_restingVersion = 1;
+    // Slots of bodies that were awake in the last step, in move event order.
+    std::vector<uint32_t> m_movedSlots;
+    // Slots with a move event since the last transform export, and the list
+    // from the export before, which the other copy has not seen.
+    TransformExport m_transformExport;
+    std::vector<uint32_t> m_exportMoved;
+    std::vector<uint32_t> m_exportMovedPrev;
+    uint64_t m_exportSerial = 0;
+    // Slots with a move event since the last EncodeStreamFrame; the scene
+    // edit count it last walked every body at.
+    bool m_streaming = false;
+    std::vector<uint32_t> m_streamMoved;
+    uint64_t m_streamEdits = 0;
+    uint64_t m_streamSerial = 0;
+    // Glass bodies that are awake, stressed or in grace.
+    std::vector<SlotHandle> m_activeGlass;
+    std::vector<size_t> m_glassBreakScratch;
+    std::vector<size_t> m_blastScratch;
+    uint32_t m_stepGlassBreaks = 0;
+    uint64_t m_glassBreakCount = 0;
+    float m_jointBreakForce = 0.0f;
+    float m_jointBreakTorque = 0.0f;
+    std::vector<JointBreakEvent> m_jointBreaks; // last step's
+    std::vector<SlotHandle> m_jointBreakScratch;
+    uint64_t m_jointBreakCount = 0;
+    scenario::Runner m_scenario{kFixedDt};
+    std::vector<uint64_t> m_scenarioGroup; // keys made by the last spawning op
+    std::vector<size_t> m_scenarioScratch;
+    uint64_t m_scenarioGlassBreaks = 0;
+    uint64_t m_scenarioJointBreaks = 0;
+    SimTuning m_tuning;
+    telemetry::Writer m_telemetry;
+    std::array<SpawnTemplate, 3> m_spawnTemplates;
+    SpawnShape m_batchShape = SpawnShape::Box;
+    std::vector<Vector2> m_batchScratch;
+    static constexpr size_t kBatchReserveMin = 16;
+    static constexpr float kBatchGapPx = 4.0f;
+    static constexpr int kGridSpawnSide = 10;
+    static constexpr int kRainRows = 4;
+    static constexpr int kSprayPerFrame = 3;
+    BodyClip m_clipboard;
+    static constexpr int kArrayCopyCols = 4;
+    static constexpr int kArrayCopyRows = 2;
+
+    static bool IsValid(b2BodyId id)
+    {
+        return b2Body_IsValid(id);
+    }
+
+    float GroundCenterYPx() const
+    {
+        return m_height * 0.74f;
+    }
+
+    float GroundTopYPx() const
+    {
+        return GroundCenterYPx() - kGroundHalfThicknessPx;
+    }
+
+    Color AccentColor() const
+    {
+        return (m_theme == Theme::Dark) ? Color{240, 248, 255, 255} : Color{20, 20, 20, 255};
+    }
+
+    Color BgColor() const
+    {
+        return (m_theme == Theme::Dark) ? Color{6, 8, 11, 255} : Color{250, 250, 252, 255};
+    }
+
+    bool InWater() const { return m_sceneLocation != SceneLocation::Land; }
+
+    // Entering the pool starts it level; the spring surface keeps its state.
+    void SetLocation(SceneLocation location)
+    {
+        if (location == SceneLocation::Shallow && m_sceneLocation != location) m_shallow.Reset();
+        m_sceneLocation = location;
+    }
+
+    static SceneLocation ClampSceneLocation(uint32_t value)
+    {
+        return value <= static_cast<uint32_t>(SceneLocation::Shallow) ? static_cast<SceneLocation>(value) : SceneLocation::Land;
+    }
+
+    float ActiveGroundCenterYPx() const
+    {
+        return InWater() ? (m_height * 0.94f) : GroundCenterYPx();
+    }
+
+    float ActiveGroundTopYPx() const
+    {
+        return ActiveGroundCenterYPx() - kGroundHalfThicknessPx;
+    }
+
+    static Rectangle NormalizeRect(Vector2 a, Vector2 b)
+    {
+        Rectangle r{};
+        r.x = std::min(a.x, b.x);
+        r.y = std::min(a.y, b.y);
+        r.width = std::abs(a.x - b.x);
+        r.height = std::abs(a.y - b.y);
+        return r;
+    }
+
+    static bool RectContains(const Rectangle& outer, const Rectangle& inner)
+    {
+        return inner.x >= outer.x && inner.y >= outer.y && inner.x + inner.width <= outer.x + outer.width &&
+               inner.y + inner.height <= outer.y + outer.height;
+    }
+
+    Rectangle WorldBounds() const { return {0.0f, 0.0f, m_worldWidth, static_cast<float>(m_height)}; }
+
+    void InitWorld()
+    {
+        // Before the first world exists; later worlds find it installed.
+        box2d_heap::Heap::Install();
+        box2d_heap::Scope heapScope(box2d_heap::Subsystem::World);
+        b2WorldDef worldDef = b2DefaultWorldDef();
+        worldDef.gravity = {0.0f, 18.0f};
+        worldDef.enableSleep = true;
+        worldDef.enableContinuous = true;
+        m_scheduler->ConfigureWorldDef(worldDef);
+        m_worldId = box2d_heap::CreateWorld(worldDef);
+        CreateGround();
+        CreateWaterSensor();
+
+        // Suppress micro-bounces that destabilize stacks.
+        b2World_SetRestitutionThreshold(m_worldId, 3.0f);
+        b2World_SetContactTuning(m_worldId, m_tuning.contactHertz, m_tuning.contactDampingRatio, m_tuning.contactPushMaxVelocity);
+        b2World_SetFrictionCallback(m_worldId, &CombineFrictionMax);
+        b2World_SetRestitutionCallback(m_worldId, &CombineRestitutionMin);
+
+        m_debris.Init(m_worldId, kDebrisPoolSize, kDebrisPoolSize * 2);
+        m_adhesion.Init(kAdhesionPoolSize, kAdhesionPoolSize);
+
+        // Shapeless, so moving it never touches the broad phase; disabled
+        // (and out of the awake count) between drags.
+        b2BodyDef handleDef = b2DefaultBodyDef();
+        handleDef.type = b2_kinematicBody;
+        handleDef.isEnabled = false;
+        m_dragHandle = b2CreateBody(m_worldId, &handleDef);
+    }
+
+    void CreateGround()
+    {
+        b2BodyDef groundDef = b2DefaultBodyDef();
+        groundDef.type = b2_staticBody;
+        groundDef.position = ToMeters({m_worldWidth * 0.5f, GroundCenterYPx()});
+        m_groundBody = b2CreateBody(m_worldId, &groundDef);
+        m_groundCenterCachePx = GroundCenterYPx();
+
+        b2ShapeDef shapeDef = b2DefaultShapeDef();
+        shapeDef.material.friction = 1.4f;
+        shapeDef.material.restitution = 0.0f;
+        shapeDef.material.rollingResistance = 0.0f;
+
+        const float halfW = (m_worldWidth * 0.7f) * kInvPixelsPerMeter;
+        const float halfH = kGroundHalfThicknessPx * kInvPixelsPerMeter;
+        b2Polygon groundPoly = b2MakeBox(halfW, halfH);
+        b2CreatePolygonShape(m_groundBody, &shapeDef, &groundPoly);
+    }
+
+    // The water volume as one static sensor box: from just above the highest
+    // crest down past the floor, across the world plus a body's width. Its
+    // overlaps are the bodies UpdateWave samples, and its begin events arm
+    // the entry splash. Disabled on land.
+    void CreateWaterSensor()
+    {
+        b2BodyDef def = b2DefaultBodyDef();
+        def.type = b2_staticBody;
+        def.isEnabled = false;
+        m_waterSensorBody = b2CreateBody(m_worldId, &def);
+
+        b2ShapeDef shapeDef = b2DefaultShapeDef();
+        shapeDef.isSensor = true;
+        shapeDef.enableSensorEvents = true;
+        b2Polygon box = b2MakeBox((m_worldWidth * 0.5f + kBaseSizePx) * kInvPixelsPerMeter, WaterSensorHalfHeightPx() * kInvPixelsPerMeter);
+        m_waterSensorShape = b2CreatePolygonShape(m_waterSensorBody, &shapeDef, &box);
+        m_waterSensorTopPx = -FLT_MAX;
+    }
+
+    float WaterSensorHalfHeightPx() const { return static_cast<float>(m_height); }
+
+    // Keeps the top between a half and one and a half headrooms above the
+    // crest, so a calm or steady surface never moves the box.
+    void FitWaterSensor(float crestY)
+    {
+        if (!b2Body_IsEnabled(m_waterSensorBody)) b2Body_Enable(m_waterSensorBody);
+        float top = m_waterSensorTopPx;
+        if (top <= crestY - kWaterSensorHeadroomPx * 0.5f && top >= crestY - kWaterSensorHeadroomPx * 1.5f) return;
+        m_waterSensorTopPx = crestY - kWaterSensorHeadroomPx;
+        b2Vec2 center = ToMeters({m_worldWidth * 0.5f, m_waterSensorTopPx + WaterSensorHalfHeightPx()});
+        b2Body_SetTransform(m_waterSensorBody, center, b2Rot_identity);
+    }
+
+    float ClampWorldWidth(float widthPx) const
+    {
+        if (!(widthPx > static_cast<float>(m_width))) return static_cast<float>(m_width);
+        return std::min(widthPx, static_cast<float>(kSceneMaxWidthPx));
+    }
+
+    // Wave columns span the world; snapshots carry it to the camera.
+    void ApplyWorldWidth(float widthPx)
+    {
+        m_worldWidth = ClampWorldWidth(widthPx);
+        InitWave();
+    }
+
+    void InitWave()
+    {
+        m_waveBaselineY = m_height * 0.58f;
+        int samples = std::max(8, static_cast<int>(std::ceil(m_worldWidth / m_waveStep)) + 1);
+        m_waveDisp.assign(samples, 0.0f);
+        m_waveVel.assign(samples, 0.0f);
+        m_waveDelta.assign(samples, 0.0f);
+        m_waveImpulse.assign(samples, 0.0f);
+        float floorY = m_height * 0.94f - kGroundHalfThicknessPx;
+        m_shallow.Init(static_cast<size_t>(samples), m_waveStep, std::max(1.0f, floorY - m_waveBaselineY));
+    }
+
+    int WaveIndexForX(float xPx) const
+    {
+        if (m_waveDisp.empty()) return 0;
+        int idx = static_cast<int>(std::round(xPx / m_waveStep));
+        idx = std::max(0, std::min(idx, static_cast<int>(m_waveDisp.size()) - 1));
+        return idx;
+    }
+
+    water::Surface WaterSurface() const
+    {
+        water::Surface surface;
+        surface.disp = m_waveDisp.data();
+        surface.count = static_cast<int>(m_waveDisp.size());
+        surface.step = m_waveStep;
+        surface.baselineY = m_waveBaselineY;
+        return surface;
+    }
+
+    float WaterHeightAt(float xPx) const { return WaterSurface().HeightAt(xPx); }
+
+    // Queued into m_waveImpulse and applied with the body disturbances on the
+    // next wave step.
+    void DisturbWave(float xPx, float impulse)
+    {
+        if (!InWater() || m_waveImpulse.empty()) return;
+        water::Splat(m_waveImpulse.data(), static_cast<int>(m_waveImpulse.size()), m_waveStep, xPx, impulse * 4.0f, 3);
+    }
+
+    // Every shape of a scene body is seen by the water sensor.
+    static b2ShapeDef BodyShapeDef()
+    {
+        b2ShapeDef def = b2DefaultShapeDef();
+        def.enableSensorEvents = true;
+        return def;
+    }
+
+    static b2BodyDef DynamicBodyDef(b2Vec2 posM)
+    {
+        b2BodyDef bodyDef = b2DefaultBodyDef();
+        bodyDef.type = b2_dynamicBody;
+        bodyDef.position = posM;
+        bodyDef.linearDamping = 0.04f;
+        bodyDef.angularDamping = 0.45f;
+        bodyDef.enableSleep = true;
+        bodyDef.isAwake = true;
+        return bodyDef;
+    }
+
+    b2BodyId CreateDynamicBody(Vector2 posPx)
+    {
+        b2BodyDef bodyDef = DynamicBodyDef(ToMeters(posPx));
+        b2BodyId body = b2CreateBody(m_worldId, &bodyDef);
+        b2Body_SetSleepThreshold(body, kBodySleepThreshold);
+        return body;
+    }
+
+    Vector2 ClampSpawnAboveGround(Vector2 posPx, float halfWidthPx, float halfHeightPx) const
+    {
+        Vector2 out = posPx;
+        float top = ActiveGroundTopYPx();
+        float minY = halfHeightPx + 4.0f;
+        float maxY = top - halfHeightPx - 4.0f;
+        out.y = std::clamp(out.y, minY, maxY);
+        out.x = std::clamp(out.x, halfWidthPx + 4.0f, m_worldWidth - halfWidthPx - 4.0f);
+        return out;
+    }
+
+    struct BodySurface
+    {
+        float friction = 1.6f;
+        float restitution = 0.0f;
+        float rolling = 0.0f;
+        float linearDamping = 0.08f;
+        float angularDamping = 1.2f;
+    };
+
+    static BodySurface SurfaceFor(BodyKind kind, uint8_t features)
+    {
+        BodySurface s;
+        if (kind == BodyKind::Circle)
+        {
+            s.friction = 0.95f;
+            s.rolling = 0.0f;
+            s.angularDamping = 0.03f;
+        }
+
+        if (features & kFeatureSlippery)
+        {
+            s.friction = std::min(s.friction, 0.015f);
+            s.rolling = 0.0f;
+            s.linearDamping = 0.015f;
+            s.angularDamping = std::min(s.angularDamping, 0.05f);
+        }
+        if (features & kFeatureSticky)
+        {
+            s.friction = std::max(s.friction, 3.2f);
+            s.rolling = std::max(s.rolling, 0.02f);
+            s.linearDamping = std::max(s.linearDamping, 0.09f);
+            s.angularDamping = std::max(s.angularDamping, 1.0f);
+        }
+        if (features & kFeatureBouncy)
+        {
+            s.restitution = std::max(s.restitution, 0.78f);
+            s.linearDamping = std::min(s.linearDamping, 0.03f);
+        }
+        return s;
+    }
+
+    // SurfaceFor precomputed for every kind and combination of the features
+    // that change a surface (Bouncy, Slippery, Sticky; glass only changes hit
+    // events). Each entry's userMaterialId is its index + 1, leaving 0 for
+    // shapes outside the table (ground, debris).
+    static constexpr uint8_t kSurfaceFeatureMask = kFeatureBouncy | kFeatureSlippery | kFeatureSticky;
+    static constexpr size_t kSurfaceKinds = static_cast<size_t>(BodyKind::Compound) + 1;
+
+    struct SurfaceEntry
+    {
+        b2SurfaceMaterial material{};
+        float linearDamping = 0.0f;
+        float angularDamping = 0.0f;
+    };
+
+    static constexpr size_t SurfaceIndex(BodyKind kind, uint8_t features)
+    {
+        return static_cast<size_t>(kind) * 8 + ((features & kSurfaceFeatureMask) >> 1);
+    }
+
+    static const SurfaceEntry& SurfaceOf(BodyKind kind, uint8_t features)
+    {
+        static const std::array<SurfaceEntry, kSurfaceKinds * 8> table = [] {
+            std::array<SurfaceEntry, kSurfaceKinds * 8> t{};
+            for (size_t k = 0; k < kSurfaceKinds; ++k)
+            {
+                for (uint8_t f = 0; f < 8; ++f)
+                {
+                    BodyKind kind = static_cast<BodyKind>(k);
+                    uint8_t features = static_cast<uint8_t>(f << 1);
+                    BodySurface s = SurfaceFor(kind, features);
+                    SurfaceEntry& e = t[SurfaceIndex(kind, features)];
+                    e.material = b2DefaultSurfaceMaterial();
+                    e.material.friction = s.friction;
+                    e.material.restitution = s.restitution;
+                    e.material.rollingResistance = s.rolling;
+                    e.material.userMaterialId = SurfaceIndex(kind, features) + 1;
+                    e.linearDamping = s.linearDamping;
+                    e.angularDamping = s.angularDamping;
+                }
+            }
+            return t;
+        }();
+        return table[SurfaceIndex(kind, features)];
+    }
+
+    // Sticky shapes report touches for m_adhesion.
+    static void ApplyShapeSurface(b2ShapeId shape, const SurfaceEntry& s, bool glass, bool sticky)
+    {
+        b2Shape_SetSurfaceMaterial(shape, &s.material);
+        b2Shape_EnableHitEvents(shape, glass);
+        if (b2Shape_AreContactEventsEnabled(shape) == sticky) return;
+        b2Shape_EnableContactEvents(shape, sticky);
+        if (!sticky) return;
+        // Contacts take the flag when they are made, so the ones the shape
+        // already has are dropped (any filter change does that) and made
+        // again on the next step, with begin events.
+        b2Filter filter = b2Shape_GetFilter(shape);
+        b2Filter nudged = filter;
+        nudged.groupIndex ^= 1;
+        b2Shape_SetFilter(shape, nudged);
+        b2Shape_SetFilter(shape, filter);
+    }
+
+    void ApplyBodySurface(size_t idx)
+    {
+        if (idx >= m_bodies.size()) return;
+        BodyEntry& e = m_bodies[idx];
+        if (!IsValid(e.bodyId)) return;
+        ++m_sceneEdits;
+        if (m_restingSet.Test(m_bodies.SlotIndexAt(idx))) ++m_restingVersion;
+
+        const SurfaceEntry& surface = SurfaceOf(e.kind, e.features);
+        if (e.kind == BodyKind::Compound)
+        {
+            // Each part keeps its own material; damping goes by all of them.
+            for (const RigidPart& p : Cold(idx).parts)
+            {
+                if (!b2Shape_IsValid(p.shapeId)) continue;
+                ApplyShapeSurface(p.shapeId, SurfaceOf(p.kind, p.features), (p.features & kFeatureGlass) != 0, (p.features & kFeatureSticky) != 0);
+            }
+        }
+        else
+        {
+            // Everything but compounds has exactly one shape.
+            b2ShapeId shape = b2_nullShapeId;
+            if (b2Body_GetShapes(e.bodyId, &shape, 1) != 1) return;
+            ApplyShapeSurface(shape, surface, e.Has(kFeatureGlass), e.Has(kFeatureSticky));
+        }
+        if (!e.Has(kFeatureSticky)) m_adhesion.ReleaseBody(BodyKey(e.bodyId));
+
+        b2Body_SetLinearDamping(e.bodyId, surface.linearDamping * m_tuning.linearDampingScale);
+        b2Body_SetAngularDamping(e.bodyId, surface.angularDamping * m_tuning.angularDampingScale);
+
+        // Awake glass finds itself in the move events through this tag.
+        bool glass = e.Has(kFeatureGlass);
+        b2Body_SetUserData(e.bodyId, glass ? GlassUserData() : nullptr);
+        if (glass)
+        {
+            m_glassSet.Set(m_bodies.SlotIndexAt(idx));
+            ActivateGlass(idx);
+        }
+        else
+        {
+            m_glassSet.Reset(m_bodies.SlotIndexAt(idx));
+        }
+    }
+
+    static void* GlassUserData() { return reinterpret_cast<void*>(uintptr_t{1}); }
+
+    void ActivateGlass(size_t idx)
+    {
+        BodyCold& cold = Cold(idx);
+        if (cold.glassActive) return;
+        cold.glassActive = true;
+        m_activeGlass.push_back(m_bodies.HandleAt(idx));
+    }
+
+    BodyCold& Cold(size_t idx) { return m_bodyCold[m_bodies.SlotIndexAt(idx)]; }
+    const BodyCold& Cold(size_t idx) const { return m_bodyCold[m_bodies.SlotIndexAt(idx)]; }
+
+    // Drops an about-to-be-erased body from the feature sets.
+    void ForgetBodySlot(size_t idx)
+    {
+        uint32_t slot = m_bodies.SlotIndexAt(idx);
+        m_glassSet.Reset(slot);
+        m_selectedSet.Reset(slot);
+        SetResting(slot, false);
+    }
+
+    void SetResting(uint32_t slot, bool on)
+    {
+        if (m_restingSet.Test(slot) == on) return;
+        if (on)
+        {
+            m_restingSet.Set(slot);
+        }
+        else
+        {
+            m_restingSet.Reset(slot);
+        }
+        ++m_restingVersion;
+    }
+
+    // Folds the last step's move events into the cached transforms and the
+    // resting set, and wakes glass polling. Box2D reports every awake body.
+    void ConsumeBodyMoves()
+    {
+        m_movedSlots.clear();
+        b2BodyEvents moves = b2World_GetBodyEvents(m_worldId);
+        for (int i = 0; i < moves.moveCount; ++i)
+        {
+            const b2BodyMoveEvent& ev = moves.moveEvents[i];
+            auto idx = BodyIndexById(ev.bodyId);
+            if (!idx) continue; // debris
+            uint32_t slot = m_bodies.SlotIndexAt(*idx);
+            m_bodyCold[slot].xf = ev.transform;
+            SetResting(slot, ev.fellAsleep);
+            m_rewindDirty.Set(slot);
+            if (m_transformExport.Enabled()) m_exportMoved.push_back(slot);
+            if (m_streaming) m_streamMoved.push_back(slot);
+            if (!ev.fellAsleep) m_movedSlots.push_back(slot);
+            if (m_stateHashing) m_hashSlots.push_back(slot);
+            if (ev.userData == GlassUserData()) ActivateGlass(*idx);
+        }
+    }
+
+    // Input and scripts can wake bodies (drags, SetAwake) or put them to sleep
+    // between steps, which produces no move event. The world's awake count
+    // only disagrees with the resting set then, so the full scan is rare.
+    void ValidateResting()
+    {
+        size_t tracked = m_bodies.size() - m_restingSet.Count();
+        size_t awake = static_cast<size_t>(b2World_GetAwakeBodyCount(m_worldId)) - m_debris.AwakeCount();
+        if (b2Body_IsValid(m_dragHandle) && b2Body_IsEnabled(m_dragHandle) && b2Body_IsAwake(m_dragHandle)) --awake;
+        if (awake == tracked) return;
+        for (size_t i = 0; i < m_bodies.size(); ++i)
+        {
+            uint32_t slot = m_bodies.SlotIndexAt(i);
+            bool asleep = b2Body_IsValid(m_bodies[i].bodyId) && !b2Body_IsAwake(m_bodies[i].bodyId);
+            if (asleep == m_restingSet.Test(slot)) continue;
+            if (asleep) m_bodyCold[slot].xf = b2Body_GetTransform(m_bodies[i].bodyId);
+            else m_movedSlots.push_back(slot);
+            SetResting(slot, asleep);
+            m_rewindDirty.Set(slot);
+            if (m_transformExport.Enabled()) m_exportMoved.push_back(slot);
+            if (m_streaming) m_streamMoved.push_back(slot);
+            if (m_stateHashing) m_hashSlots.push_back(slot);
+        }
+    }
+
+    void PushSpawnOrder(b2BodyId body)
+    {
+        m_spawnOrder.push_back(BodyKey(body));
+        if (m_spawnOrder.size() > 4096)
+        {
+            m_spawnOrder.erase(m_spawnOrder.begin(), m_spawnOrder.begin() + 2048);
+        }
+    }
+
+    void SpawnBox(Vector2 pos) { SpawnShapeAt(SpawnShape::Box, pos); }
+    void SpawnCircle(Vector2 pos) { SpawnShapeAt(SpawnShape::Circle, pos); }
+    void SpawnTriangle(Vector2 pos) { SpawnShapeAt(SpawnShape::Triangle, pos); }
+
+    static SpawnShape ClampSpawnShape(uint8_t v)
+    {
+        return static_cast<SpawnShape>(std::min<uint8_t>(v, static_cast<uint8_t>(SpawnShape::Triangle)));
+    }
+
+    static ShapeTable::Id InternPolygonPx(ShapeTable& shapes, const b2Polygon& poly)
+    {
+        Vector2 verts[ShapeGeometry::kMaxVerts];
+        for (int i = 0; i < poly.count; ++i) verts[i] = ToPixels(poly.vertices[i]);
+        return shapes.Intern(verts, static_cast<size_t>(poly.count));
+    }
+
+    static void BakeSurface(SpawnTemplate& t)
+    {
+        const SurfaceEntry& s = SurfaceOf(t.kind, 0);
+        t.shapeDef.material = s.material;
+        t.linearDamping = s.linearDamping;
+        t.angularDamping = s.angularDamping;
+    }
+
+    static SpawnTemplate MakeSpawnTemplate(SpawnShape shape, ShapeTable& shapes)
+    {
+        SpawnTemplate t;
+        t.shapeDef = BodyShapeDef();
+        t.shapeDef.density = 1.0f;
+
+        switch (shape)
+        {
+            case SpawnShape::Box:
+            {
+                t.kind = BodyKind::Box;
+                t.polygon = b2MakeBox(kBaseHalfPx * kInvPixelsPerMeter, kBaseHalfPx * kInvPixelsPerMeter);
+                t.halfWidthPx = kBaseHalfPx;
+                t.halfHeightPx = kBaseHalfPx;
+                break;
+            }
+            case SpawnShape::Circle:
+            {
+                t.kind = BodyKind::Circle;
+                t.circle.center = {0.0f, 0.0f};
+                t.circle.radius = kBaseHalfPx * kInvPixelsPerMeter;
+                t.radiusPx = kBaseHalfPx;
+                t.halfWidthPx = kBaseHalfPx;
+                t.halfHeightPx = kBaseHalfPx;
+                BakeSurface(t);
+                return t;
+            }
+            case SpawnShape::Triangle:
+            {
+                // Equilateral triangle with height h and base = 2h / sqrt(3).
+                float h = kBaseSizePx;
+                float halfBase = h / std::sqrt(3.0f);
+                b2Vec2 pts[3] = {
+                    {0.0f, -h * 0.5f * kInvPixelsPerMeter},
+                    {halfBase * kInvPixelsPerMeter, h * 0.5f * kInvPixelsPerMeter},
+                    {-halfBase * kInvPixelsPerMeter, h * 0.5f * kInvPixelsPerMeter}
+                };
+                b2Hull hull = b2ComputeHull(pts, 3);
+                t.kind = BodyKind::Triangle;
+                t.polygon = b2MakePolygon(&hull, 0.0f);
+                t.halfWidthPx = halfBase;
+                t.halfHeightPx = h * 0.5f;
+                break;
+            }
+        }
+        t.shape = InternPolygonPx(shapes, t.polygon);
+        BakeSurface(t);
+        return t;
+    }
+
+    void SpawnShapeAt(SpawnShape shape, Vector2 pos)
+    {
+        const SpawnTemplate& t = m_spawnTemplates[static_cast<size_t>(shape)];
+        Vector2 spawn = ClampSpawnAboveGround(pos, t.halfWidthPx, t.halfHeightPx);
+        SpawnBatch(shape, &spawn, 1);
+    }
+
+    // Creates one body per center from a shared template. Defs and geometry are
+    // built once, the surface is already baked in so ApplyBodySurface is skipped,
+    // and storage grows once per batch. Box2D pairs all the new proxies together
+    // in the next step's broad-phase update.
+    size_t SpawnBatch(SpawnShape shape, const Vector2* centersPx, size_t count, b2Vec2 velocityM = {0.0f, 0.0f})
+    {
+        const SpawnTemplate& t = m_spawnTemplates[static_cast<size_t>(shape)];
+        if (count >= kBatchReserveMin) m_bodies.Reserve(std::max(m_bodies.size() + count, m_bodies.size() * 2));
+
+        b2BodyDef bodyDef = DynamicBodyDef({0.0f, 0.0f});
+        bodyDef.linearDamping = t.linearDamping;
+        bodyDef.angularDamping = t.angularDamping;
+        bodyDef.sleepThreshold = kBodySleepThreshold;
+        bodyDef.linearVelocity = velocityM;
+        for (size_t i = 0; i < count; ++i)
+        {
+            bodyDef.position = ToMeters(centersPx[i]);
+            b2BodyId body = b2CreateBody(m_worldId, &bodyDef);
+            if (t.kind == BodyKind::Circle) b2CreateCircleShape(body, &t.shapeDef, &t.circle);
+            else b2CreatePolygonShape(body, &t.shapeDef, &t.polygon);
+
+            BodyEntry entry;
+            entry.bodyId = body;
+            entry.kind = t.kind;
+            entry.radiusPx = t.radiusPx;
+            entry.shape = t.shape;
+            InsertBody(std::move(entry));
+            PushSpawnOrder(body);
+        }
+        return count;
+    }
+
+    size_t SpawnGrid(SpawnShape shape, Vector2 centerPx, int cols, int rows)
+    {
+        const SpawnTemplate& t = m_spawnTemplates[static_cast<size_t>(shape)];
+        float stepX = t.halfWidthPx * 2.0f + kBatchGapPx;
+        float stepY = t.halfHeightPx * 2.0f + kBatchGapPx;
+        float minX = t.halfWidthPx + 4.0f;
+        float maxX = m_worldWidth - t.halfWidthPx - 4.0f;
+        cols = std::clamp(cols, 1, std::max(1, static_cast<int>((maxX - minX) / stepX) + 1));
+        rows = std::max(rows, 1);
+
+        float x0 = std::clamp(centerPx.x - (cols - 1) * stepX * 0.5f, minX, std::max(minX, maxX - (cols - 1) * stepX));
+        // Rows above the window drop in; only the bottom row is kept off the ground.
+        float bottom = std::min(centerPx.y + (rows - 1) * stepY * 0.5f, ActiveGroundTopYPx() - t.halfHeightPx - 4.0f);
+
+        m_batchScratch.clear();
+        m_batchScratch.reserve(static_cast<size_t>(cols) * static_cast<size_t>(rows));
+        for (int r = 0; r < rows; ++r)
+        {
+            for (int c = 0; c < cols; ++c) m_batchScratch.push_back({x0 + c * stepX, bottom - r * stepY});
+        }
+        return SpawnBatch(shape, m_batchScratch.data(), m_batchScratch.size());
+    }
+
+    // A few staggered rows a window wide around the mouse (the whole world
+    // when it is no wider), starting just above the top.
+    size_t SpawnRain(SpawnShape shape, float centerX)
+    {
+        const SpawnTemplate& t = m_spawnTemplates[static_cast<size_t>(shape)];
+        float stepX = t.halfWidthPx * 2.0f + kBatchGapPx * 3.0f;
+        float stepY = t.halfHeightPx * 2.0f + kBatchGapPx * 6.0f;
+        float span = static_cast<float>(m_width);
+        float left = std::clamp(centerX - 0.5f * span, 0.0f, m_worldWidth - span);
+        int cols = std::max(1, static_cast<int>((span - 2.0f * t.halfWidthPx) / stepX));
+
+        m_batchScratch.clear();
+        for (int r = 0; r < kRainRows; ++r)
+        {
+            float y = -t.halfHeightPx - r * stepY;
+            float offset = (r % 2) ? stepX * 0.5f : 0.0f;
+            for (int c = 0; c < cols; ++c)
+            {
+                float x = left + t.halfWidthPx + 4.0f + offset + c * stepX + static_cast<float>(m_rng.Range(-6, 6));
+                m_batchScratch.push_back({std::clamp(x, left + t.halfWidthPx + 4.0f, left + span - t.halfWidthPx - 4.0f), y});
+            }
+        }
+        return SpawnBatch(shape, m_batchScratch.data(), m_batchScratch.size(), {0.0f, 4.0f});
+    }
+
+    // Called every input frame while the spray key is held.
+    void SprayAt(SpawnShape shape, Vector2 mousePx)
+    {
+        const SpawnTemplate& t = m_spawnTemplates[static_cast<size_t>(shape)];
+        Vector2 pts[kSprayPerFrame];
+        for (int i = 0; i < kSprayPerFrame; ++i)
+        {
+            Vector2 p{mousePx.x + static_cast<float>(m_rng.Range(-40, 40)), mousePx.y + static_cast<float>(m_rng.Range(-40, 40))};
+            pts[i] = ClampSpawnAboveGround(p, t.halfWidthPx, t.halfHeightPx);
+        }
+        b2Vec2 vel{static_cast<float>(m_rng.Range(-30, 30)) * 0.1f, static_cast<float>(m_rng.Range(10, 40)) * 0.1f};
+        SpawnBatch(shape, pts, kSprayPerFrame, vel);
+    }
+
+    // Larger shapes are made lighter per area so they stay throwable.
+    template <typename VertexList>
+    static float DensityScaleFor(const VertexList& verts)
+    {
+        float area = 0.0f;
+        for (size_t i = 0; i < verts.size(); ++i)
+        {
+            const Vector2& a = verts[i];
+            const Vector2& b = verts[(i + 1) % verts.size()];
+            area += a.x * b.y - b.x * a.y;
+        }
+        float areaPx2 = verts.size() < 3 ? 1.0f : std::max(1.0f, std::abs(area) * 0.5f);
+        return std::clamp(std::sqrt(kBaseSizePx * kBaseSizePx / areaPx2), 0.25f, 1.0f);
+    }
+
+    template <typename VertexList>
+    void SpawnPolygonBody(Vector2 centerPx, const VertexList& localVertices)
+    {
+        if (localVertices.size() < 3) return;
+        float minX = localVertices[0].x;
+        float maxX = localVertices[0].x;
+        float minY = localVertices[0].y;
+        float maxY = localVertices[0].y;
+        for (const Vector2& v : localVertices)
+        {
+            minX = std::min(minX, v.x);
+            maxX = std::max(maxX, v.x);
+            minY = std::min(minY, v.y);
+            maxY = std::max(maxY, v.y);
+        }
+        Vector2 spawn = ClampSpawnAboveGround(centerPx, std::max(std::abs(minX), std::abs(maxX)), std::max(std::abs(minY), std::abs(maxY)));
+        b2BodyId body = CreateDynamicBody(spawn);
+
+        ArenaVector<b2Vec2> pts{ArenaAllocator<b2Vec2>(m_frameArena)};
+        pts.reserve(localVertices.size());
+        for (const Vector2& p : localVertices)
+        {
+            pts.push_back({p.x * kInvPixelsPerMeter, p.y * kInvPixelsPerMeter});
+        }
+
+        b2Hull hull = b2ComputeHull(pts.data(), static_cast<int>(pts.size()));
+        if (hull.count < 3)
+        {
+            b2DestroyBody(body);
+            return;
+        }
+
+        b2ShapeDef shapeDef = BodyShapeDef();
+        shapeDef.density = DensityScaleFor(localVertices);
+        shapeDef.material.friction = 1.6f;
+        shapeDef.material.restitution = 0.0f;
+        shapeDef.material.rollingResistance = 0.0f;
+
+        b2Polygon poly = b2MakePolygon(&hull, 0.0f);
+        b2CreatePolygonShape(body, &shapeDef, &poly);
+
+        BodyEntry entry;
+        entry.bodyId = body;
+        entry.kind = BodyKind::Polygon;
+        entry.shape = InternPolygonPx(m_shapes, poly);
+        ApplyBodySurface(InsertBody(std::move(entry)));
+        PushSpawnOrder(body);
+    }
+
+    void SpawnQuadFromDrag(Vector2 a, Vector2 b)
+    {
+        float minX = std::min(a.x, b.x);
+        float maxX = std::max(a.x, b.x);
+        float minY = std::min(a.y, b.y);
+        float maxY = std::max(a.y, b.y);
+        float w = maxX - minX;
+        float h = maxY - minY;
+        if (w < 10.0f || h < 10.0f) return;
+
+        const float minDim = 22.0f;
+        w = std::max(w, minDim);
+        h = std::max(h, minDim);
+        const float aspect = std::max(w, h) / std::max(1.0f, std::min(w, h));
+        if (aspect > 12.0f)
+        {
+            if (w > h) h = w / 12.0f;
+            else w = h / 12.0f;
+        }
+
+        Vector2 centerPx{(minX + maxX) * 0.5f, (minY + maxY) * 0.5f};
+        std::vector<Vector2> local = {
+            {-w * 0.5f, -h * 0.5f},
+            {w * 0.5f, -h * 0.5f},
+            {w * 0.5f, h * 0.5f},
+            {-w * 0.5f, h * 0.5f}
+        };
+        SpawnPolygonBody(centerPx, local);
+    }
+
+    void SpawnCircleFromDrag(Vector2 a, Vector2 b, bool perfect)
+    {
+        float minX = std::min(a.x, b.x);
+        float maxX = std::max(a.x, b.x);
+        float minY = std::min(a.y, b.y);
+        float maxY = std::max(a.y, b.y);
+        float w = maxX - minX;
+        float h = maxY - minY;
+        if (perfect)
+        {
+            float d = std::max(12.0f, std::max(w, h));
+            w = d;
+            h = d;
+        }
+        float diameter = std::min(w, h);
+        if (diameter < 12.0f) return;
+
+        Vector2 centerPx{(minX + maxX) * 0.5f, (minY + maxY) * 0.5f};
+        Vector2 spawn = ClampSpawnAboveGround(centerPx, diameter * 0.5f, diameter * 0.5f);
+        b2BodyId body = CreateDynamicBody(spawn);
+
+        b2ShapeDef shapeDef = BodyShapeDef();
+        float baseArea = kBaseSizePx * kBaseSizePx;
+        float circleArea = static_cast<float>(PI) * (diameter * 0.5f) * (diameter * 0.5f);
+        shapeDef.density = std::clamp(std::sqrt(baseArea / std::max(1.0f, circleArea)), 0.25f, 1.0f);
+        shapeDef.material.friction = 0.95f;
+        shapeDef.material.restitution = 0.0f;
+        shapeDef.material.rollingResistance = 0.0f;
+
+        b2Circle circle{};
+        circle.center = {0.0f, 0.0f};
+        circle.radius = (diameter * 0.5f) * kInvPixelsPerMeter;
+        b2CreateCircleShape(body, &shapeDef, &circle);
+
+        BodyEntry entry;
+        entry.bodyId = body;
+        entry.kind = BodyKind::Circle;
+        entry.radiusPx = diameter * 0.5f;
+        ApplyBodySurface(InsertBody(std::move(entry)));
+        PushSpawnOrder(body);
+    }
+
+    void SpawnTriangleFromDrag(Vector2 a, Vector2 b)
+    {
+        Rectangle r = NormalizeRect(a, b);
+        if (r.width < 12.0f || r.height < 12.0f) return;
+        float h = r.height;
+        float w = 2.0f * h / std::sqrt(3.0f);
+        if (w > r.width)
+        {
+            w = r.width;
+            h = w * std::sqrt(3.0f) * 0.5f;
+        }
+        Vector2 center{r.x + r.width * 0.5f, r.y + r.height * 0.5f};
+        std::vector<Vector2> local = {
+            {0.0f, -h * 0.5f},
+            {w * 0.5f, h * 0.5f},
+            {-w * 0.5f, h * 0.5f}
+        };
+        SpawnPolygonBody(center, local);
+    }
+
+    void SpawnFreeformFromStroke(const std::vector<Vector2>& stroke)
+    {
+        if (stroke.size() < 3) return;
+
+        // At most 48 points; decomposition and the hull cut them down further.
+        ArenaAllocator<Vector2> alloc(m_frameArena);
+        ArenaVector<Vector2> pts(alloc);
+        if (stroke.size() > 48)
+        {
+            pts.reserve(48);
+            const float step = static_cast<float>(stroke.size() - 1) / 47.0f;
+            for (int i = 0; i < 48; ++i)
+            {
+                int idx = static_cast<int>(std::round(i * step));
+                idx = std::max(0, std::min(idx, static_cast<int>(stroke.size()) - 1));
+                pts.push_back(stroke[idx]);
+            }
+        }
+        else
+        {
+            pts.assign(stroke.begin(), stroke.end());
+        }
+
+        Vector2 c{0, 0};
+        for (const Vector2& p : pts)
+        {
+            c.x += p.x;
+            c.y += p.y;
+        }
+        c.x /= static_cast<float>(pts.size());
+        c.y /= static_cast<float>(pts.size());
+
+        ArenaVector<Vector2> local(alloc);
+        local.reserve(pts.size());
+        for (const Vector2& p : pts)
+        {
+            local.push_back({p.x - c.x, p.y - c.y});
+        }
+
+        // Concave strokes become compounds of convex parts; the rest, and any
+        // stroke the decomposition gives up on, spawn as their hull.
+        const FreeformPieces& pieces = FreeformPiecesFor(local);
+        if (pieces.parts.empty()) SpawnPolygonBody(c, ReducedHullPx(std::vector<Vector2>(local.begin(), local.end())));
+        else SpawnFreeformCompound(c, local, pieces);
+    }
+
+    // Decomposes a centred stroke (px) into convex parts, or looks it up.
+    template <typename VertexList>
+    const FreeformPieces& FreeformPiecesFor(const VertexList& local)
+    {
+        uint64_t key = 14695981039346656037ull;
+        for (const Vector2& v : local)
+        {
+            // Quarter-pixel grid, so replayed strokes land on the same key.
+            for (float f : {v.x, v.y})
+            {
+                key ^= static_cast<uint32_t>(static_cast<int32_t>(std::lround(f * 4.0f)));
+                key *= 1099511628211ull;
+            }
+        }
+        auto it = m_freeformCache.find(key);
+        if (it != m_freeformCache.end()) return it->second;
+        if (m_freeformCache.size() >= kFreeformCacheSize) m_freeformCache.clear();
+
+        FreeformPieces& out = m_freeformCache[key];
+        std::vector<b2Vec2> poly;
+        poly.reserve(local.size());
+        for (const Vector2& v : local) poly.push_back({v.x, v.y});
+        std::vector<decompose::Piece> pieces;
+        if (!decompose::Decompose(std::move(poly), 3.0f, 2.0f, kMaxFreeformPieces, pieces) || pieces.size() < 2) return out;
+
+        float density = DensityScaleFor(local);
+        std::vector<b2Vec2> centroid(pieces.size());
+        for (size_t i = 0; i < pieces.size(); ++i)
+        {
+            const decompose::Piece& piece = pieces[i];
+            centroid[i] = fracture::PolygonCentroid(piece.verts, piece.count);
+            Vector2 outline[decompose::kMaxPieceVerts];
+            for (int k = 0; k < piece.count; ++k) outline[k] = {piece.verts[k].x - centroid[i].x, piece.verts[k].y - centroid[i].y};
+            RigidPart part;
+            part.local.p = ToMeters({centroid[i].x, centroid[i].y});
+            part.shape = m_shapes.Intern(outline, static_cast<size_t>(piece.count));
+            part.density = density;
+            part.kind = BodyKind::Polygon;
+            out.parts.push_back(part);
+        }
+        // Welds across the cut diagonals, so splitting leaves the outline standing.
+        for (size_t i = 0; i < pieces.size(); ++i)
+        {
+            for (const auto& [j, mid] : pieces[i].neighbours)
+            {
+                if (static_cast<size_t>(j) < i) continue;
+                RigidJoint weld;
+                weld.partA = static_cast<uint32_t>(i);
+                weld.partB = static_cast<uint32_t>(j);
+                weld.frameA.p = ToMeters({mid.x - centroid[i].x, mid.y - centroid[i].y});
+                weld.frameB.p = ToMeters({mid.x - centroid[j].x, mid.y - centroid[j].y});
+                out.welds.push_back(weld);
+            }
+        }
+        out.hull = InternCompoundHull(out.parts, out.radiusPx);
+        return out;
+    }
+
+    void SpawnFreeformCompound(Vector2 centerPx, const ArenaVector<Vector2>& local, const FreeformPieces& pieces)
+    {
+        float halfW = 0.0f;
+        float halfH = 0.0f;
+        for (const Vector2& v : local)
+        {
+            halfW = std::max(halfW, std::abs(v.x));
+            halfH = std::max(halfH, std::abs(v.y));
+        }
+        b2BodyId body = CreateDynamicBody(ClampSpawnAboveGround(centerPx, halfW, halfH));
+        std::vector<RigidPart> parts = pieces.parts;
+        for (RigidPart& p : parts) p.shapeId = CreatePartShape(body, p, p.local);
+
+        BodyEntry entry;
+        entry.bodyId = body;
+        entry.kind = BodyKind::Compound;
+        entry.shape = pieces.hull;
+        entry.radiusPx = pieces.radiusPx;
+        size_t idx = InsertBody(std::move(entry));
+        BodyCold& cold = Cold(idx);
+        cold.parts = std::move(parts);
+        cold.partJoints = pieces.welds;
+        ApplyBodySurface(idx);
+        PushSpawnOrder(body);
+    }
+
+    void UnindexBody(b2BodyId id)
+    {
+        ++m_sceneEdits;
+        if (id.index1 > 0 && static_cast<size_t>(id.index1) < m_handleByBodyIndex.size())
+        {
+            m_handleByBodyIndex[static_cast<size_t>(id.index1)] = SlotHandle{};
+        }
+    }
+
+    // Returns the dense index of the new entry.
+    size_t InsertBody(BodyEntry&& entry)
+    {
+        ++m_sceneEdits;
+        int32_t bodyIndex = entry.bodyId.index1;
+        SlotHandle handle = m_bodies.Insert(std::move(entry));
+        if (handle.index >= m_bodyCold.size()) m_bodyCold.resize(m_bodies.SlotCount());
+        // Reset the reused slot but keep its joint list capacity.
+        BodyCold& cold = m_bodyCold[handle.index];
+        std::vector<SlotHandle> joints = std::move(cold.joints);
+        joints.clear();
+        cold = BodyCold{};
+        cold.joints = std::move(joints);
+        cold.order = m_nextBodyOrder++;
+        m_drawOrder.push_back(handle);
+        if (m_drawOrder.size() > 2 * m_bodies.size() + 64) CompactDrawOrder();
+        b2BodyId bodyId = m_bodies[m_bodies.size() - 1].bodyId;
+        if (b2Body_IsValid(bodyId))
+        {
+            cold.xf = b2Body_GetTransform(bodyId);
+            if (!b2Body_IsAwake(bodyId)) SetResting(handle.index, true);
+            else m_movedSlots.push_back(handle.index);
+            m_waterFreshSlots.push_back(handle.index); // the sensor sees it after the next step
+        }
+        if (bodyIndex > 0)
+        {
+            if (static_cast<size_t>(bodyIndex) >= m_handleByBodyIndex.size())
+            {
+                m_handleByBodyIndex.resize(static_cast<size_t>(bodyIndex) * 2 + 16);
+            }
+            m_handleByBodyIndex[static_cast<size_t>(bodyIndex)] = handle;
+        }
+        return m_bodies.size() - 1;
+    }
+
+    std::optional<size_t> BodyIndexById(b2BodyId id) const
+    {
+        if (id.index1 <= 0 || static_cast<size_t>(id.index1) >= m_handleByBodyIndex.size()) return std::nullopt;
+        auto slot = m_bodies.DenseIndex(m_handleByBodyIndex[static_cast<size_t>(id.index1)]);
+        if (!slot) return std::nullopt;
+        // A recycled Box2D index must not resolve to a stale entry.
+        if (!B2_ID_EQUALS(m_bodies[*slot].bodyId, id)) return std::nullopt;
+        if (!b2Body_IsValid(id)) return std::nullopt;
+        return slot;
+    }
+
+    std::optional<size_t> BodyIndexByKey(uint64_t key) const
+    {
+        return BodyIndexById(b2LoadBodyId(key));
+    }
+
+    static constexpr float kPickPadM = 0.3f; // ~15 px
+    static constexpr float kMinFragmentAreaM2 = 0.004f;
+    static constexpr float kGlassLoadImpulse = 0.01f;
+
+    struct PickQuery
+    {
+        SandboxCore* self = nullptr;
+        b2Vec2 point{0.0f, 0.0f};
+        std::optional<size_t> hit;
+        std::optional<size_t> nearest;
+        float nearestDist2 = 999999999.0f;
+    };
+
+    static bool PickOverlapCallback(b2ShapeId shapeId, void* context)
+    {
+        PickQuery& q = *static_cast<PickQuery*>(context);
+        b2BodyId bodyId = b2Shape_GetBody(shapeId);
+        auto idx = q.self->BodyIndexById(bodyId);
+        if (!idx) return true;
+
+        // Later spawns draw on top, so the highest order wins.
+        uint64_t order = q.self->Cold(*idx).order;
+        if (b2Shape_TestPoint(shapeId, q.point))
+        {
+            if (!q.hit || order > q.self->Cold(*q.hit).order) q.hit = idx;
+            return true;
+        }
+        if (q.hit) return true;
+
+        // Fallback: allow small pick tolerance around body AABB.
+        b2AABB aabb = b2Body_ComputeAABB(bodyId);
+        if (q.point.x < aabb.lowerBound.x - kPickPadM || q.point.x > aabb.upperBound.x + kPickPadM ||
+            q.point.y < aabb.lowerBound.y - kPickPadM || q.point.y > aabb.upperBound.y + kPickPadM)
+        {
+            return true;
+        }
+        b2Vec2 c = b2Body_GetPosition(bodyId);
+        float dx = c.x - q.point.x;
+        float dy = c.y - q.point.y;
+        float d2 = dx * dx + dy * dy;
+        if (d2 < q.nearestDist2 || (d2 == q.nearestDist2 && q.nearest && order > q.self->Cold(*q.nearest).order))
+        {
+            q.nearestDist2 = d2;
+            q.nearest = idx;
+        }
+        return true;
+    }
+
+    std::optional<size_t> PickBody(Vector2 mousePx)
+    {
+        PickQuery q;
+        q.self = this;
+        q.point = ToMeters(mousePx);
+
+        b2AABB box{{q.point.x - kPickPadM, q.point.y - kPickPadM}, {q.point.x + kPickPadM, q.point.y + kPickPadM}};
+        b2World_OverlapAABB(m_worldId, box, b2DefaultQueryFilter(), &PickOverlapCallback, &q);
+        return q.hit ? q.hit : q.nearest;
+    }
+
+    void SetSelected(size_t idx, bool on)
+    {
+        BodyEntry& e = m_bodies[idx];
+        if (e.Has(kFeatureSelected) == on) return;
+        e.Set(kFeatureSelected, on);
+        ++m_restingVersion;
+        if (on) m_selectedSet.Set(m_bodies.SlotIndexAt(idx));
+        else m_selectedSet.Reset(m_bodies.SlotIndexAt(idx));
+    }
+
+    // Only touches bodies that are currently selected.
+    void ClearSelection()
+    {
+        if (!m_selectedSet.Any()) return;
+        m_selectedSet.ForEach([this](uint32_t slot) {
+            if (auto idx = m_bodies.DenseIndexOfSlot(slot)) m_bodies[*idx].Set(kFeatureSelected, false);
+        });
+        m_selectedSet.Clear();
+        ++m_restingVersion;
+    }
+
+    // Arena-backed; valid until the next frame arena reset.
+    ArenaVector<size_t> SelectedIndices()
+    {
+        ArenaVector<size_t> out{ArenaAllocator<size_t>(m_frameArena)};
+        out.reserve(m_selectedSet.Count());
+        m_selectedSet.ForEach([this, &out](uint32_t slot) {
+            auto idx = m_bodies.DenseIndexOfSlot(slot);
+            if (idx && b2Body_IsValid(m_bodies[*idx].bodyId)) out.push_back(*idx);
+        });
+        std::sort(out.begin(), out.end());
+        return out;
+    }
+
+    struct RectSelectQuery
+    {
+        SandboxCore* self = nullptr;
+        Rectangle rect{};
+    };
+
+    static bool RectSelectCallback(b2ShapeId shapeId, void* context)
+    {
+        RectSelectQuery& q = *static_cast<RectSelectQuery*>(context);
+        b2BodyId bodyId = b2Shape_GetBody(shapeId);
+        auto idx = q.self->BodyIndexById(bodyId);
+        if (!idx) return true;
+        Vector2 p = ToPixels(b2Body_GetPosition(bodyId));
+        if (PointInRect(p, q.rect)) q.self->SetSelected(*idx, true);
+        return true;
+    }
+
+    void SelectByRect(const Rectangle& rect)
+    {
+        ClearSelection();
+        RectSelectQuery q;
+        q.self = this;
+        q.rect = rect;
+        b2AABB box{ToMeters({rect.x, rect.y}), ToMeters({rect.x + rect.width, rect.y + rect.height})};
+        b2World_OverlapAABB(m_worldId, box, b2DefaultQueryFilter(), &RectSelectCallback, &q);
+    }
+
+    void LinkJoint(SlotHandle jointHandle)
+    {
+        ++m_sceneEdits;
+        const JointEntry* j = m_joints.Get(jointHandle);
+        if (!j) return;
+        if (auto ia = BodyIndexByKey(j->bodyA)) Cold(*ia).joints.push_back(jointHandle);
+        if (auto ib = BodyIndexByKey(j->bodyB)) Cold(*ib).joints.push_back(jointHandle);
+    }
+
+    void UnlinkJointFromBody(uint64_t bodyKey, SlotHandle jointHandle)
+    {
+        auto idx = BodyIndexByKey(bodyKey);
+        if (!idx) return;
+        std::vector<SlotHandle>& list = Cold(*idx).joints;
+        auto it = std::find(list.begin(), list.end(), jointHandle);
+        if (it == list.end()) return;
+        *it = list.back();
+        list.pop_back();
+    }
+
+    // Destroys the Box2D joint and drops it from both adjacency lists; the
+    // entry is left with a null id so the caller can compact m_joints once.
+    void ReleaseJoint(SlotHandle jointHandle, bool wakeAttached)
+    {
+        JointEntry* j = m_joints.Get(jointHandle);
+        if (!j) return;
+        ++m_sceneEdits;
+        if (b2Joint_IsValid(j->jointId)) b2DestroyJoint(j->jointId, wakeAttached);
+        j->jointId = b2_nullJointId;
+        UnlinkJointFromBody(j->bodyA, jointHandle);
+        UnlinkJointFromBody(j->bodyB, jointHandle);
+    }
+
+    void CompactJoints()
+    {
+        // Joints Box2D destroyed on its own still sit in adjacency lists.
+        for (size_t i = 0; i < m_joints.size(); ++i)
+        {
+            const JointEntry& j = m_joints[i];
+            if (B2_IS_NULL(j.jointId) || b2Joint_IsValid(j.jointId)) continue;
+            UnlinkJointFromBody(j.bodyA, m_joints.HandleAt(i));
+            UnlinkJointFromBody(j.bodyB, m_joints.HandleAt(i));
+        }
+        m_joints.EraseIf([](const JointEntry& j) { return !b2Joint_IsValid(j.jointId); });
+    }
+
+    // Swap-and-pop: the last body takes over dense index idx. Draw and pick
+    // order come from BodyCold::order, so that does not reorder anything.
+    void DeleteBodyIndex(size_t idx)
+    {
+        if (idx >= m_bodies.size()) return;
+        b2BodyId body = m_bodies[idx].bodyId;
+        ForgetBodySlot(idx);
+        if (!b2Body_IsValid(body))
+        {
+            UnindexBody(body);
+            m_bodies.EraseAt(idx);
+            return;
+        }
+
+        uint64_t key = BodyKey(body);
+        // Remove joints attached to this body.
+        m_linkScratch.assign(Cold(idx).joints.begin(), Cold(idx).joints.end());
+        for (SlotHandle jh : m_linkScratch) ReleaseJoint(jh, true);
+        for (SlotHandle jh : m_linkScratch) m_joints.Erase(jh);
+
+        UnindexBody(body);
+        b2DestroyBody(body);
+        m_bodies.EraseAt(idx);
+
+        m_spawnOrder.erase(std::remove(m_spawnOrder.begin(), m_spawnOrder.end(), key), m_spawnOrder.end());
+    }
+
+    // Destroys a batch of bodies, then compacts bodies, joints and spawn order in one pass each.
+    template <typename IndexList>
+    void DeleteBodies(const IndexList& indices)
+    {
+        if (indices.empty()) return;
+        ArenaVector<uint64_t> keys{ArenaAllocator<uint64_t>(m_frameArena)};
+        keys.reserve(indices.size());
+        for (size_t idx : indices)
+        {
+            if (idx >= m_bodies.size()) continue;
+            b2BodyId body = m_bodies[idx].bodyId;
+            if (!b2Body_IsValid(body)) continue;
+            uint64_t key = BodyKey(body);
+            keys.push_back(key);
+            ForgetBodySlot(idx);
+
+            m_linkScratch.assign(Cold(idx).joints.begin(), Cold(idx).joints.end());
+            for (SlotHandle jh : m_linkScratch) ReleaseJoint(jh, true);
+        }
+        std::sort(keys.begin(), keys.end());
+        auto doomed = [&keys](uint64_t key) { return std::binary_search(keys.begin(), keys.end(), key); };
+
+        CompactJoints();
+        for (uint64_t key : keys)
+        {
+            b2BodyId body = b2LoadBodyId(key);
+            UnindexBody(body);
+            b2DestroyBody(body);
+        }
+        m_bodies.EraseIf([](const BodyEntry& e) { return !b2Body_IsValid(e.bodyId); });
+        m_spawnOrder.erase(std::remove_if(m_spawnOrder.begin(), m_spawnOrder.end(), doomed), m_spawnOrder.end());
+    }
+
+    void DeleteBodyAt(Vector2 mousePx)
+    {
+        auto picked = PickBody(mousePx);
+        if (picked) DeleteBodyIndex(*picked);
+    }
+
+    void UndoSpawn()
+    {
+        while (!m_spawnOrder.empty())
+        {
+            uint64_t key = m_spawnOrder.back();
+            m_spawnOrder.pop_back();
+            if (auto idx = BodyIndexByKey(key))
+            {
+                DeleteBodyIndex(*idx);
+                return;
+            }
+        }
+    }
+
+    static RewindState RewindStateOf(b2BodyId body)
+    {
+        b2Transform xf = b2Body_GetTransform(body);
+        b2Vec2 v = b2Body_GetLinearVelocity(body);
+        return {xf.p.x, xf.p.y, b2Rot_GetAngle(xf.q), v.x, v.y, b2Body_GetAngularVelocity(body), !b2Body_IsAwake(body)};
+    }
+
+    // After a step: a keyframe when one is due, otherwise the bodies that
+    // moved since the last capture.
+    void CaptureRewind()
+    {
+        if (m_sceneEdits != m_rewindEdits || !m_rewind.AtHead() || m_rewind.FramesSinceKeyframe() >= kRewindKeyframeFrames)
+        {
+            std::vector<uint8_t> image;
+            std::vector<uint32_t> recordSlots;
+            BuildSceneImage(image, &recordSlots);
+            std::vector<RewindState> base(m_bodies.SlotCount());
+            for (size_t i = 0; i < m_bodies.size(); ++i)
+            {
+                if (IsValid(m_bodies[i].bodyId)) base[m_bodies.SlotIndexAt(i)] = RewindStateOf(m_bodies[i].bodyId);
+            }
+            m_rewind.PushKeyframe(m_rewindStep, std::move(image), std::move(recordSlots), std::move(base));
+            m_rewindEdits = m_sceneEdits;
+            m_rewindDirty.Clear();
+            return;
+        }
+        m_rewindSlots.clear();
+        m_rewindStates.clear();
+        m_rewindDirty.ForEach([this](uint32_t slot) {
+            auto idx = m_bodies.DenseIndexOfSlot(slot);
+            if (!idx || !IsValid(m_bodies[*idx].bodyId)) return;
+            m_rewindSlots.push_back(slot);
+            m_rewindStates.push_back(RewindStateOf(m_bodies[*idx].bodyId));
+        });
+        m_rewind.PushDelta(m_rewindStep, m_rewindSlots.data(), m_rewindStates.data(), m_rewindSlots.size());
+        m_rewindDirty.Clear();
+    }
+
+    void RewindBy(int captures)
+    {
+        if (m_rewind.Empty()) return;
+        long last = static_cast<long>(m_rewind.FrameCount()) - 1;
+        long target = std::clamp(static_cast<long>(m_rewind.Cursor()) + captures, 0L, last);
+        if (target == static_cast<long>(m_rewind.Cursor()) && m_paused) return;
+        RestoreRewindFrame(static_cast<size_t>(target));
+    }
+
+    // Reloads the frame's keyframe, then puts every body where the frame had
+    // it. Contacts and warm starting are not part of the history, so the run
+    // continues plausibly from there rather than exactly as before. Paused
+    // afterwards; the next capture forks the history.
+    bool RestoreRewindFrame(size_t frame)
+    {
+        const RewindBuffer::Segment* seg = m_rewind.Seek(frame, m_rewindStates);
+        if (!seg) return false;
+        std::vector<b2BodyId> recordBodies;
+        // Hibernating or restoring a region clears the history, so the
+        // regions now are the regions of every frame in it.
+        std::vector<HibernatedRegion> hibernated = std::move(m_hibernated);
+        size_t hibernatedBodies = m_hibernatedBodies;
+        bool loaded = LoadSceneImage(seg->image.data(), seg->image.size(), &recordBodies);
+        m_hibernated = std::move(hibernated);
+        m_hibernatedBodies = hibernatedBodies;
+        if (!loaded) return false;
+        for (size_t r = 0; r < recordBodies.size() && r < seg->recordSlots.size(); ++r)
+        {
+            uint32_t slot = seg->recordSlots[r];
+            // A compound's parts are consecutive records of one slot.
+            if ((r > 0 && seg->recordSlots[r - 1] == slot) || slot >= m_rewindStates.size()) continue;
+            b2BodyId body = recordBodies[r];
+            if (!IsValid(body)) continue;
+            const RewindState& from = seg->base[slot];
+            const RewindState& to = m_rewindStates[slot];
+            // A reloaded compound is rebuilt around its first part, so its
+            // origin can differ from the recorded one; keep the offset.
+            b2Transform offset = b2InvMulTransforms({{from.px, from.py}, b2MakeRot(from.angle)}, b2Body_GetTransform(body));
+            b2Transform xf = b2MulTransforms({{to.px, to.py}, b2MakeRot(to.angle)}, offset);
+            b2Body_SetTransform(body, xf.p, xf.q);
+            b2Body_SetLinearVelocity(body, {to.vx, to.vy});
+            b2Body_SetAngularVelocity(body, to.w);
+            b2Body_SetAwake(body, !to.asleep);
+            if (auto idx = BodyIndexById(body))
+            {
+                uint32_t newSlot = m_bodies.SlotIndexAt(*idx);
+                m_bodyCold[newSlot].xf = xf;
+                SetResting(newSlot, to.asleep);
+            }
+        }
+        ++m_restingVersion;
+        m_rewindStep = m_rewind.StepAt(frame);
+        m_accumulator = 0.0f;
+        m_paused = true;
+        return true;
+    }
+
+    // Walks the joint adjacency lists; cost is proportional to the group size.
+    // weldsOnly leaves out wheel joints. The returned buffer is reused by the
+    // next call.
+    const std::vector<size_t>& BodiesLinkedTo(size_t bodyIndex, bool weldsOnly = false)
+    {
+        m_linkedScratch.clear();
+        if (bodyIndex >= m_bodies.size()) return m_linkedScratch;
+
+        if (++m_visitEpoch == 0)
+        {
+            for (BodyCold& c : m_bodyCold) c.visitMark = 0;
+            m_visitEpoch = 1;
+        }
+
+        Cold(bodyIndex).visitMark = m_visitEpoch;
+        m_linkedScratch.push_back(bodyIndex);
+        for (size_t head = 0; head < m_linkedScratch.size(); ++head)
+        {
+            size_t curIdx = m_linkedScratch[head];
+            uint64_t curKey = BodyKey(m_bodies[curIdx].bodyId);
+            for (SlotHandle jh : Cold(curIdx).joints)
+            {
+                const JointEntry* j = m_joints.Get(jh);
+                if (!j || !b2Joint_IsValid(j->jointId) || (weldsOnly && j->isWheelJoint)) continue;
+                auto other = BodyIndexByKey(j->bodyA == curKey ? j->bodyB : j->bodyA);
+                if (!other || Cold(*other).visitMark == m_visitEpoch) continue;
+                Cold(*other).visitMark = m_visitEpoch;
+                m_linkedScratch.push_back(*other);
+            }
+        }
+
+        std::sort(m_linkedScratch.begin(), m_linkedScratch.end());
+        return m_linkedScratch;
+    }
+
+    // Frames are in each body's local space; shared by the tools and LoadScene.
+    bool CreateJointWithFrames(b2BodyId a, b2BodyId b, b2Transform frameA, b2Transform frameB, bool wheel)
+    {
+        b2JointId joint = b2_nullJointId;
+        if (wheel)
+        {
+            b2RevoluteJointDef def = b2DefaultRevoluteJointDef();
+            def.base.bodyIdA = a;
+            def.base.bodyIdB = b;
+            def.base.collideConnected = false;
+            def.base.localFrameA = frameA;
+            def.base.localFrameB = frameB;
+            def.enableMotor = false;
+            def.enableLimit = false;
+            def.enableSpring = false;
+            joint = b2CreateRevoluteJoint(m_worldId, &def);
+        }
+        else
+        {
+            b2WeldJointDef def = b2DefaultWeldJointDef();
+            def.base.bodyIdA = a;
+            def.base.bodyIdB = b;
+            def.base.collideConnected = false;
+            def.base.localFrameA = frameA;
+            def.base.localFrameB = frameB;
+            def.linearHertz = 0.0f;
+            def.angularHertz = 0.0f;
+            def.linearDampingRatio = 1.0f;
+            def.angularDampingRatio = 1.0f;
+            joint = b2CreateWeldJoint(m_worldId, &def);
+        }
+        if (!b2Joint_IsValid(joint)) return false;
+
+        JointEntry e;
+        e.jointId = joint;
+        e.bodyA = BodyKey(a);
+        e.bodyB = BodyKey(b);
+        e.isWheelJoint = wheel;
+        SlotHandle h = m_joints.Insert(std::move(e));
+        JointEntry& entry = *m_joints.Get(h);
+        ApplyBreakLimits(entry, m_jointBreakForce, m_jointBreakTorque);
+        // The same tag scheme as AdhesionPool; both check the id on events.
+        b2Joint_SetUserData(joint, reinterpret_cast<void*>(static_cast<uintptr_t>(h.index) + 1));
+        LinkJoint(h);
+        return true;
+    }
+
+    static void ApplyBreakLimits(JointEntry& j, float forceN, float torqueNm)
+    {
+        j.breakForce = std::max(0.0f, forceN);
+        j.breakTorque = std::max(0.0f, torqueNm);
+        b2Joint_SetForceThreshold(j.jointId, j.breakForce > 0.0f ? j.breakForce : FLT_MAX);
+        b2Joint_SetTorqueThreshold(j.jointId, j.breakTorque > 0.0f ? j.breakTorque : FLT_MAX);
+    }
+
+    // Box2D flags joints over their limits while it solves them, on the
+    // step's worker tasks and only for awake joints, and hands them over as
+    // events; breaking is one lookup per event, never a scan of m_joints.
+    void BreakOverloadedJoints()
+    {
+        SLOP_ZONE("BreakOverloadedJoints");
+        m_jointBreaks.clear();
+        m_jointBreakScratch.clear();
+        b2JointEvents events = b2World_GetJointEvents(m_worldId);
+        for (int i = 0; i < events.count; ++i)
+        {
+            const b2JointEvent& ev = events.jointEvents[i];
+            auto tag = reinterpret_cast<uintptr_t>(ev.userData);
+            if (tag == 0 || tag > m_joints.SlotCount()) continue;
+            auto dense = m_joints.DenseIndexOfSlot(static_cast<uint32_t>(tag - 1));
+            if (!dense || !B2_ID_EQUALS(m_joints[*dense].jointId, ev.jointId)) continue; // an adhesion weld
+            const JointEntry& j = m_joints[*dense];
+            b2Transform frame = b2MulTransforms(b2Body_GetTransform(b2Joint_GetBodyA(j.jointId)), b2Joint_GetLocalFrameA(j.jointId));
+            m_jointBreaks.push_back({j.bodyA, j.bodyB, ToPixels(frame.p), j.isWheelJoint});
+            m_jointBreakScratch.push_back(m_joints.HandleAt(*dense));
+        }
+        if (m_jointBreakScratch.empty()) return;
+
+        for (SlotHandle jh : m_jointBreakScratch) ReleaseJoint(jh, true);
+        for (SlotHandle jh : m_jointBreakScratch) m_joints.Erase(jh);
+        m_jointBreakCount += m_jointBreaks.size();
+        for (const JointBreakEvent& ev : m_jointBreaks)
+        {
+            // A wheel that lost its last axle is a plain body again.
+            auto wheel = ev.wheel ? BodyIndexByKey(ev.bodyB) : std::nullopt;
+            if (wheel && !HasWheelJoint(*wheel))
+            {
+                m_bodies[*wheel].Set(kFeatureWheel, false);
+                ++m_restingVersion;
+            }
+            DeferredJob job;
+            job.type = DeferredJobType::GlassShards;
+            job.at = ev.anchorPx;
+            job.amount = kBaseSizePx * kBaseSizePx * 0.25f;
+            job.seed = m_rng.Next();
+            m_deferred.Push(job, DeferredPriority::Normal, 3, true);
+        }
+    }
+
+    bool HasWheelJoint(size_t idx) const
+    {
+        for (SlotHandle jh : Cold(idx).joints)
+        {
+            const JointEntry* j = m_joints.Get(jh);
+            if (j && j->isWheelJoint && b2Joint_IsValid(j->jointId)) return true;
+        }
+        return false;
+    }
+
+    bool CreateAnchoredJoint(b2BodyId a, b2BodyId b, b2Vec2 worldAnchor, bool wheel)
+    {
+        if (!b2Body_IsValid(a) || !b2Body_IsValid(b) || B2_ID_EQUALS(a, b)) return false;
+
+        b2Transform worldFrame{};
+        worldFrame.p = worldAnchor;
+        worldFrame.q = b2MakeRot(0.0f);
+        return CreateJointWithFrames(a, b, b2InvMulTransforms(b2Body_GetTransform(a), worldFrame),
+                                     b2InvMulTransforms(b2Body_GetTransform(b), worldFrame), wheel);
+    }
+
+    bool CreateWeldJoint(b2BodyId a, b2BodyId b, b2Vec2 worldAnchor)
+    {
+        return CreateAnchoredJoint(a, b, worldAnchor, false);
+    }
+
+    bool CreateWheelJoint(b2BodyId host, b2BodyId wheel, b2Vec2 worldAnchor)
+    {
+        return CreateAnchoredJoint(host, wheel, worldAnchor, true);
+    }
+
+    void ToggleWheelMode(size_t idx)
+    {
+        if (idx >= m_bodies.size()) return;
+        b2BodyId wheelBody = m_bodies[idx].bodyId;
+        if (!b2Body_IsValid(wheelBody)) return;
+
+        bool hasWheelJoint = false;
+        bool hasAnyJoint = false;
+        for (SlotHandle jh : Cold(idx).joints)
+        {
+            const JointEntry* j = m_joints.Get(jh);
+            if (j && b2Joint_IsValid(j->jointId))
+            {
+                hasAnyJoint = true;
+                if (j->isWheelJoint) hasWheelJoint = true;
+            }
+        }
+
+        if (!hasAnyJoint) return;
+
+        b2Vec2 anchor = b2Body_GetPosition(wheelBody);
+
+        // Collect first, mutate later (prevents endless reprocessing/crash when replacing joints).
+        // A wheel has a handful of hosts, so a linear scan dedupes them.
+        ArenaVector<uint64_t> hostKeys{ArenaAllocator<uint64_t>(m_frameArena)};
+        ArenaVector<b2BodyId> hosts{ArenaAllocator<b2BodyId>(m_frameArena)};
+        hostKeys.reserve(8);
+        hosts.reserve(8);
+
+        m_linkScratch.assign(Cold(idx).joints.begin(), Cold(idx).joints.end());
+        for (SlotHandle jh : m_linkScratch)
+        {
+            const JointEntry* jp = m_joints.Get(jh);
+            if (!jp || !b2Joint_IsValid(jp->jointId)) continue;
+            const JointEntry& j = *jp;
+            b2BodyId a = b2Joint_GetBodyA(j.jointId);
+            b2BodyId b = b2Joint_GetBodyB(j.jointId);
+            if (!b2Body_IsValid(a) || !b2Body_IsValid(b) || B2_ID_EQUALS(a, b)) continue;
+            b2BodyId host = B2_ID_EQUALS(a, wheelBody) ? b : a;
+            if (!b2Body_IsValid(host) || B2_ID_EQUALS(host, wheelBody)) continue;
+            uint64_t hostKey = BodyKey(host);
+            if (std::find(hostKeys.begin(), hostKeys.end(), hostKey) == hostKeys.end())
+            {
+                hostKeys.push_back(hostKey);
+                hosts.push_back(host);
+            }
+        }
+
+        // Destroy old attached joints.
+        for (SlotHandle jh : m_linkScratch) ReleaseJoint(jh, true);
+        for (SlotHandle jh : m_linkScratch) m_joints.Erase(jh);
+
+        // Recreate in target mode.
+        for (b2BodyId host : hosts)
+        {
+            if (!b2Body_IsValid(host) || !b2Body_IsValid(wheelBody)) continue;
+            if (hasWheelJoint)
+            {
+                b2Vec2 hostPos = b2Body_GetPosition(host);
+                b2Vec2 weldAnchor = b2MulSV(0.5f, b2Add(hostPos, anchor));
+                CreateWeldJoint(host, wheelBody, weldAnchor);
+            }
+            else
+            {
+                CreateWheelJoint(host, wheelBody, anchor);
+            }
+        }
+
+        m_bodies[idx].Set(kFeatureWheel, !hasWheelJoint);
+        ++m_restingVersion;
+    }
+
+    // Rigidify (X): a weld group becomes one body with a shape per member, so
+    // the solver handles one rigid body instead of a chain of weld
+    // constraints. Parts keep their own look and material; compounds in the
+    // group are flattened into the new one. X on a compound splits it back,
+    // and so does a glass break.
+    struct OuterJoint
+    {
+        uint64_t other = 0;
+        b2Transform frame = b2Transform_identity; // in the compound's frame
+        b2Transform otherFrame = b2Transform_identity;
+        bool compoundIsA = false;
+        bool wheel = false;
+    };
+
+    // Part in [first, last) whose origin is nearest localPoint.
+    static uint32_t NearestPart(const std::vector<RigidPart>& parts, size_t first, size_t last, b2Vec2 localPoint)
+    {
+        uint32_t best = static_cast<uint32_t>(first);
+        float bestD2 = b2DistanceSquared(parts[first].local.p, localPoint);
+        for (size_t i = first + 1; i < last; ++i)
+        {
+            float d2 = b2DistanceSquared(parts[i].local.p, localPoint);
+            if (d2 < bestD2)
+            {
+                bestD2 = d2;
+                best = static_cast<uint32_t>(i);
+            }
+        }
+        return best;
+    }
+
+    b2ShapeId CreatePartShape(b2BodyId body, const RigidPart& part, const b2Transform& local)
+    {
+        b2ShapeDef def = BodyShapeDef();
+        def.density = part.density;
+        if (part.kind == BodyKind::Circle)
+        {
+            b2Circle circle{local.p, part.radiusPx * kInvPixelsPerMeter};
+            return b2CreateCircleShape(body, &def, &circle);
+        }
+        const ShapeGeometry& outline = m_shapes[part.shape];
+        b2Vec2 pts[ShapeGeometry::kMaxVerts];
+        for (size_t i = 0; i < outline.size(); ++i) pts[i] = ToMeters(outline[i]);
+        b2Hull hull = b2ComputeHull(pts, static_cast<int>(outline.size()));
+        if (hull.count < 3) return b2_nullShapeId;
+        b2Polygon poly = b2MakeOffsetPolygon(&hull, local.p, local.q);
+        return b2CreatePolygonShape(body, &def, &poly);
+    }
+
+    // Convex hull in px, cut down to ShapeGeometry::kMaxVerts by dropping the
+    // corners that add the least area.
+    static std::vector<Vector2> ReducedHullPx(std::vector<Vector2> pts)
+    {
+        // Monotone chain, counter-clockwise like b2ComputeHull.
+        std::sort(pts.begin(), pts.end(), [](const Vector2& a, const Vector2& b) { return a.x < b.x || (a.x == b.x && a.y < b.y); });
+        auto cross = [](const Vector2& o, const Vector2& a, const Vector2& b) { return (a.x - o.x) * (b.y - o.y) - (a.y - o.y) * (b.x - o.x); };
+        std::vector<Vector2> hull(2 * pts.size());
+        size_t k = 0;
+        for (size_t i = 0; i < pts.size(); ++i)
+        {
+            while (k >= 2 && cross(hull[k - 2], hull[k - 1], pts[i]) <= 0.0f) --k;
+            hull[k++] = pts[i];
+        }
+        for (size_t i = pts.size() - 1, lower = k + 1; i > 0; --i)
+        {
+            while (k >= lower && cross(hull[k - 2], hull[k - 1], pts[i - 1]) <= 0.0f) --k;
+            hull[k++] = pts[i - 1];
+        }
+        hull.resize(k > 0 ? k - 1 : 0);
+        while (hull.size() > static_cast<size_t>(ShapeGeometry::kMaxVerts))
+        {
+            size_t n = hull.size();
+            size_t drop = 0;
+            float least = std::abs(cross(hull[n - 1], hull[0], hull[1]));
+            for (size_t i = 1; i < n; ++i)
+            {
+                float area = std::abs(cross(hull[i - 1], hull[i], hull[(i + 1) % n]));
+                if (area < least)
+                {
+                    least = area;
+                    drop = i;
+                }
+            }
+            hull.erase(hull.begin() + static_cast<std::ptrdiff_t>(drop));
+        }
+        return hull;
+    }
+
+    // Hull of every part (ReducedHullPx). Water, glass thresholds and picking
+    // fallbacks see a compound through it.
+    ShapeTable::Id InternCompoundHull(const std::vector<RigidPart>& parts, float& radiusPx)
+    {
+        std::vector<Vector2> pts;
+        pts.reserve(parts.size() * ShapeGeometry::kMaxVerts);
+        for (const RigidPart& p : parts)
+        {
+            Vector2 c = ToPixels(p.local.p);
+            if (p.kind == BodyKind::Circle)
+            {
+                for (int k = 0; k < 8; ++k)
+                {
+                    float a = static_cast<float>(k) * (PI / 4.0f);
+                    pts.push_back({c.x + std::cos(a) * p.radiusPx, c.y + std::sin(a) * p.radiusPx});
+                }
+                continue;
+            }
+            for (const Vector2& v : m_shapes[p.shape]) pts.push_back(ToPixels(b2TransformPoint(p.local, ToMeters(v))));
+        }
+        radiusPx = 0.0f;
+        for (const Vector2& v : pts) radiusPx = std::max(radiusPx, std::sqrt(v.x * v.x + v.y * v.y));
+        return m_shapes.Intern(ReducedHullPx(std::move(pts)));
+    }
+
+    std::optional<size_t> RigidifyGroup(size_t idx)
+    {
+        if (idx >= m_bodies.size()) return std::nullopt;
+        std::vector<size_t> group = BodiesLinkedTo(idx, true);
+        return RigidifyBodies(group);
+    }
+
+    // Merges members (dense indices, at least two) into one compound placed
+    // at the first member. Joints among them become part joints; the rest are
+    // moved onto the compound. Returns the compound's dense index.
+    std::optional<size_t> RigidifyBodies(const std::vector<size_t>& members)
+    {
+        if (members.size() < 2) return std::nullopt;
+        for (size_t idx : members)
+        {
+            if (idx >= m_bodies.size() || !b2Body_IsValid(m_bodies[idx].bodyId)) return std::nullopt;
+        }
+
+        b2Transform base = b2Body_GetTransform(m_bodies[members[0]].bodyId);
+        std::vector<RigidPart> parts;
+        std::vector<RigidJoint> partJoints;
+        std::vector<std::pair<uint64_t, uint32_t>> memberOf; // (key, member), sorted
+        std::vector<b2Transform> memberLocal;
+        std::vector<size_t> firstPart;
+        uint8_t features = 0;
+        bool awake = false;
+        bool selected = false;
+        float glassStress = 0.0f;
+        int glassGrace = 0;
+        // Momentum about base.p, for the merged body's velocity.
+        float mass = 0.0f;
+        float inertia = 0.0f;
+        float angular = 0.0f;
+        b2Vec2 moment{0.0f, 0.0f};
+        b2Vec2 momentum{0.0f, 0.0f};
+        for (uint32_t m = 0; m < members.size(); ++m)
+        {
+            const BodyEntry& e = m_bodies[members[m]];
+            const BodyCold& cold = Cold(members[m]);
+            b2Transform local = b2InvMulTransforms(base, b2Body_GetTransform(e.bodyId));
+            memberOf.push_back({BodyKey(e.bodyId), m});
+            memberLocal.push_back(local);
+            firstPart.push_back(parts.size());
+            if (e.kind == BodyKind::Compound)
+            {
+                uint32_t offset = static_cast<uint32_t>(parts.size());
+                for (RigidPart p : cold.parts)
+                {
+                    p.local = b2MulTransforms(local, p.local);
+                    parts.push_back(p);
+                }
+                for (RigidJoint j : cold.partJoints)
+                {
+                    j.partA += offset;
+                    j.partB += offset;
+                    partJoints.push_back(j);
+                }
+            }
+            else
+            {
+                RigidPart p;
+                p.local = local;
+                p.shape = e.shape;
+                p.radiusPx = e.radiusPx;
+                p.kind = e.kind;
+                p.features = static_cast<uint8_t>(e.features & ~kFeatureSelected);
+                b2ShapeId shape = b2_nullShapeId;
+                p.density = (b2Body_GetShapes(e.bodyId, &shape, 1) == 1) ? b2Shape_GetDensity(shape) : 1.0f;
+                parts.push_back(p);
+            }
+            features |= e.features;
+            awake = awake || b2Body_IsAwake(e.bodyId);
+            selected = selected || e.Has(kFeatureSelected);
+            glassStress = std::max(glassStress, cold.glassStress);
+            glassGrace = std::max(glassGrace, cold.glassGraceFrames);
+
+            float bodyMass = b2Body_GetMass(e.bodyId);
+            float bodyInertia = b2Body_GetRotationalInertia(e.bodyId);
+            b2Vec2 c = b2Sub(b2Body_GetWorldCenterOfMass(e.bodyId), base.p);
+            b2Vec2 v = b2Body_GetLinearVelocity(e.bodyId);
+            mass += bodyMass;
+            moment = b2MulAdd(moment, bodyMass, c);
+            momentum = b2MulAdd(momentum, bodyMass, v);
+            inertia += bodyInertia + bodyMass * b2LengthSquared(c);
+            angular += bodyInertia * b2Body_GetAngularVelocity(e.bodyId) + bodyMass * b2Cross(c, v);
+        }
+        firstPart.push_back(parts.size());
+        std::sort(memberOf.begin(), memberOf.end());
+        auto memberIndex = [&memberOf](uint64_t key) -> std::optional<uint32_t> {
+            auto it = std::lower_bound(memberOf.begin(), memberOf.end(), std::pair<uint64_t, uint32_t>{key, 0});
+            if (it == memberOf.end() || it->first != key) return std::nullopt;
+            return it->second;
+        };
+        // A joint end on member m, moved onto its nearest part.
+        auto partEnd = [&](uint32_t m, b2Transform frame) {
+            b2Transform f = b2MulTransforms(memberLocal[m], frame);
+            uint32_t p = NearestPart(parts, firstPart[m], firstPart[m + 1], f.p);
+            return std::make_pair(p, b2InvMulTransforms(parts[p].local, f));
+        };
+
+        std::vector<OuterJoint> outer;
+        for (uint32_t m = 0; m < members.size(); ++m)
+        {
+            uint64_t key = BodyKey(m_bodies[members[m]].bodyId);
+            for (SlotHandle jh : Cold(members[m]).joints)
+            {
+                const JointEntry* j = m_joints.Get(jh);
+                if (!j || !b2Joint_IsValid(j->jointId)) continue;
+                bool isA = j->bodyA == key;
+                auto other = memberIndex(isA ? j->bodyB : j->bodyA);
+                b2Transform frame = isA ? b2Joint_GetLocalFrameA(j->jointId) : b2Joint_GetLocalFrameB(j->jointId);
+                b2Transform otherFrame = isA ? b2Joint_GetLocalFrameB(j->jointId) : b2Joint_GetLocalFrameA(j->jointId);
+                if (!other)
+                {
+                    outer.push_back({isA ? j->bodyB : j->bodyA, b2MulTransforms(memberLocal[m], frame), otherFrame, isA, j->isWheelJoint});
+                    continue;
+                }
+                if (!isA) continue; // taken from its A end
+                auto a = partEnd(m, frame);
+                auto b = partEnd(*other, otherFrame);
+                partJoints.push_back({a.first, b.first, a.second, b.second, j->isWheelJoint});
+            }
+        }
+
+        DeleteBodies(members);
+
+        b2BodyDef def = DynamicBodyDef(base.p);
+        def.rotation = base.q;
+        def.isAwake = awake;
+        b2BodyId body = b2CreateBody(m_worldId, &def);
+        b2Body_SetSleepThreshold(body, kBodySleepThreshold);
+        for (RigidPart& p : parts) p.shapeId = CreatePartShape(body, p, p.local);
+        if (awake && mass > 0.0f)
+        {
+            b2Vec2 com = b2MulSV(1.0f / mass, moment);
+            b2Vec2 v = b2MulSV(1.0f / mass, momentum);
+            float centralInertia = inertia - mass * b2LengthSquared(com);
+            float w = centralInertia > 0.0f ? (angular - mass * b2Cross(com, v)) / centralInertia : 0.0f;
+            b2Body_SetLinearVelocity(body, v);
+            b2Body_SetAngularVelocity(body, w);
+        }
+
+        BodyEntry entry;
+        entry.bodyId = body;
+        entry.kind = BodyKind::Compound;
+        entry.features = static_cast<uint8_t>(features & ~kFeatureSelected);
+        entry.shape = InternCompoundHull(parts, entry.radiusPx);
+        size_t idx = InsertBody(std::move(entry));
+        BodyCold& cold = Cold(idx);
+        cold.parts = std::move(parts);
+        cold.partJoints = std::move(partJoints);
+        cold.glassStress = glassStress;
+        cold.glassGraceFrames = glassGrace;
+        ApplyBodySurface(idx);
+        PushSpawnOrder(body);
+        if (selected) SetSelected(idx, true);
+        for (const OuterJoint& j : outer)
+        {
+            b2BodyId other = b2LoadBodyId(j.other);
+            if (!b2Body_IsValid(other)) continue;
+            if (j.compoundIsA) CreateJointWithFrames(body, other, j.frame, j.otherFrame, j.wheel);
+            else CreateJointWithFrames(other, body, j.otherFrame, j.frame, j.wheel);
+        }
+        return idx;
+    }
+
+    // Recreates a compound's parts as bodies, with their part joints, and
+    // moves its other joints to the part nearest each anchor. The parts take
+    // the compound's place at the end of m_bodies; returns how many there are.
+    size_t SplitCompound(size_t idx)
+    {
+        if (idx >= m_bodies.size() || m_bodies[idx].kind != BodyKind::Compound) return 0;
+        const BodyEntry e = m_bodies[idx];
+        if (!b2Body_IsValid(e.bodyId)) return 0;
+        BodyCold& cold = Cold(idx);
+        std::vector<RigidPart> parts = std::move(cold.parts);
+        std::vector<RigidJoint> partJoints = std::move(cold.partJoints);
+        float glassStress = cold.glassStress;
+        int glassGrace = cold.glassGraceFrames;
+        b2Transform xf = b2Body_GetTransform(e.bodyId);
+        b2Vec2 com = b2Body_GetWorldCenterOfMass(e.bodyId);
+        b2Vec2 v = b2Body_GetLinearVelocity(e.bodyId);
+        float w = b2Body_GetAngularVelocity(e.bodyId);
+        bool awake = b2Body_IsAwake(e.bodyId);
+        uint64_t key = BodyKey(e.bodyId);
+
+        std::vector<OuterJoint> outer;
+        for (SlotHandle jh : cold.joints)
+        {
+            const JointEntry* j = m_joints.Get(jh);
+            if (!j || !b2Joint_IsValid(j->jointId)) continue;
+            bool isA = j->bodyA == key;
+            outer.push_back({isA ? j->bodyB : j->bodyA, isA ? b2Joint_GetLocalFrameA(j->jointId) : b2Joint_GetLocalFrameB(j->jointId),
+                             isA ? b2Joint_GetLocalFrameB(j->jointId) : b2Joint_GetLocalFrameA(j->jointId), isA, j->isWheelJoint});
+        }
+        DeleteBodyIndex(idx);
+
+        std::vector<b2BodyId> bodies(parts.size(), b2_nullBodyId);
+        for (size_t i = 0; i < parts.size(); ++i)
+        {
+            const RigidPart& p = parts[i];
+            b2Transform pxf = b2MulTransforms(xf, p.local);
+            b2BodyDef def = DynamicBodyDef(pxf.p);
+            def.rotation = pxf.q;
+            def.isAwake = awake;
+            b2BodyId body = b2CreateBody(m_worldId, &def);
+            b2Body_SetSleepThreshold(body, kBodySleepThreshold);
+            if (B2_IS_NULL(CreatePartShape(body, p, b2Transform_identity)))
+            {
+                b2DestroyBody(body);
+                continue;
+            }
+            if (awake)
+            {
+                b2Body_SetLinearVelocity(body, b2Add(v, b2CrossSV(w, b2Sub(b2Body_GetWorldCenterOfMass(body), com))));
+                b2Body_SetAngularVelocity(body, w);
+            }
+
+            BodyEntry entry;
+            entry.bodyId = body;
+            entry.kind = p.kind;
+            entry.shape = p.shape;
+            entry.radiusPx = p.radiusPx;
+            entry.features = p.features;
+            size_t pi = InsertBody(std::move(entry));
+            if (p.features & kFeatureGlass)
+            {
+                Cold(pi).glassStress = glassStress;
+                Cold(pi).glassGraceFrames = glassGrace;
+            }
+            ApplyBodySurface(pi);
+            PushSpawnOrder(body);
+            if (e.Has(kFeatureSelected)) SetSelected(pi, true);
+            bodies[i] = body;
+        }
+        for (const RigidJoint& j : partJoints)
+        {
+            if (B2_IS_NULL(bodies[j.partA]) || B2_IS_NULL(bodies[j.partB])) continue;
+            CreateJointWithFrames(bodies[j.partA], bodies[j.partB], j.frameA, j.frameB, j.wheel);
+        }
+        for (const OuterJoint& j : outer)
+        {
+            b2BodyId other = b2LoadBodyId(j.other);
+            uint32_t p = NearestPart(parts, 0, parts.size(), j.frame.p);
+            if (!b2Body_IsValid(other) || B2_IS_NULL(bodies[p])) continue;
+            b2Transform frame = b2InvMulTransforms(parts[p].local, j.frame);
+            if (j.compoundIsA) CreateJointWithFrames(bodies[p], other, frame, j.otherFrame, j.wheel);
+            else CreateJointWithFrames(other, bodies[p], j.otherFrame, frame, j.wheel);
+        }
+        return static_cast<size_t>(std::count_if(bodies.begin(), bodies.end(), [](b2BodyId b) { return !B2_IS_NULL(b); }));
+    }
+
+    // X: splits the compounds among the selection (or the body under the
+    // mouse) if there are any, and otherwise rigidifies their weld groups.
+    void ToggleRigidAt(Vector2 mousePx)
+    {
+        std::vector<SlotHandle> targets;
+        for (size_t idx : SelectedIndices()) targets.push_back(m_bodies.HandleAt(idx));
+        if (targets.empty())
+        {
+            if (auto picked = PickBody(mousePx)) targets.push_back(m_bodies.HandleAt(*picked));
+        }
+        bool split = std::any_of(targets.begin(), targets.end(), [this](SlotHandle h) {
+            auto idx = m_bodies.DenseIndex(h);
+            return idx && m_bodies[*idx].kind == BodyKind::Compound;
+        });
+        for (SlotHandle h : targets)
+        {
+            auto idx = m_bodies.DenseIndex(h);
+            if (!idx) continue; // already merged into an earlier target's compound
+            if (split) SplitCompound(*idx);
+            else RigidifyGroup(*idx);
+        }
+    }
+
+    // The bodies at indices as a clip around the centre of their bounds,
+    // returned in originPx. Joints are kept when both ends are copied.
+    BodyClip CopyBodies(const size_t* indices, size_t count, Vector2& originPx)
+    {
+        BodyClip clip;
+        b2AABB bounds{{FLT_MAX, FLT_MAX}, {-FLT_MAX, -FLT_MAX}};
+        std::vector<std::pair<uint64_t, uint32_t>> clipOf; // (key, clip body), sorted
+        for (size_t i = 0; i < count; ++i)
+        {
+            if (indices[i] >= m_bodies.size() || !b2Body_IsValid(m_bodies[indices[i]].bodyId)) continue;
+            b2AABB box = b2Body_ComputeAABB(m_bodies[indices[i]].bodyId);
+            bounds.lowerBound = b2Min(bounds.lowerBound, box.lowerBound);
+            bounds.upperBound = b2Max(bounds.upperBound, box.upperBound);
+            clipOf.push_back({BodyKey(m_bodies[indices[i]].bodyId), 0});
+        }
+        if (clipOf.empty()) return clip;
+        b2Vec2 origin = b2AABB_Center(bounds);
+        originPx = ToPixels(origin);
+        clip.halfExtentPx = {b2AABB_Extents(bounds).x * kPixelsPerMeter, b2AABB_Extents(bounds).y * kPixelsPerMeter};
+
+        clipOf.clear();
+        for (size_t i = 0; i < count; ++i)
+        {
+            if (indices[i] >= m_bodies.size() || !b2Body_IsValid(m_bodies[indices[i]].bodyId)) continue;
+            const BodyEntry& e = m_bodies[indices[i]];
+            b2Transform xf = b2Body_GetTransform(e.bodyId);
+            ClipBody b;
+            b.xf = {b2Sub(xf.p, origin), xf.q};
+            b.kind = e.kind;
+            b.features = static_cast<uint8_t>(e.features & ~kFeatureSelected);
+            b.shape = e.shape;
+            b.radiusPx = e.radiusPx;
+            if (e.kind == BodyKind::Compound)
+            {
+                b.parts = Cold(indices[i]).parts;
+                for (RigidPart& p : b.parts) p.shapeId = b2_nullShapeId;
+                b.partJoints = Cold(indices[i]).partJoints;
+            }
+            else
+            {
+                b2ShapeId shape = b2_nullShapeId;
+                if (b2Body_GetShapes(e.bodyId, &shape, 1) != 1) continue;
+                b.density = b2Shape_GetDensity(shape);
+                if (b2Shape_GetType(shape) == b2_circleShape) b.circle = b2Shape_GetCircle(shape);
+                else b.polygon = b2Shape_GetPolygon(shape);
+            }
+            clipOf.push_back({BodyKey(e.bodyId), static_cast<uint32_t>(clip.bodies.size())});
+            clip.bodies.push_back(std::move(b));
+        }
+        std::sort(clipOf.begin(), clipOf.end());
+        auto clipIndex = [&clipOf](uint64_t key) -> std::optional<uint32_t> {
+            auto it = std::lower_bound(clipOf.begin(), clipOf.end(), std::pair<uint64_t, uint32_t>{key, 0});
+            if (it == clipOf.end() || it->first != key) return std::nullopt;
+            return it->second;
+        };
+        for (const auto& [key, a] : clipOf)
+        {
+            auto idx = BodyIndexByKey(key);
+            if (!idx) continue;
+            for (SlotHandle jh : Cold(*idx).joints)
+            {
+                const JointEntry* j = m_joints.Get(jh);
+                if (!j || j->bodyA != key || !b2Joint_IsValid(j->jointId)) continue; // taken from its A end
+                auto b = clipIndex(j->bodyB);
+                if (!b) continue;
+                clip.joints.push_back({a, *b, b2Joint_GetLocalFrameA(j->jointId), b2Joint_GetLocalFrameB(j->jointId), j->isWheelJoint});
+            }
+        }
+        return clip;
+    }
+
+    // Creates the whole clip at each origin, joints included, growing storage
+    // once. Copies start at rest. Returns the number of bodies made; they are
+    // the last entries in dense order.
+    size_t PasteClip(const BodyClip& clip, const Vector2* originsPx, size_t count)
+    {
+        if (clip.bodies.empty() || count == 0) return 0;
+        size_t before = m_bodies.size();
+        m_bodies.Reserve(before + count * clip.bodies.size());
+        m_joints.Reserve(m_joints.size() + count * clip.joints.size());
+
+        std::vector<b2BodyId> made(clip.bodies.size());
+        b2BodyDef bodyDef = DynamicBodyDef({0.0f, 0.0f});
+        bodyDef.sleepThreshold = kBodySleepThreshold;
+        for (size_t c = 0; c < count; ++c)
+        {
+            b2Vec2 origin = ToMeters(originsPx[c]);
+            for (size_t i = 0; i < clip.bodies.size(); ++i)
+            {
+                const ClipBody& src = clip.bodies[i];
+                bodyDef.position = b2Add(origin, src.xf.p);
+                bodyDef.rotation = src.xf.q;
+                b2BodyId body = b2CreateBody(m_worldId, &bodyDef);
+                std::vector<RigidPart> parts;
+                if (src.kind == BodyKind::Compound)
+                {
+                    parts = src.parts;
+                    for (RigidPart& p : parts) p.shapeId = CreatePartShape(body, p, p.local);
+                }
+                else
+                {
+                    b2ShapeDef shapeDef = BodyShapeDef();
+                    shapeDef.density = src.density;
+                    if (src.kind == BodyKind::Circle) b2CreateCircleShape(body, &shapeDef, &src.circle);
+                    else b2CreatePolygonShape(body, &shapeDef, &src.polygon);
+                }
+
+                BodyEntry entry;
+                entry.bodyId = body;
+                entry.kind = src.kind;
+                entry.features = src.features;
+                entry.shape = src.shape;
+                entry.radiusPx = src.radiusPx;
+                size_t idx = InsertBody(std::move(entry));
+                if (src.kind == BodyKind::Compound)
+                {
+                    Cold(idx).parts = std::move(parts);
+                    Cold(idx).partJoints = src.partJoints;
+                }
+                ApplyBodySurface(idx);
+                PushSpawnOrder(body);
+                made[i] = body;
+            }
+            for (const ClipJoint& j : clip.joints) CreateJointWithFrames(made[j.bodyA], made[j.bodyB], j.frameA, j.frameB, j.wheel);
+        }
+        return m_bodies.size() - before;
+    }
+
+    // Origins for a cols x rows array of clip above anchorPx and to its right
+    // (left when it would not fit), one bounds size apart. Copies that would
+    // leave the world's width are dropped; skipAnchor leaves the first cell to
+    // the original.
+    void ClipArray(const BodyClip& clip, Vector2 anchorPx, int cols, int rows, bool skipAnchor, std::vector<Vector2>& out) const
+    {
+        float stepX = clip.halfExtentPx.x * 2.0f + kBatchGapPx;
+        float stepY = clip.halfExtentPx.y * 2.0f + kBatchGapPx;
+        if (anchorPx.x + static_cast<float>(std::max(cols, 1) - 1) * stepX + clip.halfExtentPx.x > m_worldWidth) stepX = -stepX;
+        out.clear();
+        for (int r = 0; r < std::max(rows, 1); ++r)
+        {
+            for (int c = 0; c < std::max(cols, 1); ++c)
+            {
+                if (skipAnchor && r == 0 && c == 0) continue;
+                Vector2 p{anchorPx.x + static_cast<float>(c) * stepX, anchorPx.y - static_cast<float>(r) * stepY};
+                if (p.x - clip.halfExtentPx.x < 0.0f || p.x + clip.halfExtentPx.x > m_worldWidth) continue;
+                out.push_back(p);
+            }
+        }
+    }
+
+    // cols x rows including the originals, which stay in the first cell.
+    size_t DuplicateBodies(const size_t* indices, size_t count, int cols, int rows)
+    {
+        Vector2 origin{0.0f, 0.0f};
+        BodyClip clip = CopyBodies(indices, count, origin);
+        ClipArray(clip, origin, cols, rows, true, m_batchScratch);
+        return PasteClip(clip, m_batchScratch.data(), m_batchScratch.size());
+    }
+
+    // The last count bodies become the selection, so a paste can be dragged
+    // or duplicated again straight away.
+    void SelectLast(size_t count)
+    {
+        if (count == 0) return;
+        ClearSelection();
+        for (size_t i = m_bodies.size() - count; i < m_bodies.size(); ++i) SetSelected(i, true);
+    }
+
+    void CopySelection()
+    {
+        auto selected = SelectedIndices();
+        if (selected.empty()) return;
+        Vector2 origin{0.0f, 0.0f};
+        m_clipboard = CopyBodies(selected.data(), selected.size(), origin);
+    }
+
+    void PasteAt(Vector2 mousePx, bool array)
+    {
+        if (m_clipboard.bodies.empty()) return;
+        Vector2 anchor = ClampSpawnAboveGround(mousePx, m_clipboard.halfExtentPx.x, m_clipboard.halfExtentPx.y);
+        ClipArray(m_clipboard, anchor, array ? kArrayCopyCols : 1, array ? kArrayCopyRows : 1, false, m_batchScratch);
+        SelectLast(PasteClip(m_clipboard, m_batchScratch.data(), m_batchScratch.size()));
+    }
+
+    void DuplicateSelection(bool array)
+    {
+        auto selected = SelectedIndices();
+        if (selected.empty()) return;
+        int cols = array ? kArrayCopyCols : 2;
+        int rows = array ? kArrayCopyRows : 1;
+        SelectLast(DuplicateBodies(selected.data(), selected.size(), cols, rows));
+    }
+
+    void HandleWeldPick(size_t idx)
+    {
+        if (idx >= m_bodies.size()) return;
+        auto pending = m_bodies.DenseIndex(m_pendingWeldBody);
+        if (!pending)
+        {
+            m_pendingWeldBody = m_bodies.HandleAt(idx);
+            return;
+        }
+
+        if (*pending == idx)
+        {
+            m_pendingWeldBody = SlotHandle{};
+            return;
+        }
+
+        if (!b2Body_IsValid(m_bodies[*pending].bodyId) || !b2Body_IsValid(m_bodies[idx].bodyId))
+        {
+            m_pendingWeldBody = SlotHandle{};
+            return;
+        }
+
+        b2Vec2 a = b2Body_GetPosition(m_bodies[*pending].bodyId);
+        b2Vec2 b = b2Body_GetPosition(m_bodies[idx].bodyId);
+        b2Vec2 anchor = b2MulSV(0.5f, b2Add(a, b));
+
+        CreateWeldJoint(m_bodies[*pending].bodyId, m_bodies[idx].bodyId, anchor);
+        m_pendingWeldBody = SlotHandle{};
+    }
+
+    static uint8_t FeatureForTool(Tool tool)
+    {
+        switch (tool)
+        {
+            case Tool::Bounce: return kFeatureBouncy;
+            case Tool::Slip: return kFeatureSlippery;
+            case Tool::Sticky: return kFeatureSticky;
+            case Tool::Glass: return kFeatureGlass;
+            default: return 0;
+        }
+    }
+
+    void ToggleFeature(size_t idx, Tool tool)
+    {
+        if (idx >= m_bodies.size()) return;
+        SetFeature(&idx, 1, tool, !m_bodies[idx].Has(FeatureForTool(tool)));
+    }
+
+    // Turns tool's feature on or off for every body in indices, skipping the
+    // ones already there. Surfaces come from the material table, one store
+    // per shape.
+    void SetFeature(const size_t* indices, size_t count, Tool tool, bool on)
+    {
+        uint8_t bit = FeatureForTool(tool);
+        if (bit == 0) return;
+        for (size_t i = 0; i < count; ++i)
+        {
+            size_t idx = indices[i];
+            if (idx >= m_bodies.size() || m_bodies[idx].Has(bit) == on) continue;
+            BodyEntry& e = m_bodies[idx];
+            if (bit == kFeatureGlass)
+            {
+                Cold(idx).glassStress = 0.0f;
+                Cold(idx).glassGraceFrames = on ? 60 : 0;
+            }
+            e.Set(bit, on);
+            // A compound shows a feature when any part has it; toggling sets all of them.
+            for (RigidPart& p : Cold(idx).parts) p.features = static_cast<uint8_t>(on ? (p.features | bit) : (p.features & ~bit));
+            ApplyBodySurface(idx);
+        }
+    }
+
+    // Clicking a selected body applies the tool to the whole selection,
+    // following the clicked body's new state.
+    void ToggleFeatureAt(size_t picked, Tool tool)
+    {
+        if (!m_bodies[picked].Has(kFeatureSelected))
+        {
+            ToggleFeature(picked, tool);
+            return;
+        }
+        bool on = !m_bodies[picked].Has(FeatureForTool(tool));
+        auto selected = SelectedIndices();
+        SetFeature(selected.data(), selected.size(), tool, on);
+    }
+
+    float ApproxRadiusPx(const BodyEntry& e) const
+    {
+        if (e.kind == BodyKind::Circle) return std::max(8.0f, e.radiusPx);
+        float r = 0.0f;
+        for (const Vector2& p : m_shapes[e.shape])
+        {
+            r = std::max(r, std::sqrt(p.x * p.x + p.y * p.y));
+        }
+        return std::max(r, kBaseHalfPx);
+    }
+
+    float BodyAreaPx2(const BodyEntry& e) const
+    {
+        if (e.kind == BodyKind::Circle)
+        {
+            return static_cast<float>(PI) * e.radiusPx * e.radiusPx;
+        }
+        const ShapeGeometry& outline = m_shapes[e.shape];
+        if (outline.size() < 3)
+        {
+            float r = ApproxRadiusPx(e);
+            return r * r;
+        }
+        float area = 0.0f;
+        for (size_t i = 0; i < outline.size(); ++i)
+        {
+            const Vector2& a = outline[i];
+            const Vector2& b = outline[(i + 1) % outline.size()];
+            area += a.x * b.y - b.x * a.y;
+        }
+        return std::max(1.0f, std::abs(area) * 0.5f);
+    }
+
+    // Shards are only worth drawing while the break is still on screen.
+    void SpawnGlassShards(const BodyEntry& e)
+    {
+        if (!b2Body_IsValid(e.bodyId)) return;
+
+        b2Vec2 vM = b2Body_GetLinearVelocity(e.bodyId);
+        DeferredJob job;
+        job.type = DeferredJobType::GlassShards;
+        job.at = ToPixels(b2Body_GetPosition(e.bodyId));
+        job.velocity = {vM.x * kPixelsPerMeter, vM.y * kPixelsPerMeter};
+        job.amount = BodyAreaPx2(e);
+        job.seed = m_rng.Next();
+        m_deferred.Push(job, DeferredPriority::Normal, 3, true);
+    }
+
+    void EmitGlassShards(const DeferredJob& job)
+    {
+        SimRandom rng(job.seed);
+        Vector2 c = job.at;
+        Vector2 inherit = job.velocity;
+        float area = job.amount;
+        int count = std::clamp(static_cast<int>(area / 800.0f), 14, 90);
+        float spread = std::clamp(std::sqrt(area) * 0.09f, 6.0f, 26.0f);
+
+        for (int i = 0; i < count; ++i)
+        {
+            float a = static_cast<float>(rng.Range(0, 359)) * DEG2RAD;
+            float speed = spread * (0.75f + static_cast<float>(rng.Range(0, 100)) / 100.0f * 0.6f);
+            float rr = std::max(1.0f, std::sqrt(area) * 0.02f);
+
+            float radius = rr * (0.6f + static_cast<float>(rng.Range(0, 100)) / 100.0f);
+            float life = 0.45f + static_cast<float>(rng.Range(0, 100)) / 100.0f * 0.35f;
+            m_shards.Emit(c.x, c.y, std::cos(a) * speed + inherit.x * 0.45f, std::sin(a) * speed + inherit.y * 0.45f, radius, life);
+        }
+    }
+
+    // Ended touches and overloaded welds let go first; a touch that began
+    // and ended within the step is then dropped by the pool.
+    void UpdateAdhesion()
+    {
+        SLOP_ZONE("UpdateAdhesion");
+        b2ContactEvents events = b2World_GetContactEvents(m_worldId);
+        for (int i = 0; i < events.endCount; ++i) m_adhesion.Separate(events.endEvents[i].shapeIdA, events.endEvents[i].shapeIdB);
+        b2JointEvents joints = b2World_GetJointEvents(m_worldId);
+        for (int i = 0; i < joints.count; ++i) m_adhesion.Overloaded(joints.jointEvents[i]);
+
+        // Only scene bodies stick, and only when one of them is sticky; the
+        // ground and debris never are.
+        for (int i = 0; i < events.beginCount; ++i)
+        {
+            const b2ContactBeginTouchEvent& begin = events.beginEvents[i];
+            auto a = BodyIndexById(b2Shape_GetBody(begin.shapeIdA));
+            auto b = BodyIndexById(b2Shape_GetBody(begin.shapeIdB));
+            if (!a || !b || !(m_bodies[*a].Has(kFeatureSticky) || m_bodies[*b].Has(kFeatureSticky))) continue;
+            m_adhesion.Queue(begin.shapeIdA, begin.shapeIdB, begin.contactId);
+        }
+        m_adhesion.Update(m_worldId, kAdhesionsPerStep);
+    }
+
+    // Voronoi-splits the pane into 3-7 convex pieces for m_debris. Pieces keep
+    // the pane's velocity at their centroid plus an outward kick.
+    void QueueGlassFragments(const BodyEntry& e)
+    {
+        if (!b2Body_IsValid(e.bodyId)) return;
+
+        b2Vec2 outline[fracture::kMaxCellVerts];
+        int n = 0;
+        if (e.kind == BodyKind::Circle)
+        {
+            float r = e.radiusPx * kInvPixelsPerMeter;
+            for (; n < fracture::kMaxCellVerts; ++n)
+            {
+                float a = 2.0f * PI * static_cast<float>(n) / static_cast<float>(fracture::kMaxCellVerts);
+                outline[n] = {std::cos(a) * r, std::sin(a) * r};
+            }
+        }
+        else
+        {
+            const ShapeGeometry& geom = m_shapes[e.shape];
+            if (geom.size() < 3 || geom.size() > static_cast<size_t>(fracture::kMaxCellVerts)) return;
+            for (const Vector2& v : geom) outline[n++] = {v.x * kInvPixelsPerMeter, v.y * kInvPixelsPerMeter};
+        }
+
+        float areaM2 = fracture::PolygonArea(outline, n);
+        int seedCount = std::clamp(static_cast<int>(areaM2 * 4.0f), 3, fracture::kMaxSeeds - 1);
+        b2Vec2 seeds[fracture::kMaxSeeds];
+        for (int i = 0; i < seedCount; ++i)
+        {
+            int tri = m_rng.Range(0, n - 3);
+            float s = static_cast<float>(m_rng.Range(0, 1000)) / 1000.0f;
+            float t = static_cast<float>(m_rng.Range(0, 1000)) / 1000.0f;
+            seeds[i] = fracture::PointInFan(outline, n, tri, s, t);
+        }
+
+        b2Transform xf = b2Body_GetTransform(e.bodyId);
+        b2Vec2 v = b2Body_GetLinearVelocity(e.bodyId);
+        float w = b2Body_GetAngularVelocity(e.bodyId);
+        Color fill = MixedFeatureColor(e);
+        fill.a = static_cast<unsigned char>(std::min(255, fill.a * 2));
+
+        for (int i = 0; i < seedCount; ++i)
+        {
+            b2Vec2 cell[fracture::kMaxCellVerts];
+            int count = fracture::VoronoiCell(outline, n, seeds, seedCount, i, cell);
+            if (count < 3 || fracture::PolygonArea(cell, count) < kMinFragmentAreaM2) continue;
+
+            b2Vec2 c = fracture::PolygonCentroid(cell, count);
+            for (int k = 0; k < count; ++k) cell[k] = b2Sub(cell[k], c);
+            b2Hull hull = b2ComputeHull(cell, count);
+            if (hull.count < 3) continue;
+
+            b2Vec2 r = b2RotateVector(xf.q, c);
+            b2Vec2 dir = b2LengthSquared(r) > 1e-6f ? b2Normalize(r) : b2Vec2{0.0f, -1.0f};
+            float kick = 0.8f + static_cast<float>(m_rng.Range(0, 100)) / 100.0f * 1.2f;
+
+            DebrisSpawn spawn;
+            spawn.polygon = b2MakePolygon(&hull, 0.0f);
+            spawn.position = b2Add(xf.p, r);
+            spawn.rotation = xf.q;
+            spawn.linearVelocity = b2MulAdd(b2Add(v, b2CrossSV(w, r)), kick, dir);
+            spawn.angularVelocity = w + static_cast<float>(m_rng.Range(-30, 30)) / 10.0f;
+            spawn.life = 2.5f + static_cast<float>(m_rng.Range(0, 100)) / 100.0f;
+            spawn.fill = fill;
+            if (!m_debris.Queue(spawn)) break;
+        }
+    }
+
+    float GlassBreakThreshold(const BodyEntry& e) const
+    {
+        float areaM2 = BodyAreaPx2(e) * kInvPixelsPerMeter * kInvPixelsPerMeter;
+        float mass = b2Body_IsValid(e.bodyId) ? b2Body_GetMass(e.bodyId) : 1.0f;
+        float scale = std::max(0.08f, std::sqrt(areaM2));
+        return (28.0f + scale * 22.0f + mass * 8.0f) * m_tuning.glassBreakScale;
+    }
+
+    void UpdateGlass(float dt)
+    {
+        SLOP_ZONE("UpdateGlass");
+        m_stepGlassBreaks = 0;
+        // Moving glass was put on m_activeGlass by ConsumeBodyMoves.
+        if (!m_glassSet.Any()) return;
+
+        // Strong impacts. Hit events are only enabled on glass shapes.
+        b2ContactEvents events = b2World_GetContactEvents(m_worldId);
+        for (int i = 0; i < events.hitCount; ++i)
+        {
+            const b2ContactHitEvent& hit = events.hitEvents[i];
+            for (b2ShapeId shape : {hit.shapeIdA, hit.shapeIdB})
+            {
+                b2BodyId body = b2Shape_GetBody(shape);
+                auto idx = BodyIndexById(body);
+                if (!idx || !m_bodies[*idx].Has(kFeatureGlass) || Cold(*idx).glassGraceFrames > 0) continue;
+                Cold(*idx).glassStress += hit.approachSpeed * b2Body_GetMass(body) * 0.9f;
+                ActivateGlass(*idx);
+            }
+        }
+
+        // Decay, contact load and break checks for active glass only. Glass drops
+        // out once it is asleep with no stress left, so a settled pane costs nothing.
+        std::vector<size_t>& toBreak = m_glassBreakScratch;
+        toBreak.clear();
+        size_t keep = 0;
+        for (SlotHandle h : m_activeGlass)
+        {
+            auto idx = m_bodies.DenseIndex(h);
+            if (!idx) continue;
+            const BodyEntry& e = m_bodies[*idx];
+            BodyCold& cold = Cold(*idx);
+            if (!e.Has(kFeatureGlass) || !b2Body_IsValid(e.bodyId))
+            {
+                cold.glassActive = false;
+                continue;
+            }
+
+            cold.glassStress = std::max(0.0f, cold.glassStress - dt * 10.0f);
+            if (cold.glassGraceFrames > 0) --cold.glassGraceFrames;
+            bool awake = b2Body_IsAwake(e.bodyId);
+            if (awake && cold.glassGraceFrames <= 0) AccumulateGlassContacts(e, cold, dt);
+            if (cold.glassStress > GlassBreakThreshold(e)) toBreak.push_back(*idx);
+
+            if (awake || cold.glassStress > 0.0f || cold.glassGraceFrames > 0) m_activeGlass[keep++] = h;
+            else cold.glassActive = false;
+        }
+        m_activeGlass.resize(keep);
+
+        if (!toBreak.empty())
+        {
+            std::sort(toBreak.begin(), toBreak.end());
+            toBreak.erase(std::unique(toBreak.begin(), toBreak.end()), toBreak.end());
+            SplitBrokenCompounds(toBreak);
+            m_stepGlassBreaks = static_cast<uint32_t>(toBreak.size());
+            m_glassBreakCount += toBreak.size();
+            for (size_t idx : toBreak)
+            {
+                if (idx >= m_bodies.size()) continue;
+                SpawnGlassShards(m_bodies[idx]);
+                QueueGlassFragments(m_bodies[idx]);
+            }
+            DeleteBodies(toBreak);
+        }
+    }
+
+    // A compound breaks by splitting; its glass parts then break with the
+    // other panes in toBreak, which is left in dense order.
+    void SplitBrokenCompounds(std::vector<size_t>& toBreak)
+    {
+        auto isCompound = [this](size_t idx) { return m_bodies[idx].kind == BodyKind::Compound; };
+        if (std::none_of(toBreak.begin(), toBreak.end(), isCompound)) return;
+        std::vector<SlotHandle> handles;
+        for (size_t idx : toBreak) handles.push_back(m_bodies.HandleAt(idx));
+        std::vector<SlotHandle> panes;
+        for (SlotHandle h : handles)
+        {
+            auto idx = m_bodies.DenseIndex(h);
+            if (!idx) continue;
+            if (!isCompound(*idx))
+            {
+                panes.push_back(h);
+                continue;
+            }
+            size_t first = m_bodies.size() - 1;
+            size_t made = SplitCompound(*idx);
+            for (size_t i = first; i < first + made; ++i)
+            {
+                if (m_bodies[i].Has(kFeatureGlass)) panes.push_back(m_bodies.HandleAt(i));
+            }
+        }
+        toBreak.clear();
+        for (SlotHandle h : panes)
+        {
+            if (auto idx = m_bodies.DenseIndex(h)) toBreak.push_back(*idx);
+        }
+        std::sort(toBreak.begin(), toBreak.end());
+    }
+
+    // Impulse and resting load from the touching contacts of one awake glass body.
+    void AccumulateGlassContacts(const BodyEntry& e, BodyCold& cold, float dt)
+    {
+        int cap = b2Body_GetContactCapacity(e.bodyId);
+        if (cap <= 0) return;
+        if (static_cast<int>(m_contactScratch.size()) < cap) m_contactScratch.resize(static_cast<size_t>(cap));
+        int count = b2Body_GetContactData(e.bodyId, m_contactScratch.data(), cap);
+
+        float impulse = 0.0f;
+        float load = 0.0f;
+        for (int c = 0; c < count; ++c)
+        {
+            const b2ContactData& cd = m_contactScratch[c];
+            const b2Manifold& m = cd.manifold;
+            float contactImpulse = 0.0f;
+            for (int p = 0; p < m.pointCount; ++p)
+            {
+                contactImpulse += std::max(0.0f, m.points[p].totalNormalImpulse);
+            }
+            impulse += contactImpulse;
+            // Only contacts actually pressing on the pane can carry load.
+            if (contactImpulse < kGlassLoadImpulse) continue;
+
+            // The normal points from A to B and +y is down, so this is > 0 when
+            // the other body sits on top of the glass.
+            bool glassIsA = B2_ID_EQUALS(b2Shape_GetBody(cd.shapeIdA), e.bodyId);
+            float above = glassIsA ? -m.normal.y : m.normal.y;
+            if (above < 0.5f) continue;
+            b2BodyId other = b2Shape_GetBody(glassIsA ? cd.shapeIdB : cd.shapeIdA);
+            load += std::max(0.0f, b2Body_GetMass(other));
+        }
+
+        float impulseStress = std::max(0.0f, impulse - 0.85f) * 0.75f;
+        cold.glassStress += impulseStress * dt * 60.0f;
+        if (load > 0.0f)
+        {
+            cold.glassStress += std::max(0.0f, load - b2Body_GetMass(e.bodyId) * 2.2f) * dt * 4.0f;
+        }
+    }
+
+    void UpdateShards(float dt)
+    {
+        SLOP_ZONE("UpdateShards");
+        if (m_gpuEffects)
+        {
+            // Emitted particles wait in the pool for PublishSnapshot.
+            m_gpuSpawns.AddElapsed(dt);
+            return;
+        }
+        m_shards.Integrate(dt, 1700.0f, 0.94f, 0.96f);
+        const float ground = ActiveGroundTopYPx();
+        m_shards.Collide(0.3f, 0.7f, [&](float& x, float& y, float r, float, float vy, float& nx, float& ny) {
+            if (InWater() && vy > kShardSkimSpeedPx && CrossedWaterSurface(x, y, r, vy, dt))
+            {
+                nx = 0.0f;
+                ny = -1.0f;
+                return ParticleContact::Bounce;
+            }
+            return ParticleWorldContact(x, y, r, ground, nx, ny);
+        });
+        m_shards.Cull();
+    }
+
+    // Rebinds the bodies the CPU particles collide with, when there are any
+    // particles to collide. Awake bodies come from the last step's move
+    // events; resting ones only change when the resting set does.
+    void BuildParticleGrids()
+    {
+        SLOP_ZONE("BuildParticleGrids");
+        if (m_gpuEffects || (m_shards.empty() && m_waterChunks.empty())) return;
+        if (m_restingGridVersion != m_restingVersion || m_restingGridEdits != m_sceneEdits)
+        {
+            m_restingGridVersion = m_restingVersion;
+            m_restingGridEdits = m_sceneEdits;
+            m_restingGrid.Clear();
+            m_restingSet.ForEach([&](uint32_t slot) { AddParticleGridBody(m_restingGrid, slot); });
+            m_restingGrid.Build(kParticleGridMarginPx);
+        }
+        m_awakeGrid.Clear();
+        for (uint32_t slot : m_movedSlots) AddParticleGridBody(m_awakeGrid, slot);
+        m_awakeGrid.Build(kParticleGridMarginPx);
+    }
+
+    // Concave outlines collide as their convex hull would, near enough for
+    // cosmetic particles.
+    void AddParticleGridBody(ParticleGrid& grid, uint32_t slot) const
+    {
+        std::optional<size_t> idx = m_bodies.DenseIndexOfSlot(slot);
+        if (!idx) return;
+        const BodyEntry& e = m_bodies[*idx];
+        const BodyCold& cold = m_bodyCold[slot];
+        if (e.kind == BodyKind::Circle)
+        {
+            Vector2 c = ToPixels(cold.xf.p);
+            grid.AddCircle(c.x, c.y, e.radiusPx);
+            return;
+        }
+        water::Hull hull;
+        BuildWaterHull(e, cold, hull);
+        grid.AddPolygon(&hull.verts[0].x, hull.count);
+    }
+
+    // Pushes a particle out of the deepest body or the ground it overlaps.
+    ParticleContact ParticleWorldContact(float& x, float& y, float r, float ground, float& nx, float& ny) const
+    {
+        ParticleContact contact = ParticleContact::None;
+        if (m_restingGrid.Resolve(x, y, r, nx, ny)) contact = ParticleContact::Bounce;
+        if (m_awakeGrid.Resolve(x, y, r, nx, ny)) contact = ParticleContact::Bounce;
+        if (y + r > ground)
+        {
+            y = ground - r;
+            nx = 0.0f;
+            ny = -1.0f;
+            contact = ParticleContact::Bounce;
+        }
+        return contact;
+    }
+
+    // True when a shard moving down at vy went under the surface this frame;
+    // puts it back on top.
+    bool CrossedWaterSurface(float x, float& y, float r, float vy, float dt) const
+    {
+        float surface = WaterHeightAt(x);
+        if (y + r < surface || y + r - vy * dt > surface) return false;
+        y = surface - r;
+        return true;
+    }
+
+    void UpdateWave(float dt)
+    {
+        SLOP_ZONE("UpdateWave");
+        if (!InWater() || m_waveDisp.size() < 3)
+        {
+            if (b2Body_IsValid(m_waterSensorBody) && b2Body_IsEnabled(m_waterSensorBody)) b2Body_Disable(m_waterSensorBody);
+            m_waterFreshSlots.clear();
+            return;
+        }
+
+        const size_t n = m_waveDisp.size();
+        const bool shallow = m_sceneLocation == SceneLocation::Shallow;
+        const float gravityPx = b2World_GetGravity(m_worldId).y * kPixelsPerMeter;
+        if (shallow)
+        {
+            // Pokes become outward flow; bodies act through last step's occupancy.
+            m_shallow.ApplyImpulse(m_waveImpulse.data(), kShallowPokeGain);
+            std::fill(m_waveImpulse.begin(), m_waveImpulse.end(), 0.0f);
+            m_shallow.Step(dt, gravityPx, kShallowDamping, m_scheduler.get());
+
+            float floorY = m_waveBaselineY + m_shallow.RestDepth();
+            for (size_t i = 0; i < n; ++i) m_waveDisp[i] = floorY - m_shallow.SurfaceAt(i) - m_waveBaselineY;
+        }
+        else
+        {
+            const float spring = 27.0f;
+            const float damping = 0.038f;
+            const float spread = 0.28f;
+
+            wave::Integrate(m_waveDisp.data(), m_waveVel.data(), n, spring, damping, dt);
+
+            // Each pass reads the previous displacement only (Jacobi), which matches
+            // the old left/right neighbour exchange exactly and vectorizes.
+            for (int pass = 0; pass < 6; ++pass)
+            {
+                wave::SpreadDelta(m_waveDisp.data(), m_waveDelta.data(), n, spread);
+                wave::ApplyDelta(m_waveDisp.data(), m_waveVel.data(), m_waveDelta.data(), n);
+            }
+        }
+
+        // Body interaction with water: the sensor's overlaps from the last
+        // step, plus bodies created since. Resting bodies only matter to the
+        // pool, which they still displace, so they are sampled for their
+        // solid only.
+        float crestY = m_waveBaselineY + *std::min_element(m_waveDisp.begin(), m_waveDisp.end());
+        FitWaterSensor(crestY);
+        ConsumeWaterSensorEvents();
+        m_waterOverlaps.resize(static_cast<size_t>(b2Shape_GetSensorCapacity(m_waterSensorShape)));
+        int overlapCount = b2Shape_GetSensorData(m_waterSensorShape, m_waterOverlaps.data(), static_cast<int>(m_waterOverlaps.size()));
+        m_waterCandidates.clear();
+        for (int i = 0; i < overlapCount; ++i)
+        {
+            if (!b2Shape_IsValid(m_waterOverlaps[i])) continue;
+            auto idx = BodyIndexById(b2Shape_GetBody(m_waterOverlaps[i]));
+            if (!idx) continue;
+            if (!shallow && m_restingSet.Test(m_bodies.SlotIndexAt(*idx))) continue;
+            m_waterCandidates.push_back(*idx);
+        }
+        for (uint32_t slot : m_waterFreshSlots)
+        {
+            auto idx = m_bodies.DenseIndexOfSlot(slot);
+            if (idx && (shallow || !m_restingSet.Test(slot))) m_waterCandidates.push_back(*idx);
+        }
+        m_waterFreshSlots.clear();
+        std::sort(m_waterCandidates.begin(), m_waterCandidates.end());
+        m_waterCandidates.erase(std::unique(m_waterCandidates.begin(), m_waterCandidates.end()), m_waterCandidates.end());
+
+        // Sampling only reads the surface and body transforms, so it runs on
+        // the pool; everything that writes stays serial in candidate order.
+        m_waterSamples.resize(m_waterCandidates.size());
+        m_waterSurface = WaterSurface();
+        m_scheduler->ParallelFor(static_cast<int>(m_waterCandidates.size()), 32, &SampleWaterTask, this);
+
+        const float disturbGain = 0.22f;
+        if (shallow) m_shallow.ClearSolids();
+        for (size_t k = 0; k < m_waterCandidates.size(); ++k)
+        {
+            const BodyEntry& e = m_bodies[m_waterCandidates[k]];
+            BodyCold& cold = Cold(m_waterCandidates[k]);
+            const water::BodySample& sample = m_waterSamples[k];
+            if (shallow)
+            {
+                AddShallowSolids(sample);
+                if (m_restingSet.Test(m_bodies.SlotIndexAt(m_waterCandidates[k]))) continue;
+            }
+            float depth = sample.depth;
+            if (depth <= 0.0f) continue;
+
+            // Applied at the centre of the wet area, so a long body lying
+            // across a wave is pushed up where it is wet and rights itself.
+            // Shallow water uses Archimedes on the wet area; the spring
+            // surface keeps its tuned mass-proportional lift.
+            float buoyancy = 0.0f;
+            if (shallow)
+            {
+                buoyancy = kShallowWaterDensity * gravityPx * sample.wetArea / (kPixelsPerMeter * kPixelsPerMeter * kPixelsPerMeter);
+            }
+            else
+            {
+                buoyancy = b2Body_GetMass(e.bodyId) * 24.0f * (0.72f + 0.78f * depth);
+            }
+            Vector2 bp = sample.buoyancyPoint;
+            b2Body_ApplyForce(e.bodyId, {0.0f, -buoyancy}, {bp.x / kPixelsPerMeter, bp.y / kPixelsPerMeter}, false);
+
+            // Archimedes alone leaves bodies bobbing, so the pool drags harder.
+            float drag = dt * depth * (shallow ? kShallowDragScale : 1.0f);
+            b2Vec2 v = b2Body_GetLinearVelocity(e.bodyId);
+            float xDamp = std::max(0.0f, 1.0f - drag * 0.45f);
+            float yDamp = std::max(0.0f, 1.0f - drag * 0.65f);
+            b2Body_SetLinearVelocity(e.bodyId, {v.x * xDamp, v.y * yDamp});
+            b2Body_SetAngularVelocity(e.bodyId, b2Body_GetAngularVelocity(e.bodyId) * std::max(0.0f, 1.0f - drag * 0.6f));
+
+            if (!shallow)
+            {
+                // Each wet column pushes the surface in proportion to how much
+                // of the body is under it.
+                float wet = 0.0f;
+                for (int c = 0; c < sample.columnCount; ++c) wet += sample.columns[c].wetLength;
+                int halfWidth = std::clamp(static_cast<int>(sample.columnWidth / m_waveStep + 0.5f), 1, 3);
+                for (int c = 0; c < sample.columnCount && wet > 0.0f; ++c)
+                {
+                    const water::Column& col = sample.columns[c];
+                    if (col.wetLength <= 0.0f) continue;
+                    water::Splat(m_waveImpulse.data(), static_cast<int>(n), m_waveStep, col.x, -v.y * disturbGain * col.wetLength / wet, halfWidth);
+                }
+            }
+
+            // Entry splash, once per trip into the sensor, on the first step
+            // the body is properly wet.
+            if (cold.waterEntry && depth > 0.08f)
+            {
+                cold.waterEntry = false;
+                if (m_waterSprayEnabled && (depth > 0.18f || std::abs(v.y) > 3.0f))
+                {
+                    DeferredJob job;
+                    job.type = DeferredJobType::EntrySplash;
+                    job.at = {sample.center.x, sample.waterYAtCenter};
+                    job.velocity = {v.x, v.y};
+                    job.seed = m_rng.Next();
+                    m_deferred.Push(job, DeferredPriority::Low, 2, true);
+                }
+            }
+        }
+
+        if (shallow) return;
+        for (size_t i = 0; i < n; ++i)
+        {
+            m_waveVel[i] += m_waveImpulse[i];
+            m_waveImpulse[i] = 0.0f;
+        }
+    }
+
+    // A shape entering the sensor arms its body's entry splash. Leaving does
+    // not disarm it: a body that hops out and falls back in without getting
+    // wet still splashes when it does.
+    void ConsumeWaterSensorEvents()
+    {
+        b2SensorEvents events = b2World_GetSensorEvents(m_worldId);
+        for (int i = 0; i < events.beginCount; ++i)
+        {
+            b2ShapeId visitor = events.beginEvents[i].visitorShapeId;
+            if (!b2Shape_IsValid(visitor)) continue;
+            if (auto idx = BodyIndexById(b2Shape_GetBody(visitor))) Cold(*idx).waterEntry = true;
+        }
+    }
+
+    // The hull becomes solid in the cells each sampled column covers; the part
+    // inside the water pushes it aside on the next step.
+    void AddShallowSolids(const water::BodySample& sample)
+    {
+        float floorY = m_waveBaselineY + m_shallow.RestDepth();
+        float half = 0.5f * sample.columnWidth;
+        int cells = static_cast<int>(m_shallow.Count());
+        for (int c = 0; c < sample.columnCount; ++c)
+        {
+            const water::Column& col = sample.columns[c];
+            if (col.bottom <= col.top) continue;
+            int first = std::max(0, static_cast<int>(std::ceil((col.x - half) / m_waveStep)));
+            int last = std::min(cells, static_cast<int>(std::ceil((col.x + half) / m_waveStep)));
+            for (int i = first; i < last; ++i) m_shallow.AddSolid(static_cast<size_t>(i), floorY - col.bottom, floorY - col.top);
+        }
+    }
+
+    // World-space hull of a body in px from its last move-event transform.
+    void BuildWaterHull(const BodyEntry& e, const BodyCold& cold, water::Hull& hull) const
+    {
+        Vector2 c = ToPixels(cold.xf.p);
+        const ShapeGeometry& outline = m_shapes[e.shape];
+        if (e.kind == BodyKind::Circle || outline.size() < 3)
+        {
+            float r = e.kind == BodyKind::Circle ? e.radiusPx : ApproxRadiusPx(e);
+            const int segments = 12;
+            for (int i = 0; i < segments; ++i)
+            {
+                float a = static_cast<float>(i) * (2.0f * PI / static_cast<float>(segments));
+                hull.verts[i] = {c.x + std::cos(a) * r, c.y + std::sin(a) * r};
+            }
+            hull.count = segments;
+        }
+        else
+        {
+            float cs = cold.xf.q.c;
+            float sn = cold.xf.q.s;
+            hull.count = std::min(static_cast<int>(outline.size()), water::kMaxHullVerts);
+            for (int i = 0; i < hull.count; ++i)
+            {
+                const Vector2& lv = outline[i];
+                hull.verts[i] = {c.x + lv.x * cs - lv.y * sn, c.y + lv.x * sn + lv.y * cs};
+            }
+        }
+        hull.Bound();
+    }
+
+    static void SampleWaterTask(int start, int end, uint32_t, void* context)
+    {
+        auto* self = static_cast<SandboxCore*>(context);
+        for (int k = start; k < end; ++k)
+        {
+            size_t idx = self->m_waterCandidates[static_cast<size_t>(k)];
+            const BodyCold& cold = self->Cold(idx);
+            water::Hull hull;
+            self->BuildWaterHull(self->m_bodies[idx], cold, hull);
+            water::SampleHull(self->m_waterSurface, hull, ToPixels(cold.xf.p), self->m_waterSamples[static_cast<size_t>(k)]);
+        }
+    }
+
+    void UpdateWaterChunks(float dt)
+    {
+        SLOP_ZONE("UpdateWaterChunks");
+        if (!InWater())
+        {
+            m_waterChunks.Clear();
+            return;
+        }
+        if (m_gpuEffects) return;
+
+        m_waterChunks.Integrate(dt, 980.0f, 0.97f, 0.985f);
+        const float ground = ActiveGroundTopYPx();
+        m_waterChunks.Collide(0.15f, 0.9f, [&](float& x, float& y, float r, float, float vy, float& nx, float& ny) {
+            if (vy > 0.0f && y > WaterHeightAt(x)) return ParticleContact::Absorb;
+            return ParticleWorldContact(x, y, r, ground, nx, ny);
+        });
+        m_waterChunks.Cull(-80.0f, m_worldWidth + 80.0f, static_cast<float>(m_height + 120));
+    }
+
+    void SpawnWaterSplash(Vector2 at, float energy)
+    {
+        if (!InWater() || !m_waterSprayEnabled) return;
+        DeferredJob job;
+        job.type = DeferredJobType::WaterSplash;
+        job.at = at;
+        job.amount = energy;
+        job.seed = m_rng.Next();
+        m_deferred.Push(job, DeferredPriority::Normal, 2, true);
+    }
+
+    void EmitWaterSplash(const DeferredJob& job)
+    {
+        SimRandom rng(job.seed);
+        Vector2 at = job.at;
+        float energy = job.amount;
+        int count = std::clamp(static_cast<int>(5 + energy * 35.0f), 5, 24);
+        for (int i = 0; i < count; ++i)
+        {
+            float ang = (-85.0f + static_cast<float>(rng.Range(0, 170))) * DEG2RAD;
+            float speed = (80.0f + energy * 180.0f) * (0.5f + static_cast<float>(rng.Range(0, 100)) / 100.0f * 0.8f);
+            float px = at.x + static_cast<float>(rng.Range(-16, 16));
+            float py = at.y + static_cast<float>(rng.Range(-4, 4));
+            float radius = 1.2f + static_cast<float>(rng.Range(0, 100)) / 100.0f * 3.0f;
+            float life = 0.26f + static_cast<float>(rng.Range(0, 100)) / 100.0f * 0.5f;
+            m_waterChunks.Emit(px, py, std::cos(ang) * speed, std::sin(ang) * speed - speed * 0.15f, radius, life);
+        }
+    }
+
+    // velocity is the body's, in m/s, as it went under.
+    void EmitEntrySplash(const DeferredJob& job)
+    {
+        SimRandom rng(job.seed);
+        Vector2 v = job.velocity;
+        int chunkCount = std::clamp(static_cast<int>(4 + std::abs(v.y) * 0.8f), 4, 18);
+        float baseSpeed = 55.0f + std::abs(v.y) * 18.0f;
+        for (int i = 0; i < chunkCount; ++i)
+        {
+            float ang = (-80.0f + static_cast<float>(rng.Range(0, 160))) * DEG2RAD;
+            float speed = baseSpeed * (0.55f + static_cast<float>(rng.Range(0, 100)) / 100.0f * 0.7f);
+            float px = job.at.x + static_cast<float>(rng.Range(-20, 20));
+            float py = job.at.y + static_cast<float>(rng.Range(-6, 4));
+            float radius = 1.4f + static_cast<float>(rng.Range(0, 100)) / 100.0f * 2.8f;
+            float life = 0.3f + static_cast<float>(rng.Range(0, 100)) / 100.0f * 0.45f;
+            m_waterChunks.Emit(px, py, std::cos(ang) * speed + v.x * 8.0f, std::sin(ang) * speed - std::abs(v.y) * 6.0f, radius, life);
+        }
+    }
+
+    void RunDeferredWork()
+    {
+        SLOP_ZONE("DeferredWork");
+        m_deferred.Run(kDeferredBudgetMs, [this](const DeferredJob& job) {
+            switch (job.type)
+            {
+            case DeferredJobType::GlassShards: EmitGlassShards(job); break;
+            case DeferredJobType::WaterSplash: EmitWaterSplash(job); break;
+            case DeferredJobType::EntrySplash: EmitEntrySplash(job); break;
+            }
+        });
+    }
+
+    void StartBodyDrag(Vector2 mousePx, float time)
+    {
+        auto picked = PickBody(mousePx);
+        if (!picked)
+        {
+            m_selecting = true;
+            m_selectionRect = {mousePx.x, mousePx.y, 0, 0};
+            return;
+        }
+
+        size_t idx = *picked;
+
+        if (!m_bodies[idx].Has(kFeatureSelected))
+        {
+            ClearSelection();
+            SetSelected(idx, true);
+        }
+
+        m_draggingBodies = true;
+        DestroyDragJoints();
+        b2Body_Enable(m_dragHandle);
+        b2Body_SetTransform(m_dragHandle, ToMeters(mousePx), b2Rot_identity);
+        auto selected = SelectedIndices();
+        for (size_t si : selected)
+        {
+            b2BodyId body = m_bodies[si].bodyId;
+            if (!b2Body_IsValid(body)) continue;
+            // Strong enough to carry whatever is welded to it, about its centre.
+            b2Vec2 c = b2Body_GetWorldCenterOfMass(body);
+            float mass = 0.0f;
+            float inertia = 0.0f;
+            for (size_t li : BodiesLinkedTo(si))
+            {
+                b2BodyId linked = m_bodies[li].bodyId;
+                float m = b2Body_GetMass(linked);
+                mass += m;
+                inertia += b2Body_GetRotationalInertia(linked) + m * b2DistanceSquared(b2Body_GetWorldCenterOfMass(linked), c);
+            }
+
+            b2Transform xf = b2Body_GetTransform(body);
+            b2MotorJointDef def = b2DefaultMotorJointDef();
+            def.base.bodyIdA = m_dragHandle;
+            def.base.bodyIdB = body;
+            def.base.localFrameA = {b2Sub(xf.p, ToMeters(mousePx)), xf.q};
+            def.base.localFrameB = b2Transform_identity;
+            def.linearHertz = kDragHertz;
+            def.linearDampingRatio = kDragDampingRatio;
+            def.maxSpringForce = kDragMaxAccel * mass;
+            def.angularHertz = kDragHertz;
+            def.angularDampingRatio = kDragDampingRatio;
+            def.maxSpringTorque = kDragMaxAngularAccel * inertia;
+            b2JointId joint = b2CreateMotorJoint(m_worldId, &def);
+            if (b2Joint_IsValid(joint)) m_dragLinks.push_back({BodyKey(body), joint});
+            b2Body_SetAwake(body, true);
+        }
+
+        m_prevDragMouse = mousePx;
+        m_prevDragTime = time;
+        m_dragReleaseVelM = {0.0f, 0.0f};
+    }
+
+    void UpdateBodyDrag(Vector2 mousePx, float time)
+    {
+        if (!m_draggingBodies) return;
+
+        float dt = time - m_prevDragTime;
+        if (dt > 0.0001f)
+        {
+            Vector2 velPx{(mousePx.x - m_prevDragMouse.x) / dt, (mousePx.y - m_prevDragMouse.y) / dt};
+            m_dragReleaseVelM = {velPx.x * kInvPixelsPerMeter, velPx.y * kInvPixelsPerMeter};
+            m_prevDragMouse = mousePx;
+            m_prevDragTime = time;
+        }
+
+        b2Vec2 target = ToMeters(mousePx);
+        b2Vec2 held = b2Body_IsValid(m_dragHandle) ? b2Body_GetPosition(m_dragHandle) : target;
+        if (held.x != target.x || held.y != target.y)
+        {
+            b2Body_SetTransform(m_dragHandle, target, b2Rot_identity);
+            // The joints pull sleeping bodies only once they are awake.
+            for (const DragLink& link : m_dragLinks)
+            {
+                if (b2Joint_IsValid(link.joint)) b2Joint_WakeBodies(link.joint);
+            }
+        }
+    }
+
+    // Joints of bodies destroyed mid-drag went with them.
+    void DestroyDragJoints()
+    {
+        for (const DragLink& link : m_dragLinks)
+        {
+            if (b2Joint_IsValid(link.joint)) b2DestroyJoint(link.joint, true);
+        }
+        m_dragLinks.clear();
+        if (b2Body_IsValid(m_dragHandle)) b2Body_Disable(m_dragHandle);
+    }
+
+    void EndBodyDrag()
+    {
+        if (!m_draggingBodies) return;
+        const float maxRelease = 30.0f;
+        float speed = b2Length(m_dragReleaseVelM);
+        b2Vec2 release = m_dragReleaseVelM;
+        if (speed > maxRelease && speed > 0.0f)
+        {
+            release = b2MulSV(maxRelease / speed, release);
+        }
+
+        for (const DragLink& link : m_dragLinks)
+        {
+            auto idx = BodyIndexByKey(link.body);
+            if (!idx) continue;
+            const BodyEntry& b = m_bodies[*idx];
+            b2Body_SetLinearVelocity(b.bodyId, release);
+            if (b.kind == BodyKind::Circle)
+            {
+                float radiusM = std::max(0.01f, b.radiusPx * kInvPixelsPerMeter);
+                float targetSpin = release.x / radiusM;
+                b2Body_SetAngularVelocity(b.bodyId, targetSpin * 0.8f);
+            }
+            TagBulletIfFast(b.bodyId, b2Length(release));
+        }
+
+        DestroyDragJoints();
+        m_draggingBodies = false;
+    }
+
+    static float MinHalfExtentM(b2BodyId id)
+    {
+        b2AABB box = b2Body_ComputeAABB(id);
+        return 0.5f * std::min(box.upperBound.x - box.lowerBound.x, box.upperBound.y - box.lowerBound.y);
+    }
+
+    // speed in m/s. Returns whether the body is a bullet now.
+    bool TagBulletIfFast(b2BodyId id, float speed)
+    {
+        if (m_bulletBudget <= 0) return false;
+        float extent = MinHalfExtentM(id);
+        if (speed * kFixedDt <= kBulletTravel * extent) return false;
+        uint64_t key = BodyKey(id);
+        for (BulletTag& t : m_bullets)
+        {
+            if (t.body != key) continue;
+            t.steps = 0;
+            return true;
+        }
+        if (static_cast<int>(m_bullets.size()) >= m_bulletBudget) EvictBullets(m_bullets.size() + 1 - static_cast<size_t>(m_bulletBudget));
+        b2Body_SetBullet(id, true);
+        m_bullets.push_back({key, extent, 0});
+        return true;
+    }
+
+    void EvictBullets(size_t count)
+    {
+        count = std::min(count, m_bullets.size());
+        for (size_t i = 0; i < count; ++i)
+        {
+            if (auto idx = BodyIndexByKey(m_bullets[i].body)) b2Body_SetBullet(m_bodies[*idx].bodyId, false);
+        }
+        m_bullets.erase(m_bullets.begin(), m_bullets.begin() + static_cast<std::ptrdiff_t>(count));
+        m_bulletEvictions += count;
+    }
+
+    // After each step, so a dense pile never holds on to tags.
+    void RetireBullets()
+    {
+        if (m_bullets.empty()) return;
+        size_t kept = 0;
+        for (size_t i = 0; i < m_bullets.size(); ++i)
+        {
+            BulletTag t = m_bullets[i];
+            auto idx = BodyIndexByKey(t.body);
+            if (!idx) continue;
+            b2BodyId id = m_bodies[*idx].bodyId;
+            float travel = b2Length(b2Body_GetLinearVelocity(id)) * kFixedDt;
+            if (++t.steps < kBulletMaxSteps && travel > 0.5f * kBulletTravel * t.minExtentM)
+            {
+                m_bullets[kept++] = t;
+                continue;
+            }
+            b2Body_SetBullet(id, false);
+        }
+        m_bullets.resize(kept);
+    }
+
+    void RotateSelection(float deltaRad, bool snap15)
+    {
+        auto selected = SelectedIndices();
+        if (selected.empty()) return;
+
+        for (size_t idx : selected)
+        {
+            b2BodyId body = m_bodies[idx].bodyId;
+            if (!b2Body_IsValid(body)) continue;
+            b2Transform t = b2Body_GetTransform(body);
+            float a = std::atan2(t.q.s, t.q.c);
+            if (snap15)
+            {
+                float snapped = std::round((a + deltaRad) / (15.0f * DEG2RAD)) * (15.0f * DEG2RAD);
+                t.q = b2MakeRot(snapped);
+            }
+            else
+            {
+                t.q = b2MakeRot(a + deltaRad);
+            }
+            b2Body_SetTransform(body, t.p, t.q);
+            b2Body_SetAngularVelocity(body, 0.0f);
+            b2Body_SetAwake(body, true);
+        }
+
+        // A drag holds the rotation its joint was made with.
+        for (const DragLink& link : m_dragLinks)
+        {
+            auto idx = BodyIndexByKey(link.body);
+            if (!idx || !b2Joint_IsValid(link.joint)) continue;
+            b2Transform frame = b2Joint_GetLocalFrameA(link.joint);
+            frame.q = b2Body_GetRotation(m_bodies[*idx].bodyId);
+            b2Joint_SetLocalFrameA(link.joint, frame);
+        }
+    }
+
+    static constexpr float kBlastRadiusM = 1.6f;
+    static constexpr float kBlastFalloffM = 2.4f;
+    static constexpr float kBlastImpulsePerLength = 9.0f;
+    static constexpr float kBlastGlassStress = 70.0f; // at full strength; a 40 px pane breaks near 50
+    static constexpr float kBlastWaveImpulse = 0.6f;
+
+    // 1 inside radius, fading linearly to 0 over falloff, as b2World_Explode does.
+    static float BlastScale(float distM, float radiusM, float falloffM)
+    {
+        if (distM <= radiusM) return 1.0f;
+        if (falloffM <= 0.0f) return 0.0f;
+        return std::clamp((radiusM + falloffM - distM) / falloffM, 0.0f, 1.0f);
+    }
+
+    static bool BlastOverlapCallback(b2ShapeId shapeId, void* context)
+    {
+        SandboxCore& self = *static_cast<SandboxCore*>(context);
+        if (auto idx = self.BodyIndexById(b2Shape_GetBody(shapeId))) self.m_blastScratch.push_back(*idx);
+        return true;
+    }
+
+    // b2World_Explode finds the shapes in reach through the dynamic tree and
+    // wakes them: a sleeping pile wakes as whole solver sets, not body by
+    // body, so a blast into thousands of them costs one island move each.
+    // One more tree query over the same box then stresses glass and tags the
+    // fastest bodies as bullets; the water under the blast is pushed away.
+    void Explode(b2Vec2 centerM, float radiusM, float falloffM, float impulsePerLength)
+    {
+        b2ExplosionDef def = b2DefaultExplosionDef();
+        def.position = centerM;
+        def.radius = radiusM;
+        def.falloff = falloffM;
+        def.impulsePerLength = impulsePerLength;
+        b2World_Explode(m_worldId, &def);
+
+        float reach = radiusM + falloffM;
+        float strength = std::abs(impulsePerLength) / kBlastImpulsePerLength;
+        m_blastScratch.clear();
+        b2AABB box{{centerM.x - reach, centerM.y - reach}, {centerM.x + reach, centerM.y + reach}};
+        b2World_OverlapAABB(m_worldId, box, b2DefaultQueryFilter(), &BlastOverlapCallback, this);
+        std::sort(m_blastScratch.begin(), m_blastScratch.end());
+        m_blastScratch.erase(std::unique(m_blastScratch.begin(), m_blastScratch.end()), m_blastScratch.end());
+
+        for (size_t idx : m_blastScratch)
+        {
+            b2BodyId id = m_bodies[idx].bodyId;
+            b2AABB aabb = b2Body_ComputeAABB(id);
+            float dx = std::max({aabb.lowerBound.x - centerM.x, 0.0f, centerM.x - aabb.upperBound.x});
+            float dy = std::max({aabb.lowerBound.y - centerM.y, 0.0f, centerM.y - aabb.upperBound.y});
+            float scale = BlastScale(std::sqrt(dx * dx + dy * dy), radiusM, falloffM);
+            if (scale <= 0.0f) continue;
+
+            TagBulletIfFast(id, b2Length(b2Body_GetLinearVelocity(id)));
+            BodyCold& cold = Cold(idx);
+            if (m_bodies[idx].Has(kFeatureGlass) && cold.glassGraceFrames <= 0)
+            {
+                cold.glassStress += kBlastGlassStress * strength * scale;
+                ActivateGlass(idx);
+            }
+        }
+
+        BlastWave(centerM, radiusM, falloffM, strength);
+    }
+
+    // Kicks the wave columns in reach away from the blast, the same way a
+    // body moving through them does, and throws spray where it breaks.
+    void BlastWave(b2Vec2 centerM, float radiusM, float falloffM, float strength)
+    {
+        if (m_sceneLocation != SceneLocation::Water || m_waveImpulse.empty()) return;
+        Vector2 c = ToPixels(centerM);
+        float reachPx = (radiusM + falloffM) * kPixelsPerMeter;
+        int i0 = WaveIndexForX(c.x - reachPx);
+        int i1 = WaveIndexForX(c.x + reachPx);
+        float peak = 0.0f;
+        for (int i = i0; i <= i1; ++i)
+        {
+            float x = static_cast<float>(i) * m_waveStep;
+            float y = m_waveBaselineY + m_waveDisp[i];
+            float scale = BlastScale(std::hypot(x - c.x, y - c.y) * kInvPixelsPerMeter, radiusM, falloffM);
+            if (scale <= 0.0f) continue;
+            float away = y >= c.y ? 1.0f : -1.0f;
+            m_waveImpulse[i] -= away * kBlastWaveImpulse * strength * scale;
+            peak = std::max(peak, scale);
+        }
+        if (peak > 0.0f) SpawnWaterSplash({c.x, WaterHeightAt(c.x)}, 0.5f * peak * strength);
+    }
+
+    void HandleToolClick(Tool tool, Vector2 mouse, float time)
+    {
+        auto picked = PickBody(mouse);
+
+        switch (tool)
+        {
+            case Tool::Cursor:
+                StartBodyDrag(mouse, time);
+                break;
+            case Tool::Weld:
+                if (picked) HandleWeldPick(*picked);
+                break;
+            case Tool::Wheel:
+                if (picked) ToggleWheelMode(*picked);
+                break;
+            case Tool::Bounce:
+            case Tool::Slip:
+            case Tool::Sticky:
+            case Tool::Glass:
+                if (picked) ToggleFeatureAt(*picked, tool);
+                break;
+            case Tool::Blast:
+                Explode(ToMeters(mouse), kBlastRadiusM, kBlastFalloffM, kBlastImpulsePerLength);
+                break;
+        }
+    }
+
+    // Box2D is only deterministic for identical creation histories, so both the
+    // recording and its replay start from a fresh world loaded from the image.
+    bool BeginDeterministicRun(const ReplayHeader& header, const uint8_t* scene, size_t sceneBytes)
+    {
+        SceneView view;
+        if (!ParseSceneFile(scene, sceneBytes, view)) return false;
+        ResetScene();
+        box2d_heap::DestroyWorld(m_worldId);
+        m_handleByBodyIndex.clear();
+        // Before the ground exists, so loading the image does not rebuild it.
+        ApplyWorldWidth(static_cast<float>(view.header->width));
+        InitWorld();
+        LoadSceneImage(scene, sceneBytes);
+        m_rewind.Clear();
+        m_rewindDirty.Clear();
+        m_rewindEdits = UINT64_MAX;
+        m_rewindStep = 0;
+        m_fastForward = false;
+        m_hashEdits = UINT64_MAX;
+        m_hashSlots.clear();
+        m_hashedSteps = 0;
+        m_rng.Seed(header.seed);
+        m_accumulator = 0.0f;
+        m_shards.Clear();
+        m_waterChunks.Clear();
+        m_deferred.Clear();
+        m_drawing = false;
+        m_freeformPoints.clear();
+        m_batchShape = SpawnShape::Box;
+        m_timeScale = header.timeScale;
+        m_paused = header.paused != 0;
+        m_tool = static_cast<Tool>(std::min<uint8_t>(header.tool, static_cast<uint8_t>(Tool::Blast)));
+        m_drawTool = static_cast<DrawTool>(std::min<uint8_t>(header.drawTool, static_cast<uint8_t>(DrawTool::Freeform)));
+        m_panel.collapsed = header.panelCollapsed != 0;
+        m_panel.x = header.panelX;
+        m_panel.y = header.panelY;
+        m_panel.dragging = false;
+        m_input = InputFrame{};
+        return true;
+    }
+
+    void ResetScene()
+    {
+        for (const JointEntry& j : m_joints)
+        {
+            if (b2Joint_IsValid(j.jointId)) b2DestroyJoint(j.jointId, false);
+        }
+        for (const BodyEntry& e : m_bodies)
+        {
+            UnindexBody(e.bodyId);
+            if (b2Body_IsValid(e.bodyId)) b2DestroyBody(e.bodyId);
+        }
+        m_joints.Clear();
+        m_bodies.Clear();
+        m_drawOrder.clear();
+        m_debris.Clear();
+        m_adhesion.Clear();
+        m_glassSet.Clear();
+        m_selectedSet.Clear();
+        m_restingSet.Clear();
+        ++m_restingVersion;
+        m_movedSlots.clear();
+        m_activeGlass.clear();
+        m_spawnOrder.clear();
+        m_bullets.clear();
+        DestroyDragJoints();
+        m_pendingWeldBody = SlotHandle{};
+        m_draggingBodies = false;
+        m_selecting = false;
+        std::fill(m_waveDisp.begin(), m_waveDisp.end(), 0.0f);
+        std::fill(m_waveVel.begin(), m_waveVel.end(), 0.0f);
+        std::fill(m_waveImpulse.begin(), m_waveImpulse.end(), 0.0f);
+        m_shallow.Reset();
+        m_waterChunks.Clear();
+        m_deferred.Clear();
+        m_waterSensorTopPx = -FLT_MAX; // refit from the restored surface
+        m_waterFreshSlots.clear();
+        m_hibernated.clear();
+        m_hibernatedBodies = 0;
+    }
+
+    void RunUiCommand(UiCommand cmd, uint8_t arg = 0)
+    {
+        if (m_recorder.IsOpen()) m_recorder.WriteUi(static_cast<uint8_t>(cmd), arg);
+        ApplyUiCommand(cmd, arg);
+    }
+
+    // Interface state changes at once; anything that touches the world is
+    // queued like the rest of the input.
+    void ApplyUiCommand(UiCommand cmd, uint8_t arg)
+    {
+        switch (cmd)
+        {
+            case UiCommand::Defaults:
+                m_timeScale = 1.0f;
+                m_tool = Tool::Cursor;
+                m_drawTool = DrawTool::None;
+                m_paused = false;
+                break; // the location is the world's
+            case UiCommand::SetTool: m_tool = static_cast<Tool>(std::min<uint8_t>(arg, static_cast<uint8_t>(Tool::Blast))); return;
+            case UiCommand::SetDrawTool: m_drawTool = static_cast<DrawTool>(std::min<uint8_t>(arg, static_cast<uint8_t>(DrawTool::Freeform))); return;
+            case UiCommand::TogglePause: m_paused = !m_paused; return;
+            case UiCommand::ToggleLanguage: m_language = (m_language == Language::RU) ? Language::EN : Language::RU; return;
+            case UiCommand::TogglePixelate: m_pixelate = !m_pixelate; return;
+            default: break;
+        }
+        SimCommand c;
+        c.type = SimCommandType::Ui;
+        c.arg = static_cast<uint8_t>(cmd);
+        c.arg2 = arg;
+        c.a = m_input.world;
+        Submit(std::move(c));
+    }
+
+    // The world side of ApplyUiCommand, applied with the other commands.
+    void ApplyUiWorldCommand(UiCommand cmd, uint8_t arg, Vector2 at)
+    {
+        switch (cmd)
+        {
+            case UiCommand::Defaults: m_sceneLocation = SceneLocation::Land; break;
+            case UiCommand::ResetScene: ResetScene(); break;
+            case UiCommand::SpawnBox: SpawnBox(at); break;
+            case UiCommand::SpawnCircle: SpawnCircle(at); break;
+            case UiCommand::SpawnTriangle: SpawnTriangle(at); break;
+            case UiCommand::SpawnGrid: SpawnGrid(ClampSpawnShape(arg), at, kGridSpawnSide, kGridSpawnSide); break;
+            case UiCommand::SpawnRain: SpawnRain(ClampSpawnShape(arg), at.x); break;
+            case UiCommand::SetLocation: SetLocation(ClampSceneLocation(arg)); break;
+            case UiCommand::ToggleTheme:
+                m_theme = (m_theme == Theme::Dark) ? Theme::Light : Theme::Dark;
+                ++m_restingVersion; // fills depend on the theme
+                break;
+            default: break;
+        }
+    }
+
+    // Render thread. Threaded, a full ring waits for the simulation to drain
+    // it; otherwise, or while this thread holds the world, it drains here.
+    void Submit(SimCommand&& c)
+    {
+        while (!m_commands.TryPush(std::move(c)))
+        {
+            if (m_physicsThread.joinable() && !m_commandsInline) std::this_thread::yield();
+            else ApplyCommands();
+        }
+    }
+
+    void Submit(SimCommandType type, Vector2 at, uint8_t arg = 0, bool flag = false, float value = 0.0f, float value2 = 0.0f)
+    {
+        SimCommand c;
+        c.type = type;
+        c.arg = arg;
+        c.flag = flag;
+        c.value = value;
+        c.value2 = value2;
+        c.a = at;
+        Submit(std::move(c));
+    }
+
+    // The one point where input reaches the world: the start of a simulation
+    // frame, on whichever thread owns it.
+    void ApplyCommands()
+    {
+        SimCommand c;
+        while (m_commands.TryPop(c)) ApplyCommand(c);
+    }
+
+    void ApplyCommand(const SimCommand& c)
+    {
+        switch (c.type)
+        {
+            case SimCommandType::View:
+                m_viewRect = c.rect;
+                m_appliedInputSerial = c.serial;
+                break;
+            case SimCommandType::Ui: ApplyUiWorldCommand(static_cast<UiCommand>(c.arg), c.arg2, c.a); break;
+            case SimCommandType::ResetScene:
+                CancelSceneLoad();
+                ResetScene();
+                break;
+            case SimCommandType::UndoSpawn: UndoSpawn(); break;
+            case SimCommandType::ToggleRigid: ToggleRigidAt(c.a); break;
+            case SimCommandType::Copy: CopySelection(); break;
+            case SimCommandType::Paste: PasteAt(c.a, c.flag); break;
+            case SimCommandType::Duplicate: DuplicateSelection(c.flag); break;
+            case SimCommandType::Spawn:
+                if (c.flag) SpawnGrid(ClampSpawnShape(c.arg), c.a, kGridSpawnSide, kGridSpawnSide);
+                else SpawnShapeAt(ClampSpawnShape(c.arg), c.a);
+                break;
+            case SimCommandType::Rain: SpawnRain(ClampSpawnShape(c.arg), c.a.x); break;
+            case SimCommandType::Spray: SprayAt(ClampSpawnShape(c.arg), c.a); break;
+            case SimCommandType::Rotate: RotateSelection(c.value, c.flag); break;
+            case SimCommandType::WaveKick:
+                if (!InWater()) break;
+                if (c.flag) DisturbWave(c.a.x, static_cast<float>(m_rng.Range(-220, 220)) * 0.0016f);
+                else DisturbWave(c.a.x, static_cast<float>(m_rng.Range(-20, 20)) * 0.001f);
+                break;
+            case SimCommandType::WaterPoke:
+            {
+                if (!InWater()) break;
+                float wy = WaterHeightAt(c.a.x);
+                DisturbWave(c.a.x, c.value);
+                if (c.value2 > 0.0f) SpawnWaterSplash({c.a.x, wy}, c.value2);
+                break;
+            }
+            case SimCommandType::Delete: DeleteBodyAt(c.a); break;
+            case SimCommandType::DrawSpawn:
+                switch (static_cast<DrawTool>(c.arg))
+                {
+                    case DrawTool::Quad: SpawnQuadFromDrag(c.a, c.b); break;
+                    case DrawTool::Circle: SpawnCircleFromDrag(c.a, c.b, c.flag); break;
+                    case DrawTool::Triangle: SpawnTriangleFromDrag(c.a, c.b); break;
+                    default: break;
+                }
+                break;
+            case SimCommandType::Stroke: SpawnFreeformFromStroke(c.points); break;
+            case SimCommandType::DragBegin: StartBodyDrag(c.a, c.value); break;
+            case SimCommandType::DragTo:
+                if (m_draggingBodies) UpdateBodyDrag(c.a, c.value);
+                else if (m_selecting) m_selectionRect = NormalizeRect({m_selectionRect.x, m_selectionRect.y}, c.a);
+                break;
+            case SimCommandType::DragEnd:
+                if (m_draggingBodies) EndBodyDrag();
+                if (m_selecting)
+                {
+                    SelectByRect(m_selectionRect);
+                    m_selecting = false;
+                }
+                break;
+            case SimCommandType::ToolClick: HandleToolClick(static_cast<Tool>(c.arg), c.a, c.value); break;
+            case SimCommandType::Rewind: RewindBy(static_cast<int>(c.value)); break;
+            case SimCommandType::FastForward:
+                if (c.flag) m_fastForward = false;
+                else StartFastForward(c.value);
+                break;
+        }
+    }
+
+    // Header drag and collapse only; pure input, so replays run it too.
+    void HandlePanelDrag()
+    {
+        Rectangle header{m_panel.x, m_panel.y, m_panel.w, 46};
+        Vector2 mouse = m_input.mouse;
+
+        if (PointInRect(mouse, header) && m_input.MousePressed(InputButton::Left))
+        {
+            m_panel.dragging = true;
+            m_panel.dragOffset = {mouse.x - m_panel.x, mouse.y - m_panel.y};
+        }
+        if (m_panel.dragging && m_input.MouseDown(InputButton::Left))
+        {
+            m_panel.x = mouse.x - m_panel.dragOffset.x;
+            m_panel.y = mouse.y - m_panel.dragOffset.y;
+            m_panel.x = std::clamp(m_panel.x, 0.0f, static_cast<float>(m_width) - m_panel.w);
+            m_panel.y = std::clamp(m_panel.y, 0.0f, static_cast<float>(m_height) - 56.0f);
+        }
+        if (m_input.MouseReleased(InputButton::Left))
+        {
+            m_panel.dragging = false;
+        }
+
+        Rectangle collapseBtn{m_panel.x + m_panel.w - 38, m_panel.y + 7, 30, 30};
+        if (PointInRect(mouse, collapseBtn) && m_input.MousePressed(InputButton::Left))
+        {
+            m_panel.collapsed = !m_panel.collapsed;
+        }
+
+    }
+
+    void HandleKeyboard()
+    {
+        SLOP_ZONE("HandleKeyboard");
+        Vector2 mouse = m_input.world;
+        bool shift = m_input.KeyDown(InputKey::LeftShift) || m_input.KeyDown(InputKey::RightShift);
+        bool waveKick = false;
+
+        if (m_input.KeyPressed(InputKey::Backspace)) { Submit(SimCommandType::ResetScene, mouse); waveKick = true; }
+        if (m_input.KeyPressed(InputKey::Z)) { Submit(SimCommandType::UndoSpawn, mouse); waveKick = true; }
+        // Held: scrub the rewind history, one capture a frame (eight with Shift).
+        if (m_input.KeyDown(InputKey::Comma)) Submit(SimCommandType::Rewind, mouse, 0, false, shift ? -8.0f : -1.0f);
+        if (m_input.KeyDown(InputKey::Period)) Submit(SimCommandType::Rewind, mouse, 0, false, shift ? 8.0f : 1.0f);
+        // F fast-forwards until the scene sleeps, Shift+F for ten seconds; F again stops.
+        if (m_input.KeyPressed(InputKey::F)) Submit(SimCommandType::FastForward, mouse, 0, m_fastForward, shift ? kFastForwardKeySeconds : 0.0f);
+        if (m_input.KeyPressed(InputKey::X)) { Submit(SimCommandType::ToggleRigid, mouse); waveKick = true; }
+        if (m_input.KeyPressed(InputKey::C)) Submit(SimCommandType::Copy, mouse);
+        if (m_input.KeyPressed(InputKey::V)) { Submit(SimCommandType::Paste, mouse, 0, shift); waveKick = true; }
+        if (m_input.KeyPressed(InputKey::B)) { Submit(SimCommandType::Duplicate, mouse, 0, shift); waveKick = true; }
+
+        if (m_input.KeyPressed(InputKey::Space)) { m_paused = !m_paused; waveKick = true; }
+        if (m_input.KeyPressed(InputKey::G))
+        {
+            m_timeScale = (std::abs(m_timeScale - 0.5f) < 0.001f) ? 1.0f : 0.5f;
+            waveKick = true;
+        }
+        if (m_input.KeyPressed(InputKey::H))
+        {
+            m_timeScale = (std::abs(m_timeScale - 2.0f) < 0.001f) ? 1.0f : 2.0f;
+            waveKick = true;
+        }
+        if (m_input.KeyPressed(InputKey::Eight))
+        {
+            m_pixelate = !m_pixelate;
+        }
+        if (m_input.KeyPressed(InputKey::F3))
+        {
+            m_showProfiler = !m_showProfiler;
+        }
+        if (m_input.KeyPressed(InputKey::F4))
+        {
+            if (m_profiler.CsvOpen()) m_profiler.CloseCsv();
+            else m_profiler.OpenCsv(m_profileCsvPath.c_str());
+        }
+
+        if (m_input.KeyPressed(InputKey::One)) { m_tool = Tool::Cursor; waveKick = true; }
+        if (m_input.KeyPressed(InputKey::Two)) { m_tool = Tool::Weld; waveKick = true; }
+        if (m_input.KeyPressed(InputKey::Three)) { m_tool = Tool::Wheel; waveKick = true; }
+        if (m_input.KeyPressed(InputKey::Four)) { m_tool = Tool::Bounce; waveKick = true; }
+        if (m_input.KeyPressed(InputKey::Five)) { m_tool = Tool::Slip; waveKick = true; }
+        if (m_input.KeyPressed(InputKey::Six)) { m_tool = Tool::Sticky; waveKick = true; }
+        if (m_input.KeyPressed(InputKey::Seven)) { m_tool = Tool::Glass; waveKick = true; }
+        if (m_input.KeyPressed(InputKey::Nine)) { m_tool = Tool::Blast; waveKick = true; }
+
+        if (m_input.KeyPressed(InputKey::R)) { m_drawTool = DrawTool::Quad; waveKick = true; }
+        if (m_input.KeyPressed(InputKey::T)) { m_drawTool = DrawTool::Circle; waveKick = true; }
+        if (m_input.KeyPressed(InputKey::Y)) { m_drawTool = DrawTool::Triangle; waveKick = true; }
+        if (m_input.KeyPressed(InputKey::U)) { m_drawTool = DrawTool::Freeform; waveKick = true; }
+
+        // Shift+Q/W/E spawn a grid instead of one body; the shape also becomes
+        // the one sprayed with S and rained with Shift+S.
+        const std::pair<InputKey, SpawnShape> spawnKeys[] = {{InputKey::Q, SpawnShape::Box}, {InputKey::W, SpawnShape::Circle}, {InputKey::E, SpawnShape::Triangle}};
+        for (const auto& [key, shape] : spawnKeys)
+        {
+            if (!m_input.KeyPressed(key)) continue;
+            m_batchShape = shape;
+            Submit(SimCommandType::Spawn, mouse, static_cast<uint8_t>(shape), shift);
+            waveKick = true;
+        }
+        if (m_input.KeyPressed(InputKey::S) && shift) { Submit(SimCommandType::Rain, mouse, static_cast<uint8_t>(m_batchShape)); waveKick = true; }
+        if (m_input.KeyDown(InputKey::S) && !shift) Submit(SimCommandType::Spray, mouse, static_cast<uint8_t>(m_batchShape));
+
+        if (m_input.KeyDown(InputKey::A))
+        {
+            Submit(SimCommandType::Rotate, mouse, 0, shift, shift ? -15.0f * DEG2RAD : -2.8f * DEG2RAD);
+            waveKick = true;
+        }
+        if (m_input.KeyDown(InputKey::D))
+        {
+            Submit(SimCommandType::Rotate, mouse, 0, shift, shift ? 15.0f * DEG2RAD : 2.8f * DEG2RAD);
+            waveKick = true;
+        }
+
+        // keyboard wave kick for water
+        if (waveKick) Submit(SimCommandType::WaveKick, mouse, 0, true);
+        if (m_input.KeyDown(InputKey::A) || m_input.KeyDown(InputKey::D)) Submit(SimCommandType::WaveKick, mouse);
+    }
+
+    void HandleMouse()
+    {
+        SLOP_ZONE("HandleMouse");
+        Vector2 mouse = m_input.world;
+        bool shift = m_input.KeyDown(InputKey::LeftShift) || m_input.KeyDown(InputKey::RightShift);
+
+        m_weldCursor = mouse;
+
+        // Ignore world interactions if panel is clicked area (except collapsed header drag)
+        Rectangle panelArea{m_panel.x, m_panel.y, m_panel.w, m_panel.collapsed ? 46.0f : 650.0f};
+        bool overPanel = PointInRect(m_input.mouse, panelArea);
+
+        if (overPanel) return;
+
+        if (m_input.MousePressed(InputButton::Right))
+        {
+            Submit(SimCommandType::Delete, mouse);
+            Submit(SimCommandType::WaterPoke, mouse, 0, false, -0.08f, 0.35f);
+        }
+
+        // Pokes only reach the water when there is some.
+        if (m_input.MousePressed(InputButton::Left)) Submit(SimCommandType::WaterPoke, mouse, 0, false, 0.065f, 0.28f);
+        if (m_input.MouseDown(InputButton::Left)) Submit(SimCommandType::WaterPoke, mouse, 0, false, 0.004f);
+
+        if (m_tool == Tool::Cursor && m_drawTool != DrawTool::None)
+        {
+            // drawing mode under cursor tool not needed; drawing uses drawTool independent from cursor in this version
+        }
+
+        bool drawingActive = (m_drawTool != DrawTool::None);
+
+        if (drawingActive)
+        {
+            if (m_input.MousePressed(InputButton::Left))
+            {
+                m_drawing = true;
+                m_drawStart = mouse;
+                m_drawCurrent = mouse;
+                m_freeformPoints.clear();
+                if (m_drawTool == DrawTool::Freeform)
+                {
+                    m_freeformPoints.push_back(mouse);
+                }
+            }
+            if (m_drawing && m_input.MouseDown(InputButton::Left))
+            {
+                m_drawCurrent = mouse;
+                if (m_drawTool == DrawTool::Freeform)
+                {
+                    if (m_freeformPoints.empty() || std::hypot(m_freeformPoints.back().x - mouse.x, m_freeformPoints.back().y - mouse.y) > 5.0f)
+                    {
+                        m_freeformPoints.push_back(mouse);
+                    }
+                }
+            }
+            if (m_drawing && m_input.MouseReleased(InputButton::Left))
+            {
+                m_drawCurrent = mouse;
+                SimCommand c;
+                c.type = (m_drawTool == DrawTool::Freeform) ? SimCommandType::Stroke : SimCommandType::DrawSpawn;
+                c.arg = static_cast<uint8_t>(m_drawTool);
+                c.flag = shift;
+                c.a = m_drawStart;
+                c.b = m_drawCurrent;
+                if (m_drawTool == DrawTool::Freeform) c.points = std::move(m_freeformPoints);
+                Submit(std::move(c));
+                m_drawing = false;
+                m_freeformPoints.clear();
+            }
+            return;
+        }
+
+        if (m_tool == Tool::Cursor)
+        {
+            // Whether the press grabbed bodies or started a selection box is
+            // only known once it is applied, so drags always send all three.
+            if (m_input.MousePressed(InputButton::Left) && !m_drawing)
+            {
+                Submit(SimCommandType::DragBegin, mouse, 0, false, m_input.time);
+            }
+            if (m_input.MouseDown(InputButton::Left))
+            {
+                Submit(SimCommandType::DragTo, mouse, 0, false, m_input.time);
+            }
+            if (m_input.MouseReleased(InputButton::Left))
+            {
+                Submit(SimCommandType::DragEnd, mouse);
+            }
+        }
+        else
+        {
+            if (m_input.MouseReleased(InputButton::Left))
+            {
+                Submit(SimCommandType::ToolClick, mouse, static_cast<uint8_t>(m_tool), false, m_input.time);
+            }
+        }
+    }
+
+    void UpdateSimulation(float dt, int maxSteps)
+    {
+        SLOP_ZONE("UpdateSimulation");
+        m_frameArena.Reset();
+        bool inserting = false;
+        {
+            box2d_heap::Scope heapScope(box2d_heap::Subsystem::Edit);
+            ApplyCommands();
+            inserting = InsertLoadedScene();
+        }
+        m_stepLogCap = 0;
+        m_stepLogCount = 0;
+        m_frameHashCount = 0;
+        ValidateResting();
+        if (m_paused || inserting) return;
+
+        if (b2Body_IsValid(m_groundBody))
+        {
+            float targetYPx = ActiveGroundCenterYPx();
+            if (std::abs(targetYPx - m_groundCenterCachePx) > 0.5f)
+            {
+                b2Transform gt = b2Body_GetTransform(m_groundBody);
+                b2Vec2 targetP = ToMeters({m_worldWidth * 0.5f, targetYPx});
+                gt.p = targetP;
+                gt.q = b2MakeRot(0.0f);
+                b2Body_SetTransform(m_groundBody, gt.p, gt.q);
+                m_groundCenterCachePx = targetYPx;
+            }
+        }
+
+        if (m_fastForward)
+        {
+            FastForwardSlice();
+            return;
+        }
+
+        maxSteps = m_replayStep ? m_replayStep->stepCap : std::min(maxSteps, m_stepController.CatchUpSteps());
+        maxSteps = std::min(maxSteps, kReplayMaxSteps);
+        m_stepLogCap = maxSteps;
+        float scaled = dt * m_timeScale;
+        m_accumulator += scaled;
+        float maxAccum = kFixedDt * static_cast<float>(maxSteps);
+        if (m_accumulator > maxAccum) m_accumulator = maxAccum;
+
+        int steps = 0;
+        while (m_accumulator >= kFixedDt && steps < maxSteps)
+        {
+            int subSteps = m_stepController.SubSteps();
+            if (m_replayStep) subSteps = (steps < m_replayStep->stepCount) ? std::max<int>(1, m_replayStep->subSteps[steps]) : subSteps;
+            m_stepLog[steps] = static_cast<uint8_t>(subSteps);
+            StepOnce(subSteps);
+            m_accumulator -= kFixedDt;
+            ++steps;
+        }
+        m_stepLogCount = steps;
+    }
+
+    // One fixed step of everything the simulation advances per step.
+    void StepOnce(int subSteps)
+    {
+        if (m_scenario.Active()) RunScenarioStep();
+        {
+            FrameProfiler::Scope scope(m_profiler, ProfileStage::Wave);
+            UpdateWave(kFixedDt);
+        }
+        auto t0 = std::chrono::steady_clock::now();
+        {
+            box2d_heap::Scope heapScope(box2d_heap::Subsystem::Step);
+            {
+                SLOP_ZONE("b2World_Step");
+                b2World_Step(m_worldId, kFixedDt, subSteps);
+            }
+            ConsumeBodyMoves();
+            RetireBullets();
+        }
+        double stepMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+        m_profiler.AddStage(ProfileStage::Physics, stepMs);
+        if (m_scenario.Active()) m_scenario.RecordStep(stepMs);
+        m_profiler.AddWorldStep(b2World_GetProfile(m_worldId), subSteps);
+        m_stepController.Record(stepMs, b2World_GetAwakeBodyCount(m_worldId));
+        m_profiler.SampleWorld(m_worldId);
+        m_profiler.SampleBullets(static_cast<int>(m_bullets.size()), m_bulletEvictions);
+        {
+            FrameProfiler::Scope scope(m_profiler, ProfileStage::Glass);
+            box2d_heap::Scope heapScope(box2d_heap::Subsystem::Glass);
+            UpdateGlass(kFixedDt);
+            m_debris.Update(kFixedDt, kDebrisActivationsPerStep);
+        }
+        BreakOverloadedJoints();
+        UpdateAdhesion();
+        if (m_telemetry.IsOpen()) PushTelemetry(stepMs, subSteps);
+        if (m_stateHashing) HashStep();
+        if (++m_rewindStep % kRewindCaptureSteps == 0) CaptureRewind();
+    }
+
+    void RunScenarioStep()
+    {
+        SLOP_ZONE("Scenario");
+        m_scenario.Step([this](const scenario::Op& op) { RunScenarioOp(op); }, [this](scenario::Metric m) { return ScenarioMetric(m); });
+    }
+
+    float ScenarioCoord(const scenario::Coord& c, bool vertical) const
+    {
+        switch (c.anchor)
+        {
+            case scenario::Anchor::Center: return c.offset + (vertical ? static_cast<float>(m_height) : m_worldWidth) * 0.5f;
+            case scenario::Anchor::Ground: return c.offset + ActiveGroundTopYPx();
+            case scenario::Anchor::Water: return c.offset + m_waveBaselineY;
+            default: return c.offset;
+        }
+    }
+
+    // Bodies appended from dense index `before` on become the group.
+    void KeepScenarioGroup(size_t before)
+    {
+        m_scenarioGroup.clear();
+        for (size_t i = before; i < m_bodies.size(); ++i) m_scenarioGroup.push_back(BodyKey(m_bodies[i].bodyId));
+    }
+
+    const std::vector<size_t>& ScenarioGroupIndices()
+    {
+        m_scenarioScratch.clear();
+        for (uint64_t key : m_scenarioGroup)
+        {
+            if (auto idx = BodyIndexByKey(key)) m_scenarioScratch.push_back(*idx);
+        }
+        return m_scenarioScratch;
+    }
+
+    void RunScenarioOp(const scenario::Op& op)
+    {
+        using scenario::OpCode;
+        Vector2 at{ScenarioCoord(op.x, false), ScenarioCoord(op.y, true)};
+        auto shape = static_cast<SpawnShape>(op.kind);
+        size_t before = m_bodies.size();
+        switch (op.code)
+        {
+            case OpCode::Location: SetLocation(static_cast<SceneLocation>(op.kind)); break;
+            case OpCode::Spawn:
+                SpawnShapeAt(shape, at);
+                KeepScenarioGroup(before);
+                break;
+            case OpCode::Grid:
+                SpawnGrid(shape, at, op.count, op.count2);
+                KeepScenarioGroup(before);
+                break;
+            case OpCode::Rain:
+                SpawnRain(shape, at.x);
+                KeepScenarioGroup(before);
+                break;
+            case OpCode::Column:
+            {
+                float top = ActiveGroundTopYPx();
+                for (int h = 0; h < op.count; ++h)
+                {
+                    float y = top - kBaseHalfPx - 4.0f - static_cast<float>(h) * kBaseSizePx;
+                    size_t idx = ScriptSpawnBox({at.x, y});
+                    if (h > 0) ScriptWeld(idx - 1, idx, {at.x, y + kBaseHalfPx});
+                }
+                KeepScenarioGroup(before);
+                break;
+            }
+            case OpCode::Feature:
+            {
+                const std::vector<size_t>& group = ScenarioGroupIndices();
+                SetFeature(group.data(), group.size(), static_cast<Tool>(op.kind), op.flag);
+                break;
+            }
+            case OpCode::Push:
+                for (size_t idx : ScenarioGroupIndices())
+                {
+                    b2BodyId id = m_bodies[idx].bodyId;
+                    float mass = b2Body_GetMass(id);
+                    b2Body_ApplyLinearImpulseToCenter(id, {op.value * mass, op.value2 * mass}, true);
+                }
+                break;
+            case OpCode::Explode: ScriptExplode(at, op.value, op.value2); break;
+            case OpCode::Tool: HandleToolClick(static_cast<Tool>(op.kind), at, static_cast<float>(m_scenario.StepCount()) * kFixedDt); break;
+            case OpCode::Kick:
+            {
+                SimCommand c;
+                c.type = SimCommandType::WaveKick;
+                c.flag = true;
+                c.a = at;
+                ApplyCommand(c);
+                break;
+            }
+            case OpCode::Reset:
+                ResetScene();
+                m_scenarioGroup.clear();
+                break;
+            case OpCode::BreakLimits: SetJointBreakLimits(op.value, op.flag ? op.value2 : op.value * kBaseHalfPx * kInvPixelsPerMeter); break;
+            default: break;
+        }
+    }
+
+    double ScenarioMetric(scenario::Metric m) const
+    {
+        switch (m)
+        {
+            case scenario::Metric::Bodies: return static_cast<double>(m_bodies.size());
+            case scenario::Metric::Awake: return static_cast<double>(m_bodies.size() - m_restingSet.Count());
+            case scenario::Metric::Settled: return SceneSettled() ? 1.0 : 0.0;
+            case scenario::Metric::GlassBreaks: return static_cast<double>(m_glassBreakCount - m_scenarioGlassBreaks);
+            case scenario::Metric::JointBreaks: return static_cast<double>(m_jointBreakCount - m_scenarioJointBreaks);
+            default: return 0.0;
+        }
+    }
+
+    uint64_t BodyStateHash(size_t idx) const
+    {
+        const BodyEntry& e = m_bodies[idx];
+        state_hash::Hasher h;
+        h.Add(uint64_t{static_cast<uint8_t>(e.features & ~kFeatureSelected)});
+        if (!b2Body_IsValid(e.bodyId)) return h.Value();
+        b2Transform xf = b2Body_GetTransform(e.bodyId);
+        b2Vec2 v = b2Body_GetLinearVelocity(e.bodyId);
+        h.Add(xf.p.x);
+        h.Add(xf.p.y);
+        h.Add(xf.q.c);
+        h.Add(xf.q.s);
+        h.Add(v.x);
+        h.Add(v.y);
+        h.Add(b2Body_GetAngularVelocity(e.bodyId));
+        h.Add(uint64_t{b2Body_IsAwake(e.bodyId)});
+        // Warm-start impulses: joint state that poses alone do not show.
+        for (SlotHandle jh : Cold(idx).joints)
+        {
+            const JointEntry* j = m_joints.Get(jh);
+            if (!j || !b2Joint_IsValid(j->jointId)) continue;
+            b2Vec2 f = b2Joint_GetConstraintForce(j->jointId);
+            h.Add(f.x);
+            h.Add(f.y);
+            h.Add(b2Joint_GetConstraintTorque(j->jointId));
+        }
+        return h.Value();
+    }
+
+    static void HashBodiesTask(int start, int end, uint32_t, void* context)
+    {
+        auto* self = static_cast<SandboxCore*>(context);
+        for (int k = start; k < end; ++k)
+        {
+            self->m_hashScratch[static_cast<size_t>(k)] = self->BodyStateHash(self->m_hashIndices[static_cast<size_t>(k)]);
+        }
+    }
+
+    // After every step while hashing. A scene edit can renumber the dense
+    // order, so it rehashes every body; otherwise only the move events' do:
+    // a sleeping body's state cannot change without one.
+    void HashStep()
+    {
+        bool full = m_hashEdits != m_sceneEdits || m_bodyHashes.Size() != m_bodies.size();
+        m_hashIndices.clear();
+        if (full)
+        {
+            m_hashIndices.resize(m_bodies.size());
+            for (size_t i = 0; i < m_hashIndices.size(); ++i) m_hashIndices[i] = i;
+            m_hashEdits = m_sceneEdits;
+        }
+        else
+        {
+            for (uint32_t slot : m_hashSlots)
+            {
+                if (auto idx = m_bodies.DenseIndexOfSlot(slot)) m_hashIndices.push_back(*idx);
+            }
+        }
+        m_hashSlots.clear();
+        m_hashScratch.resize(m_hashIndices.size());
+        int count = static_cast<int>(m_hashIndices.size());
+        if (count < kHashParallelMin) HashBodiesTask(0, count, 0, this);
+        else m_scheduler->ParallelFor(count, kHashParallelMin / 2, &HashBodiesTask, this);
+        if (full) m_bodyHashes.Rebuild(m_hashScratch);
+        else
+        {
+            for (size_t k = 0; k < m_hashIndices.size(); ++k) m_bodyHashes.Set(m_hashIndices[k], m_hashScratch[k]);
+        }
+
+        state_hash::Hasher h;
+        h.Add(m_bodyHashes.Sum());
+        h.Add(uint64_t{m_bodies.size()});
+        h.Add(uint64_t{m_joints.size()});
+        for (SlotHandle gh : m_activeGlass)
+        {
+            auto idx = m_bodies.DenseIndex(gh);
+            if (!idx) continue;
+            h.Add(uint64_t{*idx});
+            h.Add(Cold(*idx).glassStress);
+            h.Add(static_cast<uint64_t>(Cold(*idx).glassGraceFrames));
+        }
+        h.Add(m_waveDisp.data(), m_waveDisp.size());
+        h.Add(m_waveVel.data(), m_waveVel.size());
+        if (m_sceneLocation == SceneLocation::Shallow)
+        {
+            h.Add(m_shallow.Depths().data(), m_shallow.Depths().size());
+            h.Add(m_shallow.Velocities().data(), m_shallow.Velocities().size());
+        }
+        h.Add(m_rng.State());
+        m_stateHash = h.Value();
+        ++m_hashedSteps;
+        if (m_frameHashCount < kReplayMaxSteps) m_frameHashes[m_frameHashCount++] = m_stateHash;
+    }
+
+    // Fast-forward: back-to-back steps for one wall-clock slice, ignoring the
+    // time scale and the catch-up cap. Ends once the requested steps are done
+    // or, when settling, once every body sleeps.
+    void FastForwardSlice()
+    {
+        auto start = std::chrono::steady_clock::now();
+        auto slice = std::chrono::duration<double, std::milli>(kFastForwardSliceMs);
+        do
+        {
+            StepOnce(m_stepController.SubSteps());
+            ++m_fastForwardDone;
+            bool done = --m_fastForwardLeft == 0 || (m_fastForwardUntilAsleep && SceneSettled());
+            if (done)
+            {
+                m_fastForward = false;
+                break;
+            }
+        } while (std::chrono::steady_clock::now() - start < slice);
+        m_accumulator = 0.0f;
+    }
+
+    // Every body asleep, except those that fell past the ground: they never
+    // come to rest.
+    bool SceneSettled() const
+    {
+        float floorM = FallenBelowM();
+        for (uint32_t slot : m_movedSlots)
+        {
+            if (m_bodyCold[slot].xf.p.y < floorM) return false;
+        }
+        return true;
+    }
+
+    // A metre under the bottom of the ground.
+    float FallenBelowM() const { return (ActiveGroundCenterYPx() + kGroundHalfThicknessPx) * kInvPixelsPerMeter + 1.0f; }
+
+    // simSeconds <= 0 runs until the scene is asleep. Not while recording or
+    // replaying: the stream holds at most kReplayMaxSteps steps a frame.
+    void StartFastForward(float simSeconds)
+    {
+        if (m_recorder.IsOpen() || m_replayStep) return;
+        m_fastForwardUntilAsleep = simSeconds <= 0.0f;
+        float seconds = m_fastForwardUntilAsleep ? kFastForwardSettleMaxSeconds : simSeconds;
+        m_fastForwardLeft = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(seconds / kFixedDt)));
+        m_fastForwardDone = 0;
+        m_fastForward = true;
+        m_paused = false;
+    }
+
+    void PushTelemetry(double stepMs, int subSteps)
+    {
+        b2Counters counters = b2World_GetCounters(m_worldId);
+        TelemetryRecord r;
+        r.step = m_telemetry.Pushed();
+        r.timeNs = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+        r.stepMs = static_cast<float>(stepMs);
+        r.subSteps = static_cast<uint32_t>(subSteps);
+        r.bodies = static_cast<uint32_t>(m_bodies.size());
+        r.awakeBodies = static_cast<uint32_t>(m_bodies.size() - m_restingSet.Count());
+        r.joints = static_cast<uint32_t>(m_joints.size());
+        r.contacts = static_cast<uint32_t>(counters.contactCount);
+        r.hitEvents = static_cast<uint32_t>(b2World_GetContactEvents(m_worldId).hitCount);
+        r.glassBreaks = m_stepGlassBreaks;
+        // The CPU pools only; with GPU effects they hold one publish worth.
+        r.particles = static_cast<uint32_t>(m_shards.size() + m_waterChunks.size());
+        m_telemetry.Push(r);
+    }
+
+    void CleanupInvalid()
+    {
+        SLOP_ZONE("CleanupInvalid");
+        // Stale index entries for removed ids fail BodyIndexById's id check.
+        for (size_t i = 0; i < m_bodies.size(); ++i)
+        {
+            if (!b2Body_IsValid(m_bodies[i].bodyId)) ForgetBodySlot(i);
+        }
+        m_bodies.EraseIf([](const BodyEntry& e) { return !b2Body_IsValid(e.bodyId); });
+        CompactJoints();
+    }
+
+    // Paused while recording or replaying, since the view is not part of a
+    // recording, and while the scene sits rewound.
+    // Regions would take bodies a background load still has to joint.
+    bool HibernationActive() const
+    {
+        return m_hibernation && !m_recorder.IsOpen() && !m_replay && m_rewind.AtHead() && !m_sceneLoader.Busy();
+    }
+
+    void UpdateHibernation()
+    {
+        if (!HibernationActive()) return;
+        SLOP_ZONE("UpdateHibernation");
+        WakeNearRegions();
+        if (--m_hibernateCountdown > 0) return;
+        m_hibernateCountdown = kHibernateCheckFrames;
+        HibernateFarRegions();
+    }
+
+    static Rectangle InflateRect(const Rectangle& r, float by) { return {r.x - by, r.y - by, r.width + 2.0f * by, r.height + 2.0f * by}; }
+
+    static bool AwakeNearCallback(b2ShapeId shapeId, void* context)
+    {
+        b2BodyId body = b2Shape_GetBody(shapeId);
+        if (b2Body_GetType(body) != b2_dynamicBody || !b2Body_IsAwake(body)) return true;
+        *static_cast<bool*>(context) = true;
+        return false;
+    }
+
+    bool AwakeBodyIn(const Rectangle& rectPx)
+    {
+        bool found = false;
+        b2AABB box{ToMeters({rectPx.x, rectPx.y}), ToMeters({rectPx.x + rectPx.width, rectPx.y + rectPx.height})};
+        b2World_OverlapAABB(m_worldId, box, b2DefaultQueryFilter(), &AwakeNearCallback, &found);
+        return found;
+    }
+
+    void WakeNearRegions()
+    {
+        Rectangle view = InflateRect(m_viewRect, kHibernateMarginPx);
+        for (size_t r = 0; r < m_hibernated.size();)
+        {
+            const Rectangle& bounds = m_hibernated[r].boundsPx;
+            if (RectsOverlap(view, bounds) || AwakeBodyIn(InflateRect(bounds, kHibernateMarginPx))) RestoreRegion(r);
+            else ++r;
+        }
+    }
+
+    void RestoreRegion(size_t r)
+    {
+        HibernatedRegion region = std::move(m_hibernated[r]);
+        m_hibernated.erase(m_hibernated.begin() + static_cast<std::ptrdiff_t>(r));
+        m_hibernatedBodies -= region.bodyCount;
+        SceneView view;
+        if (ParseSceneFile(region.image.data(), region.image.size(), view))
+        {
+            std::vector<b2BodyId> bodyIds;
+            AddSceneRecords(view, bodyIds, false);
+        }
+        // Its keyframes would bring back a world without these bodies.
+        m_rewind.Clear();
+    }
+
+    void RestoreAllRegions()
+    {
+        while (!m_hibernated.empty()) RestoreRegion(m_hibernated.size() - 1);
+    }
+
+    uint32_t RegionRoot(uint32_t r)
+    {
+        while (m_regionParent[r] != r) r = m_regionParent[r] = m_regionParent[m_regionParent[r]];
+        return r;
+    }
+
+    // Strips whose bodies touch or are jointed to each other's go together,
+    // so a pile across a border is one group. A body touching or jointed to
+    // one that stays blocks its strip: removing it would wake that body or cut
+    // the joint.
+    void LinkRegionBodies(uint32_t region, const std::vector<size_t>& members)
+    {
+        auto link = [this, region](std::optional<size_t> other) {
+            uint32_t r = other ? m_regionOfBody[*other] : UINT32_MAX;
+            if (r == UINT32_MAX)
+            {
+                m_regionBlocked[region] = 1;
+                return;
+            }
+            uint32_t a = RegionRoot(region);
+            uint32_t b = RegionRoot(r);
+            m_regionParent[std::max(a, b)] = std::min(a, b);
+        };
+        for (size_t idx : members)
+        {
+            uint64_t key = BodyKey(m_bodies[idx].bodyId);
+            for (SlotHandle jh : Cold(idx).joints)
+            {
+                const JointEntry* j = m_joints.Get(jh);
+                if (j) link(BodyIndexByKey(j->bodyA == key ? j->bodyB : j->bodyA));
+            }
+
+            b2BodyId body = m_bodies[idx].bodyId;
+            int cap = b2Body_GetContactCapacity(body);
+            if (cap <= 0) continue;
+            if (static_cast<int>(m_contactScratch.size()) < cap) m_contactScratch.resize(static_cast<size_t>(cap));
+            int count = b2Body_GetContactData(body, m_contactScratch.data(), cap);
+            for (int c = 0; c < count; ++c)
+            {
+                b2BodyId a = b2Shape_GetBody(m_contactScratch[c].shapeIdA);
+                b2BodyId other = B2_ID_EQUALS(a, body) ? b2Shape_GetBody(m_contactScratch[c].shapeIdB) : a;
+                if (b2Body_GetType(other) != b2_staticBody) link(BodyIndexById(other));
+            }
+        }
+    }
+
+    // Every kHibernateCheckFrames: sorts sleeping bodies into strips, blocks
+    // the strips near the view or near an awake or selected body (twice the
+    // restore margin, so a region does not flicker in and out), groups the
+    // strips that share contacts or joints, then images each group with no
+    // blocked strip and removes them all in one batch.
+    void HibernateFarRegions()
+    {
+        uint32_t regionCount = static_cast<uint32_t>(std::ceil(m_worldWidth / kHibernateRegionPx));
+        if (regionCount < 2) return;
+        if (m_regionMembers.size() < regionCount) m_regionMembers.resize(regionCount);
+        for (std::vector<size_t>& members : m_regionMembers) members.clear();
+        m_regionBlocked.assign(regionCount, 0);
+        m_regionParent.resize(regionCount);
+        for (uint32_t r = 0; r < regionCount; ++r) m_regionParent[r] = r;
+        m_regionOfBody.assign(m_bodies.size(), UINT32_MAX);
+        auto regionOf = [regionCount](float xPx) {
+            return static_cast<uint32_t>(std::clamp(std::floor(xPx / kHibernateRegionPx), 0.0f, static_cast<float>(regionCount - 1)));
+        };
+        const float keepOut = 2.0f * kHibernateMarginPx;
+        auto block = [&](float x0, float x1) {
+            for (uint32_t r = regionOf(x0 - keepOut), last = regionOf(x1 + keepOut); r <= last; ++r) m_regionBlocked[r] = 1;
+        };
+        block(m_viewRect.x, m_viewRect.x + m_viewRect.width);
+
+        for (size_t i = 0; i < m_bodies.size(); ++i)
+        {
+            const BodyEntry& e = m_bodies[i];
+            if (!IsValid(e.bodyId)) continue;
+            if (e.Has(kFeatureSelected) || b2Body_IsAwake(e.bodyId))
+            {
+                b2AABB box = b2Body_ComputeAABB(e.bodyId);
+                block(box.lowerBound.x * kPixelsPerMeter, box.upperBound.x * kPixelsPerMeter);
+                continue;
+            }
+            uint32_t r = regionOf(b2Body_GetPosition(e.bodyId).x * kPixelsPerMeter);
+            m_regionOfBody[i] = r;
+            m_regionMembers[r].push_back(i);
+        }
+        for (uint32_t r = 0; r < regionCount; ++r)
+        {
+            if (!m_regionBlocked[r]) LinkRegionBodies(r, m_regionMembers[r]);
+        }
+        // A group goes only if none of its strips is blocked.
+        for (uint32_t r = 0; r < regionCount; ++r)
+        {
+            if (m_regionBlocked[r]) m_regionBlocked[RegionRoot(r)] = 1;
+        }
+
+        std::vector<size_t> doomed;
+        std::vector<size_t> group;
+        for (uint32_t root = 0; root < regionCount; ++root)
+        {
+            if (RegionRoot(root) != root || m_regionBlocked[root]) continue;
+            group.clear();
+            for (uint32_t r = root; r < regionCount; ++r)
+            {
+                if (RegionRoot(r) == root) group.insert(group.end(), m_regionMembers[r].begin(), m_regionMembers[r].end());
+            }
+            if (group.size() < kHibernateMinBodies) continue;
+            std::sort(group.begin(), group.end());
+
+            HibernatedRegion region;
+            region.bodyCount = group.size();
+            BuildSceneImage(region.image, nullptr, &group);
+            b2AABB bounds = b2Body_ComputeAABB(m_bodies[group[0]].bodyId);
+            for (size_t idx : group) bounds = b2AABB_Union(bounds, b2Body_ComputeAABB(m_bodies[idx].bodyId));
+            region.boundsPx = NormalizeRect(ToPixels(bounds.lowerBound), ToPixels(bounds.upperBound));
+            m_hibernatedBodies += region.bodyCount;
+            m_hibernated.push_back(std::move(region));
+            doomed.insert(doomed.end(), group.begin(), group.end());
+        }
+        if (doomed.empty()) return;
+        DeleteBodies(doomed);
+        m_rewind.Clear();
+    }
+
+    // Fixed steps plus the per-frame particle and cleanup passes. Runs on
+    // whichever thread owns the world.
+    void SimulateFrame(float dt, int maxSteps)
+    {
+        SLOP_ZONE("SimulateFrame");
+        UpdateSimulation(dt, maxSteps);
+        if (m_recorder.IsOpen()) m_recorder.WriteStep(dt, m_stepLogCap, m_stepLog, m_stepLogCount);
+        if (m_recorder.WritesStateHashes()) m_recorder.WriteHashes(m_frameHashes, m_stateHashing ? m_frameHashCount : 0);
+        {
+            FrameProfiler::Scope scope(m_profiler, ProfileStage::Particles);
+            RunDeferredWork();
+            BuildParticleGrids();
+            UpdateShards(dt);
+            UpdateWaterChunks(dt);
+        }
+        {
+            FrameProfiler::Scope scope(m_profiler, ProfileStage::Cleanup);
+            CleanupInvalid();
+            UpdateHibernation();
+        }
+        ExportTransforms();
+        UpdateRestState(dt);
+    }
+
+    // Brings the export's back copy up to date and publishes it. That copy
+    // was last written two exports ago, so new, reordered or re-flagged rows
+    // are written in full and the rest only get the transforms of bodies moved
+    // since then: this frame's move events and the previous frame's. All of it
+    // comes from the cached move-event transforms, never from Box2D.
+    void ExportTransforms()
+    {
+        if (!m_transformExport.Enabled()) return;
+        uint32_t rows = m_transformExport.Begin(m_bodies.size(), ++m_exportSerial);
+        auto exportTransform = [this](uint32_t row, const b2Transform& xf) {
+            Vector2 p = ToPixels(xf.p);
+            m_transformExport.SetTransform(row, p.x, p.y, xf.q.c, xf.q.s);
+        };
+        for (uint32_t i = 0; i < rows; ++i)
+        {
+            const BodyEntry& e = m_bodies[i];
+            uint32_t slot = m_bodies.SlotIndexAt(i);
+            uint64_t key = BodyKey(e.bodyId);
+            uint8_t flags = static_cast<uint8_t>((e.features & kExportFeatureMask) | (m_restingSet.Test(slot) ? 0 : kExportAwake));
+            if (m_transformExport.Matches(i, key, flags)) continue;
+            m_transformExport.SetIdentity(i, key, static_cast<uint8_t>(e.kind), e.shape, e.radiusPx, flags);
+            exportTransform(i, m_bodyCold[slot].xf);
+        }
+        for (const std::vector<uint32_t>* moved : {&m_exportMovedPrev, &m_exportMoved})
+        {
+            for (uint32_t slot : *moved)
+            {
+                auto idx = m_bodies.DenseIndexOfSlot(slot);
+                if (idx && *idx < rows) exportTransform(static_cast<uint32_t>(*idx), m_bodyCold[slot].xf);
+            }
+        }
+        m_transformExport.Publish();
+        std::swap(m_exportMovedPrev, m_exportMoved);
+        m_exportMoved.clear();
+    }
+
+    // Simulation side, after every frame: whether stopping the steps would
+    // change anything on screen. Paused worlds only need their particles gone.
+    void UpdateRestState(float dt)
+    {
+        if (!m_shards.empty() || !m_waterChunks.empty()) m_particleQuietS = 0.0f;
+        else m_particleQuietS = std::min(m_particleQuietS + dt, kIdleParticleLingerS);
+        bool still = m_paused || (b2World_GetAwakeBodyCount(m_worldId) == 0 && WaterAtRest());
+        bool rest = still && m_particleQuietS >= kIdleParticleLingerS && m_deferred.Size() == 0 && !SceneLoading() &&
+                    !m_scenario.Active() && !m_recorder.IsOpen() && !m_fastForward;
+        m_sceneAtRest.store(rest, std::memory_order_relaxed);
+    }
+
+    bool WaterAtRest() const
+    {
+        if (!InWater()) return true;
+        const std::vector<float>& speed = m_sceneLocation == SceneLocation::Shallow ? m_shallow.Velocities() : m_waveVel;
+        for (float v : speed)
+        {
+            if (std::fabs(v) > kIdleWaveSpeedPx) return false;
+        }
+        return true;
+    }
+
+    void StartPhysicsThread()
+    {
+        if (m_physicsThread.joinable()) return;
+        m_physicsStop.store(false, std::memory_order_relaxed);
+        m_physicsThread = std::thread([this]() { PhysicsThreadMain(); });
+    }
+
+    void StopPhysicsThread()
+    {
+        if (!m_physicsThread.joinable()) return;
+        m_physicsStop.store(true, std::memory_order_relaxed);
+        m_physicsThread.join();
+    }
+
+    // Ticks at kFixedDt independent of the render rate and publishes a snapshot per tick.
+    void PhysicsThreadMain()
+    {
+        SLOP_TRACE_THREAD("physics");
+        using Clock = std::chrono::steady_clock;
+        const auto tick = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(kFixedDt));
+        auto last = Clock::now();
+        auto next = last + tick;
+        while (!m_physicsStop.load(std::memory_order_relaxed))
+        {
+            if (!m_fastForward) std::this_thread::sleep_until(next);
+            auto now = Clock::now();
+            if (m_physicsIdle.load(std::memory_order_relaxed))
+            {
+                // Parked by idle rendering; the time it sleeps is not simulated.
+                last = now;
+                next = now + tick;
+                continue;
+            }
+            float elapsed = std::chrono::duration<float>(now - last).count();
+            last = now;
+            {
+                std::lock_guard<std::mutex> lock(m_worldMutex);
+                SimulateFrame(elapsed, kMaxCatchUpSteps);
+                PublishSnapshot();
+            }
+            next += tick;
+            if (next < now) next = now + tick;
+        }
+    }
+
+    // Called with the world owned by the calling thread. A compound adds an
+    // entry per part under its own key, so interpolation pairs them in order.
+    void AppendSnapshotBodies(std::vector<SnapshotBody>& out, size_t idx, const b2Transform& xf) const
+    {
+        const BodyEntry& e = m_bodies[idx];
+        SnapshotBody b;
+        b.key = BodyKey(e.bodyId);
+        b.xf = xf;
+        b.kind = e.kind;
+        b.radiusPx = e.radiusPx;
+        b.fill = MixedFeatureColor(e);
+        b.selected = e.Has(kFeatureSelected);
+        b.isWheel = e.Has(kFeatureWheel);
+        b.shape = e.shape;
+        if (e.kind != BodyKind::Compound)
+        {
+            out.push_back(b);
+            return;
+        }
+        for (const RigidPart& p : Cold(idx).parts)
+        {
+            b.xf = b2MulTransforms(xf, p.local);
+            b.kind = p.kind;
+            b.radiusPx = p.radiusPx;
+            b.fill = MixedFeatureColor(p.features);
+            b.isWheel = (p.features & kFeatureWheel) != 0;
+            b.shape = p.shape;
+            out.push_back(b);
+        }
+    }
+
+    struct CullQuery
+    {
+        const SandboxCore* self = nullptr;
+        std::vector<size_t>* out = nullptr;
+    };
+
+    static bool CullCallback(b2ShapeId shapeId, void* context)
+    {
+        CullQuery& q = *static_cast<CullQuery*>(context);
+        if (auto idx = q.self->BodyIndexById(b2Shape_GetBody(shapeId))) q.out->push_back(*idx);
+        return true;
+    }
+
+    // Dense indices of the bodies whose shapes overlap rect, from the broad
+    // phase, in spawn order.
+    void BodiesInRect(const Rectangle& rect, std::vector<size_t>& out) const
+    {
+        out.clear();
+        CullQuery q;
+        q.self = this;
+        q.out = &out;
+        b2AABB box{ToMeters({rect.x, rect.y}), ToMeters({rect.x + rect.width, rect.y + rect.height})};
+        b2World_OverlapAABB(m_worldId, box, b2DefaultQueryFilter(), &CullCallback, &q);
+        // Orders are unique per body, so a body's repeats sort next to each other.
+        std::sort(out.begin(), out.end(), [this](size_t a, size_t b) { return Cold(a).order < Cold(b).order; });
+        out.erase(std::unique(out.begin(), out.end()), out.end());
+    }
+
+    void CompactDrawOrder()
+    {
+        if (m_drawOrder.size() == m_bodies.size()) return;
+        m_drawOrder.erase(std::remove_if(m_drawOrder.begin(), m_drawOrder.end(), [this](SlotHandle h) { return !m_bodies.Contains(h); }),
+                          m_drawOrder.end());
+    }
+
+    // Once the view no longer shows the whole world, only what it shows is
+    // published: awake bodies from a broad-phase query of m_viewRect, and
+    // resting ones from a query of m_restingBounds, twice the view each way,
+    // which is only redone when the view leaves it (or shrinks well inside).
+    void PublishSnapshot()
+    {
+        RenderSnapshot& snap = m_snapshots.WriteBuffer();
+        snap.wallTime = std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+        snap.bodies.clear();
+        snap.debrisShapes.clear();
+        if (snap.shapes.size() < m_shapes.size()) snap.shapes.insert(snap.shapes.end(), m_shapes.data() + snap.shapes.size(), m_shapes.data() + m_shapes.size());
+        const Rectangle view = m_viewRect;
+        bool cull = !RectContains(view, WorldBounds());
+        if (!cull)
+        {
+            if (m_restingCulled) ++m_restingVersion;
+            m_restingCulled = false;
+        }
+        else if (!m_restingCulled || !RectContains(m_restingBounds, view) || m_restingBounds.width > 4.0f * view.width)
+        {
+            m_restingBounds = {view.x - 0.5f * view.width, view.y - 0.5f * view.height, 2.0f * view.width, 2.0f * view.height};
+            m_restingCulled = true;
+            ++m_restingVersion;
+        }
+
+        if (cull)
+        {
+            BodiesInRect(view, m_cullScratch);
+            snap.bodies.reserve(m_cullScratch.size() + m_debris.ActiveCount());
+            for (size_t i : m_cullScratch)
+            {
+                if (m_restingSet.Test(m_bodies.SlotIndexAt(i))) continue;
+                AppendSnapshotBodies(snap.bodies, i, b2Body_GetTransform(m_bodies[i].bodyId));
+            }
+        }
+        else
+        {
+            CompactDrawOrder();
+            snap.bodies.reserve(m_bodies.size() - m_restingSet.Count() + m_debris.ActiveCount());
+            for (SlotHandle h : m_drawOrder)
+            {
+                size_t i = *m_bodies.DenseIndex(h);
+                const BodyEntry& e = m_bodies[i];
+                if (m_restingSet.Test(h.index) || !b2Body_IsValid(e.bodyId)) continue;
+                AppendSnapshotBodies(snap.bodies, i, b2Body_GetTransform(e.bodyId));
+            }
+        }
+        if (snap.restingVersion != m_restingVersion)
+        {
+            snap.resting.clear();
+            if (cull)
+            {
+                BodiesInRect(m_restingBounds, m_cullScratch);
+                for (size_t i : m_cullScratch)
+                {
+                    uint32_t slot = m_bodies.SlotIndexAt(i);
+                    if (m_restingSet.Test(slot)) AppendSnapshotBodies(snap.resting, i, m_bodyCold[slot].xf);
+                }
+            }
+            else
+            {
+                snap.resting.reserve(m_restingSet.Count());
+                for (SlotHandle h : m_drawOrder)
+                {
+                    if (!m_restingSet.Test(h.index)) continue;
+                    size_t i = *m_bodies.DenseIndex(h);
+                    if (b2Body_IsValid(m_bodies[i].bodyId)) AppendSnapshotBodies(snap.resting, i, m_bodyCold[h.index].xf);
+                }
+            }
+            snap.restingVersion = m_restingVersion;
+        }
+        m_debris.ForEachActive([&snap, &view, cull](const DebrisPool::Piece& p) {
+            b2Transform xf = b2Body_GetTransform(p.bodyId);
+            if (cull && !PointInRect(ToPixels(xf.p), view)) return;
+            SnapshotBody b;
+            b.key = kDebrisSnapshotKey | uint64_t{p.serial} << 32 | static_cast<uint32_t>(p.bodyId.index1);
+            b.xf = xf;
+            b.kind = BodyKind::Polygon;
+            b.fill = p.fill;
+            b.fill.a = static_cast<unsigned char>(b.fill.a * p.Alpha());
+            ShapeGeometry g;
+            g.count = static_cast<uint32_t>(p.polygon.count);
+            for (int i = 0; i < p.polygon.count; ++i) g.verts[i] = ToPixels(p.polygon.vertices[i]);
+            b.isDebris = true;
+            b.shape = static_cast<ShapeTable::Id>(snap.debrisShapes.size());
+            snap.debrisShapes.push_back(g);
+            snap.bodies.push_back(b);
+        });
+        if (m_gpuEffects)
+        {
+            m_gpuSpawns.Post(kShardLane, m_shards);
+            m_gpuSpawns.Post(kSprayLane, m_waterChunks);
+            m_shards.Consume();
+            m_waterChunks.Consume();
+        }
+        else if (cull)
+        {
+            m_shards.CopyTo(snap.shards, view.x, view.y, view.x + view.width, view.y + view.height);
+            m_waterChunks.CopyTo(snap.waterChunks, view.x, view.y, view.x + view.width, view.y + view.height);
+        }
+        else
+        {
+            m_shards.CopyTo(snap.shards);
+            m_waterChunks.CopyTo(snap.waterChunks);
+        }
+        snap.waveDisp.assign(m_waveDisp.begin(), m_waveDisp.end());
+        snap.worldWidth = m_worldWidth;
+        snap.pendingWeldValid = m_bodies.Contains(m_pendingWeldBody);
+        snap.selecting = m_selecting;
+        snap.rewindBytes = m_rewind.Bytes();
+        snap.adhesions = m_adhesion.ActiveCount();
+        snap.adhesionsQueued = m_adhesion.PendingCount();
+        snap.hibernatedBodies = m_hibernatedBodies;
+        snap.hibernatedRegions = m_hibernated.size();
+        snap.hibernatedBytes = 0;
+        for (const HibernatedRegion& r : m_hibernated) snap.hibernatedBytes += r.image.size();
+        snap.hibernation = m_hibernation;
+        snap.deferred = m_deferred.LastStats();
+        snap.sceneLoad = SceneLoadProgress();
+        snap.inputSerial = m_appliedInputSerial;
+        snap.fastForward = m_fastForward;
+        snap.fastForwardS = static_cast<float>(m_fastForwardDone) * kFixedDt;
+        snap.rewindBehindS = 0.0f;
+        snap.rewindSpanS = 0.0f;
+        if (!m_rewind.Empty())
+        {
+            uint64_t head = m_rewind.StepAt(m_rewind.FrameCount() - 1);
+            snap.rewindBehindS = static_cast<float>(head - m_rewind.StepAt(m_rewind.Cursor())) * kFixedDt;
+            snap.rewindSpanS = static_cast<float>(head - m_rewind.StepAt(0)) * kFixedDt;
+        }
+        snap.selectionRect = m_selectionRect;
+        snap.workerCount = m_scheduler->WorkerCount();
+        snap.subSteps = m_stepController.SubSteps();
+        snap.catchUpSteps = m_stepController.CatchUpSteps();
+        snap.stepBudgetMs = m_stepController.BudgetMs();
+        snap.stepDecision = m_stepController.LastDecision();
+        snap.bulletBudget = m_bulletBudget;
+        const box2d_heap::Heap& b2Heap = box2d_heap::Heap::Instance();
+        m_b2AllocRate.Sample(snap.wallTime);
+        snap.b2HeapTotal = b2Heap.Total();
+        snap.b2HeapPooledBytes = b2Heap.PooledBytes();
+        for (size_t s = 0; s < snap.b2HeapSubsystems.size(); ++s)
+        {
+            snap.b2HeapSubsystems[s] = b2Heap.SubsystemStats(static_cast<box2d_heap::Subsystem>(s));
+            snap.b2AllocsPerSecond[s] = m_b2AllocRate.PerSecond(static_cast<box2d_heap::Subsystem>(s));
+        }
+        m_snapshots.Publish();
+    }
+
+    Color MixedFeatureColor(const BodyEntry& b) const { return MixedFeatureColor(b.features); }
+
+    Color MixedFeatureColor(uint8_t features) const
+    {
+        float r = 0.0f, g = 0.0f, bl = 0.0f;
+        float c = 0.0f;
+
+        if (features & kFeatureBouncy) { r += 0.25f; g += 0.95f; bl += 0.45f; c += 1.0f; }
+        if (features & kFeatureSlippery) { r += 0.2f; g += 0.75f; bl += 1.0f; c += 1.0f; }
+        if (features & kFeatureSticky) { r += 1.0f; g += 0.85f; bl += 0.2f; c += 1.0f; }
+        if (features & kFeatureGlass)
+        {
+            if (m_theme == Theme::Dark) { r += 1.0f; g += 1.0f; bl += 1.0f; }
+            else { r += 0.0f; g += 0.0f; bl += 0.0f; }
+            c += 1.0f;
+        }
+
+        if (c <= 0.0f)
+        {
+            return WithAlpha(AccentColor(), (m_theme == Theme::Dark) ? 0.08f : 0.06f);
+        }
+
+        float a = std::min(0.33f, 0.16f + 0.05f * (c - 1.0f));
+        return Color{
+            static_cast<unsigned char>((r / c) * 255.0f),
+            static_cast<unsigned char>((g / c) * 255.0f),
+            static_cast<unsigned char>((bl / c) * 255.0f),
+            static_cast<unsigned char>(a * 255.0f)};
+    }
+};
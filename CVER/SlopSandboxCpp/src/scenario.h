@@ -0,0 +1,584 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// Scenario scripts: reproducible load tests and demos as a plain text list of
+// actions and waits, run by the sandbox at the start of each fixed step.
+//   # 2k boxes into the water, then blast the glass tower at t = 5 s
+//   location water
+//   grid box center water-400 50 40
+//   column 1200 10
+//   feature glass
+//   at 5
+//   tool blast 1200 ground-300
+//   mark
+//   wait 300
+//   assert step_ms < 4
+// One command per line, '#' starts a comment. Positions are world px; x may
+// be written center[+-N], y ground[+-N] or water[+-N]. The last spawn, grid,
+// rain or column is "the group" that feature and push act on.
+//
+//   location water|land|shallow       spawn SHAPE X Y
+//   grid SHAPE X Y COLS ROWS          rain SHAPE X
+//   column X HEIGHT                   welded boxes standing on the ground
+//   feature glass|bouncy|slippery|sticky [on|off]
+//   push VX VY                        m/s added to every body of the group
+//   explode X Y RADIUS [IMPULSE]      IMPULSE per meter of outline, default 9
+//   tool weld|wheel|bounce|slip|sticky|glass|blast X Y
+//   kick X    reset    break FORCE [TORQUE]   joint limits for later welds
+//   wait STEPS    at SECONDS    settle [MAX_SECONDS]
+//   repeat N ... end    mark    print TEXT
+//   assert METRIC <|<=|>|>= VALUE
+// Metrics: steps and time since the start, bodies, awake, settled (0 or 1),
+// glass_breaks and joint_breaks since the start, and step_ms / max_step_ms
+// over the physics steps since the last mark.
+//
+// A scenario drives the world directly, so it is not in recordings; record
+// the input of a run without one.
+namespace scenario
+{
+
+enum class OpCode : uint8_t
+{
+    // Actions: carried out by the host.
+    Location,
+    Spawn,
+    Grid,
+    Rain,
+    Column,
+    Feature,
+    Push,
+    Explode,
+    Tool,
+    Kick,
+    Reset,
+    BreakLimits,
+    // Control: handled by the Runner.
+    Wait,
+    At,
+    Settle,
+    Repeat,
+    End,
+    Mark,
+    Assert,
+    Print
+};
+
+enum class Metric : uint8_t
+{
+    Steps,
+    Time,
+    Bodies,
+    Awake,
+    Settled,
+    GlassBreaks,
+    JointBreaks,
+    StepMs,
+    MaxStepMs
+};
+
+enum class Compare : uint8_t
+{
+    Less,
+    LessEqual,
+    Greater,
+    GreaterEqual
+};
+
+// Name tables in the sandbox's enum order: SpawnShape, SceneLocation and Tool.
+// Features are named by the body bit and map onto their tool.
+constexpr const char* kShapeNames[] = {"box", "circle", "triangle"};
+constexpr const char* kLocationNames[] = {"water", "land", "shallow"};
+constexpr const char* kToolNames[] = {"cursor", "weld", "wheel", "bounce", "slip", "sticky", "glass", "blast"};
+constexpr const char* kFeatureNames[] = {"bouncy", "slippery", "sticky", "glass"};
+constexpr uint8_t kFeatureTools[] = {3, 4, 5, 6};
+constexpr const char* kMetricNames[] = {"steps", "time", "bodies", "awake", "settled", "glass_breaks", "joint_breaks", "step_ms", "max_step_ms"};
+
+enum class Anchor : uint8_t
+{
+    None,
+    Center, // half the world width
+    Ground, // top of the ground
+    Water   // water rest line
+};
+
+struct Coord
+{
+    Anchor anchor = Anchor::None;
+    float offset = 0.0f;
+};
+
+struct Op
+{
+    OpCode code = OpCode::Wait;
+    uint8_t kind = 0; // index into the name table of the op's first word
+    bool flag = false; // feature: on; break: torque given
+    Metric metric = Metric::Steps;
+    Compare compare = Compare::Less;
+    int count = 0;  // steps, cols, height or repeats
+    int count2 = 0; // rows; repeat: index of its end
+    Coord x;
+    Coord y;
+    float value = 0.0f;
+    float value2 = 0.0f;
+    uint32_t line = 0;
+    std::string text; // print text, or the assert as written
+};
+
+struct Failure
+{
+    uint32_t line = 0;
+    std::string text;
+    double actual = 0.0;
+};
+
+class Runner
+{
+public:
+    explicit Runner(float stepSeconds) : m_stepSeconds(stepSeconds) {}
+
+    // Replaces the program; on a syntax error keeps none and Error() says where.
+    bool Load(const char* path)
+    {
+        Clear();
+        std::string text;
+        std::FILE* f = path ? std::fopen(path, "rb") : nullptr;
+        if (!f)
+        {
+            Fail(0, std::string("cannot open ") + (path ? path : "(null)"));
+            return false;
+        }
+        char buf[4096];
+        for (size_t n; (n = std::fread(buf, 1, sizeof(buf), f)) > 0;) text.append(buf, n);
+        std::fclose(f);
+        return Parse(text);
+    }
+
+    bool Parse(const std::string& text)
+    {
+        Clear();
+        std::vector<size_t> open;
+        uint32_t line = 0;
+        for (size_t start = 0; start <= text.size();)
+        {
+            size_t end = text.find('\n', start);
+            if (end == std::string::npos) end = text.size();
+            ++line;
+            std::string source = text.substr(start, end - start);
+            start = end + 1;
+            size_t hash = source.find('#');
+            if (hash != std::string::npos) source.resize(hash);
+            std::vector<std::string> words = Split(source);
+            if (words.empty()) continue;
+
+            Op op;
+            op.line = line;
+            if (!ParseOp(words, source, op))
+            {
+                std::string why = m_error.empty() ? "cannot read '" + Trim(source) + "'" : m_error;
+                Clear();
+                Fail(line, why);
+                return false;
+            }
+            if (op.code == OpCode::Repeat) open.push_back(m_program.size());
+            if (op.code == OpCode::End)
+            {
+                if (open.empty())
+                {
+                    Clear();
+                    Fail(line, "end without repeat");
+                    return false;
+                }
+                m_program[open.back()].count2 = static_cast<int>(m_program.size());
+                op.count2 = static_cast<int>(open.back());
+                open.pop_back();
+            }
+            m_program.push_back(std::move(op));
+        }
+        if (!open.empty())
+        {
+            uint32_t at = m_program[open.back()].line;
+            Clear();
+            Fail(at, "repeat without end");
+            return false;
+        }
+        m_loaded = true;
+        return true;
+    }
+
+    void Clear()
+    {
+        m_program.clear();
+        m_loops.clear();
+        m_failures.clear();
+        m_log.clear();
+        m_error.clear();
+        m_pc = 0;
+        m_step = 0;
+        m_waitUntil = 0;
+        m_settleUntil = 0;
+        m_settling = false;
+        m_passed = 0;
+        m_loaded = false;
+        Mark();
+    }
+
+    bool Active() const { return m_loaded && m_pc < m_program.size(); }
+    bool Finished() const { return m_loaded && m_pc >= m_program.size(); }
+
+    // The physics time of each step since Step ran, for step_ms.
+    void RecordStep(double ms)
+    {
+        m_markMs += ms;
+        m_markMax = std::max(m_markMax, ms);
+        ++m_markSteps;
+    }
+
+    // Runs the program up to its next wait. exec(const Op&) carries out
+    // actions; probe(Metric) reads the world for asserts and settle. While
+    // waiting this is a compare and a return.
+    template <typename Exec, typename Probe>
+    void Step(Exec&& exec, Probe&& probe)
+    {
+        ++m_step;
+        if (m_step < m_waitUntil) return;
+        if (m_settling)
+        {
+            if (m_step < m_settleUntil && probe(Metric::Settled) == 0.0) return;
+            if (m_step >= m_settleUntil) Log(m_program[m_pc].line, "settle timed out");
+            m_settling = false;
+            ++m_pc;
+        }
+        while (m_pc < m_program.size())
+        {
+            const Op& op = m_program[m_pc];
+            switch (op.code)
+            {
+                case OpCode::Wait:
+                    ++m_pc;
+                    m_waitUntil = m_step + static_cast<uint64_t>(op.count);
+                    return;
+                case OpCode::At:
+                {
+                    ++m_pc;
+                    auto target = static_cast<uint64_t>(std::ceil(op.value / m_stepSeconds - 1e-4f));
+                    if (target > m_step)
+                    {
+                        m_waitUntil = target;
+                        return;
+                    }
+                    continue;
+                }
+                case OpCode::Settle:
+                    if (probe(Metric::Settled) != 0.0) break;
+                    m_settling = true;
+                    m_settleUntil = m_step + static_cast<uint64_t>(std::ceil(op.value / m_stepSeconds));
+                    return;
+                case OpCode::Repeat:
+                    if (op.count <= 0)
+                    {
+                        m_pc = static_cast<size_t>(op.count2) + 1;
+                        continue;
+                    }
+                    m_loops.push_back({m_pc, op.count});
+                    break;
+                case OpCode::End:
+                    if (!m_loops.empty() && --m_loops.back().left > 0)
+                    {
+                        m_pc = m_loops.back().start + 1;
+                        continue;
+                    }
+                    if (!m_loops.empty()) m_loops.pop_back();
+                    break;
+                case OpCode::Mark: Mark(); break;
+                case OpCode::Assert:
+                {
+                    double v = Value(op.metric, probe);
+                    if (Holds(v, op.compare, op.value)) ++m_passed;
+                    else m_failures.push_back({op.line, op.text, v});
+                    break;
+                }
+                case OpCode::Print: Log(op.line, op.text); break;
+                default: exec(op); break;
+            }
+            ++m_pc;
+        }
+    }
+
+    // Steps since the start; time is this times the step length.
+    uint64_t StepCount() const { return m_step; }
+    size_t AssertsPassed() const { return m_passed; }
+    const std::vector<Failure>& Failures() const { return m_failures; }
+    // print output and notes such as timed out settles, in order.
+    const std::vector<std::string>& LogLines() const { return m_log; }
+    const std::string& Error() const { return m_error; }
+
+private:
+    struct Loop
+    {
+        size_t start = 0;
+        int left = 0;
+    };
+
+    template <typename Probe>
+    double Value(Metric m, Probe& probe) const
+    {
+        switch (m)
+        {
+            case Metric::Steps: return static_cast<double>(m_step);
+            case Metric::Time: return static_cast<double>(m_step) * m_stepSeconds;
+            case Metric::StepMs: return m_markSteps ? m_markMs / static_cast<double>(m_markSteps) : 0.0;
+            case Metric::MaxStepMs: return m_markMax;
+            default: return probe(m);
+        }
+    }
+
+    static bool Holds(double v, Compare c, double limit)
+    {
+        switch (c)
+        {
+            case Compare::Less: return v < limit;
+            case Compare::LessEqual: return v <= limit;
+            case Compare::Greater: return v > limit;
+            case Compare::GreaterEqual: return v >= limit;
+        }
+        return false;
+    }
+
+    void Mark()
+    {
+        m_markMs = 0.0;
+        m_markMax = 0.0;
+        m_markSteps = 0;
+    }
+
+    void Log(uint32_t line, const std::string& text)
+    {
+        char prefix[48];
+        std::snprintf(prefix, sizeof(prefix), "%.2fs line %u: ", static_cast<double>(m_step) * m_stepSeconds, line);
+        m_log.push_back(prefix + text);
+    }
+
+    void Fail(uint32_t line, const std::string& text)
+    {
+        m_error = line ? "line " + std::to_string(line) + ": " + text : text;
+    }
+
+    static std::string Trim(const std::string& s)
+    {
+        size_t a = s.find_first_not_of(" \t\r");
+        size_t b = s.find_last_not_of(" \t\r");
+        return a == std::string::npos ? std::string() : s.substr(a, b - a + 1);
+    }
+
+    static std::vector<std::string> Split(const std::string& s)
+    {
+        std::vector<std::string> out;
+        for (size_t i = 0; i < s.size();)
+        {
+            i = s.find_first_not_of(" \t\r", i);
+            if (i == std::string::npos) break;
+            size_t j = s.find_first_of(" \t\r", i);
+            if (j == std::string::npos) j = s.size();
+            out.push_back(s.substr(i, j - i));
+            i = j;
+        }
+        return out;
+    }
+
+    template <size_t N>
+    static bool Name(const std::string& word, const char* const (&names)[N], uint8_t& out)
+    {
+        for (size_t i = 0; i < N; ++i)
+        {
+            if (word != names[i]) continue;
+            out = static_cast<uint8_t>(i);
+            return true;
+        }
+        return false;
+    }
+
+    static bool Number(const std::string& word, float& out)
+    {
+        char* end = nullptr;
+        out = std::strtof(word.c_str(), &end);
+        return !word.empty() && *end == '\0' && std::isfinite(out);
+    }
+
+    static bool Integer(const std::string& word, int& out)
+    {
+        float v = 0.0f;
+        if (!Number(word, v) || v != std::floor(v) || std::fabs(v) > 1e7f) return false;
+        out = static_cast<int>(v);
+        return true;
+    }
+
+    static bool Position(const std::string& word, Coord& out)
+    {
+        static const std::pair<const char*, Anchor> kAnchors[] = {{"center", Anchor::Center}, {"ground", Anchor::Ground}, {"water", Anchor::Water}};
+        out = Coord{};
+        std::string rest = word;
+        for (const auto& [name, anchor] : kAnchors)
+        {
+            size_t n = std::strlen(name);
+            if (word.compare(0, n, name) != 0) continue;
+            out.anchor = anchor;
+            rest = word.substr(n);
+            if (rest.empty()) return true;
+            if (rest[0] != '+' && rest[0] != '-') return false;
+            break;
+        }
+        return Number(rest, out.offset);
+    }
+
+    bool ParseOp(const std::vector<std::string>& w, const std::string& source, Op& op)
+    {
+        const std::string& cmd = w[0];
+        size_t n = w.size();
+        auto pos = [&](size_t i) { return i + 1 < n && Position(w[i], op.x) && Position(w[i + 1], op.y); };
+        if (cmd == "location")
+        {
+            op.code = OpCode::Location;
+            return n == 2 && Name(w[1], kLocationNames, op.kind);
+        }
+        if (cmd == "spawn")
+        {
+            op.code = OpCode::Spawn;
+            return n == 4 && Name(w[1], kShapeNames, op.kind) && pos(2);
+        }
+        if (cmd == "grid")
+        {
+            op.code = OpCode::Grid;
+            return n == 6 && Name(w[1], kShapeNames, op.kind) && pos(2) && Integer(w[4], op.count) && Integer(w[5], op.count2) &&
+                   op.count > 0 && op.count2 > 0;
+        }
+        if (cmd == "rain")
+        {
+            op.code = OpCode::Rain;
+            return n == 3 && Name(w[1], kShapeNames, op.kind) && Position(w[2], op.x);
+        }
+        if (cmd == "column")
+        {
+            op.code = OpCode::Column;
+            return n == 3 && Position(w[1], op.x) && Integer(w[2], op.count) && op.count > 0;
+        }
+        if (cmd == "feature")
+        {
+            op.code = OpCode::Feature;
+            uint8_t feature = 0;
+            if (n < 2 || n > 3 || !Name(w[1], kFeatureNames, feature)) return false;
+            op.kind = kFeatureTools[feature];
+            op.flag = n == 2 || w[2] == "on";
+            return n == 2 || w[2] == "on" || w[2] == "off";
+        }
+        if (cmd == "push")
+        {
+            op.code = OpCode::Push;
+            return n == 3 && Number(w[1], op.value) && Number(w[2], op.value2);
+        }
+        if (cmd == "explode")
+        {
+            op.code = OpCode::Explode;
+            op.value2 = 9.0f;
+            return (n == 4 || n == 5) && pos(1) && Number(w[3], op.value) && (n == 4 || Number(w[4], op.value2));
+        }
+        if (cmd == "tool")
+        {
+            op.code = OpCode::Tool;
+            return n == 4 && Name(w[1], kToolNames, op.kind) && op.kind != 0 && pos(2);
+        }
+        if (cmd == "kick")
+        {
+            op.code = OpCode::Kick;
+            return n == 2 && Position(w[1], op.x);
+        }
+        if (cmd == "reset")
+        {
+            op.code = OpCode::Reset;
+            return n == 1;
+        }
+        if (cmd == "break")
+        {
+            op.code = OpCode::BreakLimits;
+            op.flag = n == 3; // torque given
+            return (n == 2 || n == 3) && Number(w[1], op.value) && (n == 2 || Number(w[2], op.value2)) && op.value >= 0.0f && op.value2 >= 0.0f;
+        }
+        if (cmd == "wait")
+        {
+            op.code = OpCode::Wait;
+            return n == 2 && Integer(w[1], op.count) && op.count >= 0;
+        }
+        if (cmd == "at")
+        {
+            op.code = OpCode::At;
+            return n == 2 && Number(w[1], op.value) && op.value >= 0.0f;
+        }
+        if (cmd == "settle")
+        {
+            op.code = OpCode::Settle;
+            op.value = 30.0f;
+            return n <= 2 && (n == 1 || Number(w[1], op.value)) && op.value > 0.0f;
+        }
+        if (cmd == "repeat")
+        {
+            op.code = OpCode::Repeat;
+            return n == 2 && Integer(w[1], op.count);
+        }
+        if (cmd == "end")
+        {
+            op.code = OpCode::End;
+            return n == 1;
+        }
+        if (cmd == "mark")
+        {
+            op.code = OpCode::Mark;
+            return n == 1;
+        }
+        if (cmd == "print")
+        {
+            op.code = OpCode::Print;
+            op.text = Trim(Trim(source).substr(cmd.size()));
+            return true;
+        }
+        if (cmd == "assert")
+        {
+            op.code = OpCode::Assert;
+            op.text = Trim(source);
+            static const char* const kCompares[] = {"<", "<=", ">", ">="};
+            uint8_t metric = 0;
+            uint8_t compare = 0;
+            if (n != 4 || !Name(w[1], kMetricNames, metric) || !Name(w[2], kCompares, compare) || !Number(w[3], op.value)) return false;
+            op.metric = static_cast<Metric>(metric);
+            op.compare = static_cast<Compare>(compare);
+            return true;
+        }
+        m_error = "unknown command '" + cmd + "'";
+        return false;
+    }
+
+    float m_stepSeconds;
+    std::vector<Op> m_program;
+    std::vector<Loop> m_loops;
+    std::vector<Failure> m_failures;
+    std::vector<std::string> m_log;
+    std::string m_error;
+    size_t m_pc = 0;
+    uint64_t m_step = 0;
+    uint64_t m_waitUntil = 0;
+    uint64_t m_settleUntil = 0;
+    bool m_settling = false;
+    size_t m_passed = 0;
+    bool m_loaded = false;
+    double m_markMs = 0.0;
+    double m_markMax = 0.0;
+    uint64_t m_markSteps = 0;
+};
+
+} // namespace scenario
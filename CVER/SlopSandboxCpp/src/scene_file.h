@@ -0,0 +1,297 @@
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Versioned binary scene snapshot. Layout, all sections packed back to back:
+//   SceneFileHeader
+//   SceneBodyRecord[bodyCount]
+//   SceneJointRecord[jointCount]
+//   float[2 * vertCount]        local polygon vertices in px, indexed by body records
+//   float[waveSamples] x 2      wave displacement, then wave velocity (shallow
+//                               water: column depth, then face velocity)
+// Every record is a multiple of 4 bytes and only holds 32-bit fields, so the
+// loader reads straight out of the mapping. Native byte order.
+
+constexpr char kSceneFileMagic[8] = {'S', 'L', 'O', 'P', 'S', 'C', 'N', '\0'};
+constexpr uint32_t kSceneFileVersion = 1;
+constexpr uint32_t kSceneMaxPolygonVerts = 8;
+// Wave columns are allocated across the whole width, so a file cannot ask
+// for more than this.
+constexpr int32_t kSceneMaxWidthPx = 1 << 20;
+
+enum SceneBodyFlags : uint32_t
+{
+    kSceneBodyWheel = 1u << 0,
+    kSceneBodyBouncy = 1u << 1,
+    kSceneBodySlippery = 1u << 2,
+    kSceneBodySticky = 1u << 3,
+    kSceneBodyGlass = 1u << 4,
+    kSceneBodyAwake = 1u << 5
+};
+
+enum SceneJointFlags : uint32_t
+{
+    kSceneJointWheel = 1u << 0,
+    // Between two parts of one compound body: bodies joined by rigid joints
+    // are merged again on load.
+    kSceneJointRigid = 1u << 1
+};
+
+struct SceneFileHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t headerSize;
+    uint32_t bodyCount;
+    uint32_t jointCount;
+    uint32_t vertCount;
+    uint32_t waveSamples;
+    uint32_t sceneLocation;
+    int32_t width;
+    int32_t height;
+    uint32_t reserved;
+};
+
+struct SceneBodyRecord
+{
+    uint32_t kind;
+    uint32_t flags;
+    float radiusPx;
+    float density;
+    float glassStress;
+    int32_t glassGraceFrames;
+    uint32_t vertStart;
+    uint32_t vertCount;
+    float position[2]; // meters
+    float rotation[2]; // cos, sin
+    float linearVelocity[2];
+    float angularVelocity;
+};
+
+struct SceneJointRecord
+{
+    uint32_t bodyA; // index into the body records
+    uint32_t bodyB;
+    uint32_t flags; // SceneJointFlags
+    float frameA[4]; // px, py, cos, sin in body A's local space
+    float frameB[4];
+};
+
+static_assert(sizeof(SceneFileHeader) == 48, "scene header layout");
+static_assert(sizeof(SceneBodyRecord) == 60, "scene body record layout");
+static_assert(sizeof(SceneJointRecord) == 44, "scene joint record layout");
+
+// Pointers into a validated scene image. Valid as long as the backing bytes are.
+struct SceneView
+{
+    const SceneFileHeader* header = nullptr;
+    const SceneBodyRecord* bodies = nullptr;
+    const SceneJointRecord* joints = nullptr;
+    const float* verts = nullptr; // x, y pairs
+    const float* waveDisp = nullptr;
+    const float* waveVel = nullptr;
+};
+
+inline bool SceneFinite(const float* v, size_t count)
+{
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (!std::isfinite(v[i])) return false;
+    }
+    return true;
+}
+
+// A unit rotation as Box2D wants it; b2NormalizeRot cannot repair a zero one.
+inline bool SceneUnitRotation(const float* cs)
+{
+    return std::fabs(cs[0] * cs[0] + cs[1] * cs[1] - 1.0f) < 1e-3f;
+}
+
+// Outline vertices must span some area's worth of extent in both axes.
+inline bool SceneOutlineHasSize(const float* xy, uint32_t count)
+{
+    float minX = xy[0];
+    float maxX = xy[0];
+    float minY = xy[1];
+    float maxY = xy[1];
+    for (uint32_t k = 1; k < count; ++k)
+    {
+        minX = std::fmin(minX, xy[2 * k]);
+        maxX = std::fmax(maxX, xy[2 * k]);
+        minY = std::fmin(minY, xy[2 * k + 1]);
+        maxY = std::fmax(maxY, xy[2 * k + 1]);
+    }
+    return maxX - minX > 0.0f && maxY - minY > 0.0f;
+}
+
+// Checks magic, version and that every section and index lies inside the
+// image, then every value Box2D would be handed: finite floats, unit
+// rotations, non-negative density, a positive radius for circles (records
+// without vertices) and at least three vertices with some extent otherwise.
+inline bool ParseSceneFile(const uint8_t* data, size_t size, SceneView& out)
+{
+    if (!data || size < sizeof(SceneFileHeader)) return false;
+    const auto* h = reinterpret_cast<const SceneFileHeader*>(data);
+    if (std::memcmp(h->magic, kSceneFileMagic, sizeof(kSceneFileMagic)) != 0) return false;
+    if (h->version != kSceneFileVersion || h->headerSize != sizeof(SceneFileHeader)) return false;
+    if (h->width <= 0 || h->width > kSceneMaxWidthPx) return false;
+
+    uint64_t need = sizeof(SceneFileHeader);
+    need += uint64_t{h->bodyCount} * sizeof(SceneBodyRecord);
+    need += uint64_t{h->jointCount} * sizeof(SceneJointRecord);
+    need += uint64_t{h->vertCount} * 2 * sizeof(float);
+    need += uint64_t{h->waveSamples} * 2 * sizeof(float);
+    if (need != size) return false;
+
+    size_t offset = sizeof(SceneFileHeader);
+    out.header = h;
+    out.bodies = reinterpret_cast<const SceneBodyRecord*>(data + offset);
+    offset += size_t{h->bodyCount} * sizeof(SceneBodyRecord);
+    out.joints = reinterpret_cast<const SceneJointRecord*>(data + offset);
+    offset += size_t{h->jointCount} * sizeof(SceneJointRecord);
+    out.verts = reinterpret_cast<const float*>(data + offset);
+    offset += size_t{h->vertCount} * 2 * sizeof(float);
+    out.waveDisp = reinterpret_cast<const float*>(data + offset);
+    out.waveVel = out.waveDisp + h->waveSamples;
+
+    if (!SceneFinite(out.verts, size_t{h->vertCount} * 2) || !SceneFinite(out.waveDisp, size_t{h->waveSamples} * 2)) return false;
+    for (uint32_t i = 0; i < h->bodyCount; ++i)
+    {
+        const SceneBodyRecord& b = out.bodies[i];
+        if (b.vertCount > kSceneMaxPolygonVerts || uint64_t{b.vertStart} + b.vertCount > h->vertCount) return false;
+        const float values[] = {b.radiusPx, b.density, b.glassStress, b.position[0], b.position[1], b.rotation[0], b.rotation[1],
+                                b.linearVelocity[0], b.linearVelocity[1], b.angularVelocity};
+        if (!SceneFinite(values, sizeof(values) / sizeof(values[0])) || !SceneUnitRotation(b.rotation)) return false;
+        if (b.density < 0.0f || b.radiusPx < 0.0f) return false;
+        if (b.vertCount == 0 ? b.radiusPx <= 0.0f : b.vertCount < 3 || !SceneOutlineHasSize(out.verts + size_t{b.vertStart} * 2, b.vertCount))
+        {
+            return false;
+        }
+    }
+    for (uint32_t i = 0; i < h->jointCount; ++i)
+    {
+        const SceneJointRecord& j = out.joints[i];
+        if (j.bodyA >= h->bodyCount || j.bodyB >= h->bodyCount || j.bodyA == j.bodyB) return false;
+        if (!SceneFinite(j.frameA, 4) || !SceneFinite(j.frameB, 4)) return false;
+        if (!SceneUnitRotation(j.frameA + 2) || !SceneUnitRotation(j.frameB + 2)) return false;
+    }
+    return true;
+}
+
+// Appends one complete scene image (header included) to out.
+inline void AppendSceneImage(std::vector<uint8_t>& out, const SceneFileHeader& header,
+                             const std::vector<SceneBodyRecord>& bodies, const std::vector<SceneJointRecord>& joints,
+                             const std::vector<float>& verts, const std::vector<float>& waveDisp,
+                             const std::vector<float>& waveVel)
+{
+    auto put = [&out](const void* p, size_t bytes) {
+        const auto* b = static_cast<const uint8_t*>(p);
+        out.insert(out.end(), b, b + bytes);
+    };
+    put(&header, sizeof(header));
+    put(bodies.data(), bodies.size() * sizeof(SceneBodyRecord));
+    put(joints.data(), joints.size() * sizeof(SceneJointRecord));
+    put(verts.data(), verts.size() * sizeof(float));
+    put(waveDisp.data(), waveDisp.size() * sizeof(float));
+    put(waveVel.data(), waveVel.size() * sizeof(float));
+}
+
+// Writes to path.tmp and renames over path, so a failed save leaves the old file intact.
+inline bool WriteFileAtomic(const std::string& path, const std::vector<uint8_t>& bytes)
+{
+    std::string tmp = path + ".tmp";
+    FILE* f = std::fopen(tmp.c_str(), "wb");
+    if (!f) return false;
+    bool ok = bytes.empty() || std::fwrite(bytes.data(), 1, bytes.size(), f) == bytes.size();
+    ok = (std::fclose(f) == 0) && ok;
+    if (!ok)
+    {
+        std::remove(tmp.c_str());
+        return false;
+    }
+#if defined(_WIN32)
+    std::remove(path.c_str());
+#endif
+    return std::rename(tmp.c_str(), path.c_str()) == 0;
+}
+
+// Read-only view of a whole file: mmap on POSIX, a plain read elsewhere
+// (windows.h clashes with raylib names).
+class MappedFile
+{
+public:
+    MappedFile() = default;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    ~MappedFile() { Close(); }
+
+    bool Open(const char* path)
+    {
+        Close();
+#if defined(_WIN32)
+        FILE* f = std::fopen(path, "rb");
+        if (!f) return false;
+        std::fseek(f, 0, SEEK_END);
+        long len = std::ftell(f);
+        std::fseek(f, 0, SEEK_SET);
+        if (len > 0)
+        {
+            m_buffer.resize(static_cast<size_t>(len));
+            if (std::fread(m_buffer.data(), 1, m_buffer.size(), f) != m_buffer.size()) m_buffer.clear();
+        }
+        std::fclose(f);
+        m_data = m_buffer.data();
+        m_size = m_buffer.size();
+        return m_size > 0;
+#else
+        int fd = ::open(path, O_RDONLY);
+        if (fd < 0) return false;
+        struct stat st{};
+        if (::fstat(fd, &st) != 0 || st.st_size <= 0)
+        {
+            ::close(fd);
+            return false;
+        }
+        void* p = ::mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (p == MAP_FAILED) return false;
+        m_data = static_cast<const uint8_t*>(p);
+        m_size = static_cast<size_t>(st.st_size);
+        return true;
+#endif
+    }
+
+    void Close()
+    {
+#if defined(_WIN32)
+        m_buffer.clear();
+#else
+        if (m_data) ::munmap(const_cast<uint8_t*>(m_data), m_size);
+#endif
+        m_data = nullptr;
+        m_size = 0;
+    }
+
+    const uint8_t* Data() const { return m_data; }
+    size_t Size() const { return m_size; }
+
+private:
+    const uint8_t* m_data = nullptr;
+    size_t m_size = 0;
+#if defined(_WIN32)
+    std::vector<uint8_t> m_buffer;
+#endif
+};
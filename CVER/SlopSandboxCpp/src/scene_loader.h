@@ -0,0 +1,126 @@
+#pragma once
+
+#include "scene_file.h"
+#include "trace_zones.h"
+
+#include <box2d/box2d.h>
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+// One scene body record as Box2D definitions, hull included, so adding it to
+// the world is only the create calls.
+struct PreparedSceneBody
+{
+    uint32_t record = 0;
+    b2BodyDef bodyDef{};
+    b2ShapeDef shapeDef{};
+    bool isCircle = false;
+    b2Circle circle{};
+    b2Polygon polygon{};
+};
+
+// Reads, validates and prepares a scene file on a worker thread, so the
+// thread that owns the world only inserts. Once Ready, View and Bodies stay
+// valid until the next Start or Cancel. State and the counts may be read from
+// any thread; Start and Cancel belong to the world's owner.
+class SceneLoader
+{
+public:
+    enum class State : uint8_t
+    {
+        Idle,
+        Preparing,
+        Ready,
+        Failed, // unreadable or invalid; nothing was prepared
+    };
+
+    // Runs on the worker; false skips the record.
+    using PrepareFn = bool (*)(const SceneView& view, uint32_t record, PreparedSceneBody& out);
+
+    SceneLoader() = default;
+    SceneLoader(const SceneLoader&) = delete;
+    SceneLoader& operator=(const SceneLoader&) = delete;
+    ~SceneLoader() { Cancel(); }
+
+    // Drops any load still in flight first.
+    void Start(const std::string& path, PrepareFn prepare)
+    {
+        Cancel();
+        m_state.store(State::Preparing, std::memory_order_relaxed);
+        m_thread = std::thread([this, path, prepare]() { Work(path, prepare); });
+    }
+
+    // Stops the worker and forgets the load, whatever state it reached.
+    void Cancel()
+    {
+        m_cancel.store(true, std::memory_order_relaxed);
+        if (m_thread.joinable()) m_thread.join();
+        m_cancel.store(false, std::memory_order_relaxed);
+        m_view = SceneView{};
+        m_bodies.clear();
+        m_file.Close();
+        m_prepared.store(0, std::memory_order_relaxed);
+        m_records.store(0, std::memory_order_relaxed);
+        m_state.store(State::Idle, std::memory_order_release);
+    }
+
+    State GetState() const { return m_state.load(std::memory_order_acquire); }
+    bool Busy() const
+    {
+        State s = GetState();
+        return s == State::Preparing || s == State::Ready;
+    }
+
+    // Records prepared so far out of the file's; 0 of 0 until it is parsed.
+    uint32_t PreparedCount() const { return m_prepared.load(std::memory_order_relaxed); }
+    uint32_t RecordCount() const { return m_records.load(std::memory_order_relaxed); }
+
+    const SceneView& View() const { return m_view; }
+    const std::vector<PreparedSceneBody>& Bodies() const { return m_bodies; }
+
+private:
+    static constexpr uint32_t kProgressRecords = 256;
+
+    void Work(const std::string& path, PrepareFn prepare)
+    {
+        SLOP_TRACE_THREAD("scene loader");
+        SLOP_ZONE("PrepareScene");
+        SceneView view;
+        if (!m_file.Open(path.c_str()) || !ParseSceneFile(m_file.Data(), m_file.Size(), view))
+        {
+            m_state.store(State::Failed, std::memory_order_release);
+            return;
+        }
+        uint32_t count = view.header->bodyCount;
+        m_records.store(count, std::memory_order_relaxed);
+        m_bodies.reserve(count);
+        PreparedSceneBody body;
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            if (i % kProgressRecords == 0)
+            {
+                if (m_cancel.load(std::memory_order_relaxed)) return;
+                m_prepared.store(i, std::memory_order_relaxed);
+            }
+            body = PreparedSceneBody{};
+            if (prepare(view, i, body)) m_bodies.push_back(body);
+        }
+        m_view = view;
+        m_prepared.store(count, std::memory_order_relaxed);
+        m_state.store(State::Ready, std::memory_order_release);
+    }
+
+    std::thread m_thread;
+    std::atomic<State> m_state{State::Idle};
+    std::atomic<bool> m_cancel{false};
+    std::atomic<uint32_t> m_prepared{0};
+    std::atomic<uint32_t> m_records{0};
+    // Written by the worker only until it publishes Ready.
+    MappedFile m_file;
+    SceneView m_view;
+    std::vector<PreparedSceneBody> m_bodies;
+};
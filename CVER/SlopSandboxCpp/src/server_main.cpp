@@ -0,0 +1,152 @@
+// SlopServer: runs one sandbox world headless in real time and streams it to
+// viewers (SlopViewer) over TCP; viewers send commands back like local input.
+//   SlopServer --port 7420 --rate 20 --world-scale 8 --scene big.bin
+// Frames carry only the bodies that moved since the last one (net_stream.h),
+// so bandwidth and encode time follow the awake bodies, not the world.
+
+#include "net_socket.h"
+#include "sandbox_core.h"
+
+#include <algorithm>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+
+SLOP_DEFINE_HEAP_ALLOC_COUNTER()
+
+namespace
+{
+
+volatile std::sig_atomic_t g_stop = 0;
+
+void OnSignal(int) { g_stop = 1; }
+
+struct ServerOptions
+{
+    uint16_t port = netstream::kDefaultPort;
+    int rate = 20; // frames sent per second
+    int workers = 0;
+    float worldScale = 1.0f;
+    const char* sceneFile = nullptr;
+    bool hibernate = false;
+};
+
+void PrintUsage()
+{
+    std::fprintf(stderr, "usage: SlopServer [--port 7420] [--rate 20] [--workers N] [--world-scale S] [--scene FILE] [--hibernate]\n");
+}
+
+std::vector<uint8_t> BuildHello(int rate)
+{
+    netstream::ByteWriter w;
+    size_t at = w.BeginMessage(netstream::MessageType::Hello);
+    w.U32(netstream::kVersion);
+    w.F32(SandboxCore::FixedDt());
+    w.U16(static_cast<uint16_t>(rate));
+    w.EndMessage(at);
+    return w.Bytes();
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    ServerOptions opt;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--port") == 0 && i + 1 < argc) opt.port = static_cast<uint16_t>(std::atoi(argv[++i]));
+        else if (std::strcmp(argv[i], "--rate") == 0 && i + 1 < argc) opt.rate = std::clamp(std::atoi(argv[++i]), 1, 120);
+        else if (std::strcmp(argv[i], "--workers") == 0 && i + 1 < argc) opt.workers = std::atoi(argv[++i]);
+        else if (std::strcmp(argv[i], "--world-scale") == 0 && i + 1 < argc) opt.worldScale = static_cast<float>(std::atof(argv[++i]));
+        else if (std::strcmp(argv[i], "--scene") == 0 && i + 1 < argc) opt.sceneFile = argv[++i];
+        else if (std::strcmp(argv[i], "--hibernate") == 0) opt.hibernate = true;
+        else
+        {
+            PrintUsage();
+            return 1;
+        }
+    }
+
+    netstream::StreamServer server;
+    if (!server.Listen(opt.port))
+    {
+        std::fprintf(stderr, "cannot listen on port %u\n", static_cast<unsigned>(opt.port));
+        return 1;
+    }
+    std::signal(SIGINT, OnSignal);
+    std::signal(SIGTERM, OnSignal);
+
+    SandboxCore app(1536, 960, opt.workers);
+    app.SetPhysicsThreadEnabled(false);
+    app.SetWorldWidth(opt.worldScale * static_cast<float>(app.Width()));
+    if (opt.sceneFile && !app.LoadScene(opt.sceneFile)) std::fprintf(stderr, "cannot load scene %s\n", opt.sceneFile);
+    app.SetRegionHibernation(opt.hibernate);
+    app.SetStreaming(true);
+
+    const std::vector<uint8_t> hello = BuildHello(opt.rate);
+    netstream::FrameEncoder encoder;
+    using Clock = std::chrono::steady_clock;
+    const auto stepPeriod = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(SandboxCore::FixedDt()));
+    const auto sendPeriod = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / opt.rate));
+    auto nextStep = Clock::now();
+    auto nextSend = nextStep;
+    auto nextReport = nextStep + std::chrono::seconds(1);
+    uint64_t reportBytes = 0;
+    uint64_t reportFrames = 0;
+    uint64_t reportMoves = 0;
+    double reportEncodeMs = 0.0;
+    std::printf("listening on port %u, %d frames/s\n", static_cast<unsigned>(opt.port), opt.rate);
+    std::fflush(stdout);
+
+    while (!g_stop)
+    {
+        server.Poll(hello, [&](netstream::MessageType type, const uint8_t* payload, size_t size) {
+            SimCommand c;
+            if (type == netstream::MessageType::Command && DecodeCommand(payload, size, c)) app.SubmitRemoteCommand(std::move(c));
+        });
+
+        // A step that ran late is caught up on, up to a few, like the window does.
+        int steps = 0;
+        while (Clock::now() >= nextStep && steps < 4)
+        {
+            app.StepHeadless(SandboxCore::FixedDt());
+            nextStep += stepPeriod;
+            ++steps;
+        }
+        if (steps == 4) nextStep = Clock::now() + stepPeriod;
+
+        if (Clock::now() >= nextSend)
+        {
+            auto start = Clock::now();
+            app.EncodeStreamFrame(encoder);
+            const std::vector<uint8_t>& frame = encoder.Finish();
+            server.Broadcast(frame, [&](netstream::ByteWriter& out) { encoder.Keyframe(out); });
+            reportEncodeMs += std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+            reportBytes += frame.size() * server.ViewerCount();
+            reportMoves += encoder.LastStats().moves;
+            ++reportFrames;
+            nextSend += sendPeriod;
+            if (nextSend < start) nextSend = start + sendPeriod;
+        }
+
+        auto now = Clock::now();
+        if (now >= nextReport)
+        {
+            std::printf("viewers %zu  bodies %zu  frames %llu  moves/frame %.0f  encode %.3f ms/frame  %.1f KiB/s  resyncs %llu\n", server.ViewerCount(),
+                        encoder.BodyCount(), static_cast<unsigned long long>(reportFrames),
+                        reportFrames ? static_cast<double>(reportMoves) / reportFrames : 0.0, reportFrames ? reportEncodeMs / reportFrames : 0.0,
+                        static_cast<double>(reportBytes) / 1024.0, static_cast<unsigned long long>(server.Resyncs()));
+            std::fflush(stdout);
+            reportBytes = reportFrames = reportMoves = 0;
+            reportEncodeMs = 0.0;
+            nextReport = now + std::chrono::seconds(1);
+        }
+        // Wakes for the next step or send, whichever is first; sockets are
+        // polled then, so commands wait at most a step.
+        std::this_thread::sleep_until(std::min(nextStep, nextSend));
+    }
+    return 0;
+}
@@ -0,0 +1,188 @@
+#pragma once
+
+#include "task_scheduler.h"
+#include "wave_kernels.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Depth-averaged shallow-water columns on a staggered grid: depth per cell,
+// velocity and flux per face, walls at both ends. Heights only change through
+// face fluxes, so the water volume stays fixed.
+//
+// Bodies enter as a solid per cell, the vertical extent of whatever overlaps
+// it. Water above a solid's bottom shares the column with it, so the surface
+// is depth plus the part of the solid inside the water (wave::ShallowSurface);
+// in effect a body fills half the column's thickness. The surface is a pure
+// function of depth, which keeps the coupling stable with a one-step lag.
+//
+// The cost is one pass over the columns per substep however deep the water
+// is, which is what lets a full-screen pool run at frame rate. Cells are split
+// into tiles; each substep runs a face pass and a cell pass over the tiles on
+// the task pool. Tiles write disjoint ranges, so results do not depend on the
+// worker count. A screen-wide pool is a few hundred columns, one tile, and
+// runs inline: the passes are memory bound and only pay for the two barriers
+// per substep once a grid spans several tiles.
+class ShallowWater
+{
+public:
+    static constexpr size_t kTileCells = 4096;
+
+    void Init(size_t columns, float columnWidth, float restDepth)
+    {
+        m_count = columns;
+        m_dx = columnWidth;
+        m_restDepth = restDepth;
+        m_depth.assign(columns, restDepth);
+        m_velocity.assign(columns, 0.0f);
+        m_wallFlux.assign(columns + 1, 0.0f);
+        m_solidBottom.assign(columns, kNoSolid);
+        m_solidTop.assign(columns, kNoSolid);
+        m_solidSpan.assign(columns, 0.0f);
+        m_volume = Volume();
+    }
+
+    void Reset() { Init(m_count, m_dx, m_restDepth); }
+
+    size_t Count() const { return m_count; }
+    float RestDepth() const { return m_restDepth; }
+
+    // Water column height in px, and velocity in px/s at the face right of
+    // each cell (the last entry is the wall and stays zero).
+    const std::vector<float>& Depths() const { return m_depth; }
+    const std::vector<float>& Velocities() const { return m_velocity; }
+
+    // Loads state saved from Depths()/Velocities() of the same column count.
+    void Restore(const float* depth, const float* velocity)
+    {
+        if (m_count == 0) return;
+        std::copy(depth, depth + m_count, m_depth.begin());
+        std::copy(velocity, velocity + m_count, m_velocity.begin());
+        m_velocity[m_count - 1] = 0.0f;
+        ClearSolids();
+        m_volume = Volume();
+    }
+
+    // Refilled by the caller every step from the bodies it sampled. Heights
+    // are px above the floor; several solids in one cell merge into their
+    // vertical envelope.
+    void ClearSolids()
+    {
+        std::fill(m_solidBottom.begin(), m_solidBottom.end(), kNoSolid);
+        std::fill(m_solidTop.begin(), m_solidTop.end(), kNoSolid);
+        std::fill(m_solidSpan.begin(), m_solidSpan.end(), 0.0f);
+    }
+
+    void AddSolid(size_t cell, float bottom, float top)
+    {
+        if (cell >= m_count || top <= bottom) return;
+        if (m_solidBottom[cell] == kNoSolid)
+        {
+            m_solidBottom[cell] = bottom;
+            m_solidTop[cell] = top;
+        }
+        else
+        {
+            m_solidBottom[cell] = std::min(m_solidBottom[cell], bottom);
+            m_solidTop[cell] = std::max(m_solidTop[cell], top);
+        }
+        m_solidSpan[cell] = m_solidTop[cell] - m_solidBottom[cell];
+    }
+
+    // Surface height above the floor.
+    float SurfaceAt(size_t i) const { return wave::ShallowSurface(m_depth[i], m_solidBottom[i], m_solidSpan[i]); }
+
+    float Volume() const
+    {
+        double sum = 0.0;
+        for (size_t i = 0; i < m_count; ++i) sum += m_depth[i];
+        return static_cast<float>(sum);
+    }
+
+    // Turns per-cell downward pokes into outward flow, which moves water
+    // without creating or removing any.
+    void ApplyImpulse(const float* impulse, float gain)
+    {
+        for (size_t f = 0; f + 1 < m_count; ++f) m_velocity[f] += gain * (impulse[f] - impulse[f + 1]);
+    }
+
+    // Advances by dt with as many substeps as the wave speed needs to keep the
+    // scheme stable and every depth non-negative.
+    void Step(float dt, float gravity, float damping, TaskScheduler* scheduler)
+    {
+        if (m_count < 2) return;
+
+        // Where a solid is in the water the surface rises twice as fast as
+        // the depth, which doubles the effective gravity there.
+        float maxDepth = *std::max_element(m_depth.begin(), m_depth.end());
+        float speed = std::sqrt(2.0f * gravity * std::max(maxDepth, 1.0f));
+        int substeps = std::clamp(static_cast<int>(std::ceil(speed * dt / (0.5f * m_dx))), 1, kMaxSubsteps);
+
+        m_subDt = dt / static_cast<float>(substeps);
+        m_slopeGain = gravity * m_subDt / m_dx;
+        m_keep = std::max(0.0f, 1.0f - damping * m_subDt);
+        // |u| dt / dx <= 1/2 caps each face's outflow at half the upwind cell.
+        m_maxU = 0.5f * m_dx / m_subDt;
+
+        int tiles = static_cast<int>((m_count + kTileCells - 1) / kTileCells);
+        for (int s = 0; s < substeps; ++s)
+        {
+            RunTiles(tiles, &FaceTask, scheduler);
+            RunTiles(tiles, &CellTask, scheduler);
+        }
+
+        // Rounding drift is spread evenly so the volume stays put over long runs.
+        float drift = (m_volume - Volume()) / static_cast<float>(m_count);
+        for (size_t i = 0; i < m_count; ++i) m_depth[i] = std::max(0.0f, m_depth[i] + drift);
+    }
+
+private:
+    static constexpr int kMaxSubsteps = 24;
+    static constexpr float kNoSolid = 1e30f;
+
+    void RunTiles(int tiles, b2TaskCallback* fn, TaskScheduler* scheduler)
+    {
+        if (tiles <= 1 || !scheduler) fn(0, tiles, 0, this);
+        else scheduler->ParallelFor(tiles, 1, fn, this);
+    }
+
+    static void FaceTask(int start, int end, uint32_t, void* context)
+    {
+        auto* self = static_cast<ShallowWater*>(context);
+        size_t faces = self->m_count - 1;
+        size_t begin = static_cast<size_t>(start) * kTileCells;
+        size_t stop = std::min(faces, static_cast<size_t>(end) * kTileCells);
+        if (begin >= stop) return;
+        wave::ShallowFaces(self->m_depth.data(), self->m_solidBottom.data(), self->m_solidSpan.data(), self->m_velocity.data(),
+                           self->m_wallFlux.data() + 1, begin, stop, self->m_slopeGain, self->m_keep, self->m_maxU);
+    }
+
+    static void CellTask(int start, int end, uint32_t, void* context)
+    {
+        auto* self = static_cast<ShallowWater*>(context);
+        size_t begin = static_cast<size_t>(start) * kTileCells;
+        size_t stop = std::min(self->m_count, static_cast<size_t>(end) * kTileCells);
+        if (begin >= stop) return;
+        wave::ShallowCells(self->m_depth.data(), self->m_wallFlux.data(), begin, stop, self->m_subDt / self->m_dx);
+    }
+
+    size_t m_count = 0;
+    float m_dx = 1.0f;
+    float m_restDepth = 0.0f;
+    float m_volume = 0.0f;
+
+    std::vector<float> m_depth;
+    std::vector<float> m_velocity;
+    std::vector<float> m_wallFlux; // [0] and [count] are the walls
+    std::vector<float> m_solidBottom;
+    std::vector<float> m_solidTop;
+    std::vector<float> m_solidSpan;
+
+    float m_subDt = 0.0f;
+    float m_slopeGain = 0.0f;
+    float m_keep = 1.0f;
+    float m_maxU = 0.0f;
+};
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <box2d/box2d.h>
+
+#include "sim_types.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+// Local polygon outline in px, stored inline. b2Polygon caps vertices at
+// B2_MAX_POLYGON_VERTICES, so no shape needs more.
+struct ShapeGeometry
+{
+    static constexpr int kMaxVerts = B2_MAX_POLYGON_VERTICES;
+
+    Vector2 verts[kMaxVerts]{};
+    uint32_t count = 0;
+
+    const Vector2* begin() const { return verts; }
+    const Vector2* end() const { return verts + count; }
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    const Vector2& operator[](size_t i) const { return verts[i]; }
+};
+
+// Append-only table of interned outlines: identical geometry gets one id, so a
+// thousand boxes share a single entry. Id 0 is the empty outline (circles).
+// Entries are never removed, which keeps ids stable and lets render snapshots
+// copy only the tail they have not seen yet.
+class ShapeTable
+{
+public:
+    using Id = uint32_t;
+    static constexpr Id kEmpty = 0;
+
+    ShapeTable()
+    {
+        m_shapes.emplace_back();
+        m_hashes.push_back(0);
+        m_buckets.assign(kInitialBuckets, kNone);
+        m_next.push_back(kNone);
+    }
+
+    // Counts above kMaxVerts are truncated; callers pass b2Polygon-sized outlines.
+    Id Intern(const Vector2* verts, size_t count)
+    {
+        ShapeGeometry g;
+        g.count = static_cast<uint32_t>(count < ShapeGeometry::kMaxVerts ? count : ShapeGeometry::kMaxVerts);
+        if (g.count == 0) return kEmpty;
+        std::memcpy(g.verts, verts, g.count * sizeof(Vector2));
+
+        uint64_t h = Hash(g);
+        size_t bucket = static_cast<size_t>(h & (m_buckets.size() - 1));
+        for (Id id = m_buckets[bucket]; id != kNone; id = m_next[id])
+        {
+            if (m_hashes[id] == h && Same(m_shapes[id], g)) return id;
+        }
+
+        Id id = static_cast<Id>(m_shapes.size());
+        m_shapes.push_back(g);
+        m_hashes.push_back(h);
+        m_next.push_back(m_buckets[bucket]);
+        m_buckets[bucket] = id;
+        if (m_shapes.size() > m_buckets.size()) Rehash(m_buckets.size() * 2);
+        return id;
+    }
+
+    Id Intern(const std::vector<Vector2>& verts) { return Intern(verts.data(), verts.size()); }
+
+    const ShapeGeometry& operator[](Id id) const { return m_shapes[id < m_shapes.size() ? id : kEmpty]; }
+    size_t size() const { return m_shapes.size(); }
+    const ShapeGeometry* data() const { return m_shapes.data(); }
+
+private:
+    static constexpr Id kNone = 0xFFFFFFFFu;
+    static constexpr size_t kInitialBuckets = 64;
+
+    // FNV-1a over the raw float bits; outlines are only equal when bit-identical.
+    static uint64_t Hash(const ShapeGeometry& g)
+    {
+        uint64_t h = 1469598103934665603ull ^ g.count;
+        const auto* bytes = reinterpret_cast<const uint8_t*>(g.verts);
+        for (size_t i = 0; i < g.count * sizeof(Vector2); ++i)
+        {
+            h ^= bytes[i];
+            h *= 1099511628211ull;
+        }
+        return h;
+    }
+
+    static bool Same(const ShapeGeometry& a, const ShapeGeometry& b)
+    {
+        return a.count == b.count && std::memcmp(a.verts, b.verts, a.count * sizeof(Vector2)) == 0;
+    }
+
+    void Rehash(size_t buckets)
+    {
+        m_buckets.assign(buckets, kNone);
+        for (Id id = 1; id < m_shapes.size(); ++id)
+        {
+            size_t bucket = static_cast<size_t>(m_hashes[id] & (buckets - 1));
+            m_next[id] = m_buckets[bucket];
+            m_buckets[bucket] = id;
+        }
+    }
+
+    std::vector<ShapeGeometry> m_shapes;
+    std::vector<uint64_t> m_hashes;
+    std::vector<Id> m_next;
+    std::vector<Id> m_buckets; // power of two
+};
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <algorithm>
+
+// The few raylib value types the simulation shares with the renderer, so the
+// core builds without raylib. Layouts match raylib's; when raylib.h is
+// included it must come first, and its own definitions are used instead.
+#if !defined(RL_VECTOR2_TYPE)
+struct Vector2
+{
+    float x;
+    float y;
+};
+#endif
+
+#if !defined(RL_RECTANGLE_TYPE)
+struct Rectangle
+{
+    float x;
+    float y;
+    float width;
+    float height;
+};
+#endif
+
+#if !defined(RL_COLOR_TYPE)
+struct Color
+{
+    unsigned char r;
+    unsigned char g;
+    unsigned char b;
+    unsigned char a;
+};
+#endif
+
+#ifndef PI
+#define PI 3.14159265358979323846f
+#endif
+#ifndef DEG2RAD
+#define DEG2RAD (PI / 180.0f)
+#endif
+
+// Same results as raylib's CheckCollisionPointRec, CheckCollisionRecs and Fade.
+inline bool PointInRect(Vector2 p, const Rectangle& r)
+{
+    return p.x >= r.x && p.x < r.x + r.width && p.y >= r.y && p.y < r.y + r.height;
+}
+
+inline bool RectsOverlap(const Rectangle& a, const Rectangle& b)
+{
+    return a.x < b.x + b.width && a.x + a.width > b.x && a.y < b.y + b.height && a.y + a.height > b.y;
+}
+
+inline Color WithAlpha(Color c, float alpha)
+{
+    c.a = static_cast<unsigned char>(255.0f * std::clamp(alpha, 0.0f, 1.0f));
+    return c;
+}
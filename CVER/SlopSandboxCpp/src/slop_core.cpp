@@ -0,0 +1,308 @@
+// C API over a headless SandboxCore; see slop_core.h.
+
+#include "slop_core.h"
+
+#include "sandbox_core.h"
+
+#include <algorithm>
+#include <vector>
+
+struct SlopCore
+{
+    SlopCore(int width, int height, int workers) : sandbox(width, height, workers) { sandbox.SetPhysicsThreadEnabled(false); }
+
+    SandboxCore sandbox;
+};
+
+static_assert(static_cast<int>(SLOP_LOCATION_WATER) == static_cast<int>(SceneLocation::Water), "location values");
+static_assert(static_cast<int>(SLOP_LOCATION_LAND) == static_cast<int>(SceneLocation::Land), "location values");
+static_assert(static_cast<int>(SLOP_LOCATION_SHALLOW) == static_cast<int>(SceneLocation::Shallow), "location values");
+static_assert(static_cast<int>(SLOP_BODY_POLYGON) == static_cast<int>(BodyKind::Polygon), "body kind values");
+static_assert(static_cast<int>(SLOP_BODY_COMPOUND) == static_cast<int>(BodyKind::Compound), "body kind values");
+static_assert(static_cast<unsigned>(SLOP_BODY_WHEEL) == kFeatureWheel && static_cast<unsigned>(SLOP_BODY_GLASS) == kFeatureGlass,
+              "feature bits");
+static_assert(static_cast<unsigned>(SLOP_BODY_SELECTED) == kFeatureSelected && static_cast<unsigned>(SLOP_BODY_AWAKE) == kExportAwake,
+              "export flags");
+
+namespace
+{
+
+bool ValidIndex(const SlopCore* core, int32_t index)
+{
+    return core && index >= 0 && static_cast<size_t>(index) < core->sandbox.BodyCount();
+}
+
+// The new body's index, or -1 when the spawn created nothing.
+int32_t SpawnResult(const SlopCore* core, size_t before)
+{
+    size_t after = core->sandbox.BodyCount();
+    return after > before ? static_cast<int32_t>(after - 1) : -1;
+}
+
+Tool ToolForFeature(uint32_t feature)
+{
+    switch (feature)
+    {
+        case SLOP_BODY_BOUNCY: return Tool::Bounce;
+        case SLOP_BODY_SLIPPERY: return Tool::Slip;
+        case SLOP_BODY_STICKY: return Tool::Sticky;
+        case SLOP_BODY_GLASS: return Tool::Glass;
+        default: return Tool::Cursor;
+    }
+}
+
+} // namespace
+
+extern "C" {
+
+SlopCore* slop_core_create(int width, int height, int workers)
+{
+    if (width <= 0 || height <= 0) return nullptr;
+    return new SlopCore(width, height, workers);
+}
+
+void slop_core_destroy(SlopCore* core) { delete core; }
+
+void slop_core_step(SlopCore* core, float dt)
+{
+    if (core && dt > 0.0f) core->sandbox.StepHeadless(dt);
+}
+
+float slop_core_fixed_dt(void) { return SandboxCore::FixedDt(); }
+
+void slop_core_reset(SlopCore* core)
+{
+    if (core) core->sandbox.ScriptResetScene();
+}
+
+void slop_core_set_location(SlopCore* core, SlopLocation location)
+{
+    if (!core || location < SLOP_LOCATION_WATER || location > SLOP_LOCATION_SHALLOW) return;
+    core->sandbox.SetSceneLocation(static_cast<SceneLocation>(location));
+}
+
+void slop_core_set_world_width(SlopCore* core, float width)
+{
+    if (core) core->sandbox.SetWorldWidth(width);
+}
+
+float slop_core_world_width(const SlopCore* core) { return core ? core->sandbox.WorldWidth() : 0.0f; }
+
+float slop_core_ground_top(const SlopCore* core) { return core ? core->sandbox.GroundTopPx() : 0.0f; }
+
+int32_t slop_core_spawn(SlopCore* core, SlopShape shape, float x, float y)
+{
+    if (!core) return -1;
+    size_t before = core->sandbox.BodyCount();
+    switch (shape)
+    {
+        case SLOP_SHAPE_BOX: core->sandbox.ScriptSpawnBox({x, y}); break;
+        case SLOP_SHAPE_CIRCLE: core->sandbox.ScriptSpawnCircle({x, y}); break;
+        case SLOP_SHAPE_TRIANGLE: core->sandbox.ScriptSpawnTriangle({x, y}); break;
+        default: return -1;
+    }
+    return SpawnResult(core, before);
+}
+
+int32_t slop_core_spawn_polygon(SlopCore* core, float x, float y, const float* vertices, int32_t count)
+{
+    if (!core || !vertices || count < 3 || count > ShapeGeometry::kMaxVerts) return -1;
+    std::vector<Vector2> local(static_cast<size_t>(count));
+    for (int32_t i = 0; i < count; ++i) local[static_cast<size_t>(i)] = {vertices[2 * i], vertices[2 * i + 1]};
+    auto idx = core->sandbox.ScriptSpawnPolygon({x, y}, local);
+    return idx ? static_cast<int32_t>(*idx) : -1;
+}
+
+int32_t slop_core_spawn_grid(SlopCore* core, SlopShape shape, float x, float y, int32_t cols, int32_t rows)
+{
+    if (!core || shape < SLOP_SHAPE_BOX || shape > SLOP_SHAPE_TRIANGLE) return 0;
+    return static_cast<int32_t>(core->sandbox.ScriptSpawnGrid(static_cast<SpawnShape>(shape), {x, y}, cols, rows));
+}
+
+void slop_core_remove_body(SlopCore* core, int32_t index)
+{
+    if (ValidIndex(core, index)) core->sandbox.ScriptRemoveBody(static_cast<size_t>(index));
+}
+
+void slop_core_set_feature(SlopCore* core, int32_t index, uint32_t feature, int on)
+{
+    if (ValidIndex(core, index)) core->sandbox.ScriptSetFeature(static_cast<size_t>(index), ToolForFeature(feature), on != 0);
+}
+
+int slop_core_weld(SlopCore* core, int32_t a, int32_t b, float anchorX, float anchorY)
+{
+    if (!ValidIndex(core, a) || !ValidIndex(core, b) || a == b) return 0;
+    return core->sandbox.ScriptWeld(static_cast<size_t>(a), static_cast<size_t>(b), {anchorX, anchorY}) ? 1 : 0;
+}
+
+int slop_core_attach_wheel(SlopCore* core, int32_t host, int32_t wheel)
+{
+    if (!ValidIndex(core, host) || !ValidIndex(core, wheel) || host == wheel) return 0;
+    return core->sandbox.ScriptAttachWheel(static_cast<size_t>(host), static_cast<size_t>(wheel)) ? 1 : 0;
+}
+
+int32_t slop_core_rigidify(SlopCore* core, int32_t index)
+{
+    if (!ValidIndex(core, index)) return -1;
+    auto idx = core->sandbox.ScriptRigidify(static_cast<size_t>(index));
+    return idx ? static_cast<int32_t>(*idx) : -1;
+}
+
+int32_t slop_core_split(SlopCore* core, int32_t index)
+{
+    if (!ValidIndex(core, index)) return 0;
+    return static_cast<int32_t>(core->sandbox.ScriptSplit(static_cast<size_t>(index)));
+}
+
+int32_t slop_core_duplicate(SlopCore* core, const int32_t* indices, int32_t count, int32_t cols, int32_t rows)
+{
+    if (!core || !indices || count <= 0 || cols <= 0 || rows <= 0) return 0;
+    std::vector<size_t> list;
+    list.reserve(static_cast<size_t>(count));
+    for (int32_t i = 0; i < count; ++i)
+    {
+        if (ValidIndex(core, indices[i])) list.push_back(static_cast<size_t>(indices[i]));
+    }
+    return static_cast<int32_t>(core->sandbox.ScriptDuplicate(list, cols, rows));
+}
+
+void slop_core_set_bullet_budget(SlopCore* core, int32_t budget)
+{
+    if (core) core->sandbox.SetBulletBudget(budget);
+}
+
+int32_t slop_core_bullet_count(const SlopCore* core) { return core ? static_cast<int32_t>(core->sandbox.BulletCount()) : 0; }
+
+void slop_core_explode(SlopCore* core, float x, float y, float radius, float impulse)
+{
+    if (core) core->sandbox.ScriptExplode({x, y}, radius, impulse);
+}
+
+void slop_core_set_view(SlopCore* core, float x, float y, float width, float height)
+{
+    if (core) core->sandbox.ScriptSetView({x, y, width, height});
+}
+
+void slop_core_set_hibernation(SlopCore* core, int on)
+{
+    if (core) core->sandbox.SetRegionHibernation(on != 0);
+}
+
+int32_t slop_core_hibernated_count(const SlopCore* core) { return core ? static_cast<int32_t>(core->sandbox.HibernatedBodyCount()) : 0; }
+
+int32_t slop_core_body_count(const SlopCore* core) { return core ? static_cast<int32_t>(core->sandbox.BodyCount()) : 0; }
+
+int32_t slop_core_find_body(const SlopCore* core, uint64_t key)
+{
+    if (!core) return -1;
+    auto idx = core->sandbox.FindBody(key);
+    return idx ? static_cast<int32_t>(*idx) : -1;
+}
+
+int32_t slop_core_read_bodies(const SlopCore* core, SlopBodyState* out, int32_t capacity)
+{
+    if (!core) return 0;
+    const SandboxCore& sandbox = core->sandbox;
+    size_t count = sandbox.BodyCount();
+    size_t n = out ? std::min(count, static_cast<size_t>(std::max(capacity, 0))) : 0;
+    for (size_t i = 0; i < n; ++i)
+    {
+        const BodyEntry& e = sandbox.BodyAt(i);
+        SlopBodyState& s = out[i];
+        s = SlopBodyState{};
+        s.key = BodyKey(e.bodyId);
+        if (b2Body_IsValid(e.bodyId))
+        {
+            b2Transform xf = b2Body_GetTransform(e.bodyId);
+            Vector2 p = ToPixels(xf.p);
+            s.x = p.x;
+            s.y = p.y;
+            s.cosAngle = xf.q.c;
+            s.sinAngle = xf.q.s;
+            if (b2Body_IsAwake(e.bodyId)) s.flags |= SLOP_BODY_AWAKE;
+        }
+        s.radius = e.radiusPx;
+        s.shape = e.shape;
+        s.kind = static_cast<uint8_t>(e.kind);
+        s.flags |= e.features & kExportFeatureMask;
+    }
+    return static_cast<int32_t>(count);
+}
+
+int32_t slop_core_read_shape(const SlopCore* core, uint32_t shape, float* out, int32_t capacity)
+{
+    if (!core || shape >= core->sandbox.Shapes().size()) return 0;
+    const ShapeGeometry& g = core->sandbox.Shapes()[shape];
+    int32_t n = out ? std::min(static_cast<int32_t>(g.size()), capacity) : 0;
+    for (int32_t i = 0; i < n; ++i)
+    {
+        out[2 * i] = g[static_cast<size_t>(i)].x;
+        out[2 * i + 1] = g[static_cast<size_t>(i)].y;
+    }
+    return static_cast<int32_t>(g.size());
+}
+
+int32_t slop_core_read_parts(const SlopCore* core, int32_t index, SlopBodyPart* out, int32_t capacity)
+{
+    if (!ValidIndex(core, index)) return 0;
+    const std::vector<RigidPart>& parts = core->sandbox.PartsAt(static_cast<size_t>(index));
+    size_t n = out ? std::min(parts.size(), static_cast<size_t>(std::max(capacity, 0))) : 0;
+    for (size_t i = 0; i < n; ++i)
+    {
+        const RigidPart& p = parts[i];
+        SlopBodyPart& o = out[i];
+        o = SlopBodyPart{};
+        Vector2 pos = ToPixels(p.local.p);
+        o.x = pos.x;
+        o.y = pos.y;
+        o.cosAngle = p.local.q.c;
+        o.sinAngle = p.local.q.s;
+        o.radius = p.radiusPx;
+        o.shape = p.shape;
+        o.kind = static_cast<uint8_t>(p.kind);
+        o.flags = p.features & kExportFeatureMask;
+    }
+    return static_cast<int32_t>(parts.size());
+}
+
+void slop_core_set_transform_export(SlopCore* core, int32_t capacity)
+{
+    if (core) core->sandbox.SetTransformExportCapacity(static_cast<uint32_t>(std::max(capacity, 0)));
+}
+
+int slop_core_read_transforms(const SlopCore* core, SlopTransforms* out)
+{
+    if (!core || !out) return 0;
+    auto copy = [out](const TransformExport::View& v) {
+        size_t n = std::min(static_cast<size_t>(v.count), static_cast<size_t>(std::max(out->capacity, 0)));
+        if (out->key) std::copy_n(v.key, n, out->key);
+        if (out->x) std::copy_n(v.x, n, out->x);
+        if (out->y) std::copy_n(v.y, n, out->y);
+        if (out->cosAngle) std::copy_n(v.cosAngle, n, out->cosAngle);
+        if (out->sinAngle) std::copy_n(v.sinAngle, n, out->sinAngle);
+        if (out->kind) std::copy_n(v.kind, n, out->kind);
+        if (out->flags) std::copy_n(v.flags, n, out->flags);
+        out->count = static_cast<int32_t>(n);
+        out->total = static_cast<int32_t>(v.total);
+        out->step = v.step;
+    };
+    return core->sandbox.Transforms().Read(copy) ? 1 : 0;
+}
+
+int32_t slop_core_read_water(const SlopCore* core, float* out, int32_t capacity)
+{
+    if (!core) return 0;
+    const std::vector<float>& disp = core->sandbox.WaveDisplacement();
+    if (out) std::copy_n(disp.begin(), std::min(disp.size(), static_cast<size_t>(std::max(capacity, 0))), out);
+    return static_cast<int32_t>(disp.size());
+}
+
+float slop_core_water_step(const SlopCore* core) { return core ? core->sandbox.WaveStepPx() : 0.0f; }
+
+float slop_core_water_baseline(const SlopCore* core) { return core ? core->sandbox.WaterBaselinePx() : 0.0f; }
+
+int slop_core_save_scene(SlopCore* core, const char* path) { return core && path && core->sandbox.SaveScene(path) ? 1 : 0; }
+
+int slop_core_load_scene(SlopCore* core, const char* path) { return core && path && core->sandbox.LoadScene(path) ? 1 : 0; }
+
+} // extern "C"
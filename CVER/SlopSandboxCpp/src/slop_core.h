@@ -0,0 +1,183 @@
+#pragma once
+
+// Flat C interface to the sandbox simulation (world, bodies, joints, water,
+// glass) without a window, for front-ends in other languages. Built as the
+// slopsandbox_core static library. Positions and sizes are in pixels, y down,
+// as everywhere else in the sandbox; one SlopCore is driven from one thread.
+//
+// Bodies are addressed by index in [0, slop_core_body_count). Indices shift
+// when bodies are removed, so hold on to SlopBodyState::key across steps and
+// look the index up again with slop_core_find_body.
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct SlopCore SlopCore;
+
+typedef enum SlopLocation
+{
+    SLOP_LOCATION_WATER = 0,
+    SLOP_LOCATION_LAND = 1,
+    SLOP_LOCATION_SHALLOW = 2
+} SlopLocation;
+
+typedef enum SlopShape
+{
+    SLOP_SHAPE_BOX = 0,
+    SLOP_SHAPE_CIRCLE = 1,
+    SLOP_SHAPE_TRIANGLE = 2
+} SlopShape;
+
+// Same values as the sandbox's BodyKind.
+typedef enum SlopBodyKind
+{
+    SLOP_BODY_BOX = 0,
+    SLOP_BODY_CIRCLE = 1,
+    SLOP_BODY_TRIANGLE = 2,
+    SLOP_BODY_POLYGON = 3,
+    SLOP_BODY_COMPOUND = 4 // merged weld group; see slop_core_read_parts
+} SlopBodyKind;
+
+// SlopBodyState::flags; the first five match the sandbox's feature bits.
+enum
+{
+    SLOP_BODY_WHEEL = 1u << 0,
+    SLOP_BODY_BOUNCY = 1u << 1,
+    SLOP_BODY_SLIPPERY = 1u << 2,
+    SLOP_BODY_STICKY = 1u << 3,
+    SLOP_BODY_GLASS = 1u << 4,
+    SLOP_BODY_SELECTED = 1u << 5,
+    SLOP_BODY_AWAKE = 1u << 7
+};
+
+typedef struct SlopBodyState
+{
+    uint64_t key; // stable for the body's lifetime
+    float x;
+    float y;
+    float cosAngle;
+    float sinAngle;
+    float radius; // circles only
+    uint32_t shape; // outline id for slop_core_read_shape; 0 for circles, the hull for compounds
+    uint8_t kind;
+    uint8_t flags;
+    uint8_t reserved[2];
+} SlopBodyState;
+
+// One part of a compound body, placed in the compound's local frame.
+typedef struct SlopBodyPart
+{
+    float x;
+    float y;
+    float cosAngle;
+    float sinAngle;
+    float radius;
+    uint32_t shape;
+    uint8_t kind;
+    uint8_t flags; // feature bits only
+    uint8_t reserved[2];
+} SlopBodyPart;
+
+// workers <= 0 picks a worker count from hardware concurrency.
+SlopCore* slop_core_create(int width, int height, int workers);
+void slop_core_destroy(SlopCore* core);
+
+// Advances by dt seconds in fixed steps, carrying the remainder over.
+void slop_core_step(SlopCore* core, float dt);
+float slop_core_fixed_dt(void);
+
+void slop_core_reset(SlopCore* core);
+void slop_core_set_location(SlopCore* core, SlopLocation location);
+// Never narrower than the width passed to slop_core_create; clears the scene.
+void slop_core_set_world_width(SlopCore* core, float width);
+float slop_core_world_width(const SlopCore* core);
+float slop_core_ground_top(const SlopCore* core);
+
+// Spawns return the new body's index, or -1 when nothing was created.
+int32_t slop_core_spawn(SlopCore* core, SlopShape shape, float x, float y);
+// count vertices as x, y pairs around the centre; convex, at most 8.
+int32_t slop_core_spawn_polygon(SlopCore* core, float x, float y, const float* vertices, int32_t count);
+// Returns the number spawned; they are the last bodies in index order.
+int32_t slop_core_spawn_grid(SlopCore* core, SlopShape shape, float x, float y, int32_t cols, int32_t rows);
+void slop_core_remove_body(SlopCore* core, int32_t index);
+
+// One of SLOP_BODY_BOUNCY, _SLIPPERY, _STICKY or _GLASS.
+void slop_core_set_feature(SlopCore* core, int32_t index, uint32_t feature, int on);
+int slop_core_weld(SlopCore* core, int32_t a, int32_t b, float anchorX, float anchorY);
+int slop_core_attach_wheel(SlopCore* core, int32_t host, int32_t wheel);
+// Merges every body welded to index, directly or not, into one compound
+// body and returns its index, or -1 when there is nothing to merge.
+int32_t slop_core_rigidify(SlopCore* core, int32_t index);
+// Turns a compound back into separate welded bodies, appended at the end of
+// the index order; returns how many.
+int32_t slop_core_split(SlopCore* core, int32_t index);
+// Copies the listed bodies, with the welds and wheels between them, into a
+// cols x rows array beside them (the originals fill the first cell). Returns
+// how many bodies were made; they are appended at the end of the index order.
+int32_t slop_core_duplicate(SlopCore* core, const int32_t* indices, int32_t count, int32_t cols, int32_t rows);
+// Bodies thrown fast for their size are swept against dynamic bodies too
+// until they slow down; at most budget at a time (0 turns that off).
+void slop_core_set_bullet_budget(SlopCore* core, int32_t budget);
+int32_t slop_core_bullet_count(const SlopCore* core);
+// Wakes and throws every body within radius of (x, y), fading out over as far
+// again; impulse is per meter of outline facing the blast (negative pulls in).
+// Glass in reach is stressed and water under it pushed away.
+void slop_core_explode(SlopCore* core, float x, float y, float radius, float impulse);
+// With hibernation on, settled regions far from the view leave the world
+// until the view or an awake body comes near; the view defaults to the
+// whole world. Saving brings every region back first.
+void slop_core_set_view(SlopCore* core, float x, float y, float width, float height);
+void slop_core_set_hibernation(SlopCore* core, int on);
+int32_t slop_core_hibernated_count(const SlopCore* core);
+
+int32_t slop_core_body_count(const SlopCore* core);
+int32_t slop_core_find_body(const SlopCore* core, uint64_t key);
+// Writes up to capacity bodies in index order; returns the body count.
+int32_t slop_core_read_bodies(const SlopCore* core, SlopBodyState* out, int32_t capacity);
+// Local outline of a shape id as x, y pairs; returns its vertex count.
+int32_t slop_core_read_shape(const SlopCore* core, uint32_t shape, float* out, int32_t capacity);
+// Writes up to capacity parts of a compound; returns its part count (0 for
+// other bodies).
+int32_t slop_core_read_parts(const SlopCore* core, int32_t index, SlopBodyPart* out, int32_t capacity);
+
+// Caller-owned columns for slop_core_read_transforms, each capacity entries
+// long; a NULL column is skipped. Rows are in body index order.
+typedef struct SlopTransforms
+{
+    uint64_t* key;
+    float* x;
+    float* y;
+    float* cosAngle;
+    float* sinAngle;
+    uint8_t* kind;
+    uint8_t* flags;
+    int32_t capacity;
+    int32_t count; // out: rows written
+    int32_t total; // out: bodies in the world when the rows were exported
+    uint64_t step; // out: increases by one per exported frame
+} SlopTransforms;
+
+// Exports every body's transform after each step into a double-buffered
+// block of at most capacity rows (0 turns the export off). Call between steps.
+void slop_core_set_transform_export(SlopCore* core, int32_t capacity);
+// Copies the latest exported rows. Never waits for the simulation, so it may
+// run on another thread while slop_core_step does. Nonzero on success.
+int slop_core_read_transforms(const SlopCore* core, SlopTransforms* out);
+
+// Water surface: column i is at x = i * step, y = baseline + out[i]. Returns
+// the column count and writes up to capacity of them.
+int32_t slop_core_read_water(const SlopCore* core, float* out, int32_t capacity);
+float slop_core_water_step(const SlopCore* core);
+float slop_core_water_baseline(const SlopCore* core);
+
+// Nonzero on success.
+int slop_core_save_scene(SlopCore* core, const char* path);
+int slop_core_load_scene(SlopCore* core, const char* path);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,1654 @@
+#pragma once
+
+#include <raylib.h>
+#include <rlgl.h>
+
+#include "sandbox_core.h"
+
+#include "body_batch.h"
+#include "font_atlas.h"
+#include "frame_pacer.h"
+#include "gpu_effects.h"
+#include "gpu_timer.h"
+#include "render_layers.h"
+#include "view_camera.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+// Per GPU particle lane; the CPU pools then only buffer one publish worth.
+static constexpr size_t kGpuParticlesPerLane = size_t{1} << 16;
+static constexpr int kParticleTexSize = 32;
+
+// The raylib key behind each InputKey, in InputKey order.
+static constexpr int kInputKeyCodes[] = {
+    KEY_LEFT_SHIFT, KEY_RIGHT_SHIFT, KEY_BACKSPACE, KEY_Z, KEY_SPACE, KEY_G, KEY_H, KEY_EIGHT,
+    KEY_ONE, KEY_TWO, KEY_THREE, KEY_FOUR, KEY_FIVE, KEY_SIX, KEY_SEVEN,
+    KEY_R, KEY_T, KEY_Y, KEY_U, KEY_Q, KEY_W, KEY_E, KEY_A, KEY_D,
+    KEY_F3, KEY_F4, KEY_F5, KEY_F6, KEY_F9, KEY_S, KEY_X, KEY_C, KEY_V, KEY_B,
+    KEY_COMMA, KEY_PERIOD, KEY_F, KEY_NINE};
+static_assert(sizeof(kInputKeyCodes) / sizeof(kInputKeyCodes[0]) == static_cast<size_t>(InputKey::Count),
+              "one raylib key per InputKey");
+
+// The sandbox app: SandboxCore plus the window, camera, input polling, panel
+// UI and drawing. Run() owns the window; the scripting methods inherited from
+// the core work without one.
+class SlopSandbox : public SandboxCore
+{
+public:
+    // workerCount <= 0 picks a worker count from hardware concurrency.
+    explicit SlopSandbox(int width, int height, int workerCount = 0)
+        : SandboxCore(width, height, workerCount)
+    {
+        m_view.SetViewport(static_cast<float>(width), static_cast<float>(height));
+        SyncViewBounds(m_worldWidth);
+    }
+
+    ~SlopSandbox()
+    {
+        StopPhysicsThread();
+        if (m_pixelTargetLoaded)
+        {
+            UnloadRenderTexture(m_pixelTarget);
+            m_pixelTargetLoaded = false;
+        }
+        if (m_resTargetLoaded)
+        {
+            UnloadRenderTexture(m_resTarget);
+            m_resTargetLoaded = false;
+        }
+        if (m_panelLabelTargetLoaded)
+        {
+            UnloadRenderTexture(m_panelLabelTarget);
+            m_panelLabelTargetLoaded = false;
+        }
+    }
+
+    // Low-latency frames: FramePacer starts each one as late as its recent
+    // cost allows, input is polled again after that wait, and the simulation
+    // runs on the render thread so drags land in the snapshot drawn the same
+    // frame instead of a physics tick and an interpolation tick later. The
+    // profiler (F3) shows the input-to-present latency of either mode. Set
+    // before Run; it replaces the physics thread.
+    void SetLowLatency(bool on)
+    {
+        m_lowLatency = on;
+        if (on) m_physicsThreaded = false;
+    }
+    // On by default: once nothing is awake, the water is still, the particles
+    // are gone and no input came for kIdleEnterFrames frames, Run() stops
+    // stepping and only redraws the last snapshot when the window gets an
+    // event, waking on the first input.
+    void SetIdleRendering(bool on) { m_idleRendering = on; }
+    bool Idle() const { return m_idle; }
+    // Before Run: false keeps the particles on the CPU even when compute
+    // shaders are available.
+    void SetGpuEffectsEnabled(bool enabled) { m_gpuEffectsAllowed = enabled; }
+    // Before Run: draws the world at a resolution that follows the measured
+    // GPU frame time (ResolutionScaleGovernor) and scales it up; the UI stays
+    // at full resolution. Needs GPU timer queries, so OpenGL 3.3; without
+    // them the world is drawn at full resolution as before.
+    void SetDynamicResolution(bool enabled) { m_dynamicResAllowed = enabled; }
+
+    // Baked UI font (font_atlas.h) read at startup instead of rasterizing a
+    // TTF; empty always rasterizes. Set before Run.
+    void SetFontCachePath(const std::string& path) { m_fontCachePath = path; }
+
+    void SetBodyLod(const BodyLod& lod)
+    {
+        m_bodyLod = lod;
+        m_restingBatchZoom = 0.0f; // rebuild the resting layer
+    }
+
+    void Run()
+    {
+        SLOP_TRACE_THREAD("main");
+        // Keep rendering lightweight on high-DPI displays.
+        InitWindow(m_width, m_height, "SlopSandbox CPP v2");
+        m_lastAppliedFps = m_lowLatency ? 0 : m_fpsLimit;
+        SetTargetFPS(m_lastAppliedFps);
+        InitUIFont();
+        InitParticleTexture();
+        InitGpuEffects();
+        InitPixelShader();
+        InitDynamicResolution();
+        m_view.Reset();
+
+        PublishSnapshot();
+        if (m_physicsThreaded) StartPhysicsThread();
+
+        while (!WindowShouldClose())
+        {
+            if (UpdateIdle())
+            {
+                // The same snapshot again; EndDrawing then sleeps until the next event.
+                Draw();
+                continue;
+            }
+            if (m_lowLatency) PollLateInput();
+            // Time spent idle is not simulated.
+            float dt = m_idleResumed ? kFixedDt : GetFrameTime();
+            m_idleResumed = false;
+            m_profiler.BeginFrame();
+            Update(dt);
+            if (!m_physicsThreaded) PublishSnapshot();
+            Draw();
+            if (m_lowLatency) m_pacer.Presented();
+            m_profiler.EndFrame(dt * 1000.0);
+        }
+
+        StopPhysicsThread();
+
+        if (m_uiFontLoaded)
+        {
+            UnloadFont(m_uiFont);
+            m_uiFontLoaded = false;
+        }
+        if (m_particleTexLoaded)
+        {
+            UnloadTexture(m_particleTex);
+            m_particleTexLoaded = false;
+        }
+        m_gpu.Unload();
+        m_gpuEffects = false;
+        if (m_pixelShaderLoaded)
+        {
+            UnloadShader(m_pixelShader);
+            m_pixelShaderLoaded = false;
+        }
+        if (m_sharpenShaderLoaded)
+        {
+            UnloadShader(m_sharpenShader);
+            m_sharpenShaderLoaded = false;
+        }
+        if (m_resTargetLoaded)
+        {
+            UnloadRenderTexture(m_resTarget);
+            m_resTargetLoaded = false;
+        }
+        m_gpuTimer.Unload();
+        m_dynamicRes = false;
+        m_backdropLayer.Unload();
+        m_panelLayer.Unload();
+        m_waterMesh.Unload();
+        CloseWindow();
+    }
+
+private:
+    friend struct SandboxProbe;
+
+    // Render-thread camera. m_viewRect is what it shows plus a margin, sent
+    // with a View command each input pass for snapshot culling; the default
+    // covers everything, so headless runs publish the whole world.
+    ViewCamera m_view;
+    float m_viewWorldWidth = 0.0f; // what m_view's bounds were last set for
+    bool m_lowLatency = false;
+    // Idle rendering. The simulation sets m_sceneAtRest after every frame;
+    // the render thread decides m_idle and parks the physics thread with
+    // m_physicsIdle while it holds.
+    bool m_idleRendering = true;
+    bool m_idle = false;
+    bool m_idleResumed = false;
+    int m_quietFrames = 0;
+    FramePacer m_pacer;
+    // What EndDrawing's poll saw, kept across the late poll that would reset it.
+    struct CarriedInput
+    {
+        bool valid = false;
+        InputFrame edges;
+        float wheel = 0.0f;
+        Vector2 mouseDelta{0.0f, 0.0f};
+        bool home = false;
+    };
+    CarriedInput m_carried;
+    // Render thread: when each recent input sample was taken, by serial.
+    static constexpr uint32_t kInputSampleHistory = 256;
+    std::array<double, kInputSampleHistory> m_inputSampleTime{};
+    uint32_t m_inputSerial = 0;
+    RenderSnapshot m_prevSnapshot;
+    Texture2D m_particleTex{};
+    bool m_particleTexLoaded = false;
+    bool m_gpuEffectsAllowed = true;
+    GpuSpawnQueue::Batch m_gpuBatch;
+    GpuEffects m_gpu;
+    int m_fpsLimit = 60;
+    int m_lastAppliedFps = -1;
+    static constexpr float kCameraPanSpeedPx = 900.0f;
+
+    Font m_uiFont{};
+    bool m_uiFontLoaded = false;
+    std::string m_fontCachePath = "slop_font.atlas";
+    static constexpr int kUiFontBaseSize = 44;
+    mutable TextWidthCache m_textWidths;
+    std::vector<Vector2> m_worldVertsScratch;
+    BodyBatch m_bodyBatch;
+    BodyBatch m_restingBatch;
+    uint32_t m_restingBatchVersion = 0;
+    Theme m_restingBatchTheme = Theme::Dark;
+    float m_restingBatchZoom = 0.0f;
+    BodyLod m_bodyLod;
+    // Screen cells already holding a dot in the batch being built.
+    std::unordered_set<uint64_t> m_lodCells;
+    static constexpr size_t kInterpLookahead = 8;
+    std::vector<Vector2> m_wavePointsScratch;
+    std::vector<float> m_waveVisibleScratch;
+    RenderTexture2D m_pixelTarget{};
+    bool m_pixelTargetLoaded = false;
+    int m_pixelTargetW = 0;
+    int m_pixelTargetH = 0;
+    PixelSizeGovernor m_pixelSize;
+    Shader m_pixelShader{};
+    bool m_pixelShaderLoaded = false;
+    int m_pixelBlockLoc = -1;
+    int m_pixelResolutionLoc = -1;
+    // Dynamic resolution: the world goes into the top left of a target the
+    // size of the framebuffer, m_resScale of it each way, so a new scale
+    // never reallocates.
+    bool m_dynamicResAllowed = false;
+    bool m_dynamicRes = false;
+    GpuFrameTimer m_gpuTimer;
+    ResolutionScaleGovernor m_resScale;
+    RenderTexture2D m_resTarget{};
+    bool m_resTargetLoaded = false;
+    Shader m_sharpenShader{};
+    bool m_sharpenShaderLoaded = false;
+    int m_sharpenTexelLoc = -1;
+    int m_sharpenBoundsLoc = -1;
+    int m_sharpenAmountLoc = -1;
+
+    // Panel labels, in panel-local px. UiButton/UiToggle queue them each frame;
+    // the texture is only redrawn when the list differs from the drawn one.
+    struct PanelLabel
+    {
+        uint32_t key = 0; // ui_text::StringKey
+        float x = 0.0f;
+        float y = 0.0f;
+        float size = 0.0f;
+        Color color{};
+
+        bool operator==(const PanelLabel& o) const
+        {
+            return key == o.key && x == o.x && y == o.y && size == o.size && color.r == o.color.r &&
+                   color.g == o.color.g && color.b == o.color.b && color.a == o.color.a;
+        }
+    };
+    static constexpr size_t kMaxPanelLabels = 64;
+    std::array<PanelLabel, kMaxPanelLabels> m_panelLabels{};
+    std::array<PanelLabel, kMaxPanelLabels> m_panelLabelsDrawn{};
+    size_t m_panelLabelCount = 0;
+    size_t m_panelLabelsDrawnCount = 0;
+    RenderTexture2D m_panelLabelTarget{};
+    bool m_panelLabelTargetLoaded = false;
+    // Background plus ground, and the panel chrome; both change only with
+    // theme, location, language or layout.
+    CachedLayer m_backdropLayer;
+    CachedLayer m_panelLayer;
+    WaterMesh m_waterMesh;
+
+    Color PanelBg() const
+    {
+        return (m_theme == Theme::Dark) ? Color{14, 18, 24, 220} : Color{245, 246, 249, 225};
+    }
+
+    Color PanelStroke() const
+    {
+        return (m_theme == Theme::Dark) ? Color{58, 66, 78, 180} : Color{180, 188, 198, 200};
+    }
+
+    // White disc with an anti-aliased rim, used as the sprite for every particle.
+    void InitParticleTexture()
+    {
+        Image img = GenImageColor(kParticleTexSize, kParticleTexSize, BLANK);
+        Color* px = static_cast<Color*>(img.data);
+        const float half = 0.5f * kParticleTexSize;
+        for (int y = 0; y < kParticleTexSize; ++y)
+        {
+            for (int x = 0; x < kParticleTexSize; ++x)
+            {
+                float dx = static_cast<float>(x) + 0.5f - half;
+                float dy = static_cast<float>(y) + 0.5f - half;
+                float cover = std::clamp(half - std::sqrt(dx * dx + dy * dy), 0.0f, 1.0f);
+                px[y * kParticleTexSize + x] = Color{255, 255, 255, static_cast<unsigned char>(255.0f * cover)};
+            }
+        }
+        m_particleTex = LoadTextureFromImage(img);
+        UnloadImage(img);
+        m_particleTexLoaded = m_particleTex.id != 0;
+        if (m_particleTexLoaded) SetTextureFilter(m_particleTex, TEXTURE_FILTER_BILINEAR);
+    }
+
+    // Samples the centre of each block so one pass over a full-size target
+    // gives the pixelated look; raylib's default vertex shader feeds it.
+    void InitPixelShader()
+    {
+        static constexpr const char* kSource = R"(#version 330
+in vec2 fragTexCoord;
+in vec4 fragColor;
+uniform sampler2D texture0;
+uniform vec4 colDiffuse;
+uniform vec2 u_resolution;
+uniform float u_block;
+out vec4 finalColor;
+void main()
+{
+    vec2 cell = u_block / u_resolution;
+    vec2 uv = (floor(fragTexCoord / cell) + 0.5) * cell;
+    finalColor = texture(texture0, uv) * colDiffuse * fragColor;
+}
+)";
+        m_pixelShader = LoadShaderFromMemory(nullptr, kSource);
+        // A failed compile falls back to the default shader.
+        m_pixelShaderLoaded = m_pixelShader.id != 0 && m_pixelShader.id != rlGetShaderIdDefault();
+        if (!m_pixelShaderLoaded) return;
+        m_pixelBlockLoc = GetShaderLocation(m_pixelShader, "u_block");
+        m_pixelResolutionLoc = GetShaderLocation(m_pixelShader, "u_resolution");
+    }
+
+    // Upscale for the dynamic-resolution target: bilinear, then sharpened by
+    // u_amount against the four neighbours and clamped to their range so
+    // edges get no halo. Taps stay inside u_bounds, the part drawn this frame.
+    void InitDynamicResolution()
+    {
+        if (!m_dynamicResAllowed || !m_gpuTimer.Init()) return;
+        static constexpr const char* kSource = R"(#version 330
+in vec2 fragTexCoord;
+in vec4 fragColor;
+uniform sampler2D texture0;
+uniform vec4 colDiffuse;
+uniform vec2 u_texel;
+uniform vec4 u_bounds;
+uniform float u_amount;
+out vec4 finalColor;
+vec3 tap(vec2 uv)
+{
+    return texture(texture0, clamp(uv, u_bounds.xy, u_bounds.zw)).rgb;
+}
+void main()
+{
+    vec3 c = tap(fragTexCoord);
+    vec3 n = tap(fragTexCoord + vec2(0.0, u_texel.y));
+    vec3 s = tap(fragTexCoord - vec2(0.0, u_texel.y));
+    vec3 e = tap(fragTexCoord + vec2(u_texel.x, 0.0));
+    vec3 w = tap(fragTexCoord - vec2(u_texel.x, 0.0));
+    vec3 lo = min(c, min(min(n, s), min(e, w)));
+    vec3 hi = max(c, max(max(n, s), max(e, w)));
+    vec3 sharp = c + (4.0 * c - (n + s + e + w)) * u_amount;
+    finalColor = vec4(clamp(sharp, lo, hi), 1.0) * colDiffuse * fragColor;
+}
+)";
+        m_sharpenShader = LoadShaderFromMemory(nullptr, kSource);
+        // Without it the upscale is plain bilinear.
+        m_sharpenShaderLoaded = m_sharpenShader.id != 0 && m_sharpenShader.id != rlGetShaderIdDefault();
+        if (m_sharpenShaderLoaded)
+        {
+            m_sharpenTexelLoc = GetShaderLocation(m_sharpenShader, "u_texel");
+            m_sharpenBoundsLoc = GetShaderLocation(m_sharpenShader, "u_bounds");
+            m_sharpenAmountLoc = GetShaderLocation(m_sharpenShader, "u_amount");
+        }
+        m_resTarget = LoadRenderTexture(GetRenderWidth(), GetRenderHeight());
+        SetTextureFilter(m_resTarget.texture, TEXTURE_FILTER_BILINEAR);
+        m_resTargetLoaded = true;
+        m_resScale.Reset();
+        m_dynamicRes = true;
+    }
+
+    void InitGpuEffects()
+    {
+        if (!m_gpuEffectsAllowed || !m_particleTexLoaded) return;
+        // DrawWater never sends more than about two screens of columns.
+        size_t columns = 2 * static_cast<size_t>(m_width / std::max(1.0f, m_waveStep)) + 4;
+        if (!m_gpu.Init(kGpuParticlesPerLane, columns)) return;
+        m_gpu.SetLaneParams(kShardLane, {1700.0f, 0.94f, 0.96f});
+        m_gpu.SetLaneParams(kSprayLane, {980.0f, 0.97f, 0.985f, -80.0f, m_worldWidth + 80.0f, static_cast<float>(m_height + 120)});
+        m_gpuEffects = true;
+    }
+
+    void InitUIFont()
+    {
+        std::array<const char*, 4> candidates = {
+            "/System/Library/Fonts/Supplemental/Arial Unicode.ttf",
+            "/System/Library/Fonts/Supplemental/Arial.ttf",
+            "/System/Library/Fonts/Supplemental/Times New Roman.ttf",
+            "/System/Library/Fonts/Supplemental/Helvetica.ttc"
+        };
+
+        std::vector<int> cps;
+        cps.reserve((126 - 32 + 1) + (0x052F - 0x0400 + 1) + 32);
+        for (int cp = 32; cp <= 126; ++cp) cps.push_back(cp);
+        for (int cp = 0x0400; cp <= 0x052F; ++cp) cps.push_back(cp);
+        cps.push_back(0x2116); // numero sign
+        cps.push_back(0x2014);
+        cps.push_back(0x2013);
+        cps.push_back(0x00AB);
+        cps.push_back(0x00BB);
+
+        // The baked atlas stands in for the first font that exists (or for
+        // none); rasterizing a TTF is the fallback, and rewrites the cache.
+        const char* source = nullptr;
+        for (const char* path : candidates)
+        {
+            if (FileExists(path))
+            {
+                source = path;
+                break;
+            }
+        }
+        const char* cache = m_fontCachePath.empty() ? nullptr : m_fontCachePath.c_str();
+        Font f{};
+        bool loaded = cache && font_atlas::Load(cache, source, cps.data(), static_cast<int>(cps.size()), kUiFontBaseSize, f);
+        for (size_t i = 0; !loaded && i < candidates.size(); ++i)
+        {
+            if (!FileExists(candidates[i])) continue;
+            loaded = font_atlas::Bake(candidates[i], cps.data(), static_cast<int>(cps.size()), kUiFontBaseSize, cache, f);
+        }
+        if (loaded)
+        {
+            m_uiFont = f;
+            m_uiFontLoaded = true;
+            SetTextureFilter(m_uiFont.texture, TEXTURE_FILTER_BILINEAR);
+        }
+    }
+
+    const char* Text(TextId id) const { return ui_text::Get(id, m_language); }
+
+    float MeasureTextUi(TextId id, float fontSize) const
+    {
+        uint32_t key = ui_text::StringKey(id, m_language);
+        float value = 0.0f;
+        if (m_textWidths.Find(key, fontSize, value))
+        {
+            return value;
+        }
+
+        const char* text = Text(id);
+        if (m_uiFontLoaded)
+        {
+            value = MeasureTextEx(m_uiFont, text, fontSize, 1.0f).x;
+        }
+        else
+        {
+            value = static_cast<float>(MeasureText(text, static_cast<int>(fontSize)));
+        }
+
+        m_textWidths.Store(key, fontSize, value);
+        return value;
+    }
+
+    void DrawTextUi(const char* text, float x, float y, float fontSize, Color color) const
+    {
+        if (m_uiFontLoaded)
+        {
+            DrawTextEx(m_uiFont, text, {x, y}, fontSize, 1.0f, color);
+        }
+        else
+        {
+            DrawText(text, static_cast<int>(x), static_cast<int>(y), static_cast<int>(fontSize), color);
+        }
+    }
+
+    void DrawTextUi(TextId id, float x, float y, float fontSize, Color color) const
+    {
+        DrawTextUi(Text(id), x, y, fontSize, color);
+    }
+
+    bool UiButton(Rectangle r, TextId text, bool active = false)
+    {
+        bool hovered = CheckCollisionPointRec(m_input.mouse, r);
+        Color fill = active ? Fade(Color{80, 140, 255, 255}, (m_theme == Theme::Dark ? 0.55f : 0.7f))
+                            : Fade((m_theme == Theme::Dark ? Color{26, 31, 40, 255} : Color{235, 238, 244, 255}), 0.96f);
+        if (hovered && !active)
+        {
+            fill = (m_theme == Theme::Dark) ? Color{36, 44, 56, 248} : Color{221, 228, 238, 250};
+        }
+        Color stroke = active ? Color{120, 180, 255, 255} : (hovered ? Color{92, 126, 170, 220} : PanelStroke());
+        Color txt = (m_theme == Theme::Dark) ? RAYWHITE : BLACK;
+
+        DrawRectangleRounded(r, 0.26f, 10, fill);
+        DrawRectangleRoundedLinesEx(r, 0.26f, 10, 1.4f, stroke);
+
+        float fs = 18.0f;
+        float tw = MeasureTextUi(text, fs);
+        QueuePanelLabel(text, r.x + (r.width - tw) * 0.5f, r.y + (r.height - fs) * 0.5f, fs, txt);
+
+        return hovered && m_input.MouseReleased(InputButton::Left);
+    }
+
+    bool UiToggle(Rectangle r, bool on, TextId left, TextId right)
+    {
+        bool hovered = CheckCollisionPointRec(m_input.mouse, r);
+        Color border = PanelStroke();
+        Color bg = (m_theme == Theme::Dark) ? Color{30, 36, 46, 240} : Color{230, 234, 242, 240};
+        if (hovered)
+        {
+            bg = (m_theme == Theme::Dark) ? Color{36, 43, 54, 248} : Color{223, 230, 240, 250};
+            border = (m_theme == Theme::Dark) ? Color{98, 130, 168, 220} : Color{150, 164, 184, 220};
+        }
+        DrawRectangleRounded(r, 0.5f, 16, bg);
+        DrawRectangleRoundedLinesEx(r, 0.5f, 16, 1.3f, border);
+
+        float knobW = r.height - 6.0f;
+        float knobX = on ? (r.x + r.width - knobW - 3.0f) : (r.x + 3.0f);
+        Rectangle knob{knobX, r.y + 3.0f, knobW, knobW};
+        DrawRectangleRounded(knob, 0.5f, 16, RAYWHITE);
+
+        Color txt = (m_theme == Theme::Dark) ? RAYWHITE : BLACK;
+        float fs = 20.0f;
+        QueuePanelLabel(left, r.x - MeasureTextUi(left, fs) - 12.0f, r.y + 4.0f, fs, txt);
+        QueuePanelLabel(right, r.x + r.width + 10.0f, r.y + 4.0f, fs, txt);
+
+        if (hovered && m_input.MouseReleased(InputButton::Left))
+        {
+            return true;
+        }
+        return false;
+    }
+
+    void QueuePanelLabel(TextId id, float x, float y, float fontSize, Color color)
+    {
+        if (m_panelLabelCount >= kMaxPanelLabels) return;
+        m_panelLabels[m_panelLabelCount++] = {ui_text::StringKey(id, m_language), x - m_panel.x, y - m_panel.y, fontSize, color};
+    }
+
+    // Redraws the label texture only when the queued labels changed (language,
+    // theme, layout or state colours), then blits it at the panel origin.
+    void FlushPanelLabels()
+    {
+        size_t n = m_panelLabelCount;
+        m_panelLabelCount = 0;
+        if (n == 0) return;
+
+        bool dirty = !m_panelLabelTargetLoaded || n != m_panelLabelsDrawnCount ||
+                     !std::equal(m_panelLabels.begin(), m_panelLabels.begin() + n, m_panelLabelsDrawn.begin());
+        if (dirty)
+        {
+            float w = 1.0f;
+            float h = 1.0f;
+            for (size_t i = 0; i < n; ++i)
+            {
+                const PanelLabel& l = m_panelLabels[i];
+                TextId id = static_cast<TextId>(l.key / kLanguageCount);
+                w = std::max(w, l.x + MeasureTextUi(id, l.size) + 2.0f);
+                h = std::max(h, l.y + l.size + 2.0f);
+            }
+            int tw = static_cast<int>(std::ceil(w));
+            int th = static_cast<int>(std::ceil(h));
+            if (m_panelLabelTargetLoaded && (m_panelLabelTarget.texture.width < tw || m_panelLabelTarget.texture.height < th))
+            {
+                UnloadRenderTexture(m_panelLabelTarget);
+                m_panelLabelTargetLoaded = false;
+            }
+            if (!m_panelLabelTargetLoaded)
+            {
+                m_panelLabelTarget = LoadRenderTexture(tw, th);
+                m_panelLabelTargetLoaded = true;
+            }
+
+            // Premultiplied colour with straight coverage alpha, so antialiased
+            // edges blend the same as drawing the text directly.
+            BeginTextureMode(m_panelLabelTarget);
+            ClearBackground(BLANK);
+            rlSetBlendFactorsSeparate(RL_SRC_ALPHA, RL_ONE_MINUS_SRC_ALPHA, RL_ONE, RL_ONE_MINUS_SRC_ALPHA, RL_FUNC_ADD, RL_FUNC_ADD);
+            BeginBlendMode(BLEND_CUSTOM_SEPARATE);
+            for (size_t i = 0; i < n; ++i)
+            {
+                const PanelLabel& l = m_panelLabels[i];
+                const char* text = ui_text::Get(static_cast<TextId>(l.key / kLanguageCount), static_cast<Language>(l.key % kLanguageCount));
+                DrawTextUi(text, l.x, l.y, l.size, l.color);
+            }
+            EndBlendMode();
+            EndTextureMode();
+
+            std::copy(m_panelLabels.begin(), m_panelLabels.begin() + n, m_panelLabelsDrawn.begin());
+            m_panelLabelsDrawnCount = n;
+        }
+
+        const Texture2D& tex = m_panelLabelTarget.texture;
+        Rectangle src{0.0f, 0.0f, static_cast<float>(tex.width), -static_cast<float>(tex.height)};
+        BeginBlendMode(BLEND_ALPHA_PREMULTIPLY);
+        DrawTextureRec(tex, src, {m_panel.x, m_panel.y}, WHITE);
+        EndBlendMode();
+    }
+
+    void HandlePanelInput()
+    {
+        if (m_recorder.IsOpen()) m_recorder.WritePanel();
+        HandlePanelDrag();
+        if (m_panel.collapsed) return;
+        m_panelLabelCount = 0;
+
+        float x = m_panel.x + 10;
+        float y = m_panel.y + 54;
+        float colGap = 8;
+        float bw = (m_panel.w - 10 * 2 - colGap) * 0.5f;
+        float bh = 34;
+
+        auto B = [&](TextId text, bool active, int col, UiCommand cmd, uint8_t arg = 0) {
+            Rectangle r{x + col * (bw + colGap), y, bw, bh};
+            if (UiButton(r, text, active)) RunUiCommand(cmd, arg);
+        };
+
+        auto stepRow = [&]() { y += bh + 8; };
+
+        B(TextId::Defaults, true, 0, UiCommand::Defaults);
+        B(TextId::ResetScene, false, 1, UiCommand::ResetScene);
+        stepRow();
+
+        B(TextId::Cube, false, 0, UiCommand::SpawnBox);
+        B(TextId::Ball, false, 1, UiCommand::SpawnCircle);
+        stepRow();
+
+        B(TextId::Triangle, false, 0, UiCommand::SpawnTriangle);
+        B(TextId::Cursor, m_tool == Tool::Cursor, 1, UiCommand::SetTool, static_cast<uint8_t>(Tool::Cursor));
+        stepRow();
+
+        B(TextId::Grid, false, 0, UiCommand::SpawnGrid, static_cast<uint8_t>(m_batchShape));
+        B(TextId::Rain, false, 1, UiCommand::SpawnRain, static_cast<uint8_t>(m_batchShape));
+        stepRow();
+
+        B(TextId::Weld, m_tool == Tool::Weld, 0, UiCommand::SetTool, static_cast<uint8_t>(Tool::Weld));
+        B(TextId::Wheel, m_tool == Tool::Wheel, 1, UiCommand::SetTool, static_cast<uint8_t>(Tool::Wheel));
+        stepRow();
+
+        B(TextId::Bounce, m_tool == Tool::Bounce, 0, UiCommand::SetTool, static_cast<uint8_t>(Tool::Bounce));
+        B(TextId::Slip, m_tool == Tool::Slip, 1, UiCommand::SetTool, static_cast<uint8_t>(Tool::Slip));
+        stepRow();
+
+        B(TextId::Sticky, m_tool == Tool::Sticky, 0, UiCommand::SetTool, static_cast<uint8_t>(Tool::Sticky));
+        B(TextId::Glass, m_tool == Tool::Glass, 1, UiCommand::SetTool, static_cast<uint8_t>(Tool::Glass));
+        stepRow();
+
+        B(TextId::Blast, m_tool == Tool::Blast, 0, UiCommand::SetTool, static_cast<uint8_t>(Tool::Blast));
+        stepRow();
+
+        B(TextId::Water, m_sceneLocation == SceneLocation::Water, 0, UiCommand::SetLocation, static_cast<uint8_t>(SceneLocation::Water));
+        B(TextId::Land, m_sceneLocation == SceneLocation::Land, 1, UiCommand::SetLocation, static_cast<uint8_t>(SceneLocation::Land));
+        stepRow();
+
+        B(TextId::DrawOff, m_drawTool == DrawTool::None, 0, UiCommand::SetDrawTool, static_cast<uint8_t>(DrawTool::None));
+        B(TextId::DrawQuad, m_drawTool == DrawTool::Quad, 1, UiCommand::SetDrawTool, static_cast<uint8_t>(DrawTool::Quad));
+        stepRow();
+
+        B(TextId::DrawCircle, m_drawTool == DrawTool::Circle, 0, UiCommand::SetDrawTool, static_cast<uint8_t>(DrawTool::Circle));
+        B(TextId::DrawTriangle, m_drawTool == DrawTool::Triangle, 1, UiCommand::SetDrawTool, static_cast<uint8_t>(DrawTool::Triangle));
+        stepRow();
+
+        B(TextId::DrawFreeform, m_drawTool == DrawTool::Freeform, 0, UiCommand::SetDrawTool, static_cast<uint8_t>(DrawTool::Freeform));
+        B(TextId::Pause, m_paused, 1, UiCommand::TogglePause);
+        stepRow();
+
+        B(TextId::Shallow, m_sceneLocation == SceneLocation::Shallow, 0, UiCommand::SetLocation, static_cast<uint8_t>(SceneLocation::Shallow));
+        Rectangle langT{ x + bw + colGap + (bw - 72) * 0.5f, y + 2, 72, 30};
+        if (UiToggle(langT, m_language == Language::EN, TextId::LangRu, TextId::LangEn))
+        {
+            RunUiCommand(UiCommand::ToggleLanguage);
+        }
+        y += 40;
+
+        Rectangle themeT{ x + bw + colGap + (bw - 72) * 0.5f, y + 2, 72, 30};
+        if (UiToggle(themeT, m_theme == Theme::Light, TextId::ThemeDark, TextId::ThemeLight))
+        {
+            RunUiCommand(UiCommand::ToggleTheme);
+        }
+        y += 40;
+
+        Rectangle pixelT{ x + bw + colGap + (bw - 72) * 0.5f, y + 2, 72, 30};
+        if (UiToggle(pixelT, m_pixelate, TextId::PixelOff, TextId::PixelOn))
+        {
+            RunUiCommand(UiCommand::TogglePixelate);
+        }
+        FlushPanelLabels();
+    }
+
+    void Update(float dt)
+    {
+        SLOP_ZONE("Update");
+        // Without the thread a fast-forward slice already holds the frame.
+        int fps = (m_fastForward && m_physicsThreaded) ? kFastForwardFps : m_fpsLimit;
+        // The pacer times low-latency frames; raylib must not sleep as well.
+        m_pacer.SetTargetFps(fps);
+        if (m_lowLatency) fps = 0;
+        if (m_lastAppliedFps != fps)
+        {
+            SetTargetFPS(fps);
+            m_lastAppliedFps = fps;
+        }
+
+        UpdateCamera(dt);
+        m_input = CaptureInput();
+        if (m_carried.valid) m_input.KeepEdgesOf(m_carried.edges);
+        m_carried = CarriedInput{};
+        m_input.world = m_view.ToWorld(m_input.mouse);
+        ++m_inputSerial;
+        m_inputSampleTime[m_inputSerial % kInputSampleHistory] = WallSeconds();
+
+        // Input normally runs alongside the step and only queues commands.
+        // A recording must see them land between the same steps its replay
+        // does, and the file keys read or replace the world, so those take
+        // the world and apply the commands right here, starting with any the
+        // simulation has not got to yet.
+        bool fileKey = m_input.KeyPressed(InputKey::F5) || m_input.KeyPressed(InputKey::F6) || m_input.KeyPressed(InputKey::F9);
+        std::unique_lock<std::mutex> lock(m_worldMutex, std::defer_lock);
+        if (m_physicsThreaded && (fileKey || m_recorder.IsOpen()))
+        {
+            lock.lock();
+            m_commandsInline = true;
+        }
+        if (fileKey || m_commandsInline) ApplyCommands();
+        {
+            FrameProfiler::Scope scope(m_profiler, ProfileStage::Input);
+            // Before recording, so the toggle frame itself is not in the stream.
+            if (m_input.KeyPressed(InputKey::F6))
+            {
+                if (m_recorder.IsOpen()) StopRecording();
+                else StartRecording(m_replayPath);
+            }
+            if (m_input.KeyPressed(InputKey::F5)) SaveScene(m_sceneFilePath);
+            if (m_input.KeyPressed(InputKey::F9))
+            {
+                // A replay cannot reproduce a file load, so the recording ends here.
+                if (m_recorder.IsOpen()) StopRecording();
+                LoadSceneAsync(m_sceneFilePath);
+            }
+            if (m_recorder.IsOpen()) m_recorder.WriteInput(m_input);
+            HandleKeyboard();
+            HandleMouse();
+            // Last, so by the time the simulation echoes the serial it has
+            // applied everything this sample produced.
+            SimCommand view;
+            view.type = SimCommandType::View;
+            view.rect = m_view.Visible(kCullMarginPx);
+            view.serial = m_inputSerial;
+            Submit(std::move(view));
+        }
+        if (m_commandsInline)
+        {
+            ApplyCommands();
+            m_commandsInline = false;
+        }
+
+        if (!m_physicsThreaded) SimulateFrame(dt, kMaxPhysicsStepsPerFrame);
+    }
+
+    // Enters idle while the simulation reports the scene at rest and nothing
+    // was touched for kIdleEnterFrames frames; raylib's event waiting then
+    // blocks each EndDrawing until the OS has something for the window. Any
+    // input, a resize or a dropped file leaves it before the frame that
+    // handles them.
+    bool UpdateIdle()
+    {
+        m_quietFrames = InputSeen() ? 0 : std::min(m_quietFrames + 1, kIdleEnterFrames);
+        bool idle = m_idleRendering && m_quietFrames >= kIdleEnterFrames && !m_showProfiler &&
+                    m_sceneAtRest.load(std::memory_order_relaxed);
+        if (idle == m_idle) return m_idle;
+        m_idle = idle;
+        m_physicsIdle.store(idle, std::memory_order_relaxed);
+        if (idle)
+        {
+            EnableEventWaiting();
+        }
+        else
+        {
+            DisableEventWaiting();
+            m_idleResumed = true;
+        }
+        return m_idle;
+    }
+
+    static InputFrame CaptureInput()
+    {
+        InputFrame f;
+        f.mouse = GetMousePosition();
+        f.world = f.mouse;
+        f.time = static_cast<float>(GetTime());
+        const std::pair<int, InputButton> buttons[] = {{MOUSE_BUTTON_LEFT, InputButton::Left}, {MOUSE_BUTTON_RIGHT, InputButton::Right}};
+        for (const auto& [button, input] : buttons)
+        {
+            uint8_t bit = InputFrame::MouseBit(input);
+            if (IsMouseButtonDown(button)) f.mouseDown |= bit;
+            if (IsMouseButtonPressed(button)) f.mousePressed |= bit;
+            if (IsMouseButtonReleased(button)) f.mouseReleased |= bit;
+        }
+        for (size_t i = 0; i < sizeof(kInputKeyCodes) / sizeof(kInputKeyCodes[0]); ++i)
+        {
+            if (IsKeyDown(kInputKeyCodes[i])) f.keysDown |= uint64_t{1} << i;
+            if (IsKeyPressed(kInputKeyCodes[i])) f.keysPressed |= uint64_t{1} << i;
+        }
+        return f;
+    }
+
+    // Anything in the last poll that the next frame could act on. The key
+    // queue is read nowhere else, so draining it here loses nothing.
+    static bool InputSeen()
+    {
+        InputFrame f = CaptureInput();
+        if (f.keysDown || f.keysPressed || f.mouseDown || f.mousePressed || f.mouseReleased) return true;
+        if (IsKeyDown(KEY_LEFT) || IsKeyDown(KEY_RIGHT) || IsKeyDown(KEY_UP) || IsKeyDown(KEY_DOWN)) return true;
+        if (IsMouseButtonDown(MOUSE_BUTTON_MIDDLE) || GetMouseWheelMove() != 0.0f) return true;
+        Vector2 delta = GetMouseDelta();
+        if (delta.x != 0.0f || delta.y != 0.0f) return true;
+        bool pressed = false;
+        while (GetKeyPressed() != 0) pressed = true;
+        return pressed || IsWindowResized() || IsFileDropped();
+    }
+
+    // Sleeps until the pacer's start and polls input again, keeping what the
+    // poll at the end of the last frame saw (presses, wheel, pan) for Update.
+    void PollLateInput()
+    {
+        m_carried.valid = true;
+        m_carried.edges = CaptureInput();
+        m_carried.wheel = GetMouseWheelMove();
+        m_carried.mouseDelta = GetMouseDelta();
+        m_carried.home = IsKeyPressed(KEY_HOME);
+        m_pacer.Wait();
+        PollInputEvents();
+    }
+
+    static double WallSeconds()
+    {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    // From the sample behind what this frame draws to its swap request; the
+    // wait for vblank inside the swap is not in it.
+    void RecordInputLatency()
+    {
+        const RenderSnapshot& cur = m_snapshots.ReadBuffer();
+        uint32_t serial = SnapshotAlpha() >= 1.0f ? cur.inputSerial : m_prevSnapshot.inputSerial;
+        if (serial == 0 || m_inputSerial - serial >= kInputSampleHistory) return;
+        m_profiler.SetInputLatency((WallSeconds() - m_inputSampleTime[serial % kInputSampleHistory]) * 1000.0);
+    }
+
+    // Wheel zooms at the cursor, middle drag or the arrow keys pan, Home
+    // resets. Read straight from raylib: the view is not simulation state, and
+    // recordings carry the world-space mouse instead.
+    void UpdateCamera(float dt)
+    {
+        float wheel = GetMouseWheelMove() + m_carried.wheel;
+        if (wheel != 0.0f) m_view.ZoomAt(GetMousePosition(), std::pow(1.1f, wheel));
+        if (IsMouseButtonDown(MOUSE_BUTTON_MIDDLE))
+        {
+            Vector2 delta = GetMouseDelta();
+            m_view.Pan({delta.x + m_carried.mouseDelta.x, delta.y + m_carried.mouseDelta.y});
+        }
+
+        Vector2 dir{0.0f, 0.0f};
+        if (IsKeyDown(KEY_LEFT)) dir.x -= 1.0f;
+        if (IsKeyDown(KEY_RIGHT)) dir.x += 1.0f;
+        if (IsKeyDown(KEY_UP)) dir.y -= 1.0f;
+        if (IsKeyDown(KEY_DOWN)) dir.y += 1.0f;
+        if (dir.x != 0.0f || dir.y != 0.0f) m_view.Pan({-dir.x * kCameraPanSpeedPx * dt, -dir.y * kCameraPanSpeedPx * dt});
+        if (IsKeyPressed(KEY_HOME) || m_carried.home) m_view.Reset();
+    }
+
+    // Swaps in the newest snapshot, keeping the previous one for interpolation.
+    void AcquireSnapshot()
+    {
+        if (!m_snapshots.HasFresh()) return;
+        std::swap(m_prevSnapshot, m_snapshots.ReadBuffer());
+        m_snapshots.Acquire();
+        SyncViewBounds(m_snapshots.ReadBuffer().worldWidth);
+    }
+
+    // A new world width (SetWorldWidth, a scene load, a replay) resets the view.
+    void SyncViewBounds(float worldWidth)
+    {
+        if (worldWidth <= 0.0f || worldWidth == m_viewWorldWidth) return;
+        m_viewWorldWidth = worldWidth;
+        m_view.SetWorldBounds({0.0f, 0.0f, worldWidth, static_cast<float>(m_height)});
+        m_view.Reset();
+    }
+
+    // Blend factor between m_prevSnapshot and the current one. Drawing one tick
+    // behind the newest snapshot keeps motion smooth when render and physics rates differ.
+    float SnapshotAlpha() const
+    {
+        if (!m_physicsThreaded) return 1.0f;
+        const RenderSnapshot& cur = m_snapshots.ReadBuffer();
+        double span = cur.wallTime - m_prevSnapshot.wallTime;
+        if (span <= 1e-6) return 1.0f;
+        double now = std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+        double renderTime = now - kFixedDt;
+        return static_cast<float>(std::clamp((renderTime - m_prevSnapshot.wallTime) / span, 0.0, 1.0));
+    }
+
+    // Appends the body to m_bodyBatch; the caller flushes once per frame.
+    static float BoundingRadiusPx(const ShapeGeometry& outline)
+    {
+        float r2 = 0.0f;
+        for (const Vector2& v : outline) r2 = std::max(r2, v.x * v.x + v.y * v.y);
+        return std::sqrt(r2);
+    }
+
+    // Appends the body to batch at the level of detail its on-screen size
+    // (at zoom) calls for; see BodyLod. The caller flushes once per frame.
+    void DrawBody(BodyBatch& batch, const SnapshotBody& b, const ShapeGeometry& outline, const SnapshotBody* prev, float alpha, float zoom)
+    {
+        b2Transform xf = b.xf;
+        if (prev && alpha < 1.0f)
+        {
+            xf.p = b2Lerp(prev->xf.p, b.xf.p, alpha);
+            xf.q = b2NLerp(prev->xf.q, b.xf.q, alpha);
+        }
+        Vector2 c = ToPixels(xf.p);
+
+        const Color selection{80, 170, 255, 240};
+        Color stroke = AccentColor();
+        Color fill = b.fill;
+        const BodyLod& lod = m_bodyLod;
+        bool isCircle = b.kind == BodyKind::Circle;
+        if (!isCircle && outline.empty()) return;
+        float screenSize = 2.0f * (isCircle ? b.radiusPx : BoundingRadiusPx(outline)) * zoom;
+
+        // Without an outline the faint fill alone would vanish, so small
+        // bodies draw it opaque enough to read, in the selection colour when selected.
+        bool outlined = screenSize >= lod.outlinePx;
+        bool detailed = screenSize >= lod.detailPx;
+        if (!outlined && !b.isDebris) fill = b.selected ? Fade(selection, 0.6f) : Color{fill.r, fill.g, fill.b, std::max<unsigned char>(fill.a, 140)};
+        else if (b.selected && !detailed) stroke = selection;
+
+        if (screenSize < lod.pointPx)
+        {
+            // One dot per pointPx screen cell, however many bodies share it.
+            float cell = lod.pointPx / zoom;
+            float cx = std::floor(c.x / cell);
+            float cy = std::floor(c.y / cell);
+            uint64_t key = uint64_t{static_cast<uint32_t>(static_cast<int32_t>(cx))} << 32 | static_cast<uint32_t>(static_cast<int32_t>(cy));
+            if (!m_lodCells.insert(key).second) return;
+            batch.AddRect(cx * cell, cy * cell, (cx + 1.0f) * cell, (cy + 1.0f) * cell, fill);
+            return;
+        }
+
+        if (isCircle)
+        {
+            if (screenSize < lod.boxPx)
+            {
+                batch.AddRect(c.x - b.radiusPx, c.y - b.radiusPx, c.x + b.radiusPx, c.y + b.radiusPx, fill);
+                return;
+            }
+            int step = BodyBatch::CircleStep(b.radiusPx * zoom, lod.circleSegmentPx);
+            batch.AddCircleFill(c, b.radiusPx, fill, step);
+            if (outlined) batch.AddCircleOutline(c, b.radiusPx, 1.0f, stroke, step);
+            if (!detailed) return;
+            if (b.selected)
+            {
+                batch.AddCircleOutline(c, b.radiusPx + 3.5f, 1.0f, selection, step);
+            }
+            if (b.isWheel)
+            {
+                batch.AddCircleOutline(c, 6.0f, 1.0f, stroke, BodyBatch::CircleStep(6.0f * zoom, lod.circleSegmentPx));
+                batch.AddCircleFill(c, 1.8f, stroke, BodyBatch::CircleStep(1.8f * zoom, lod.circleSegmentPx));
+            }
+            return;
+        }
+
+        m_worldVertsScratch.resize(outline.size());
+        float cs = xf.q.c;
+        float sn = xf.q.s;
+        for (size_t i = 0; i < outline.size(); ++i)
+        {
+            const Vector2& lv = outline[i];
+            m_worldVertsScratch[i] = {c.x + lv.x * cs - lv.y * sn, c.y + lv.x * sn + lv.y * cs};
+        }
+
+        const Vector2* pts = m_worldVertsScratch.data();
+        size_t n = m_worldVertsScratch.size();
+        if (screenSize < lod.boxPx)
+        {
+            Vector2 lo = pts[0];
+            Vector2 hi = pts[0];
+            for (size_t i = 1; i < n; ++i)
+            {
+                lo = {std::min(lo.x, pts[i].x), std::min(lo.y, pts[i].y)};
+                hi = {std::max(hi.x, pts[i].x), std::max(hi.y, pts[i].y)};
+            }
+            batch.AddRect(lo.x, lo.y, hi.x, hi.y, fill);
+            return;
+        }
+
+        batch.AddConvexFill(pts, n, fill);
+        if (outlined) batch.AddClosedOutline(pts, n, 2.2f, stroke);
+        if (!detailed) return;
+        if (b.selected)
+        {
+            batch.AddClosedOutline(pts, n, 5.0f, Color{80, 170, 255, 120});
+        }
+
+        if (b.isWheel)
+        {
+            batch.AddCircleOutline(c, 6.0f, 1.0f, stroke, BodyBatch::CircleStep(6.0f * zoom, lod.circleSegmentPx));
+            batch.AddCircleFill(c, 1.8f, stroke, BodyBatch::CircleStep(1.8f * zoom, lod.circleSegmentPx));
+        }
+    }
+
+    void DrawBodies(const RenderSnapshot& snap)
+    {
+        // Resting bodies do not move, so their triangles are only rebuilt when
+        // the resting set, a resting body's look, the theme or the zoom (for
+        // the level of detail) changes.
+        float zoom = m_view.Zoom();
+        if (snap.restingVersion != m_restingBatchVersion || m_theme != m_restingBatchTheme || zoom != m_restingBatchZoom)
+        {
+            m_restingBatch.Clear();
+            m_lodCells.clear();
+            for (const SnapshotBody& b : snap.resting)
+            {
+                DrawBody(m_restingBatch, b, b.shape < snap.shapes.size() ? snap.shapes[b.shape] : snap.shapes[0], nullptr, 1.0f, zoom);
+            }
+            m_restingBatchVersion = snap.restingVersion;
+            m_restingBatchTheme = m_theme;
+            m_restingBatchZoom = zoom;
+        }
+        m_restingBatch.Submit();
+
+        float alpha = SnapshotAlpha();
+        const std::vector<SnapshotBody>& prev = m_prevSnapshot.bodies;
+        m_bodyBatch.Clear();
+        m_lodCells.clear();
+        size_t next = 0;
+        for (const SnapshotBody& b : snap.bodies)
+        {
+            // Both lists are in spawn order; bodies falling asleep or waking
+            // only shift it by a few entries.
+            const SnapshotBody* p = nullptr;
+            for (size_t k = next; k < prev.size() && k < next + kInterpLookahead; ++k)
+            {
+                if (prev[k].key != b.key) continue;
+                p = &prev[k];
+                next = k + 1;
+                break;
+            }
+            const std::vector<ShapeGeometry>& shapes = b.isDebris ? snap.debrisShapes : snap.shapes;
+            DrawBody(m_bodyBatch, b, b.shape < shapes.size() ? shapes[b.shape] : shapes[0], p, alpha, zoom);
+        }
+        m_bodyBatch.Flush();
+    }
+
+    void DrawWater(const RenderSnapshot& snap)
+    {
+        const std::vector<float>& disp = snap.waveDisp;
+        if (!InWater() || disp.size() < 2) return;
+
+        Color accent = AccentColor();
+        Color fill = Fade(accent, (m_theme == Theme::Dark) ? 0.08f : 0.06f);
+        Color spray = accent;
+        spray.a = 220;
+
+        // Only the columns in view, and zoomed out only every stride-th one,
+        // so the surface stays at about one column per m_waveStep screen px.
+        Rectangle view = m_view.Visible();
+        size_t stride = static_cast<size_t>(std::max(1.0f, std::floor(1.0f / m_view.Zoom())));
+        size_t first = static_cast<size_t>(std::max(0.0f, std::floor(view.x / m_waveStep) - 1.0f));
+        first -= first % stride;
+        size_t last = std::min(disp.size() - 1, static_cast<size_t>(std::max(0.0f, std::ceil((view.x + view.width) / m_waveStep) + 1.0f)));
+        m_waveVisibleScratch.clear();
+        for (size_t i = first; i < last + stride; i += stride) m_waveVisibleScratch.push_back(disp[std::min(i, last)]);
+        const float* cols = m_waveVisibleScratch.data();
+        size_t count = m_waveVisibleScratch.size();
+        float x0 = static_cast<float>(first) * m_waveStep;
+        float step = static_cast<float>(stride) * m_waveStep;
+
+        if (m_gpuEffects)
+        {
+            m_gpu.DrawSurface(cols, count, x0, step, m_waveBaselineY, static_cast<float>(m_height), fill, accent, 2.5f);
+            m_gpu.DrawParticles(kSprayLane, spray, m_particleTex.id);
+            return;
+        }
+        if (m_waterMesh.Draw(cols, count, x0, step, m_waveBaselineY, static_cast<float>(m_height), fill, accent, 2.5f))
+        {
+            DrawParticles(snap.waterChunks, spray);
+            return;
+        }
+
+        m_wavePointsScratch.clear();
+        m_wavePointsScratch.reserve(count);
+        for (size_t i = 0; i < count; ++i)
+        {
+            float x = x0 + static_cast<float>(i) * step;
+            m_wavePointsScratch.push_back({x, m_waveBaselineY + cols[i]});
+        }
+
+        for (size_t i = 0; i + 1 < m_wavePointsScratch.size(); ++i)
+        {
+            Vector2 a = m_wavePointsScratch[i];
+            Vector2 b = m_wavePointsScratch[i + 1];
+            DrawLineEx(a, b, 2.5f, accent);
+            DrawTriangle(a, b, {b.x, static_cast<float>(m_height)}, fill);
+            DrawTriangle(a, {b.x, static_cast<float>(m_height)}, {a.x, static_cast<float>(m_height)}, fill);
+        }
+
+        // Water spray particles/chunks
+        DrawParticles(snap.waterChunks, spray);
+    }
+
+    // Background and ground from the cached layer, in screen space; drawn
+    // first, before the water, so the ground line shows through the water fill.
+    void DrawBackdrop()
+    {
+        float groundY = GroundScreenY();
+        uint64_t key = CachedLayer::Key()
+                           .Add(static_cast<uint64_t>(m_theme))
+                           .Add(static_cast<uint64_t>(InWater()))
+                           .Add(groundY)
+                           .Value();
+        m_backdropLayer.Draw(key, m_width, m_height, {0.0f, 0.0f}, [&]() {
+            ClearBackground(BgColor());
+            DrawGround();
+        });
+        if (m_backdropLayer.Loaded()) return;
+        ClearBackground(BgColor());
+        DrawGround();
+    }
+
+    // The ground runs past both world edges, so on screen it always spans the width.
+    float GroundScreenY() const { return m_view.ToScreen({0.0f, ActiveGroundTopYPx()}).y; }
+
+    void DrawGround()
+    {
+        float y = GroundScreenY();
+        Color accent = AccentColor();
+        float fillAlpha = InWater() ? ((m_theme == Theme::Dark) ? 0.03f : 0.025f) : ((m_theme == Theme::Dark) ? 0.08f : 0.06f);
+        Color fill = Fade(accent, fillAlpha);
+
+        DrawRectangle(0, static_cast<int>(y), m_width, m_height - static_cast<int>(y), fill);
+        DrawLineEx({0.0f, y}, {static_cast<float>(m_width), y}, 3.0f, accent);
+    }
+
+    // Panel chrome only; buttons and labels come from HandlePanelInput.
+    void DrawPanel()
+    {
+        constexpr float kMargin = 2.0f; // room for the outline strokes
+        float bodyH = static_cast<float>(m_height) - m_panel.y - 60;
+        float h = (m_panel.collapsed || bodyH <= 0.0f) ? 46.0f : 50.0f + bodyH;
+        uint64_t key = CachedLayer::Key()
+                           .Add(m_panel.w)
+                           .Add(bodyH)
+                           .Add(static_cast<uint64_t>(m_panel.collapsed))
+                           .Add(static_cast<uint64_t>(m_theme))
+                           .Add(static_cast<uint64_t>(m_language))
+                           .Value();
+        int w = static_cast<int>(std::ceil(m_panel.w + 2.0f * kMargin));
+        m_panelLayer.Draw(key, w, static_cast<int>(std::ceil(h + 2.0f * kMargin)), {m_panel.x - kMargin, m_panel.y - kMargin},
+                          [&]() { PaintPanelChrome(kMargin, kMargin, bodyH); });
+        if (!m_panelLayer.Loaded()) PaintPanelChrome(m_panel.x, m_panel.y, bodyH);
+    }
+
+    void PaintPanelChrome(float px, float py, float bodyH)
+    {
+        Rectangle header{px, py, m_panel.w, 46};
+        DrawRectangleRounded(header, 0.33f, 12, PanelBg());
+        DrawRectangleRoundedLinesEx(header, 0.33f, 12, 1.3f, PanelStroke());
+
+        DrawTextUi(TextId::Move, px + 16.0f, py + 13.0f, 20.0f, AccentColor());
+
+        Rectangle collapseBtn{px + m_panel.w - 38, py + 7, 30, 30};
+        DrawRectangleRounded(collapseBtn, 0.32f, 8, Fade(BLUE, 0.35f));
+        DrawTextUi(m_panel.collapsed ? TextId::Expand : TextId::Collapse, collapseBtn.x + 10.0f, collapseBtn.y + 5.0f, 22.0f, RAYWHITE);
+
+        if (m_panel.collapsed || bodyH <= 0.0f) return;
+
+        Rectangle body{px, py + 50, m_panel.w, bodyH};
+        DrawRectangleRounded(body, 0.06f, 10, PanelBg());
+        DrawRectangleRoundedLinesEx(body, 0.06f, 10, 1.2f, PanelStroke());
+    }
+
+    void DrawOverlayText()
+    {
+        Color txt = AccentColor();
+        float fs = 18.0f;
+        float x = m_panel.x + 12.0f;
+        float y = m_panel.y + (m_panel.collapsed ? 56.0f : static_cast<float>(m_height - 120));
+
+        TextId tool = TextId::ToolCursor;
+        switch (m_tool)
+        {
+            case Tool::Cursor: tool = TextId::ToolCursor; break;
+            case Tool::Weld: tool = TextId::ToolWeld; break;
+            case Tool::Wheel: tool = TextId::ToolWheel; break;
+            case Tool::Bounce: tool = TextId::ToolBounce; break;
+            case Tool::Slip: tool = TextId::ToolSlip; break;
+            case Tool::Sticky: tool = TextId::ToolSticky; break;
+            case Tool::Glass: tool = TextId::ToolGlass; break;
+            case Tool::Blast: tool = TextId::ToolBlast; break;
+        }
+
+        // A background load shows its progress instead.
+        const RenderSnapshot& snap = m_snapshots.ReadBuffer();
+        if (snap.sceneLoad >= 0.0f)
+        {
+            float w = 240.0f;
+            DrawTextUi(TextFormat(Text(TextId::LoadingSceneFormat), static_cast<int>(snap.sceneLoad * 100.0f)), x, y, fs, txt);
+            Rectangle bar{x, y + 28.0f, w, 10.0f};
+            DrawRectangleRec(bar, PanelBg());
+            DrawRectangleRec({bar.x, bar.y, w * std::min(snap.sceneLoad, 1.0f), bar.height}, txt);
+            DrawRectangleLinesEx(bar, 1.0f, PanelStroke());
+            return;
+        }
+
+        // TextFormat writes into raylib's static ring buffer, so no allocation here.
+        DrawTextUi(TextFormat("FPS %d", GetFPS()), x, y, fs, txt);
+        DrawTextUi(tool, x, y + 24.0f, fs, txt);
+        DrawTextUi(TextFormat(Text(TextId::TimeSpeedFormat), m_timeScale.load()), x, y + 48.0f, fs, txt);
+        DrawTextUi(m_pixelate ? TextId::PixelStateOn : TextId::PixelStateOff, x, y + 72.0f, fs, txt);
+        if (snap.fastForward) DrawTextUi(TextFormat(Text(TextId::FastForwardFormat), snap.fastForwardS), x, y + 96.0f, fs, txt);
+        else if (snap.rewindBehindS > 0.0f) DrawTextUi(TextFormat(Text(TextId::RewindFormat), snap.rewindBehindS), x, y + 96.0f, fs, txt);
+    }
+
+    void DrawWeldCursor()
+    {
+        if (!m_snapshots.ReadBuffer().pendingWeldValid) return;
+        DrawCircleLinesLod(m_weldCursor, 8.0f / m_view.Zoom(), Color{80, 170, 255, 220});
+    }
+
+    // Rolling per-stage timings, Box2D step breakdown and a frame-time histogram (F3).
+    void DrawProfilerOverlay()
+    {
+        const FrameStats& avg = m_profiler.Mean();
+        const FrameStats& last = m_profiler.Last();
+        const RenderSnapshot& snap = m_snapshots.ReadBuffer();
+        Color txt = AccentColor();
+        float fs = 15.0f;
+        float lh = 17.0f;
+        float w = 300.0f;
+        float x = static_cast<float>(m_width) - w - 10.0f;
+        float y = 10.0f;
+        int heapLines = 0;
+        for (const box2d_heap::Stats& st : snap.b2HeapSubsystems)
+        {
+            if (st.allocs > 0) ++heapLines;
+        }
+        int lines = (heap_stats::kEnabled ? 25 : 24) + heapLines + static_cast<int>(ProfileStage::Count);
+        Rectangle box{x - 8.0f, y - 6.0f, w + 16.0f, lines * lh + 70.0f};
+        DrawRectangleRounded(box, 0.06f, 8, PanelBg());
+        DrawRectangleRoundedLinesEx(box, 0.06f, 8, 1.3f, PanelStroke());
+
+        DrawTextUi(TextFormat("frame %.2f ms (max %.2f)  cpu %.2f ms", avg.frameMs, m_profiler.MaxFrameMs(), avg.cpuMs), x, y, fs, txt);
+        y += lh;
+        if (m_lowLatency)
+        {
+            DrawTextUi(TextFormat("input->present %.2f ms (max %.2f)  low latency, wait %.2f predict %.2f", avg.inputLatencyMs,
+                                  m_profiler.MaxInputLatencyMs(), m_pacer.LastWaitMs(), m_pacer.PredictedMs()), x, y, fs, txt);
+        }
+        else
+        {
+            DrawTextUi(TextFormat("input->present %.2f ms (max %.2f)  %s", avg.inputLatencyMs, m_profiler.MaxInputLatencyMs(),
+                                  m_physicsThreaded ? "threaded" : "sync"), x, y, fs, txt);
+        }
+        y += lh;
+        if (m_dynamicRes)
+        {
+            DrawTextUi(TextFormat("gpu %.2f ms (target %.2f)  resolution %.0f%%%s", m_resScale.SmoothedMs(), m_resScale.TargetMs(), m_resScale.Scale() * 100.0f,
+                                  m_pixelate ? ", pixelate overrides" : ""), x, y, fs, txt);
+        }
+        else
+        {
+            DrawTextUi(m_dynamicResAllowed ? "dynamic resolution unavailable (no GPU timer)" : "dynamic resolution off", x, y, fs, txt);
+        }
+        y += lh;
+        for (int s = 0; s < static_cast<int>(ProfileStage::Count); ++s)
+        {
+            DrawTextUi(TextFormat("  %-10s %7.3f ms", FrameProfiler::StageName(static_cast<ProfileStage>(s)), avg.stageMs[static_cast<size_t>(s)]), x, y, fs, txt);
+            y += lh;
+        }
+
+        y += 4.0f;
+        DrawTextUi(TextFormat("b2 step %.3f ms x%d/frame, %d workers%s, %s", avg.b2Step, avg.physicsSteps, snap.workerCount, m_physicsThreaded ? ", threaded" : "", SimdLevelName(b2GetSimdLevel())), x, y, fs, txt);
+        y += lh;
+        DrawTextUi(TextFormat("  broadphase %.3f  collide %.3f", avg.b2Pairs, avg.b2Collide), x, y, fs, txt);
+        y += lh;
+        DrawTextUi(TextFormat("  solve %.3f  refit %.3f", avg.b2Solve, avg.b2Refit), x, y, fs, txt);
+        y += lh;
+        DrawTextUi(TextFormat("  continuous %.3f  sleep %.3f  bullets %d/%d (%llu evicted)", avg.b2Continuous, avg.b2Sleep, last.bulletCount,
+                              snap.bulletBudget, static_cast<unsigned long long>(last.bulletEvictions)), x, y, fs, txt);
+        y += lh;
+        DrawTextUi(TextFormat("  substeps %d  catch-up %d  budget %.1f ms (%s)", snap.subSteps, snap.catchUpSteps, snap.stepBudgetMs,
+                              StepController::DecisionName(snap.stepDecision)), x, y, fs, txt);
+        y += lh;
+
+        y += 4.0f;
+        DrawTextUi(TextFormat("bodies %d  awake %d  contacts %d", last.bodyCount, last.awakeBodyCount, last.contactCount), x, y, fs, txt);
+        y += lh;
+        DrawTextUi(TextFormat("joints %d  islands %d  tasks %d", last.jointCount, last.islandCount, last.taskCount), x, y, fs, txt);
+        y += lh;
+        DrawTextUi(TextFormat("rewind %.1f s in %.2f MB", snap.rewindSpanS, snap.rewindBytes / 1048576.0), x, y, fs, txt);
+        y += lh;
+        DrawTextUi(TextFormat("hibernated %zu bodies in %zu regions, %.2f MB%s", snap.hibernatedBodies, snap.hibernatedRegions,
+                              snap.hibernatedBytes / 1048576.0, snap.hibernation ? "" : " (off)"), x, y, fs, txt);
+        y += lh;
+        DrawTextUi(TextFormat("adhesion %zu welds  %zu queued", snap.adhesions, snap.adhesionsQueued), x, y, fs, txt);
+        y += lh;
+        DrawTextUi(TextFormat("deferred %u ran  %u forced  %u dropped  %u pending  %.2f ms", snap.deferred.ran, snap.deferred.forced,
+                              snap.deferred.dropped, snap.deferred.pending, snap.deferred.ms), x, y, fs, txt);
+        y += lh;
+        if (m_gpuEffects)
+        {
+            // Slots in use; the GPU path never reads its particles back.
+            DrawTextUi(TextFormat("gpu particle slots %d + %d", static_cast<int>(m_gpu.Resident(kShardLane)), static_cast<int>(m_gpu.Resident(kSprayLane))), x, y, fs, txt);
+        }
+        else
+        {
+            DrawTextUi(TextFormat("particles %d + %d", static_cast<int>(m_snapshots.ReadBuffer().shards.size()), static_cast<int>(m_snapshots.ReadBuffer().waterChunks.size())), x, y, fs, txt);
+        }
+        y += lh;
+        if (heap_stats::kEnabled)
+        {
+            DrawTextUi(TextFormat("heap allocs %.1f/frame (last %.0f)  arena %zu KB", avg.heapAllocs, last.heapAllocs, m_frameArena.HighWater() / 1024), x, y, fs, txt);
+            y += lh;
+        }
+        DrawTextUi(TextFormat("b2 heap %.2f MB (peak %.2f)  pooled %.2f MB", snap.b2HeapTotal.liveBytes / 1048576.0, snap.b2HeapTotal.peakBytes / 1048576.0,
+                              snap.b2HeapPooledBytes / 1048576.0), x, y, fs, txt);
+        y += lh;
+        for (int s = 0; s < static_cast<int>(box2d_heap::Subsystem::Count); ++s)
+        {
+            auto sub = static_cast<box2d_heap::Subsystem>(s);
+            const box2d_heap::Stats& st = snap.b2HeapSubsystems[static_cast<size_t>(s)];
+            if (st.allocs == 0) continue;
+            DrawTextUi(TextFormat("  %-6s %8.1f KB (peak %.1f)  %.0f/s", box2d_heap::SubsystemName(sub), st.liveBytes / 1024.0, st.peakBytes / 1024.0,
+                                  snap.b2AllocsPerSecond[static_cast<size_t>(s)]), x, y, fs, txt);
+            y += lh;
+        }
+        DrawTextUi(m_profiler.CsvOpen() ? TextFormat("CSV: %s (F4 stop)", m_profileCsvPath.c_str()) : "CSV: off (F4)", x, y, fs, txt);
+        y += lh + 6.0f;
+
+        // Histogram of frame times over the rolling window, 4 ms per bucket.
+        auto hist = m_profiler.FrameHistogram();
+        int peak = std::max(1, *std::max_element(hist.begin(), hist.end()));
+        float barW = w / static_cast<float>(FrameProfiler::kHistogramBuckets);
+        float barH = 54.0f;
+        for (int i = 0; i < FrameProfiler::kHistogramBuckets; ++i)
+        {
+            float h = barH * static_cast<float>(hist[static_cast<size_t>(i)]) / static_cast<float>(peak);
+            Color bar = (i * FrameProfiler::kHistogramBucketMs >= 16.0) ? Color{230, 90, 70, 220} : Fade(txt, 0.7f);
+            DrawRectangleRec({x + i * barW + 1.0f, y + barH - h, barW - 2.0f, h}, bar);
+        }
+        DrawTextUi(TextFormat("0..%d ms", static_cast<int>(FrameProfiler::kHistogramBuckets * FrameProfiler::kHistogramBucketMs)), x, y + barH + 2.0f, 13.0f, txt);
+    }
+
+    void DrawShards(const RenderSnapshot& snap)
+    {
+        Color base = (m_theme == Theme::Dark) ? Color{245, 245, 255, 200} : Color{20, 20, 26, 180};
+        if (m_gpuEffects) m_gpu.DrawParticles(kShardLane, base, m_particleTex.id);
+        else DrawParticles(snap.shards, base);
+    }
+
+    // One textured-quad batch per pool; alpha fades with remaining life.
+    void DrawParticles(const ParticleFrame& pool, Color base)
+    {
+        if (pool.empty()) return;
+        if (!m_particleTexLoaded)
+        {
+            for (size_t i = 0; i < pool.size(); ++i)
+            {
+                Color c = base;
+                c.a = static_cast<unsigned char>(base.a * pool.life[i]);
+                DrawCircleV({pool.x[i], pool.y[i]}, pool.radius[i], c);
+            }
+            return;
+        }
+
+        rlSetTexture(m_particleTex.id);
+        rlBegin(RL_QUADS);
+        rlNormal3f(0.0f, 0.0f, 1.0f);
+        for (size_t i = 0; i < pool.size(); ++i)
+        {
+            rlCheckRenderBatchLimit(4);
+            float x = pool.x[i];
+            float y = pool.y[i];
+            float r = pool.radius[i];
+            rlColor4ub(base.r, base.g, base.b, static_cast<unsigned char>(base.a * pool.life[i]));
+            rlTexCoord2f(0.0f, 0.0f);
+            rlVertex2f(x - r, y - r);
+            rlTexCoord2f(0.0f, 1.0f);
+            rlVertex2f(x - r, y + r);
+            rlTexCoord2f(1.0f, 1.0f);
+            rlVertex2f(x + r, y + r);
+            rlTexCoord2f(1.0f, 0.0f);
+            rlVertex2f(x + r, y - r);
+        }
+        rlEnd();
+        rlSetTexture(0);
+    }
+
+    // DrawCircleLinesV under the world camera, with segments for its on-screen size.
+    void DrawCircleLinesLod(Vector2 center, float radius, Color color) const
+    {
+        int sides = BodyBatch::kCircleSegments / BodyBatch::CircleStep(radius * m_view.Zoom(), m_bodyLod.circleSegmentPx);
+        DrawPolyLines(center, sides, radius, 0.0f, color);
+    }
+
+    void DrawDrawPreview()
+    {
+        if (!m_drawing) return;
+        Color c = Color{80, 170, 255, 220};
+        if (m_drawTool == DrawTool::Quad)
+        {
+            Rectangle r = NormalizeRect(m_drawStart, m_drawCurrent);
+            DrawRectangleLinesEx(r, 2.0f, c);
+        }
+        else if (m_drawTool == DrawTool::Circle)
+        {
+            Rectangle r = NormalizeRect(m_drawStart, m_drawCurrent);
+            float d = std::min(r.width, r.height);
+            Vector2 cc{r.x + r.width * 0.5f, r.y + r.height * 0.5f};
+            DrawCircleLinesLod(cc, d * 0.5f, c);
+        }
+        else if (m_drawTool == DrawTool::Triangle)
+        {
+            Rectangle r = NormalizeRect(m_drawStart, m_drawCurrent);
+            float h = r.height;
+            float w = 2.0f * h / std::sqrt(3.0f);
+            if (w > r.width)
+            {
+                w = r.width;
+                h = w * std::sqrt(3.0f) * 0.5f;
+            }
+            Vector2 center{r.x + r.width * 0.5f, r.y + r.height * 0.5f};
+            Vector2 a{center.x, center.y - h * 0.5f};
+            Vector2 b{center.x + w * 0.5f, center.y + h * 0.5f};
+            Vector2 d{center.x - w * 0.5f, center.y + h * 0.5f};
+            DrawTriangleLines(a, b, d, c);
+        }
+        else if (m_drawTool == DrawTool::Freeform)
+        {
+            for (size_t i = 1; i < m_freeformPoints.size(); ++i)
+            {
+                DrawLineEx(m_freeformPoints[i - 1], m_freeformPoints[i], 2.0f, c);
+            }
+        }
+    }
+
+    void DrawSelectionRect()
+    {
+        const RenderSnapshot& snap = m_snapshots.ReadBuffer();
+        if (!snap.selecting) return;
+        DrawRectangleLinesEx(snap.selectionRect, 1.6f, Color{80, 170, 255, 220});
+        DrawRectangleRec(snap.selectionRect, Color{80, 170, 255, 40});
+    }
+
+    void EnsurePixelTarget(int w, int h)
+    {
+        w = std::max(160, w);
+        h = std::max(100, h);
+        if (m_pixelTargetLoaded && m_pixelTargetW == w && m_pixelTargetH == h) return;
+        if (m_pixelTargetLoaded)
+        {
+            UnloadRenderTexture(m_pixelTarget);
+            m_pixelTargetLoaded = false;
+        }
+        m_pixelTarget = LoadRenderTexture(w, h);
+        SetTextureFilter(m_pixelTarget.texture, TEXTURE_FILTER_POINT);
+        m_pixelTargetLoaded = true;
+        m_pixelTargetW = w;
+        m_pixelTargetH = h;
+    }
+
+    // The world at m_resScale of the framebuffer, drawn like the pixelate path
+    // but into a scissored corner of m_resTarget, then sharpened up to the
+    // window. The scale follows the GPU time of whole frames, UI included, so
+    // the governor aims at the frame's budget less some headroom.
+    void DrawWorldScaled()
+    {
+        SLOP_ZONE("DynamicResolution");
+        static constexpr float kBudgetFraction = 0.8f;
+        static constexpr float kMaxSharpen = 0.35f;
+        m_resScale.SetTargetMs(kBudgetFraction * 1000.0f / static_cast<float>(m_fpsLimit > 0 ? m_fpsLimit : 60));
+        float scale = m_resScale.Update(m_gpuTimer.LastMs(), GetFrameTime());
+        float texW = static_cast<float>(m_resTarget.texture.width);
+        float texH = static_cast<float>(m_resTarget.texture.height);
+        int drawW = std::max(1, static_cast<int>(std::lround(texW * scale)));
+        int drawH = std::max(1, static_cast<int>(std::lround(texH * scale)));
+
+        BeginTextureMode(m_resTarget);
+        BeginScissorMode(0, 0, drawW, drawH);
+        ClearBackground(BgColor());
+        float targetScale = static_cast<float>(drawW) / static_cast<float>(m_width);
+        Camera2D screenCam{};
+        screenCam.zoom = targetScale;
+        BeginMode2D(screenCam);
+        if (!m_backdropLayer.Blit({0.0f, 0.0f})) DrawGround();
+        EndMode2D();
+        Camera2D worldCam = m_view.Camera();
+        worldCam.zoom *= targetScale;
+        BeginMode2D(worldCam);
+        DrawWorld();
+        EndMode2D();
+        EndScissorMode();
+        EndTextureMode();
+
+        // Screen rows run down the texture from its top, so the drawn corner
+        // is the last drawH rows.
+        Rectangle src{0.0f, texH - static_cast<float>(drawH), static_cast<float>(drawW), -static_cast<float>(drawH)};
+        Rectangle dst{0.0f, 0.0f, static_cast<float>(m_width), static_cast<float>(m_height)};
+        if (m_sharpenShaderLoaded)
+        {
+            float texel[2] = {1.0f / texW, 1.0f / texH};
+            float bounds[4] = {0.5f / texW, 1.0f - (static_cast<float>(drawH) - 0.5f) / texH, (static_cast<float>(drawW) - 0.5f) / texW, 1.0f - 0.5f / texH};
+            float amount = kMaxSharpen * (ResolutionScaleGovernor::kMaxScale - scale) / (ResolutionScaleGovernor::kMaxScale - ResolutionScaleGovernor::kMinScale);
+            SetShaderValue(m_sharpenShader, m_sharpenTexelLoc, texel, SHADER_UNIFORM_VEC2);
+            SetShaderValue(m_sharpenShader, m_sharpenBoundsLoc, bounds, SHADER_UNIFORM_VEC4);
+            SetShaderValue(m_sharpenShader, m_sharpenAmountLoc, &amount, SHADER_UNIFORM_FLOAT);
+            BeginShaderMode(m_sharpenShader);
+        }
+        DrawTexturePro(m_resTarget.texture, src, dst, {0.0f, 0.0f}, 0.0f, WHITE);
+        if (m_sharpenShaderLoaded) EndShaderMode();
+    }
+
+    // Everything in world space, under the caller's camera; the backdrop is
+    // drawn by the caller.
+    void DrawWorld()
+    {
+        SLOP_ZONE("DrawWorld");
+        const RenderSnapshot& snap = m_snapshots.ReadBuffer();
+        if (InWater()) DrawWater(snap);
+
+        DrawBodies(snap);
+        DrawShards(snap);
+    }
+
+    void Draw()
+    {
+        SLOP_ZONE("Draw");
+        FrameProfiler::Scope scope(m_profiler, ProfileStage::Draw);
+        AcquireSnapshot();
+        if (m_gpuEffects)
+        {
+            m_gpuSpawns.Take(m_gpuBatch);
+            m_gpu.Apply(m_gpuBatch);
+            m_gpuBatch.Reset();
+        }
+        BeginDrawing();
+        if (m_dynamicRes) m_gpuTimer.Begin();
+        DrawBackdrop();
+
+        if (m_pixelate)
+        {
+            SLOP_ZONE("Pixelate");
+            // The shader pixelates a full-resolution copy, so the block size
+            // is only a uniform. Without it the scene is drawn small and
+            // scaled up, which reallocates the target when the size changes.
+            int pixelSize = m_pixelSize.Update(GetFrameTime());
+            int targetW = m_pixelShaderLoaded ? m_width : m_width / pixelSize;
+            int targetH = m_pixelShaderLoaded ? m_height : m_height / pixelSize;
+            EnsurePixelTarget(targetW, targetH);
+
+            BeginTextureMode(m_pixelTarget);
+            ClearBackground(BgColor());
+
+            // The target is the window scaled by targetScale: the backdrop
+            // goes in scaled only, the world through the view and the scale.
+            float targetScale = static_cast<float>(m_pixelTarget.texture.width) / static_cast<float>(m_width);
+            Camera2D screenCam{};
+            screenCam.zoom = targetScale;
+            BeginMode2D(screenCam);
+            // Painted at the start of the frame; no nested texture mode here.
+            if (!m_backdropLayer.Blit({0.0f, 0.0f})) DrawGround();
+            EndMode2D();
+            Camera2D worldCam = m_view.Camera();
+            worldCam.zoom *= targetScale;
+            BeginMode2D(worldCam);
+            DrawWorld();
+            EndMode2D();
+
+            EndTextureMode();
+
+            Rectangle src{0.0f, 0.0f, static_cast<float>(m_pixelTarget.texture.width), -static_cast<float>(m_pixelTarget.texture.height)};
+            Rectangle dst{0.0f, 0.0f, static_cast<float>(m_width), static_cast<float>(m_height)};
+            if (m_pixelShaderLoaded)
+            {
+                float block = static_cast<float>(pixelSize);
+                float resolution[2] = {src.width, -src.height};
+                SetShaderValue(m_pixelShader, m_pixelBlockLoc, &block, SHADER_UNIFORM_FLOAT);
+                SetShaderValue(m_pixelShader, m_pixelResolutionLoc, resolution, SHADER_UNIFORM_VEC2);
+                BeginShaderMode(m_pixelShader);
+            }
+            DrawTexturePro(m_pixelTarget.texture, src, dst, {0.0f, 0.0f}, 0.0f, WHITE);
+            if (m_pixelShaderLoaded) EndShaderMode();
+        }
+        else if (m_dynamicRes)
+        {
+            DrawWorldScaled();
+        }
+        else
+        {
+            BeginMode2D(m_view.Camera());
+            DrawWorld();
+            EndMode2D();
+        }
+
+        // UI goes on top at full resolution, after any pixelation.
+        DrawPanel();
+        {
+            // Queues like the rest of the input; see Update.
+            std::unique_lock<std::mutex> lock(m_worldMutex, std::defer_lock);
+            if (m_physicsThreaded && m_recorder.IsOpen())
+            {
+                lock.lock();
+                m_commandsInline = true;
+            }
+            HandlePanelInput();
+            if (m_commandsInline)
+            {
+                ApplyCommands();
+                m_commandsInline = false;
+            }
+        }
+        BeginMode2D(m_view.Camera());
+        DrawDrawPreview();
+        DrawSelectionRect();
+        DrawWeldCursor();
+        EndMode2D();
+        DrawOverlayText();
+        if (m_showProfiler) DrawProfilerOverlay();
+
+        RecordInputLatency();
+        if (m_dynamicRes) m_gpuTimer.End();
+        EndDrawing();
+        SLOP_TRACE_FRAME();
+    }
+};
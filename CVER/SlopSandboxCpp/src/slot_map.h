@@ -0,0 +1,263 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// Stable handle into a SlotMap. Generation 0 is never issued, so a
+// default-constructed handle is always invalid.
+struct SlotHandle
+{
+    uint32_t index = 0;
+    uint32_t generation = 0;
+
+    bool IsNull() const { return generation == 0; }
+    bool operator==(const SlotHandle& o) const { return index == o.index && generation == o.generation; }
+    bool operator!=(const SlotHandle& o) const { return !(*this == o); }
+};
+
+// Dense storage with generation-checked handles and a slot free list.
+// Values stay packed for iteration; single erases swap-and-pop, batch
+// erases compact in one stable pass.
+template <typename T>
+class SlotMap
+{
+public:
+    using iterator = typename std::vector<T>::iterator;
+    using const_iterator = typename std::vector<T>::const_iterator;
+
+    SlotHandle Insert(T&& value)
+    {
+        uint32_t slotIndex;
+        if (m_freeHead != kNone)
+        {
+            slotIndex = m_freeHead;
+            m_freeHead = m_slots[slotIndex].dense;
+        }
+        else
+        {
+            slotIndex = static_cast<uint32_t>(m_slots.size());
+            m_slots.push_back(Slot{});
+        }
+
+        Slot& slot = m_slots[slotIndex];
+        slot.dense = static_cast<uint32_t>(m_dense.size());
+        m_dense.push_back(std::move(value));
+        m_denseToSlot.push_back(slotIndex);
+        return SlotHandle{slotIndex, slot.generation};
+    }
+
+    bool Contains(SlotHandle h) const
+    {
+        return h.generation != 0 && h.index < m_slots.size() && m_slots[h.index].generation == h.generation;
+    }
+
+    std::optional<size_t> DenseIndex(SlotHandle h) const
+    {
+        if (!Contains(h)) return std::nullopt;
+        return static_cast<size_t>(m_slots[h.index].dense);
+    }
+
+    T* Get(SlotHandle h)
+    {
+        auto i = DenseIndex(h);
+        return i ? &m_dense[*i] : nullptr;
+    }
+
+    const T* Get(SlotHandle h) const
+    {
+        auto i = DenseIndex(h);
+        return i ? &m_dense[*i] : nullptr;
+    }
+
+    SlotHandle HandleAt(size_t denseIndex) const
+    {
+        uint32_t slotIndex = m_denseToSlot[denseIndex];
+        return SlotHandle{slotIndex, m_slots[slotIndex].generation};
+    }
+
+    // Slot indices stay fixed for an element's lifetime, so side tables and
+    // SlotBitsets can be indexed by them.
+    uint32_t SlotIndexAt(size_t denseIndex) const { return m_denseToSlot[denseIndex]; }
+    size_t SlotCount() const { return m_slots.size(); }
+
+    std::optional<size_t> DenseIndexOfSlot(uint32_t slotIndex) const
+    {
+        if (slotIndex >= m_slots.size() || m_slots[slotIndex].dense == kNone) return std::nullopt;
+        size_t dense = m_slots[slotIndex].dense;
+        if (dense >= m_denseToSlot.size() || m_denseToSlot[dense] != slotIndex) return std::nullopt;
+        return dense;
+    }
+
+    // Swap-and-pop: the last element moves into denseIndex.
+    void EraseAt(size_t denseIndex)
+    {
+        size_t last = m_dense.size() - 1;
+        ReleaseSlot(m_denseToSlot[denseIndex]);
+        if (denseIndex != last)
+        {
+            m_dense[denseIndex] = std::move(m_dense[last]);
+            m_denseToSlot[denseIndex] = m_denseToSlot[last];
+            m_slots[m_denseToSlot[denseIndex]].dense = static_cast<uint32_t>(denseIndex);
+        }
+        m_dense.pop_back();
+        m_denseToSlot.pop_back();
+    }
+
+    bool Erase(SlotHandle h)
+    {
+        auto i = DenseIndex(h);
+        if (!i) return false;
+        EraseAt(*i);
+        return true;
+    }
+
+    // Removes every element matching pred in a single stable compaction pass.
+    template <typename Pred>
+    size_t EraseIf(Pred pred)
+    {
+        size_t write = 0;
+        const size_t count = m_dense.size();
+        for (size_t read = 0; read < count; ++read)
+        {
+            if (pred(m_dense[read]))
+            {
+                ReleaseSlot(m_denseToSlot[read]);
+                continue;
+            }
+            if (write != read)
+            {
+                m_dense[write] = std::move(m_dense[read]);
+                m_denseToSlot[write] = m_denseToSlot[read];
+            }
+            m_slots[m_denseToSlot[write]].dense = static_cast<uint32_t>(write);
+            ++write;
+        }
+        m_dense.resize(write);
+        m_denseToSlot.resize(write);
+        return count - write;
+    }
+
+    void Clear()
+    {
+        for (uint32_t slotIndex : m_denseToSlot) ReleaseSlot(slotIndex);
+        m_dense.clear();
+        m_denseToSlot.clear();
+    }
+
+    void Reserve(size_t n)
+    {
+        m_dense.reserve(n);
+        m_denseToSlot.reserve(n);
+        m_slots.reserve(n);
+    }
+
+    size_t size() const { return m_dense.size(); }
+    bool empty() const { return m_dense.empty(); }
+    T& operator[](size_t denseIndex) { return m_dense[denseIndex]; }
+    const T& operator[](size_t denseIndex) const { return m_dense[denseIndex]; }
+    T& back() { return m_dense.back(); }
+    iterator begin() { return m_dense.begin(); }
+    iterator end() { return m_dense.end(); }
+    const_iterator begin() const { return m_dense.begin(); }
+    const_iterator end() const { return m_dense.end(); }
+
+private:
+    static constexpr uint32_t kNone = 0xFFFFFFFFu;
+
+    struct Slot
+    {
+        uint32_t dense = kNone; // dense index when live, next free slot otherwise
+        uint32_t generation = 1;
+    };
+
+    void ReleaseSlot(uint32_t slotIndex)
+    {
+        Slot& slot = m_slots[slotIndex];
+        if (++slot.generation == 0) slot.generation = 1;
+        slot.dense = m_freeHead;
+        m_freeHead = slotIndex;
+    }
+
+    std::vector<T> m_dense;
+    std::vector<uint32_t> m_denseToSlot;
+    std::vector<Slot> m_slots;
+    uint32_t m_freeHead = kNone;
+};
+
+// One bit per SlotMap slot, for "every body with feature X" scans that read
+// 64 bodies per word. The owner sets and clears bits as elements gain or lose
+// the feature and when they are erased.
+class SlotBitset
+{
+public:
+    void Set(uint32_t slot)
+    {
+        size_t w = slot >> 6;
+        if (w >= m_words.size()) m_words.resize(w + 1, 0);
+        uint64_t bit = uint64_t{1} << (slot & 63);
+        if (!(m_words[w] & bit)) ++m_count;
+        m_words[w] |= bit;
+    }
+
+    void Reset(uint32_t slot)
+    {
+        size_t w = slot >> 6;
+        if (w >= m_words.size()) return;
+        uint64_t bit = uint64_t{1} << (slot & 63);
+        if (m_words[w] & bit) --m_count;
+        m_words[w] &= ~bit;
+    }
+
+    bool Test(uint32_t slot) const
+    {
+        size_t w = slot >> 6;
+        return w < m_words.size() && (m_words[w] >> (slot & 63)) & 1;
+    }
+
+    void Clear()
+    {
+        std::fill(m_words.begin(), m_words.end(), 0);
+        m_count = 0;
+    }
+
+    size_t Count() const { return m_count; }
+    bool Any() const { return m_count != 0; }
+
+    // Visits set slots in increasing order.
+    template <typename Fn>
+    void ForEach(Fn&& fn) const
+    {
+        for (size_t w = 0; w < m_words.size(); ++w)
+        {
+            uint64_t bits = m_words[w];
+            while (bits)
+            {
+                fn(static_cast<uint32_t>(w * 64 + LowestBit(bits)));
+                bits &= bits - 1;
+            }
+        }
+    }
+
+private:
+    static unsigned LowestBit(uint64_t bits)
+    {
+#if defined(_MSC_VER)
+        unsigned long i;
+        _BitScanForward64(&i, bits);
+        return static_cast<unsigned>(i);
+#else
+        return static_cast<unsigned>(__builtin_ctzll(bits));
+#endif
+    }
+
+    std::vector<uint64_t> m_words;
+    size_t m_count = 0;
+};
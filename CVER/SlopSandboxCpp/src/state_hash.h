@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+// Fingerprints of the simulation state for determinism checks. Floats are
+// hashed as their bits: the question is whether two runs are bit-identical,
+// not whether they are close.
+namespace state_hash
+{
+
+// splitmix64's finalizer.
+inline uint64_t Mix(uint64_t x)
+{
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ull;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebull;
+    return x ^ (x >> 31);
+}
+
+class Hasher
+{
+public:
+    void Add(uint64_t v) { m_h = Mix(m_h ^ v) + 0x9e3779b97f4a7c15ull; }
+
+    void Add(float f)
+    {
+        uint32_t bits;
+        std::memcpy(&bits, &f, sizeof(bits));
+        Add(uint64_t{bits});
+    }
+
+    // Long arrays take FNV-style multiplies, two floats a word, and one mix.
+    void Add(const float* values, size_t count)
+    {
+        uint64_t h = m_h ^ count;
+        size_t i = 0;
+        for (; i + 1 < count; i += 2)
+        {
+            uint64_t word;
+            std::memcpy(&word, values + i, sizeof(word));
+            h = (h ^ word) * 0x100000001b3ull;
+        }
+        if (i < count)
+        {
+            uint32_t bits;
+            std::memcpy(&bits, values + i, sizeof(bits));
+            h = (h ^ bits) * 0x100000001b3ull;
+        }
+        Add(h);
+    }
+
+    uint64_t Value() const { return Mix(m_h); }
+
+private:
+    uint64_t m_h = 0x5eed5eed5eed5eedull;
+};
+
+} // namespace state_hash
+
+// One hash per entry, folded into a sum after mixing in the entry's key. A
+// step only rehashes the entries that changed, and the sum comes out the same
+// whatever order or thread they were hashed on.
+class StateHashSum
+{
+public:
+    size_t Size() const { return m_entries.size(); }
+    uint64_t Sum() const { return m_sum; }
+
+    // hashes[i] is entry i's.
+    void Rebuild(const std::vector<uint64_t>& hashes)
+    {
+        m_entries = hashes;
+        m_sum = 0;
+        for (size_t i = 0; i < m_entries.size(); ++i) m_sum += Keyed(i, m_entries[i]);
+    }
+
+    void Set(size_t key, uint64_t hash)
+    {
+        uint64_t& entry = m_entries[key];
+        m_sum += Keyed(key, hash) - Keyed(key, entry);
+        entry = hash;
+    }
+
+private:
+    static uint64_t Keyed(size_t key, uint64_t hash) { return state_hash::Mix(hash + (uint64_t{key} + 1) * 0x9e3779b97f4a7c15ull); }
+
+    std::vector<uint64_t> m_entries;
+    uint64_t m_sum = 0;
+};
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+
+// Picks Box2D substeps and the number of catch-up steps per tick from the
+// measured b2World_Step cost. The cost model is linear in awake bodies times
+// substeps, smoothed with an EMA, so a scene that suddenly wakes up is
+// predicted before the first expensive step lands.
+class StepController
+{
+public:
+    struct Config
+    {
+        float budgetMs = 6.5f;     // target wall time for one b2World_Step
+        float tickMs = 18.0f;      // wall time available per tick for catch-up steps
+        int minSubSteps = 2;
+        int maxSubSteps = 8;
+        int maxCatchUpSteps = 4;
+        int holdSteps = 30;        // steps to wait before raising substeps again
+    };
+
+    enum class Decision
+    {
+        Hold,
+        Raise,
+        Lower,
+        Overloaded,
+        Pinned
+    };
+
+    StepController() = default;
+    explicit StepController(const Config& config)
+        : m_config(config)
+    {
+    }
+
+    int SubSteps() const { return m_subSteps; }
+    int CatchUpSteps() const { return m_catchUpSteps; }
+    Decision LastDecision() const { return m_decision; }
+    float BudgetMs() const { return m_config.budgetMs; }
+    double SmoothedStepMs() const { return m_stepMsEma; }
+
+    static const char* DecisionName(Decision d)
+    {
+        switch (d)
+        {
+            case Decision::Hold: return "hold";
+            case Decision::Raise: return "raise";
+            case Decision::Lower: return "lower";
+            case Decision::Overloaded: return "overloaded";
+            case Decision::Pinned: return "pinned";
+        }
+        return "?";
+    }
+
+    // subSteps > 0 disables adaptation; 0 re-enables it.
+    void Pin(int subSteps)
+    {
+        m_pinned = subSteps > 0;
+        if (m_pinned) m_subSteps = subSteps;
+    }
+
+    // Predicted wall time of one step for the given awake count and substeps.
+    double PredictMs(int awakeBodies, int subSteps) const
+    {
+        return m_costPerBodySubStep * std::max(1, awakeBodies) * subSteps;
+    }
+
+    // Feed the wall time of a step taken with SubSteps() and the awake count after it.
+    void Record(double stepMs, int awakeBodies)
+    {
+        double sample = stepMs / (std::max(1, awakeBodies) * std::max(1, m_subSteps));
+        m_costPerBodySubStep = m_haveSample ? m_costPerBodySubStep + kEma * (sample - m_costPerBodySubStep) : sample;
+        m_stepMsEma = m_haveSample ? m_stepMsEma + kEma * (stepMs - m_stepMsEma) : stepMs;
+        m_haveSample = true;
+        ++m_sinceChange;
+
+        if (m_pinned)
+        {
+            m_decision = Decision::Pinned;
+        }
+        else if (PredictMs(awakeBodies, m_subSteps) > m_config.budgetMs && m_subSteps > m_config.minSubSteps)
+        {
+            // Over budget: drop a substep right away rather than stutter.
+            --m_subSteps;
+            m_sinceChange = 0;
+            m_decision = Decision::Lower;
+        }
+        else if (PredictMs(awakeBodies, m_config.minSubSteps) > m_config.budgetMs)
+        {
+            m_decision = Decision::Overloaded;
+        }
+        else if (m_sinceChange >= m_config.holdSteps && m_subSteps < m_config.maxSubSteps &&
+                 PredictMs(awakeBodies, m_subSteps + 1) < kRaiseMargin * m_config.budgetMs)
+        {
+            ++m_subSteps;
+            m_sinceChange = 0;
+            m_decision = Decision::Raise;
+        }
+        else
+        {
+            m_decision = Decision::Hold;
+        }
+
+        // Catch-up steps must fit in a tick, or a late frame snowballs.
+        double predicted = std::max(0.01, PredictMs(awakeBodies, m_subSteps));
+        int fit = static_cast<int>(std::floor(m_config.tickMs / predicted));
+        m_catchUpSteps = std::clamp(fit, 1, m_config.maxCatchUpSteps);
+    }
+
+private:
+    static constexpr double kEma = 0.1;
+    static constexpr double kRaiseMargin = 0.7;
+
+    Config m_config;
+    int m_subSteps = 4;
+    int m_catchUpSteps = 1;
+    bool m_pinned = false;
+    bool m_haveSample = false;
+    int m_sinceChange = 0;
+    double m_costPerBodySubStep = 0.0;
+    double m_stepMsEma = 0.0;
+    Decision m_decision = Decision::Hold;
+};
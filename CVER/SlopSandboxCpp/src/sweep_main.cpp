@@ -0,0 +1,277 @@
+// SlopSweep: runs one saved scene under many parameter sets in parallel.
+// Every combination of the given values gets its own world loaded from the
+// same scene image, stepped on a thread of its own with one Box2D worker, and
+// one CSV row of outcomes and timings. Never opens a window.
+
+#include "sandbox_core.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+
+struct SweepOptions
+{
+    const char* sceneFile = nullptr;
+    const char* outFile = "sweep.csv";
+    int frames = 1100; // 20 simulated seconds
+    int threads = 0;   // 0 = hardware concurrency
+    int subSteps = 4;
+    bool stopWhenSettled = true;
+    std::vector<float> glass{1.0f};
+    std::vector<float> hertz{45.0f};
+    std::vector<float> contactDamping{1.2f};
+    std::vector<float> push{2.0f};
+    std::vector<float> linearDamping{1.0f};
+    std::vector<float> angularDamping{1.0f};
+};
+
+struct RunResult
+{
+    SimTuning tuning;
+    size_t bodiesStart = 0;
+    size_t bodiesEnd = 0;
+    size_t awakeEnd = 0;
+    size_t fallen = 0;
+    uint64_t glassBreaks = 0;
+    int frames = 0;
+    float settledS = -1.0f; // never
+    float kineticEnergy = 0.0f; // J at the end, fallen bodies left out
+    double meanStepMs = 0.0;
+    double maxStepMs = 0.0;
+    double wallS = 0.0;
+    bool loaded = false;
+};
+
+// "1,1.5,2" -> {1, 1.5, 2}; false on anything that is not a number.
+bool ParseList(const char* text, std::vector<float>& out)
+{
+    out.clear();
+    const char* p = text;
+    while (*p)
+    {
+        char* end = nullptr;
+        float v = std::strtof(p, &end);
+        if (end == p) return false;
+        out.push_back(v);
+        p = end;
+        if (*p == ',') ++p;
+        else if (*p) return false;
+    }
+    return !out.empty();
+}
+
+// Cartesian product of the axes, the last one varying fastest.
+std::vector<SimTuning> BuildGrid(const SweepOptions& opt)
+{
+    const std::vector<float>* axes[] = {&opt.angularDamping, &opt.linearDamping, &opt.push, &opt.contactDamping, &opt.hertz, &opt.glass};
+    size_t total = 1;
+    for (const std::vector<float>* axis : axes) total *= axis->size();
+
+    std::vector<SimTuning> grid(total);
+    for (size_t i = 0; i < total; ++i)
+    {
+        size_t k = i;
+        auto pick = [&k](const std::vector<float>& axis) {
+            float v = axis[k % axis.size()];
+            k /= axis.size();
+            return v;
+        };
+        SimTuning& t = grid[i];
+        t.angularDampingScale = pick(opt.angularDamping);
+        t.linearDampingScale = pick(opt.linearDamping);
+        t.contactPushMaxVelocity = pick(opt.push);
+        t.contactDampingRatio = pick(opt.contactDamping);
+        t.contactHertz = pick(opt.hertz);
+        t.glassBreakScale = pick(opt.glass);
+    }
+    return grid;
+}
+
+// Bodies that fell off the ground only gain speed, so they are counted apart.
+void MeasureEnd(const SandboxCore& app, RunResult& out)
+{
+    out.kineticEnergy = 0.0f;
+    out.fallen = 0;
+    for (size_t i = 0; i < app.BodyCount(); ++i)
+    {
+        b2BodyId id = app.BodyIdAt(i);
+        if (!b2Body_IsValid(id)) continue;
+        if (app.FellOffGround(i))
+        {
+            ++out.fallen;
+            continue;
+        }
+        if (!b2Body_IsAwake(id)) continue;
+        b2Vec2 v = b2Body_GetLinearVelocity(id);
+        float w = b2Body_GetAngularVelocity(id);
+        out.kineticEnergy += 0.5f * (b2Body_GetMass(id) * b2Dot(v, v) + b2Body_GetRotationalInertia(id) * w * w);
+    }
+}
+
+void RunOne(const uint8_t* image, size_t imageSize, const SweepOptions& opt, RunResult& out)
+{
+    using Clock = std::chrono::steady_clock;
+
+    auto start = Clock::now();
+    SandboxCore app(1536, 960, 1);
+    app.SetPhysicsThreadEnabled(false);
+    app.SetFixedSubSteps(opt.subSteps);
+    app.SetRewindBudget(0);
+    app.SetSimTuning(out.tuning);
+    if (!app.LoadSceneImage(image, imageSize)) return;
+    out.loaded = true;
+    out.bodiesStart = app.BodyCount();
+
+    const float dt = SandboxCore::FixedDt();
+    double sumMs = 0.0;
+    int f = 0;
+    while (f < opt.frames)
+    {
+        auto t0 = Clock::now();
+        app.StepHeadless(dt);
+        double ms = std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+        sumMs += ms;
+        out.maxStepMs = std::max(out.maxStepMs, ms);
+        ++f;
+        if (out.settledS < 0.0f && app.Settled())
+        {
+            out.settledS = static_cast<float>(f) * dt;
+            if (opt.stopWhenSettled) break;
+        }
+    }
+
+    out.frames = f;
+    out.bodiesEnd = app.BodyCount();
+    out.awakeEnd = app.BodyCount() - app.RestingBodyCount();
+    out.glassBreaks = app.GlassBreakCount();
+    MeasureEnd(app, out);
+    out.meanStepMs = f > 0 ? sumMs / f : 0.0;
+    out.wallS = std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+bool WriteResults(const char* path, const std::vector<RunResult>& results)
+{
+    FILE* f = std::fopen(path, "w");
+    if (!f) return false;
+    std::fprintf(f, "run,glass_scale,contact_hz,contact_damping,push_mps,linear_damping_scale,angular_damping_scale,"
+                    "bodies_start,bodies_end,awake_end,fallen,glass_breaks,frames,settled_s,kinetic_j,mean_step_ms,max_step_ms,wall_s\n");
+    for (size_t i = 0; i < results.size(); ++i)
+    {
+        const RunResult& r = results[i];
+        const SimTuning& t = r.tuning;
+        if (!r.loaded)
+        {
+            std::fprintf(f, "%zu,%g,%g,%g,%g,%g,%g,,,,,,,,,,,\n", i, t.glassBreakScale, t.contactHertz, t.contactDampingRatio,
+                         t.contactPushMaxVelocity, t.linearDampingScale, t.angularDampingScale);
+            continue;
+        }
+        std::fprintf(f, "%zu,%g,%g,%g,%g,%g,%g,%zu,%zu,%zu,%zu,%llu,%d,%.3f,%.3f,%.4f,%.4f,%.3f\n", i, t.glassBreakScale, t.contactHertz,
+                     t.contactDampingRatio, t.contactPushMaxVelocity, t.linearDampingScale, t.angularDampingScale, r.bodiesStart,
+                     r.bodiesEnd, r.awakeEnd, r.fallen, static_cast<unsigned long long>(r.glassBreaks), r.frames, r.settledS, r.kineticEnergy,
+                     r.meanStepMs, r.maxStepMs, r.wallS);
+    }
+    return std::fclose(f) == 0;
+}
+
+void PrintUsage()
+{
+    std::printf("usage: SlopSweep --scene-file PATH [--out PATH] [--frames N] [--threads N] [--substeps N] [--no-early-stop]\n"
+                "                 [--glass LIST] [--hertz LIST] [--contact-damping LIST] [--push LIST]\n"
+                "                 [--linear-damping LIST] [--angular-damping LIST]\n"
+                "LIST is comma separated, e.g. --glass 0.5,1,2; every combination is run. Glass and damping\n"
+                "values scale the sandbox's own; contact values replace them (defaults 45 Hz, 1.2, 2 m/s).\n"
+                "Box2D caps contact stiffness at an eighth of the substep rate (27.5 Hz at 4 substeps).\n");
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    SweepOptions opt;
+    for (int i = 1; i < argc; ++i)
+    {
+        bool ok = true;
+        if (std::strcmp(argv[i], "--scene-file") == 0 && i + 1 < argc) opt.sceneFile = argv[++i];
+        else if (std::strcmp(argv[i], "--out") == 0 && i + 1 < argc) opt.outFile = argv[++i];
+        else if (std::strcmp(argv[i], "--frames") == 0 && i + 1 < argc) opt.frames = std::max(1, std::atoi(argv[++i]));
+        else if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc) opt.threads = std::atoi(argv[++i]);
+        else if (std::strcmp(argv[i], "--substeps") == 0 && i + 1 < argc) opt.subSteps = std::max(1, std::atoi(argv[++i]));
+        else if (std::strcmp(argv[i], "--no-early-stop") == 0) opt.stopWhenSettled = false;
+        else if (std::strcmp(argv[i], "--glass") == 0 && i + 1 < argc) ok = ParseList(argv[++i], opt.glass);
+        else if (std::strcmp(argv[i], "--hertz") == 0 && i + 1 < argc) ok = ParseList(argv[++i], opt.hertz);
+        else if (std::strcmp(argv[i], "--contact-damping") == 0 && i + 1 < argc) ok = ParseList(argv[++i], opt.contactDamping);
+        else if (std::strcmp(argv[i], "--push") == 0 && i + 1 < argc) ok = ParseList(argv[++i], opt.push);
+        else if (std::strcmp(argv[i], "--linear-damping") == 0 && i + 1 < argc) ok = ParseList(argv[++i], opt.linearDamping);
+        else if (std::strcmp(argv[i], "--angular-damping") == 0 && i + 1 < argc) ok = ParseList(argv[++i], opt.angularDamping);
+        else ok = false;
+        if (!ok)
+        {
+            PrintUsage();
+            return 1;
+        }
+    }
+    if (!opt.sceneFile)
+    {
+        PrintUsage();
+        return 1;
+    }
+
+    // Loaded once; every run builds its world from the same read-only bytes.
+    MappedFile scene;
+    SceneView view;
+    if (!scene.Open(opt.sceneFile) || !ParseSceneFile(scene.Data(), scene.Size(), view))
+    {
+        std::fprintf(stderr, "failed to load scene file %s\n", opt.sceneFile);
+        return 1;
+    }
+
+    std::vector<SimTuning> grid = BuildGrid(opt);
+    std::vector<RunResult> results(grid.size());
+    for (size_t i = 0; i < grid.size(); ++i) results[i].tuning = grid[i];
+
+    int threads = opt.threads > 0 ? opt.threads : static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    threads = std::min(threads, static_cast<int>(grid.size()));
+    std::printf("%zu runs of up to %d frames on %d threads, %u bodies\n", grid.size(), opt.frames, threads, view.header->bodyCount);
+    std::fflush(stdout);
+
+    // Worlds are created and destroyed under box2d_heap's world mutex; the
+    // per-subsystem heap scopes are process-wide and would only fight.
+    box2d_heap::Heap::Install();
+    box2d_heap::SetAttribution(false);
+
+    auto start = std::chrono::steady_clock::now();
+    std::atomic<size_t> next{0};
+    std::atomic<size_t> done{0};
+    auto worker = [&]() {
+        for (size_t i = next.fetch_add(1); i < results.size(); i = next.fetch_add(1))
+        {
+            RunOne(scene.Data(), scene.Size(), opt, results[i]);
+            size_t n = done.fetch_add(1) + 1;
+            std::fprintf(stderr, "\r%zu/%zu", n, results.size());
+        }
+    };
+    std::vector<std::thread> pool;
+    for (int t = 1; t < threads; ++t) pool.emplace_back(worker);
+    worker();
+    for (std::thread& t : pool) t.join();
+    double wallS = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::fprintf(stderr, "\n");
+
+    if (!WriteResults(opt.outFile, results))
+    {
+        std::fprintf(stderr, "failed to write %s\n", opt.outFile);
+        return 1;
+    }
+    uint64_t frames = 0;
+    for (const RunResult& r : results) frames += static_cast<uint64_t>(r.frames);
+    std::printf("%.2f s wall, %.0f world-steps/s, results in %s\n", wallS, wallS > 0.0 ? static_cast<double>(frames) / wallS : 0.0, opt.outFile);
+    return 0;
+}
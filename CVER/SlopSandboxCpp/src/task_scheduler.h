@@ -0,0 +1,291 @@
+#pragma once
+
+#include <box2d/box2d.h>
+
+#include "trace_zones.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Work-stealing thread pool that plugs into b2WorldDef::enqueueTask/finishTask.
+// Worker 0 is the thread that calls b2World_Step; it helps drain the queues
+// while waiting in FinishTask. Workers 1..N-1 are owned by the scheduler.
+// Every thread the scheduler does not own runs as worker 0, so only one such
+// thread may drive a given scheduler at a time.
+class TaskScheduler
+{
+public:
+    static constexpr int kMaxWorkers = 32;
+
+    explicit TaskScheduler(int workerCount)
+    {
+        if (workerCount <= 0) workerCount = DefaultWorkerCount();
+        m_workerCount = std::clamp(workerCount, 1, kMaxWorkers);
+
+        m_queues.reserve(static_cast<size_t>(m_workerCount));
+        for (int i = 0; i < m_workerCount; ++i)
+        {
+            m_queues.push_back(std::make_unique<WorkerQueue>());
+        }
+
+        m_threads.reserve(static_cast<size_t>(m_workerCount - 1));
+        for (int i = 1; i < m_workerCount; ++i)
+        {
+            m_threads.emplace_back([this, i]() { WorkerMain(i); });
+        }
+    }
+
+    ~TaskScheduler()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_wakeMutex);
+            m_stop.store(true, std::memory_order_relaxed);
+        }
+        m_wakeCv.notify_all();
+        for (std::thread& t : m_threads)
+        {
+            if (t.joinable()) t.join();
+        }
+    }
+
+    TaskScheduler(const TaskScheduler&) = delete;
+    TaskScheduler& operator=(const TaskScheduler&) = delete;
+
+    // Box2D recommends performance cores only; hyper-threads rarely help the solver.
+    static int DefaultWorkerCount()
+    {
+        unsigned hw = std::thread::hardware_concurrency();
+        if (hw == 0) return 1;
+        int cores = static_cast<int>(hw);
+        if (cores > 4) cores = cores * 3 / 4;
+        return std::clamp(cores, 1, 8);
+    }
+
+    int WorkerCount() const { return m_workerCount; }
+
+    void ConfigureWorldDef(b2WorldDef& def)
+    {
+        if (m_workerCount <= 1) return;
+        def.workerCount = m_workerCount;
+        def.enqueueTask = &EnqueueTaskCallback;
+        def.finishTask = &FinishTaskCallback;
+        def.userTaskContext = this;
+    }
+
+    // Generic parallel-for over [0, itemCount) using the same worker indices Box2D sees.
+    void ParallelFor(int itemCount, int minRange, b2TaskCallback* fn, void* context)
+    {
+        void* task = Enqueue(fn, itemCount, minRange, context);
+        if (task) Finish(task);
+    }
+
+    void* Enqueue(b2TaskCallback* fn, int itemCount, int minRange, void* context)
+    {
+        if (itemCount <= 0) return nullptr;
+        minRange = std::max(1, minRange);
+        if (m_workerCount <= 1)
+        {
+            fn(0, itemCount, static_cast<uint32_t>(CurrentWorkerIndex()), context);
+            return nullptr;
+        }
+
+        int maxChunks = m_workerCount * kChunksPerWorker;
+        int chunkCount = std::clamp(itemCount / minRange, 1, maxChunks);
+        int chunkSize = (itemCount + chunkCount - 1) / chunkCount;
+        chunkCount = (itemCount + chunkSize - 1) / chunkSize;
+
+        Task* task = AcquireTask();
+        task->fn = fn;
+        task->context = context;
+        task->remaining.store(chunkCount, std::memory_order_relaxed);
+
+        m_pendingJobs.fetch_add(chunkCount, std::memory_order_release);
+        // Single-item tasks (Box2D's per-worker solver tasks) must land on different
+        // threads, so rotate the starting queue across calls.
+        int queue = static_cast<int>(m_nextQueue.fetch_add(1, std::memory_order_relaxed) % static_cast<unsigned>(m_workerCount));
+        for (int c = 0; c < chunkCount; ++c)
+        {
+            Job job{task, c * chunkSize, std::min(itemCount, (c + 1) * chunkSize)};
+            {
+                std::lock_guard<std::mutex> lock(m_queues[static_cast<size_t>(queue)]->mutex);
+                m_queues[static_cast<size_t>(queue)]->jobs.push_back(job);
+            }
+            queue = (queue + 1) % m_workerCount;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_wakeMutex);
+        }
+        m_wakeCv.notify_all();
+        return task;
+    }
+
+    void Finish(void* userTask)
+    {
+        Task* task = static_cast<Task*>(userTask);
+        if (!task) return;
+        while (task->remaining.load(std::memory_order_acquire) > 0)
+        {
+            if (!TryRunOne(CurrentWorkerIndex()))
+            {
+                std::this_thread::yield();
+            }
+        }
+        ReleaseTask(task);
+    }
+
+private:
+    static constexpr int kChunksPerWorker = 4;
+    static constexpr int kSpinIterations = 2000;
+
+    struct Task
+    {
+        b2TaskCallback* fn = nullptr;
+        void* context = nullptr;
+        std::atomic<int> remaining{0};
+    };
+
+    struct Job
+    {
+        Task* task = nullptr;
+        int start = 0;
+        int end = 0;
+    };
+
+    struct WorkerQueue
+    {
+        std::mutex mutex;
+        std::deque<Job> jobs;
+    };
+
+    int m_workerCount = 1;
+    std::vector<std::unique_ptr<WorkerQueue>> m_queues;
+    std::vector<std::thread> m_threads;
+
+    std::atomic<int> m_pendingJobs{0};
+    std::atomic<unsigned> m_nextQueue{0};
+    std::atomic<bool> m_stop{false};
+    std::mutex m_wakeMutex;
+    std::condition_variable m_wakeCv;
+
+    std::mutex m_taskMutex;
+    std::vector<std::unique_ptr<Task>> m_taskStorage;
+    std::vector<Task*> m_freeTasks;
+
+    // The scheduler that owns this thread, and the thread's index in it. A
+    // worker of one scheduler that calls into another is a caller there.
+    // Zero-initialized like any thread_local, so other threads have no owner.
+    struct WorkerIdentity
+    {
+        const TaskScheduler* owner;
+        int index;
+    };
+    static inline thread_local WorkerIdentity t_worker;
+
+    int CurrentWorkerIndex() const { return t_worker.owner == this ? t_worker.index : 0; }
+
+    static void* EnqueueTaskCallback(b2TaskCallback* task, int itemCount, int minRange, void* taskContext, void* userContext)
+    {
+        return static_cast<TaskScheduler*>(userContext)->Enqueue(task, itemCount, minRange, taskContext);
+    }
+
+    static void FinishTaskCallback(void* userTask, void* userContext)
+    {
+        static_cast<TaskScheduler*>(userContext)->Finish(userTask);
+    }
+
+    Task* AcquireTask()
+    {
+        std::lock_guard<std::mutex> lock(m_taskMutex);
+        if (m_freeTasks.empty())
+        {
+            m_taskStorage.push_back(std::make_unique<Task>());
+            return m_taskStorage.back().get();
+        }
+        Task* t = m_freeTasks.back();
+        m_freeTasks.pop_back();
+        return t;
+    }
+
+    void ReleaseTask(Task* task)
+    {
+        std::lock_guard<std::mutex> lock(m_taskMutex);
+        m_freeTasks.push_back(task);
+    }
+
+    bool PopJob(int workerIndex, Job& out)
+    {
+        // Own queue from the back (LIFO, cache-warm), then steal from the front of the others.
+        {
+            WorkerQueue& q = *m_queues[static_cast<size_t>(workerIndex)];
+            std::lock_guard<std::mutex> lock(q.mutex);
+            if (!q.jobs.empty())
+            {
+                out = q.jobs.back();
+                q.jobs.pop_back();
+                return true;
+            }
+        }
+        for (int k = 1; k < m_workerCount; ++k)
+        {
+            WorkerQueue& q = *m_queues[static_cast<size_t>((workerIndex + k) % m_workerCount)];
+            std::lock_guard<std::mutex> lock(q.mutex);
+            if (!q.jobs.empty())
+            {
+                out = q.jobs.front();
+                q.jobs.pop_front();
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool TryRunOne(int workerIndex)
+    {
+        if (m_pendingJobs.load(std::memory_order_acquire) <= 0) return false;
+        Job job;
+        if (!PopJob(workerIndex, job)) return false;
+        m_pendingJobs.fetch_sub(1, std::memory_order_acq_rel);
+        {
+            SLOP_ZONE("task");
+            job.task->fn(job.start, job.end, static_cast<uint32_t>(workerIndex), job.task->context);
+        }
+        job.task->remaining.fetch_sub(1, std::memory_order_acq_rel);
+        return true;
+    }
+
+    void WorkerMain(int workerIndex)
+    {
+        t_worker = {this, workerIndex};
+        SLOP_TRACE_THREAD_INDEXED("worker", workerIndex);
+        while (!m_stop.load(std::memory_order_relaxed))
+        {
+            if (TryRunOne(workerIndex)) continue;
+
+            // Box2D issues many short tasks per step; spin briefly before sleeping.
+            bool found = false;
+            for (int i = 0; i < kSpinIterations; ++i)
+            {
+                if (m_pendingJobs.load(std::memory_order_acquire) > 0 || m_stop.load(std::memory_order_relaxed))
+                {
+                    found = true;
+                    break;
+                }
+                if ((i & 63) == 63) std::this_thread::yield();
+            }
+            if (found) continue;
+
+            std::unique_lock<std::mutex> lock(m_wakeMutex);
+            m_wakeCv.wait(lock, [this]() {
+                return m_stop.load(std::memory_order_relaxed) || m_pendingJobs.load(std::memory_order_acquire) > 0;
+            });
+        }
+    }
+};
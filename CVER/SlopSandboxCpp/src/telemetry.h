@@ -0,0 +1,246 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+// One fixed step as seen from outside the process.
+struct TelemetryRecord
+{
+    uint64_t step = 0; // fixed steps since the writer opened the ring
+    uint64_t timeNs = 0; // steady clock
+    float stepMs = 0.0f; // b2World_Step alone
+    uint32_t subSteps = 0;
+    uint32_t bodies = 0;
+    uint32_t awakeBodies = 0;
+    uint32_t joints = 0;
+    uint32_t contacts = 0; // live contact pairs after the step
+    uint32_t hitEvents = 0;
+    uint32_t glassBreaks = 0;
+    uint32_t particles = 0; // shards + spray
+    uint32_t reserved = 0;
+};
+
+// Ring of TelemetryRecords in a named POSIX shared memory segment
+// (shm_open + mmap). One writer pushes a record per step: a copy into the
+// slot and three atomic stores, never a syscall or a lock. Readers in other
+// processes poll it at their own pace; a slot carries the sequence of the
+// record in it, so a reader that fell a whole ring behind sees exactly which
+// records it lost. Windows builds compile but Open/Attach fail (windows.h
+// clashes with raylib names).
+namespace telemetry
+{
+
+inline constexpr uint32_t kMagic = 0x4c455453u; // "STEL"
+inline constexpr uint32_t kVersion = 1;
+inline constexpr const char* kDefaultName = "/slop_telemetry";
+
+struct alignas(64) RingHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t recordBytes;
+    uint32_t capacity;
+    std::atomic<uint64_t> head; // records ever pushed
+    std::atomic<uint32_t> writerOpen;
+};
+
+// seq is 2n+1 while record n is being written and 2n+2 once it is complete.
+struct alignas(64) RingSlot
+{
+    std::atomic<uint64_t> seq;
+    TelemetryRecord record;
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "the ring is shared between processes");
+
+inline size_t RingBytes(uint32_t capacity) { return sizeof(RingHeader) + size_t{capacity} * sizeof(RingSlot); }
+
+class Writer
+{
+public:
+    Writer() = default;
+    Writer(const Writer&) = delete;
+    Writer& operator=(const Writer&) = delete;
+    ~Writer() { Close(); }
+
+    // Creates (or replaces) the segment; capacity is rounded up to a power of two.
+    bool Open(const std::string& name, uint32_t capacity = 4096)
+    {
+        Close();
+#if defined(_WIN32)
+        (void)name;
+        (void)capacity;
+        return false;
+#else
+        uint32_t cap = 64;
+        while (cap < capacity && cap < (1u << 24)) cap <<= 1;
+        ::shm_unlink(name.c_str());
+        int fd = ::shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+        if (fd < 0) return false;
+        size_t bytes = RingBytes(cap);
+        void* p = MAP_FAILED;
+        if (::ftruncate(fd, static_cast<off_t>(bytes)) == 0) p = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (p == MAP_FAILED)
+        {
+            ::shm_unlink(name.c_str());
+            return false;
+        }
+        m_name = name;
+        m_bytes = bytes;
+        m_header = static_cast<RingHeader*>(p);
+        m_slots = reinterpret_cast<RingSlot*>(static_cast<uint8_t*>(p) + sizeof(RingHeader));
+        m_mask = cap - 1;
+        m_next = 0;
+        // ftruncate zero-fills, so the atomics start at 0.
+        m_header->recordBytes = sizeof(TelemetryRecord);
+        m_header->capacity = cap;
+        m_header->version = kVersion;
+        m_header->writerOpen.store(1, std::memory_order_relaxed);
+        m_header->magic = kMagic;
+        std::atomic_thread_fence(std::memory_order_release);
+        return true;
+#endif
+    }
+
+    void Close()
+    {
+#if !defined(_WIN32)
+        if (!m_header) return;
+        m_header->writerOpen.store(0, std::memory_order_release);
+        ::munmap(m_header, m_bytes);
+        ::shm_unlink(m_name.c_str());
+#endif
+        m_header = nullptr;
+        m_slots = nullptr;
+    }
+
+    bool IsOpen() const { return m_header != nullptr; }
+    uint64_t Pushed() const { return m_next; }
+
+    void Push(const TelemetryRecord& r)
+    {
+        if (!m_header) return;
+        RingSlot& slot = m_slots[m_next & m_mask];
+        slot.seq.store(2 * m_next + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        std::memcpy(&slot.record, &r, sizeof(r));
+        slot.seq.store(2 * m_next + 2, std::memory_order_release);
+        m_header->head.store(++m_next, std::memory_order_release);
+    }
+
+private:
+    std::string m_name;
+    size_t m_bytes = 0;
+    RingHeader* m_header = nullptr;
+    RingSlot* m_slots = nullptr;
+    uint64_t m_mask = 0;
+    uint64_t m_next = 0;
+};
+
+class Reader
+{
+public:
+    Reader() = default;
+    Reader(const Reader&) = delete;
+    Reader& operator=(const Reader&) = delete;
+    ~Reader() { Close(); }
+
+    // Maps an existing segment read-only and starts at its newest record.
+    bool Attach(const std::string& name)
+    {
+        Close();
+#if defined(_WIN32)
+        (void)name;
+        return false;
+#else
+        int fd = ::shm_open(name.c_str(), O_RDONLY, 0);
+        if (fd < 0) return false;
+        void* p = ::mmap(nullptr, sizeof(RingHeader), PROT_READ, MAP_SHARED, fd, 0);
+        if (p == MAP_FAILED)
+        {
+            ::close(fd);
+            return false;
+        }
+        const RingHeader* h = static_cast<const RingHeader*>(p);
+        bool valid = h->magic == kMagic && h->version == kVersion && h->recordBytes == sizeof(TelemetryRecord) && h->capacity > 0 &&
+                     (h->capacity & (h->capacity - 1)) == 0;
+        uint32_t cap = valid ? h->capacity : 0;
+        ::munmap(p, sizeof(RingHeader));
+        p = valid ? ::mmap(nullptr, RingBytes(cap), PROT_READ, MAP_SHARED, fd, 0) : MAP_FAILED;
+        ::close(fd);
+        if (p == MAP_FAILED) return false;
+        m_bytes = RingBytes(cap);
+        m_header = static_cast<const RingHeader*>(p);
+        m_slots = reinterpret_cast<const RingSlot*>(static_cast<const uint8_t*>(p) + sizeof(RingHeader));
+        m_mask = cap - 1;
+        m_cursor = m_header->head.load(std::memory_order_acquire);
+        m_dropped = 0;
+        return true;
+#endif
+    }
+
+    void Close()
+    {
+#if !defined(_WIN32)
+        if (m_header) ::munmap(const_cast<RingHeader*>(m_header), m_bytes);
+#endif
+        m_header = nullptr;
+        m_slots = nullptr;
+    }
+
+    bool IsAttached() const { return m_header != nullptr; }
+    bool WriterOpen() const { return m_header && m_header->writerOpen.load(std::memory_order_acquire) != 0; }
+    // Records overwritten before this reader got to them.
+    uint64_t Dropped() const { return m_dropped; }
+
+    // Copies up to maxCount records pushed since the last call, oldest first.
+    size_t Poll(TelemetryRecord* out, size_t maxCount)
+    {
+        if (!m_header) return 0;
+        uint64_t head = m_header->head.load(std::memory_order_acquire);
+        uint64_t capacity = m_mask + 1;
+        if (head - m_cursor > capacity)
+        {
+            m_dropped += head - capacity - m_cursor;
+            m_cursor = head - capacity;
+        }
+        size_t n = 0;
+        for (; m_cursor < head && n < maxCount; ++m_cursor)
+        {
+            const RingSlot& slot = m_slots[m_cursor & m_mask];
+            uint64_t seq = slot.seq.load(std::memory_order_acquire);
+            if (seq == 2 * m_cursor + 2)
+            {
+                std::memcpy(&out[n], &slot.record, sizeof(TelemetryRecord));
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (slot.seq.load(std::memory_order_relaxed) == seq)
+                {
+                    ++n;
+                    continue;
+                }
+            }
+            ++m_dropped; // lapped while reading
+        }
+        return n;
+    }
+
+private:
+    size_t m_bytes = 0;
+    const RingHeader* m_header = nullptr;
+    const RingSlot* m_slots = nullptr;
+    uint64_t m_mask = 0;
+    uint64_t m_cursor = 0;
+    uint64_t m_dropped = 0;
+};
+
+} // namespace telemetry
@@ -0,0 +1,114 @@
+// SlopTelemetry: follows a running sandbox's telemetry ring (started with
+// SlopSandboxCpp --telemetry NAME) from another process. Prints a summary
+// line per second, or with --csv every step as CSV for plotting. Waits for
+// the writer to appear and exits when it closes the ring.
+
+#include "telemetry.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+namespace
+{
+
+struct Summary
+{
+    uint64_t steps = 0;
+    double stepMsSum = 0.0;
+    float stepMsMax = 0.0f;
+    uint64_t glassBreaks = 0;
+    uint64_t hitEvents = 0;
+    TelemetryRecord last;
+
+    void Add(const TelemetryRecord& r)
+    {
+        ++steps;
+        stepMsSum += r.stepMs;
+        stepMsMax = std::max(stepMsMax, r.stepMs);
+        glassBreaks += r.glassBreaks;
+        hitEvents += r.hitEvents;
+        last = r;
+    }
+};
+
+void PrintCsvRow(const TelemetryRecord& r)
+{
+    std::printf("%llu,%llu,%.4f,%u,%u,%u,%u,%u,%u,%u,%u\n", static_cast<unsigned long long>(r.step),
+                static_cast<unsigned long long>(r.timeNs), r.stepMs, r.subSteps, r.bodies, r.awakeBodies, r.joints, r.contacts,
+                r.hitEvents, r.glassBreaks, r.particles);
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    const char* name = telemetry::kDefaultName;
+    bool csv = false;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--name") == 0 && i + 1 < argc)
+        {
+            name = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--csv") == 0)
+        {
+            csv = true;
+        }
+        else
+        {
+            std::fprintf(stderr, "usage: %s [--name /slop_telemetry] [--csv]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    telemetry::Reader reader;
+    std::fprintf(stderr, "waiting for %s\n", name);
+    while (!reader.Attach(name)) std::this_thread::sleep_for(std::chrono::milliseconds(250));
+
+    if (csv) std::printf("step,time_ns,step_ms,substeps,bodies,awake,joints,contacts,hits,glass_breaks,particles\n");
+    std::vector<TelemetryRecord> batch(1024);
+    Summary summary;
+    uint64_t reportedDrops = 0;
+    auto lastReport = std::chrono::steady_clock::now();
+    bool open = true;
+    while (open)
+    {
+        open = reader.WriterOpen();
+        size_t n;
+        while ((n = reader.Poll(batch.data(), batch.size())) > 0)
+        {
+            for (size_t i = 0; i < n; ++i)
+            {
+                if (csv) PrintCsvRow(batch[i]);
+                else summary.Add(batch[i]);
+            }
+        }
+        if (reader.Dropped() != reportedDrops)
+        {
+            std::fprintf(stderr, "dropped %llu records\n", static_cast<unsigned long long>(reader.Dropped() - reportedDrops));
+            reportedDrops = reader.Dropped();
+        }
+
+        auto now = std::chrono::steady_clock::now();
+        if (!csv && (now - lastReport >= std::chrono::seconds(1) || !open) && summary.steps > 0)
+        {
+            const TelemetryRecord& r = summary.last;
+            std::printf("step %llu  %llu steps  step %.2f ms avg %.2f max  bodies %u (%u awake)  joints %u  contacts %u  hits %llu  "
+                        "glass breaks %llu  particles %u\n",
+                        static_cast<unsigned long long>(r.step), static_cast<unsigned long long>(summary.steps),
+                        summary.stepMsSum / static_cast<double>(summary.steps), summary.stepMsMax, r.bodies, r.awakeBodies, r.joints,
+                        r.contacts, static_cast<unsigned long long>(summary.hitEvents),
+                        static_cast<unsigned long long>(summary.glassBreaks), r.particles);
+            std::fflush(stdout);
+            summary = Summary{};
+            lastReport = now;
+        }
+        if (open) std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    std::fprintf(stderr, "writer closed\n");
+    return 0;
+}
@@ -0,0 +1,255 @@
+#pragma once
+
+// Timeline zones, compiled in only when a backend is chosen (CMake SLOP_TRACE):
+//   SLOP_TRACE_TRACY   zones go to the Tracy client linked into the build
+//   SLOP_TRACE_CHROME  zones are written as Chrome trace JSON, for
+//                      about://tracing or ui.perfetto.dev, to trace::Open's path
+// Without either every macro expands to nothing.
+//   SLOP_ZONE("name")                 zone to the end of the block; a literal
+//   SLOP_TRACE_THREAD("name")         names the calling thread
+//   SLOP_TRACE_THREAD_INDEXED("w", i) names it "w i"
+//   SLOP_TRACE_FRAME()                marks the end of a presented frame
+
+#if defined(SLOP_TRACE_TRACY) && defined(SLOP_TRACE_CHROME)
+#error "pick one of SLOP_TRACE_TRACY and SLOP_TRACE_CHROME"
+#endif
+
+#define SLOP_TRACE_CONCAT_(a, b) a##b
+#define SLOP_TRACE_CONCAT(a, b) SLOP_TRACE_CONCAT_(a, b)
+
+#if defined(SLOP_TRACE_TRACY)
+
+#include <tracy/Tracy.hpp>
+
+#include <string>
+
+namespace trace
+{
+inline constexpr const char* kBackend = "tracy";
+// The Tracy client streams to a connected profiler; there is no file.
+inline bool Open(const char*) { return true; }
+inline void Close() {}
+} // namespace trace
+
+#define SLOP_ZONE(name) ZoneScopedN(name)
+#define SLOP_TRACE_THREAD(name) tracy::SetThreadName(name)
+#define SLOP_TRACE_THREAD_INDEXED(name, index) tracy::SetThreadName((std::string(name) + " " + std::to_string(index)).c_str())
+#define SLOP_TRACE_FRAME() FrameMark
+
+#elif defined(SLOP_TRACE_CHROME)
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace trace
+{
+
+inline constexpr const char* kBackend = "chrome";
+
+struct Event
+{
+    const char* name;
+    int64_t startNs;
+    int64_t durNs; // < 0: an instant
+};
+
+// One JSON file shared by every thread. Threads collect complete events
+// locally and hand them over in batches, so a zone costs two clock reads
+// and a push_back; nothing is written while the file is closed.
+class ChromeSink
+{
+public:
+    static ChromeSink& Instance()
+    {
+        static ChromeSink sink;
+        return sink;
+    }
+
+    // Thread buffers are gone by now, so this only finishes the file.
+    ~ChromeSink() { CloseFile(); }
+
+    bool Open(const char* path)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_file) return true;
+        m_file = std::fopen(path, "w");
+        if (!m_file) return false;
+        std::fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n", m_file);
+        m_first = true;
+        m_generation.fetch_add(1, std::memory_order_relaxed);
+        m_open.store(true, std::memory_order_release);
+        return true;
+    }
+
+    // Worker threads flush when they exit; call once they have.
+    void Close();
+
+    bool IsOpen() const { return m_open.load(std::memory_order_acquire); }
+    uint32_t Generation() const { return m_generation.load(std::memory_order_relaxed); }
+
+    int64_t NowNs() const
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - m_origin).count();
+    }
+
+    uint32_t NextThreadId() { return m_nextTid.fetch_add(1, std::memory_order_relaxed); }
+
+    void Write(uint32_t tid, const std::string& threadName, bool writeName, const Event* events, size_t count)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_file) return;
+        if (writeName && !threadName.empty())
+        {
+            Separate();
+            std::fprintf(m_file, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"%s\"}}", tid,
+                         threadName.c_str());
+        }
+        for (size_t i = 0; i < count; ++i)
+        {
+            const Event& e = events[i];
+            Separate();
+            if (e.durNs < 0)
+            {
+                std::fprintf(m_file, "{\"name\":\"%s\",\"ph\":\"i\",\"s\":\"g\",\"pid\":1,\"tid\":%u,\"ts\":%.3f}", e.name, tid,
+                             static_cast<double>(e.startNs) * 1e-3);
+            }
+            else
+            {
+                std::fprintf(m_file, "{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}", e.name, tid,
+                             static_cast<double>(e.startNs) * 1e-3, static_cast<double>(e.durNs) * 1e-3);
+            }
+        }
+    }
+
+private:
+    ChromeSink() : m_origin(std::chrono::steady_clock::now()) {}
+
+    void CloseFile()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_file) return;
+        std::fputs("\n]}\n", m_file);
+        std::fclose(m_file);
+        m_file = nullptr;
+        m_open.store(false, std::memory_order_release);
+    }
+
+    void Separate()
+    {
+        if (!m_first) std::fputs(",\n", m_file);
+        m_first = false;
+    }
+
+    std::chrono::steady_clock::time_point m_origin;
+    std::mutex m_mutex;
+    FILE* m_file = nullptr;
+    bool m_first = true;
+    std::atomic<bool> m_open{false};
+    std::atomic<uint32_t> m_generation{0};
+    std::atomic<uint32_t> m_nextTid{1};
+};
+
+class ThreadBuffer
+{
+public:
+    static constexpr size_t kFlushEvents = 4096;
+
+    ThreadBuffer() : m_tid(ChromeSink::Instance().NextThreadId()) { m_events.reserve(kFlushEvents); }
+    ~ThreadBuffer() { Flush(); }
+
+    static ThreadBuffer& Local()
+    {
+        thread_local ThreadBuffer buffer;
+        return buffer;
+    }
+
+    void SetName(std::string name)
+    {
+        m_name = std::move(name);
+        m_nameGeneration = 0;
+    }
+
+    void Add(const char* name, int64_t startNs, int64_t durNs)
+    {
+        m_events.push_back({name, startNs, durNs});
+        if (m_events.size() >= kFlushEvents) Flush();
+    }
+
+    void Flush()
+    {
+        ChromeSink& sink = ChromeSink::Instance();
+        // The name goes once into every file this thread writes to.
+        bool writeName = m_nameGeneration != sink.Generation();
+        if (m_events.empty() && !writeName) return;
+        sink.Write(m_tid, m_name, writeName, m_events.data(), m_events.size());
+        m_nameGeneration = sink.Generation();
+        m_events.clear();
+    }
+
+private:
+    uint32_t m_tid;
+    uint32_t m_nameGeneration = 0;
+    std::string m_name;
+    std::vector<Event> m_events;
+};
+
+inline void ChromeSink::Close()
+{
+    if (IsOpen()) ThreadBuffer::Local().Flush();
+    CloseFile();
+}
+
+class Zone
+{
+public:
+    explicit Zone(const char* name) : m_name(name), m_start(ChromeSink::Instance().IsOpen() ? ChromeSink::Instance().NowNs() : -1) {}
+
+    ~Zone()
+    {
+        if (m_start < 0 || !ChromeSink::Instance().IsOpen()) return;
+        ThreadBuffer::Local().Add(m_name, m_start, ChromeSink::Instance().NowNs() - m_start);
+    }
+
+    Zone(const Zone&) = delete;
+    Zone& operator=(const Zone&) = delete;
+
+private:
+    const char* m_name;
+    int64_t m_start;
+};
+
+inline bool Open(const char* path) { return ChromeSink::Instance().Open(path); }
+inline void Close() { ChromeSink::Instance().Close(); }
+
+inline void Frame()
+{
+    if (ChromeSink::Instance().IsOpen()) ThreadBuffer::Local().Add("frame", ChromeSink::Instance().NowNs(), -1);
+}
+
+} // namespace trace
+
+#define SLOP_ZONE(name) ::trace::Zone SLOP_TRACE_CONCAT(slopZone, __LINE__)(name)
+#define SLOP_TRACE_THREAD(name) ::trace::ThreadBuffer::Local().SetName(name)
+#define SLOP_TRACE_THREAD_INDEXED(name, index) ::trace::ThreadBuffer::Local().SetName(std::string(name) + " " + std::to_string(index))
+#define SLOP_TRACE_FRAME() ::trace::Frame()
+
+#else
+
+namespace trace
+{
+inline constexpr const char* kBackend = nullptr;
+inline bool Open(const char*) { return false; }
+inline void Close() {}
+} // namespace trace
+
+#define SLOP_ZONE(name)
+#define SLOP_TRACE_THREAD(name)
+#define SLOP_TRACE_THREAD_INDEXED(name, index)
+#define SLOP_TRACE_FRAME()
+
+#endif
@@ -0,0 +1,225 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <utility>
+
+// Body transforms for external renderers: one contiguous block holding a
+// header and two copies of structure-of-arrays rows (key, position, rotation,
+// radius, shape, kind, flags). The writer fills the copy readers are not
+// pointed at and then flips `front`; readers never block, and a copy that was
+// rewritten while being read shows up as a changed sequence (a seqlock), so
+// the read is simply retried. Everything is addressed by offset from the
+// block start, so the block can be mapped into another process as is.
+//
+// Rows the writer does not touch keep what that copy held two publishes ago,
+// which lets the writer rewrite only rows changed since then.
+class TransformExport
+{
+public:
+    static constexpr uint32_t kMagic = 0x4d465853u; // "SXFM"
+    static constexpr uint32_t kFormatVersion = 1;
+
+    struct alignas(64) Header
+    {
+        uint32_t magic = kMagic;
+        uint32_t format = kFormatVersion;
+        uint32_t capacity = 0; // rows per copy
+        uint32_t copyBytes = 0; // copy i starts at sizeof(Header) + i * copyBytes
+        std::atomic<uint32_t> front{0};
+    };
+
+    // Start of each copy; the columns follow, in View order, each
+    // capacity entries long.
+    struct alignas(64) CopyHeader
+    {
+        std::atomic<uint32_t> sequence{0}; // odd while being written
+        uint32_t count = 0; // rows present, at most capacity
+        uint32_t total = 0; // bodies in the world; above count when rows were dropped
+        uint64_t step = 0; // writer step the copy was published at
+    };
+
+    // What a reader gets handed, valid only inside its copy callback.
+    struct View
+    {
+        uint32_t count;
+        uint32_t total;
+        uint64_t step;
+        const uint64_t* key;
+        const float* x;
+        const float* y;
+        const float* cosAngle;
+        const float* sinAngle;
+        const float* radius;
+        const uint32_t* shape;
+        const uint8_t* kind;
+        const uint8_t* flags;
+    };
+
+    static_assert(std::atomic<uint32_t>::is_always_lock_free, "the block may be shared between processes");
+
+    static constexpr size_t kRowBytes = sizeof(uint64_t) + 5 * sizeof(float) + sizeof(uint32_t) + 2;
+
+    static size_t CopyBytes(uint32_t capacity) { return (sizeof(CopyHeader) + size_t{capacity} * kRowBytes + 63) & ~size_t{63}; }
+    static size_t BlockBytes(uint32_t capacity) { return sizeof(Header) + 2 * CopyBytes(capacity); }
+
+    // capacity 0 frees the block.
+    void Allocate(uint32_t capacity)
+    {
+        m_block.reset();
+        m_capacity = capacity;
+        m_back = 1;
+        if (capacity == 0) return;
+        m_block.reset(new Line[BlockBytes(capacity) / sizeof(Line)]());
+        Header* h = new (m_block.get()) Header{};
+        h->capacity = capacity;
+        h->copyBytes = static_cast<uint32_t>(CopyBytes(capacity));
+        for (uint32_t i = 0; i < 2; ++i) new (Bytes() + sizeof(Header) + i * h->copyBytes) CopyHeader{};
+    }
+
+    bool Enabled() const { return m_block != nullptr; }
+    uint32_t Capacity() const { return m_capacity; }
+    const uint8_t* Data() const { return reinterpret_cast<const uint8_t*>(m_block.get()); }
+    size_t Size() const { return m_block ? BlockBytes(m_capacity) : 0; }
+
+    // Writer side: Begin, then Matches/SetIdentity/SetTransform for rows
+    // below the returned count, then Publish.
+    uint32_t Begin(size_t total, uint64_t step)
+    {
+        Header* h = reinterpret_cast<Header*>(Bytes());
+        m_back = 1u - h->front.load(std::memory_order_relaxed);
+        CopyHeader* c = BackCopy();
+        m_backCount = c->count;
+        c->sequence.store(c->sequence.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        c->count = static_cast<uint32_t>(std::min<size_t>(total, m_capacity));
+        c->total = static_cast<uint32_t>(std::min<size_t>(total, UINT32_MAX));
+        c->step = step;
+        uint8_t* p = reinterpret_cast<uint8_t*>(c) + sizeof(CopyHeader);
+        m_key = Take<uint64_t>(p, m_capacity);
+        m_x = Take<float>(p, m_capacity);
+        m_y = Take<float>(p, m_capacity);
+        m_cos = Take<float>(p, m_capacity);
+        m_sin = Take<float>(p, m_capacity);
+        m_radius = Take<float>(p, m_capacity);
+        m_shape = Take<uint32_t>(p, m_capacity);
+        m_kind = Take<uint8_t>(p, m_capacity);
+        m_flags = Take<uint8_t>(p, m_capacity);
+        return c->count;
+    }
+
+    // True when the back copy already holds this body in row i with these
+    // flags, so at most its transform is stale.
+    bool Matches(uint32_t i, uint64_t key, uint8_t flags) const { return i < m_backCount && m_key[i] == key && m_flags[i] == flags; }
+
+    void SetIdentity(uint32_t i, uint64_t key, uint8_t kind, uint32_t shape, float radius, uint8_t flags)
+    {
+        m_key[i] = key;
+        m_kind[i] = kind;
+        m_shape[i] = shape;
+        m_radius[i] = radius;
+        m_flags[i] = flags;
+    }
+
+    void SetTransform(uint32_t i, float x, float y, float cosAngle, float sinAngle)
+    {
+        m_x[i] = x;
+        m_y[i] = y;
+        m_cos[i] = cosAngle;
+        m_sin[i] = sinAngle;
+    }
+
+    void Publish()
+    {
+        CopyHeader* c = BackCopy();
+        c->sequence.store(c->sequence.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        reinterpret_cast<Header*>(Bytes())->front.store(m_back, std::memory_order_release);
+    }
+
+    // Reader side, from any thread or process that can see the block.
+    // copy(const View&) must only copy out and may run more than once. False
+    // when the block is not valid or keeps being rewritten under the reader.
+    template <typename CopyFn>
+    static bool Read(const uint8_t* block, CopyFn&& copy)
+    {
+        if (!block) return false;
+        const Header* h = reinterpret_cast<const Header*>(block);
+        if (h->magic != kMagic || h->format != kFormatVersion) return false;
+        for (int attempt = 0; attempt < kReadAttempts; ++attempt)
+        {
+            uint32_t front = h->front.load(std::memory_order_acquire) & 1u;
+            const CopyHeader* c = reinterpret_cast<const CopyHeader*>(block + sizeof(Header) + front * h->copyBytes);
+            uint32_t seq = c->sequence.load(std::memory_order_acquire);
+            if (seq & 1u) continue;
+
+            const uint8_t* p = reinterpret_cast<const uint8_t*>(c) + sizeof(CopyHeader);
+            uint32_t cap = h->capacity;
+            View v{};
+            v.count = std::min(c->count, h->capacity);
+            v.total = c->total;
+            v.step = c->step;
+            v.key = Take<const uint64_t>(p, cap);
+            v.x = Take<const float>(p, cap);
+            v.y = Take<const float>(p, cap);
+            v.cosAngle = Take<const float>(p, cap);
+            v.sinAngle = Take<const float>(p, cap);
+            v.radius = Take<const float>(p, cap);
+            v.shape = Take<const uint32_t>(p, cap);
+            v.kind = Take<const uint8_t>(p, cap);
+            v.flags = Take<const uint8_t>(p, cap);
+            copy(static_cast<const View&>(v));
+
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (c->sequence.load(std::memory_order_relaxed) == seq) return true;
+        }
+        return false;
+    }
+
+    template <typename CopyFn>
+    bool Read(CopyFn&& copy) const
+    {
+        return Read(Data(), std::forward<CopyFn>(copy));
+    }
+
+private:
+    static constexpr int kReadAttempts = 8;
+
+    struct alignas(64) Line
+    {
+        uint8_t bytes[64];
+    };
+
+    // Widest columns first, so each stays naturally aligned.
+    template <typename T, typename Byte>
+    static T* Take(Byte*& p, uint32_t capacity)
+    {
+        T* col = reinterpret_cast<T*>(p);
+        p += size_t{capacity} * sizeof(T);
+        return col;
+    }
+
+    uint8_t* Bytes() { return reinterpret_cast<uint8_t*>(m_block.get()); }
+
+    CopyHeader* BackCopy()
+    {
+        return reinterpret_cast<CopyHeader*>(Bytes() + sizeof(Header) + m_back * CopyBytes(m_capacity));
+    }
+
+    std::unique_ptr<Line[]> m_block;
+    uint32_t m_capacity = 0;
+    uint32_t m_back = 1;
+    uint32_t m_backCount = 0;
+    uint64_t* m_key = nullptr;
+    float* m_x = nullptr;
+    float* m_y = nullptr;
+    float* m_cos = nullptr;
+    float* m_sin = nullptr;
+    float* m_radius = nullptr;
+    uint32_t* m_shape = nullptr;
+    uint8_t* m_kind = nullptr;
+    uint8_t* m_flags = nullptr;
+};
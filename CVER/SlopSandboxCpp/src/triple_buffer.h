@@ -0,0 +1,47 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+// Lock-free single-producer/single-consumer triple buffer. The writer fills
+// WriteBuffer() and calls Publish(); the reader calls Acquire() to take the
+// newest published buffer. Neither side ever blocks, and a slow reader only
+// skips intermediate buffers.
+template <typename T>
+class TripleBuffer
+{
+public:
+    T& WriteBuffer() { return m_slots[m_write]; }
+
+    void Publish()
+    {
+        uint8_t prev = m_shared.exchange(static_cast<uint8_t>(m_write | kFresh), std::memory_order_acq_rel);
+        m_write = prev & kIndexMask;
+    }
+
+    bool HasFresh() const { return (m_shared.load(std::memory_order_acquire) & kFresh) != 0; }
+
+    // Returns true if a newer buffer was swapped in.
+    bool Acquire()
+    {
+        if (!HasFresh()) return false;
+        uint8_t prev = m_shared.exchange(m_read, std::memory_order_acq_rel);
+        m_read = prev & kIndexMask;
+        return true;
+    }
+
+    // The reader may modify or swap out its buffer; it goes back to the writer,
+    // which is expected to overwrite it completely.
+    T& ReadBuffer() { return m_slots[m_read]; }
+    const T& ReadBuffer() const { return m_slots[m_read]; }
+
+private:
+    static constexpr uint8_t kIndexMask = 0x3;
+    static constexpr uint8_t kFresh = 0x4;
+
+    std::array<T, 3> m_slots{};
+    uint8_t m_write = 0;
+    uint8_t m_read = 1;
+    std::atomic<uint8_t> m_shared{2};
+};
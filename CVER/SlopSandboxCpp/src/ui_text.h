@@ -0,0 +1,205 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+enum class Language
+{
+    RU,
+    EN
+};
+
+constexpr size_t kLanguageCount = 2;
+
+// Every fixed UI string. A label's interned id is (TextId, Language), so
+// lookups and width cache keys never touch the string itself.
+enum class TextId : uint16_t
+{
+    Defaults,
+    ResetScene,
+    Cube,
+    Ball,
+    Triangle,
+    Cursor,
+    Grid,
+    Rain,
+    Weld,
+    Wheel,
+    Bounce,
+    Slip,
+    Sticky,
+    Glass,
+    Blast,
+    Water,
+    Land,
+    Shallow,
+    DrawOff,
+    DrawQuad,
+    DrawCircle,
+    DrawTriangle,
+    DrawFreeform,
+    Pause,
+    LangRu,
+    LangEn,
+    ThemeDark,
+    ThemeLight,
+    PixelOff,
+    PixelOn,
+    Move,
+    Collapse,
+    Expand,
+    ToolCursor,
+    ToolWeld,
+    ToolWheel,
+    ToolBounce,
+    ToolSlip,
+    ToolSticky,
+    ToolGlass,
+    ToolBlast,
+    TimeSpeedFormat, // printf format, one float
+    PixelStateOn,
+    PixelStateOff,
+    RewindFormat, // printf format, one float
+    FastForwardFormat, // printf format, one float
+    LoadingSceneFormat, // printf format, one int (percent)
+    Count
+};
+
+namespace ui_text
+{
+
+constexpr size_t kTextCount = static_cast<size_t>(TextId::Count);
+
+// Indexed by TextId, then Language.
+constexpr const char* kStrings[kTextCount][kLanguageCount] = {
+    {"По умолчанию", "Defaults"},
+    {"Сброс Сцены", "Reset Scene"},
+    {"Куб (Q)", "Cube (Q)"},
+    {"Шар (W)", "Ball (W)"},
+    {"Треугольник (E)", "Triangle (E)"},
+    {"Курсор (1)", "Cursor (1)"},
+    {"Сетка (Shift+Q)", "Grid (Shift+Q)"},
+    {"Дождь (Shift+S)", "Rain (Shift+S)"},
+    {"Сварка (2)", "Weld (2)"},
+    {"Колесо (3)", "Wheel (3)"},
+    {"Прыгучесть (4)", "Bounce (4)"},
+    {"Скользкость (5)", "Slip (5)"},
+    {"Липкость (6)", "Sticky (6)"},
+    {"Стеклянность (7)", "Glass (7)"},
+    {"Взрыв (9)", "Blast (9)"},
+    {"Вода", "Water"},
+    {"Суша", "Land"},
+    {"Мелководье", "Shallow"},
+    {"Нет (1)", "Off (1)"},
+    {"4-угольник (R)", "Quad (R)"},
+    {"Окружность (T)", "Circle (T)"},
+    {"Треугольник (Y)", "Triangle (Y)"},
+    {"Рисунок [exp] (U)", "Drawing [exp] (U)"},
+    {"Пауза (Space)", "Pause (Space)"},
+    {"RU", "RU"},
+    {"EN", "EN"},
+    {"Тём", "Dark"},
+    {"Свет", "Light"},
+    {"Пикс", "Pixel"},
+    {"Ретро", "Retro"},
+    {"Переместить", "Move"},
+    {"^", "^"},
+    {"v", "v"},
+    {"Инструмент: Курсор", "Tool: Cursor"},
+    {"Инструмент: Сварка", "Tool: Weld"},
+    {"Инструмент: Колесо", "Tool: Wheel"},
+    {"Инструмент: Прыгучесть", "Tool: Bounce"},
+    {"Инструмент: Скользкость", "Tool: Slip"},
+    {"Инструмент: Липкость", "Tool: Sticky"},
+    {"Инструмент: Стеклянность", "Tool: Glass"},
+    {"Инструмент: Взрыв", "Tool: Blast"},
+    {"Скорость времени %.2f", "Time speed %.2f"},
+    {"Пикс: ВКЛ (8)", "Pixel: ON (8)"},
+    {"Пикс: ВЫКЛ (8)", "Pixel: OFF (8)"},
+    {"Перемотка -%.1f с (, .)", "Rewind -%.1f s (, .)"},
+    {"Ускорение: +%.0f с (F)", "Fast-forward: +%.0f s (F)"},
+    {"Загрузка сцены %d%%", "Loading scene %d%%"},
+};
+
+static_assert(kStrings[kTextCount - 1][0] != nullptr, "every TextId needs a row in kStrings");
+
+// Dense id of one localized string.
+constexpr uint32_t StringKey(TextId id, Language lang)
+{
+    return static_cast<uint32_t>(id) * kLanguageCount + static_cast<uint32_t>(lang);
+}
+
+inline const char* Get(TextId id, Language lang)
+{
+    size_t i = static_cast<size_t>(id);
+    return i < kTextCount ? kStrings[i][static_cast<size_t>(lang)] : "";
+}
+
+} // namespace ui_text
+
+// Fixed-size open-addressed cache of measured widths keyed by (string key,
+// pixel size). Never allocates; when a probe run is full the home slot is
+// overwritten, so a miss only costs a re-measure.
+class TextWidthCache
+{
+public:
+    static constexpr size_t kCapacity = 256; // power of two
+    static constexpr size_t kMaxProbe = 4;
+
+    bool Find(uint32_t key, float fontSize, float& width) const
+    {
+        uint32_t size = SizeKey(fontSize);
+        size_t home = Home(key, size);
+        for (size_t p = 0; p < kMaxProbe; ++p)
+        {
+            const Entry& e = m_entries[(home + p) & (kCapacity - 1)];
+            if (!e.used) return false;
+            if (e.key == key && e.size == size)
+            {
+                width = e.width;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void Store(uint32_t key, float fontSize, float width)
+    {
+        uint32_t size = SizeKey(fontSize);
+        size_t home = Home(key, size);
+        for (size_t p = 0; p < kMaxProbe; ++p)
+        {
+            Entry& e = m_entries[(home + p) & (kCapacity - 1)];
+            if (!e.used || (e.key == key && e.size == size))
+            {
+                e = {key, size, width, true};
+                return;
+            }
+        }
+        m_entries[home] = {key, size, width, true};
+    }
+
+    void Clear()
+    {
+        for (Entry& e : m_entries) e.used = false;
+    }
+
+private:
+    struct Entry
+    {
+        uint32_t key = 0;
+        uint32_t size = 0;
+        float width = 0.0f;
+        bool used = false;
+    };
+
+    static uint32_t SizeKey(float fontSize) { return static_cast<uint32_t>(fontSize + 0.5f); }
+
+    static size_t Home(uint32_t key, uint32_t size)
+    {
+        uint32_t h = (key * 0x9E3779B1u) ^ (size * 0x85EBCA77u);
+        return static_cast<size_t>(h >> 24) & (kCapacity - 1);
+    }
+
+    Entry m_entries[kCapacity];
+};
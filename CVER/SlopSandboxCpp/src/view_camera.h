@@ -0,0 +1,95 @@
+#pragma once
+
+#include <raylib.h>
+
+#include <algorithm>
+#include <cmath>
+
+// Pan/zoom view over a world that can be much wider than the window. Screen =
+// (world - target) * zoom, so target is the world point at the top-left
+// corner. The view is kept inside the world horizontally and anchored to its
+// bottom (the ground) when zoomed out far enough to see past the top. Owned
+// by the render thread; the simulation only ever sees world coordinates.
+class ViewCamera
+{
+public:
+    static constexpr float kMaxZoom = 4.0f;
+
+    void SetViewport(float width, float height)
+    {
+        m_viewW = width;
+        m_viewH = height;
+        Clamp();
+    }
+
+    void SetWorldBounds(Rectangle bounds)
+    {
+        m_world = bounds;
+        Clamp();
+    }
+
+    // Zoom 1 at the left edge, bottom aligned with the screen.
+    void Reset()
+    {
+        m_zoom = 1.0f;
+        m_target = {m_world.x, m_world.y + m_world.height - m_viewH};
+        Clamp();
+    }
+
+    void Pan(Vector2 screenDelta)
+    {
+        m_target.x -= screenDelta.x / m_zoom;
+        m_target.y -= screenDelta.y / m_zoom;
+        Clamp();
+    }
+
+    // Scales the zoom by factor keeping the world point under screenPoint fixed.
+    void ZoomAt(Vector2 screenPoint, float factor)
+    {
+        Vector2 anchor = ToWorld(screenPoint);
+        m_zoom = std::clamp(m_zoom * factor, MinZoom(), kMaxZoom);
+        m_target = {anchor.x - screenPoint.x / m_zoom, anchor.y - screenPoint.y / m_zoom};
+        Clamp();
+    }
+
+    Camera2D Camera() const
+    {
+        Camera2D cam{};
+        cam.target = m_target;
+        cam.zoom = m_zoom;
+        return cam;
+    }
+
+    float Zoom() const { return m_zoom; }
+
+    Vector2 ToWorld(Vector2 screen) const { return {m_target.x + screen.x / m_zoom, m_target.y + screen.y / m_zoom}; }
+    Vector2 ToScreen(Vector2 world) const { return {(world.x - m_target.x) * m_zoom, (world.y - m_target.y) * m_zoom}; }
+
+    // Visible world rectangle grown by marginPx screen pixels on every side.
+    Rectangle Visible(float marginPx = 0.0f) const
+    {
+        float m = marginPx / m_zoom;
+        return {m_target.x - m, m_target.y - m, m_viewW / m_zoom + 2.0f * m, m_viewH / m_zoom + 2.0f * m};
+    }
+
+private:
+    // Zoomed out just far enough to show the whole width.
+    float MinZoom() const { return std::min(1.0f, m_viewW / std::max(1.0f, m_world.width)); }
+
+    void Clamp()
+    {
+        m_zoom = std::clamp(m_zoom, MinZoom(), kMaxZoom);
+        float w = m_viewW / m_zoom;
+        float h = m_viewH / m_zoom;
+        if (w >= m_world.width) m_target.x = m_world.x + 0.5f * (m_world.width - w);
+        else m_target.x = std::clamp(m_target.x, m_world.x, m_world.x + m_world.width - w);
+        float bottom = m_world.y + m_world.height - h;
+        m_target.y = std::clamp(m_target.y, std::min(m_world.y, bottom), bottom);
+    }
+
+    Rectangle m_world{0.0f, 0.0f, 1.0f, 1.0f};
+    float m_viewW = 1.0f;
+    float m_viewH = 1.0f;
+    Vector2 m_target{0.0f, 0.0f};
+    float m_zoom = 1.0f;
+};
@@ -0,0 +1,217 @@
+// SlopViewer: a thin window onto a SlopServer world. Draws the streamed
+// bodies and water and sends clicks back as the same commands the sandbox
+// queues for local input.
+//   SlopViewer [host] [--port 7420]
+// Left click spawns (1/2/3 pick box, circle, triangle; shift for a grid),
+// right click deletes, K kicks the water, R resets the scene. Arrows or a
+// middle drag pan, the wheel zooms.
+
+#include <raylib.h>
+
+#include "net_socket.h"
+#include "sandbox_core.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+SLOP_DEFINE_HEAP_ALLOC_COUNTER()
+
+namespace
+{
+
+Color BodyColor(uint8_t flags)
+{
+    if (flags & kFeatureGlass) return Color{150, 210, 255, 255};
+    if (flags & kFeatureSticky) return Color{120, 220, 120, 255};
+    if (flags & kFeatureBouncy) return Color{255, 170, 80, 255};
+    if (flags & kFeatureSlippery) return Color{170, 170, 255, 255};
+    return Color{230, 230, 235, 255};
+}
+
+void DrawStreamedBody(const netstream::StreamMirror& mirror, const netstream::StreamMirror::Body& b)
+{
+    Vector2 p{b.X(), b.Y()};
+    Color color = BodyColor(b.flags);
+    float a = b.Angle();
+    float c = std::cos(a);
+    float s = std::sin(a);
+    const std::vector<float>* outline = b.shape != 0 ? mirror.Outline(b.shape) : nullptr;
+    if (!outline || outline->size() < 6)
+    {
+        float r = std::max(1.0f, b.RadiusPx());
+        DrawCircleLinesV(p, r, color);
+        DrawLineV(p, {p.x + c * r, p.y + s * r}, color);
+        return;
+    }
+    size_t n = outline->size() / 2;
+    Vector2 prev{};
+    for (size_t i = 0; i <= n; ++i)
+    {
+        float lx = (*outline)[2 * (i % n)];
+        float ly = (*outline)[2 * (i % n) + 1];
+        Vector2 v{p.x + c * lx - s * ly, p.y + s * lx + c * ly};
+        if (i > 0) DrawLineV(prev, v, color);
+        prev = v;
+    }
+}
+
+void DrawStreamedWater(const netstream::StreamMirror& mirror)
+{
+    const netstream::WorldInfo& world = mirror.World();
+    size_t columns = mirror.WaterColumns();
+    if (columns < 2 || world.waveStep <= 0.0f) return;
+    Color line{90, 170, 255, 255};
+    Vector2 prev{0.0f, world.waveBaseline + mirror.WaterHeight(0)};
+    for (size_t i = 1; i < columns; ++i)
+    {
+        Vector2 v{static_cast<float>(i) * world.waveStep, world.waveBaseline + mirror.WaterHeight(i)};
+        DrawLineV(prev, v, line);
+        prev = v;
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    std::string host = "127.0.0.1";
+    uint16_t port = netstream::kDefaultPort;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--port") == 0 && i + 1 < argc) port = static_cast<uint16_t>(std::atoi(argv[++i]));
+        else if (argv[i][0] != '-') host = argv[i];
+        else
+        {
+            std::fprintf(stderr, "usage: SlopViewer [host] [--port 7420]\n");
+            return 1;
+        }
+    }
+
+    netstream::Connection connection;
+    if (!netstream::ConnectTo(connection, host, port))
+    {
+        std::fprintf(stderr, "cannot connect to %s:%u\n", host.c_str(), static_cast<unsigned>(port));
+        return 1;
+    }
+
+    const int width = 1536;
+    const int height = 960;
+    InitWindow(width, height, "SlopViewer");
+    SetTargetFPS(60);
+
+    netstream::StreamMirror mirror;
+    netstream::ByteWriter out;
+    Camera2D cam{};
+    cam.zoom = 1.0f;
+    SpawnShape shape = SpawnShape::Box;
+    bool helloSeen = false;
+    int rate = 0;
+    uint64_t bytesIn = 0;
+    double rateStart = GetTime();
+    double kibPerSecond = 0.0;
+    const char* status = "waiting for the server";
+
+    while (!WindowShouldClose())
+    {
+        bool alive = connection.Pump();
+        netstream::MessageType type;
+        const uint8_t* payload = nullptr;
+        size_t size = 0;
+        while (alive && connection.NextMessage(type, payload, size))
+        {
+            bytesIn += size + netstream::kHeaderBytes;
+            netstream::ByteReader r(payload, size);
+            if (type == netstream::MessageType::Hello)
+            {
+                uint32_t version = 0;
+                float fixedDt = 0.0f;
+                uint16_t fps = 0;
+                alive = r.U32(version) && r.F32(fixedDt) && r.U16(fps) && version == netstream::kVersion;
+                rate = fps;
+                helloSeen = alive;
+                status = alive ? "connected" : "server speaks another version";
+            }
+            else if (type == netstream::MessageType::Frame)
+            {
+                alive = helloSeen && mirror.Apply(r);
+            }
+        }
+        if (!alive && connection.Open())
+        {
+            connection.Close();
+            if (helloSeen) status = "disconnected";
+        }
+        if (GetTime() - rateStart >= 1.0)
+        {
+            kibPerSecond = static_cast<double>(bytesIn) / 1024.0 / (GetTime() - rateStart);
+            bytesIn = 0;
+            rateStart = GetTime();
+        }
+
+        float pan = 600.0f * GetFrameTime() / cam.zoom;
+        if (IsKeyDown(KEY_LEFT)) cam.target.x -= pan;
+        if (IsKeyDown(KEY_RIGHT)) cam.target.x += pan;
+        if (IsKeyDown(KEY_UP)) cam.target.y -= pan;
+        if (IsKeyDown(KEY_DOWN)) cam.target.y += pan;
+        if (IsMouseButtonDown(MOUSE_BUTTON_MIDDLE))
+        {
+            Vector2 d = GetMouseDelta();
+            cam.target.x -= d.x / cam.zoom;
+            cam.target.y -= d.y / cam.zoom;
+        }
+        float wheel = GetMouseWheelMove();
+        if (wheel != 0.0f)
+        {
+            Vector2 before = GetScreenToWorld2D(GetMousePosition(), cam);
+            cam.zoom = std::clamp(cam.zoom * std::pow(1.1f, wheel), 0.05f, 4.0f);
+            Vector2 after = GetScreenToWorld2D(GetMousePosition(), cam);
+            cam.target.x += before.x - after.x;
+            cam.target.y += before.y - after.y;
+        }
+        if (IsKeyPressed(KEY_ONE)) shape = SpawnShape::Box;
+        if (IsKeyPressed(KEY_TWO)) shape = SpawnShape::Circle;
+        if (IsKeyPressed(KEY_THREE)) shape = SpawnShape::Triangle;
+
+        Vector2 at = GetScreenToWorld2D(GetMousePosition(), cam);
+        auto send = [&](SimCommandType t, uint8_t arg = 0, bool flag = false) {
+            SimCommand c;
+            c.type = t;
+            c.arg = arg;
+            c.flag = flag;
+            c.a = at;
+            out.Clear();
+            EncodeCommand(c, out);
+            connection.Queue(out.Bytes());
+        };
+        if (connection.Open() && helloSeen)
+        {
+            bool shift = IsKeyDown(KEY_LEFT_SHIFT) || IsKeyDown(KEY_RIGHT_SHIFT);
+            if (IsMouseButtonPressed(MOUSE_BUTTON_LEFT)) send(SimCommandType::Spawn, static_cast<uint8_t>(shape), shift);
+            if (IsMouseButtonPressed(MOUSE_BUTTON_RIGHT)) send(SimCommandType::Delete);
+            if (IsKeyPressed(KEY_K)) send(SimCommandType::WaveKick, 0, true);
+            if (IsKeyPressed(KEY_R)) send(SimCommandType::ResetScene);
+        }
+
+        BeginDrawing();
+        ClearBackground(Color{18, 20, 26, 255});
+        BeginMode2D(cam);
+        const netstream::WorldInfo& world = mirror.World();
+        if (world.width > 0.0f) DrawLineEx({-10000.0f, world.groundTop}, {world.width + 10000.0f, world.groundTop}, 2.0f, Color{120, 130, 150, 255});
+        DrawStreamedWater(mirror);
+        for (const netstream::StreamMirror::Body& b : mirror.Bodies())
+        {
+            if (b.live) DrawStreamedBody(mirror, b);
+        }
+        EndMode2D();
+        DrawText(TextFormat("%s  bodies %d  frame %llu  %d/s  %.1f KiB/s", status, static_cast<int>(mirror.LiveCount()),
+                            static_cast<unsigned long long>(mirror.Serial()), rate, kibPerSecond),
+                 10, 10, 18, RAYWHITE);
+        EndDrawing();
+    }
+    CloseWindow();
+    return 0;
+}
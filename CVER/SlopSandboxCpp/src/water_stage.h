@@ -0,0 +1,185 @@
+#pragma once
+
+#include "sim_types.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+
+// Body/water interaction for one step, split so the expensive part can run on
+// worker threads. Sampling reads the surface and a body's world-space hull and
+// writes only its own BodySample; the caller then applies forces, splashes and
+// the accumulated wave impulse serially in candidate order, so the outcome
+// does not depend on how the samples were scheduled.
+namespace water
+{
+
+constexpr int kMaxHullVerts = 16;
+constexpr int kMaxColumns = 16;
+constexpr int kMinColumns = 3;
+
+// Read-only view of the height field. Columns are m_waveStep apart starting at
+// x = 0, so the cell under any x is found directly without a lookup structure.
+struct Surface
+{
+    const float* disp = nullptr;
+    int count = 0;
+    float step = 1.0f;
+    float baselineY = 0.0f;
+
+    float HeightAt(float xPx) const
+    {
+        if (count <= 0) return baselineY;
+        float fx = xPx / step;
+        int i0 = std::max(0, std::min(static_cast<int>(std::floor(fx)), count - 1));
+        int i1 = std::max(0, std::min(i0 + 1, count - 1));
+        float t = fx - static_cast<float>(i0);
+        return baselineY + disp[i0] + (disp[i1] - disp[i0]) * t;
+    }
+};
+
+// Convex outline in world px, counter-clockwise or clockwise.
+struct Hull
+{
+    Vector2 verts[kMaxHullVerts];
+    int count = 0;
+    float minX = 0.0f;
+    float maxX = 0.0f;
+    float minY = 0.0f;
+    float maxY = 0.0f;
+
+    void Bound()
+    {
+        if (count <= 0) return;
+        minX = maxX = verts[0].x;
+        minY = maxY = verts[0].y;
+        for (int i = 1; i < count; ++i)
+        {
+            minX = std::min(minX, verts[i].x);
+            maxX = std::max(maxX, verts[i].x);
+            minY = std::min(minY, verts[i].y);
+            maxY = std::max(maxY, verts[i].y);
+        }
+    }
+
+    // Vertical extent of the hull at x. False when x misses it.
+    bool SpanAt(float x, float& top, float& bottom) const
+    {
+        top = INFINITY;
+        bottom = -INFINITY;
+        for (int i = 0; i < count; ++i)
+        {
+            const Vector2& a = verts[i];
+            const Vector2& b = verts[(i + 1) % count];
+            float lo = std::min(a.x, b.x);
+            float hi = std::max(a.x, b.x);
+            if (x < lo || x > hi) continue;
+            float y = (hi - lo < 1e-4f) ? std::min(a.y, b.y) : a.y + (b.y - a.y) * (x - a.x) / (b.x - a.x);
+            float y2 = (hi - lo < 1e-4f) ? std::max(a.y, b.y) : y;
+            top = std::min(top, y);
+            bottom = std::max(bottom, y2);
+        }
+        return bottom > top;
+    }
+};
+
+struct Column
+{
+    float x = 0.0f;
+    float top = 0.0f; // hull extent at x in px, empty when bottom <= top
+    float bottom = 0.0f;
+    float wetLength = 0.0f; // px of hull below the surface at x
+};
+
+struct BodySample
+{
+    // 0 dry, 1 fully submerged, up to 1.25 once the top sinks below the surface.
+    float depth = 0.0f;
+    float wetArea = 0.0f; // px^2
+    Vector2 buoyancyPoint{}; // centroid of the submerged part, px
+    Vector2 center{};
+    float waterYAtCenter = 0.0f;
+    float columnWidth = 0.0f;
+    int columnCount = 0;
+    Column columns[kMaxColumns];
+};
+
+// Integrates the submerged area of hull over vertical columns spaced about one
+// surface cell apart, so a long body tilted across a wave gets its buoyancy
+// where it is actually wet.
+inline void SampleHull(const Surface& surface, const Hull& hull, Vector2 center, BodySample& out)
+{
+    out.center = center;
+    out.waterYAtCenter = surface.HeightAt(center.x);
+    out.depth = 0.0f;
+    out.wetArea = 0.0f;
+    out.columnCount = 0;
+    out.buoyancyPoint = center;
+
+    float width = std::max(1.0f, hull.maxX - hull.minX);
+    int columns = std::clamp(static_cast<int>(std::ceil(width / surface.step)), kMinColumns, kMaxColumns);
+    float dx = width / static_cast<float>(columns);
+    out.columnWidth = dx;
+
+    float area = 0.0f;
+    float wetArea = 0.0f;
+    float wetX = 0.0f;
+    float wetY = 0.0f;
+    float minClearance = INFINITY; // surface to hull top over wet columns
+    for (int k = 0; k < columns; ++k)
+    {
+        float x = hull.minX + (static_cast<float>(k) + 0.5f) * dx;
+        Column& col = out.columns[out.columnCount++];
+        col.x = x;
+        col.top = 0.0f;
+        col.bottom = 0.0f;
+        col.wetLength = 0.0f;
+
+        float top = 0.0f;
+        float bottom = 0.0f;
+        if (!hull.SpanAt(x, top, bottom)) continue;
+        col.top = top;
+        col.bottom = bottom;
+        float h = surface.HeightAt(x);
+        area += bottom - top;
+        float wetTop = std::max(top, h);
+        if (bottom <= wetTop) continue;
+        col.wetLength = bottom - wetTop;
+        wetArea += col.wetLength;
+        wetX += col.wetLength * x;
+        wetY += col.wetLength * 0.5f * (wetTop + bottom);
+        minClearance = std::min(minClearance, top - h);
+    }
+
+    if (area <= 0.0f || wetArea <= 0.0f) return;
+    float fraction = std::min(1.0f, wetArea / area);
+    out.depth = fraction;
+    out.wetArea = wetArea * dx;
+    if (fraction >= 0.999f && minClearance > 0.0f)
+    {
+        float span = std::max(1.0f, hull.maxY - hull.minY);
+        out.depth = 1.0f + std::min(0.25f, minClearance / span);
+    }
+    out.buoyancyPoint = {wetX / wetArea, wetY / wetArea};
+}
+
+// Spreads amount over a tent of 2 * halfWidth + 1 cells centred under xPx;
+// the cells receive amount in total.
+inline void Splat(float* impulse, int count, float step, float xPx, float amount, int halfWidth)
+{
+    int center = static_cast<int>(std::round(xPx / step));
+    float norm = 0.0f;
+    for (int k = -halfWidth; k <= halfWidth; ++k)
+    {
+        norm += 1.0f - std::abs(static_cast<float>(k)) / static_cast<float>(halfWidth + 1);
+    }
+    for (int k = -halfWidth; k <= halfWidth; ++k)
+    {
+        int i = center + k;
+        if (i < 0 || i >= count) continue;
+        float f = 1.0f - std::abs(static_cast<float>(k)) / static_cast<float>(halfWidth + 1);
+        impulse[i] += amount * f / norm;
+    }
+}
+
+} // namespace water
@@ -0,0 +1,229 @@
+#pragma once
+
+#include <cstddef>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define SLOP_WAVE_SSE2 1
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define SLOP_WAVE_NEON 1
+#endif
+
+// Vectorized kernels for the 1D spring water surface. The arrays are plain
+// SoA float buffers of equal length n.
+namespace wave
+{
+
+inline const char* KernelName()
+{
+#if defined(SLOP_WAVE_SSE2)
+    return "sse2";
+#elif defined(SLOP_WAVE_NEON)
+    return "neon";
+#else
+    return "scalar";
+#endif
+}
+
+// vel += (-spring * disp - damping * vel) * dt; disp += vel * dt
+inline void Integrate(float* disp, float* vel, size_t n, float spring, float damping, float dt)
+{
+    size_t i = 0;
+#if defined(SLOP_WAVE_SSE2)
+    const __m128 vk = _mm_set1_ps(-spring * dt);
+    const __m128 vc = _mm_set1_ps(1.0f - damping * dt);
+    const __m128 vdt = _mm_set1_ps(dt);
+    for (; i + 4 <= n; i += 4)
+    {
+        __m128 d = _mm_loadu_ps(disp + i);
+        __m128 v = _mm_loadu_ps(vel + i);
+        v = _mm_add_ps(_mm_mul_ps(v, vc), _mm_mul_ps(d, vk));
+        d = _mm_add_ps(d, _mm_mul_ps(v, vdt));
+        _mm_storeu_ps(vel + i, v);
+        _mm_storeu_ps(disp + i, d);
+    }
+#elif defined(SLOP_WAVE_NEON)
+    const float32x4_t vk = vdupq_n_f32(-spring * dt);
+    const float32x4_t vc = vdupq_n_f32(1.0f - damping * dt);
+    const float32x4_t vdt = vdupq_n_f32(dt);
+    for (; i + 4 <= n; i += 4)
+    {
+        float32x4_t d = vld1q_f32(disp + i);
+        float32x4_t v = vld1q_f32(vel + i);
+        v = vmlaq_f32(vmulq_f32(v, vc), d, vk);
+        d = vmlaq_f32(d, v, vdt);
+        vst1q_f32(vel + i, v);
+        vst1q_f32(disp + i, d);
+    }
+#endif
+    const float k = -spring * dt;
+    const float c = 1.0f - damping * dt;
+    for (; i < n; ++i)
+    {
+        vel[i] = vel[i] * c + disp[i] * k;
+        disp[i] += vel[i] * dt;
+    }
+}
+
+// Jacobi spread: delta[i] = spread * (disp[i-1] + disp[i+1] - 2 disp[i]) using
+// one-sided differences at the ends. disp is read-only, so there is no
+// loop-carried dependency.
+inline void SpreadDelta(const float* disp, float* delta, size_t n, float spread)
+{
+    if (n < 2)
+    {
+        if (n == 1) delta[0] = 0.0f;
+        return;
+    }
+    delta[0] = spread * (disp[1] - disp[0]);
+    delta[n - 1] = spread * (disp[n - 2] - disp[n - 1]);
+
+    size_t i = 1;
+#if defined(SLOP_WAVE_SSE2)
+    const __m128 vs = _mm_set1_ps(spread);
+    const __m128 two = _mm_set1_ps(2.0f);
+    for (; i + 4 <= n - 1; i += 4)
+    {
+        __m128 l = _mm_loadu_ps(disp + i - 1);
+        __m128 c = _mm_loadu_ps(disp + i);
+        __m128 r = _mm_loadu_ps(disp + i + 1);
+        __m128 lap = _mm_sub_ps(_mm_add_ps(l, r), _mm_mul_ps(two, c));
+        _mm_storeu_ps(delta + i, _mm_mul_ps(vs, lap));
+    }
+#elif defined(SLOP_WAVE_NEON)
+    const float32x4_t vs = vdupq_n_f32(spread);
+    const float32x4_t two = vdupq_n_f32(2.0f);
+    for (; i + 4 <= n - 1; i += 4)
+    {
+        float32x4_t l = vld1q_f32(disp + i - 1);
+        float32x4_t c = vld1q_f32(disp + i);
+        float32x4_t r = vld1q_f32(disp + i + 1);
+        float32x4_t lap = vmlsq_f32(vaddq_f32(l, r), two, c);
+        vst1q_f32(delta + i, vmulq_f32(vs, lap));
+    }
+#endif
+    for (; i < n - 1; ++i)
+    {
+        delta[i] = spread * (disp[i - 1] + disp[i + 1] - 2.0f * disp[i]);
+    }
+}
+
+// disp += delta; vel += delta
+inline void ApplyDelta(float* disp, float* vel, const float* delta, size_t n)
+{
+    size_t i = 0;
+#if defined(SLOP_WAVE_SSE2)
+    for (; i + 4 <= n; i += 4)
+    {
+        __m128 dl = _mm_loadu_ps(delta + i);
+        _mm_storeu_ps(disp + i, _mm_add_ps(_mm_loadu_ps(disp + i), dl));
+        _mm_storeu_ps(vel + i, _mm_add_ps(_mm_loadu_ps(vel + i), dl));
+    }
+#elif defined(SLOP_WAVE_NEON)
+    for (; i + 4 <= n; i += 4)
+    {
+        float32x4_t dl = vld1q_f32(delta + i);
+        vst1q_f32(disp + i, vaddq_f32(vld1q_f32(disp + i), dl));
+        vst1q_f32(vel + i, vaddq_f32(vld1q_f32(vel + i), dl));
+    }
+#endif
+    for (; i < n; ++i)
+    {
+        disp[i] += delta[i];
+        vel[i] += delta[i];
+    }
+}
+
+// Surface of one shallow-water column: depth h plus the part of a body that
+// reaches below it, clamp(h - bottom, 0, span).
+inline float ShallowSurface(float h, float bottom, float span)
+{
+    float o = h - bottom;
+    o = o < 0.0f ? 0.0f : (o > span ? span : o);
+    return h + o;
+}
+
+// Shallow-water face update over faces [begin, end); face f sits between
+// cells f and f + 1. Accelerates u by the surface slope, clamps it to maxU
+// and writes the upwind flux u * h. bottom/span describe the bodies in each
+// cell (see ShallowSurface).
+inline void ShallowFaces(const float* h, const float* bottom, const float* span, float* u, float* flux, size_t begin,
+                         size_t end, float slopeGain, float keep, float maxU)
+{
+    size_t f = begin;
+#if defined(SLOP_WAVE_SSE2)
+    const __m128 vg = _mm_set1_ps(slopeGain);
+    const __m128 vk = _mm_set1_ps(keep);
+    const __m128 vmax = _mm_set1_ps(maxU);
+    const __m128 vmin = _mm_set1_ps(-maxU);
+    const __m128 zero = _mm_setzero_ps();
+    for (; f + 4 <= end; f += 4)
+    {
+        __m128 hl = _mm_loadu_ps(h + f);
+        __m128 hr = _mm_loadu_ps(h + f + 1);
+        __m128 ol = _mm_min_ps(_mm_max_ps(_mm_sub_ps(hl, _mm_loadu_ps(bottom + f)), zero), _mm_loadu_ps(span + f));
+        __m128 orr = _mm_min_ps(_mm_max_ps(_mm_sub_ps(hr, _mm_loadu_ps(bottom + f + 1)), zero), _mm_loadu_ps(span + f + 1));
+        __m128 slope = _mm_sub_ps(_mm_add_ps(hr, orr), _mm_add_ps(hl, ol));
+        __m128 v = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(u + f), _mm_mul_ps(vg, slope)), vk);
+        v = _mm_max_ps(vmin, _mm_min_ps(vmax, v));
+        __m128 right = _mm_cmpgt_ps(v, zero);
+        __m128 up = _mm_or_ps(_mm_and_ps(right, hl), _mm_andnot_ps(right, hr));
+        _mm_storeu_ps(u + f, v);
+        _mm_storeu_ps(flux + f, _mm_mul_ps(v, up));
+    }
+#elif defined(SLOP_WAVE_NEON)
+    const float32x4_t vg = vdupq_n_f32(slopeGain);
+    const float32x4_t vk = vdupq_n_f32(keep);
+    const float32x4_t vmax = vdupq_n_f32(maxU);
+    const float32x4_t vmin = vdupq_n_f32(-maxU);
+    const float32x4_t zero = vdupq_n_f32(0.0f);
+    for (; f + 4 <= end; f += 4)
+    {
+        float32x4_t hl = vld1q_f32(h + f);
+        float32x4_t hr = vld1q_f32(h + f + 1);
+        float32x4_t ol = vminq_f32(vmaxq_f32(vsubq_f32(hl, vld1q_f32(bottom + f)), zero), vld1q_f32(span + f));
+        float32x4_t orr = vminq_f32(vmaxq_f32(vsubq_f32(hr, vld1q_f32(bottom + f + 1)), zero), vld1q_f32(span + f + 1));
+        float32x4_t slope = vsubq_f32(vaddq_f32(hr, orr), vaddq_f32(hl, ol));
+        float32x4_t v = vmulq_f32(vmlsq_f32(vld1q_f32(u + f), vg, slope), vk);
+        v = vmaxq_f32(vmin, vminq_f32(vmax, v));
+        float32x4_t up = vbslq_f32(vcgtq_f32(v, zero), hl, hr);
+        vst1q_f32(u + f, v);
+        vst1q_f32(flux + f, vmulq_f32(v, up));
+    }
+#endif
+    for (; f < end; ++f)
+    {
+        float slope = ShallowSurface(h[f + 1], bottom[f + 1], span[f + 1]) - ShallowSurface(h[f], bottom[f], span[f]);
+        float v = (u[f] - slopeGain * slope) * keep;
+        v = v > maxU ? maxU : (v < -maxU ? -maxU : v);
+        u[f] = v;
+        flux[f] = v * (v > 0.0f ? h[f] : h[f + 1]);
+    }
+}
+
+// h[i] -= gain * (wallFlux[i + 1] - wallFlux[i]) over cells [begin, end).
+// wallFlux[i] is the flux through the left wall of cell i; the outer walls
+// carry zero, so the sum of h only changes by rounding.
+inline void ShallowCells(float* h, const float* wallFlux, size_t begin, size_t end, float gain)
+{
+    size_t i = begin;
+#if defined(SLOP_WAVE_SSE2)
+    const __m128 vg = _mm_set1_ps(gain);
+    for (; i + 4 <= end; i += 4)
+    {
+        __m128 div = _mm_sub_ps(_mm_loadu_ps(wallFlux + i + 1), _mm_loadu_ps(wallFlux + i));
+        _mm_storeu_ps(h + i, _mm_sub_ps(_mm_loadu_ps(h + i), _mm_mul_ps(vg, div)));
+    }
+#elif defined(SLOP_WAVE_NEON)
+    const float32x4_t vg = vdupq_n_f32(gain);
+    for (; i + 4 <= end; i += 4)
+    {
+        float32x4_t div = vsubq_f32(vld1q_f32(wallFlux + i + 1), vld1q_f32(wallFlux + i));
+        vst1q_f32(h + i, vmlsq_f32(vld1q_f32(h + i), vg, div));
+    }
+#endif
+    for (; i < end; ++i) h[i] -= gain * (wallFlux[i + 1] - wallFlux[i]);
+}
+
+} // namespace wave
@@ -0,0 +1,70 @@
+#!/usr/bin/env python3
+"""Compares two SlopMicrobench JSON results (--benchmark_out_format=json).
+
+    compare_microbench.py baseline.json current.json [--metric cpu_time] [--threshold 0.10]
+
+Prints each benchmark's time in both runs and the ratio current/baseline, and
+exits 1 when any benchmark is slower than the baseline by more than the
+threshold. Benchmarks in only one file are listed but never fail the run.
+"""
+
+import argparse
+import json
+import sys
+
+UNIT_TO_NS = {"ns": 1.0, "us": 1e3, "ms": 1e6, "s": 1e9}
+
+
+def load(path, metric):
+    with open(path) as f:
+        data = json.load(f)
+    times = {}
+    for b in data.get("benchmarks", []):
+        # With --benchmark_repetitions only the mean is compared.
+        if b.get("run_type") == "aggregate" and b.get("aggregate_name") != "mean":
+            continue
+        name = b.get("run_name", b["name"])
+        times[name] = b[metric] * UNIT_TO_NS[b.get("time_unit", "ns")]
+    return times
+
+
+def format_ns(ns):
+    for unit, scale in (("s", 1e9), ("ms", 1e6), ("us", 1e3)):
+        if ns >= scale:
+            return f"{ns / scale:.2f} {unit}"
+    return f"{ns:.1f} ns"
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("baseline")
+    parser.add_argument("current")
+    parser.add_argument("--metric", choices=("real_time", "cpu_time"), default="real_time")
+    parser.add_argument("--threshold", type=float, default=0.10, help="allowed slowdown, 0.10 = 10%%")
+    args = parser.parse_args()
+
+    base = load(args.baseline, args.metric)
+    cur = load(args.current, args.metric)
+    width = max((len(n) for n in base.keys() | cur.keys()), default=9)
+
+    regressions = 0
+    print(f"{'benchmark':<{width}}  {'baseline':>10}  {'current':>10}  {'ratio':>6}")
+    for name in list(base) + [n for n in cur if n not in base]:
+        if name not in cur or name not in base:
+            only = "baseline" if name in base else "current"
+            print(f"{name:<{width}}  only in {only}")
+            continue
+        ratio = cur[name] / base[name] if base[name] > 0 else float("inf")
+        slower = ratio > 1.0 + args.threshold
+        regressions += slower
+        mark = "  SLOWER" if slower else ("  faster" if ratio < 1.0 - args.threshold else "")
+        print(f"{name:<{width}}  {format_ns(base[name]):>10}  {format_ns(cur[name]):>10}  {ratio:6.2f}{mark}")
+
+    if regressions:
+        print(f"{regressions} benchmark(s) slower than baseline by more than {args.threshold:.0%}")
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
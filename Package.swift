@@ -19,9 +19,21 @@ let package = Package(
                 .headerSearchPath("src")
             ]
         ),
+        // The C++ sandbox simulation behind its C API (CVER/SlopSandboxCpp/src/slop_core.h).
+        .target(
+            name: "CSlopCore",
+            dependencies: ["CBox2D"],
+            path: "CVER/SlopSandboxCpp",
+            sources: ["src/slop_core.cpp"],
+            publicHeadersPath: "swift",
+            cxxSettings: [
+                .headerSearchPath("src")
+            ]
+        ),
         .executableTarget(
             name: "SlopSandbox",
-            dependencies: ["CBox2D"]
+            dependencies: ["CBox2D", "CSlopCore"]
         ),
-    ]
+    ],
+    cxxLanguageStandard: .cxx17
 )
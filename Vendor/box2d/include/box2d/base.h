@@ -91,6 +91,24 @@ typedef struct b2Version
 /// Get the current version of Box2D
 B2_API b2Version b2GetVersion( void );
 
+/// Instruction sets the graph-colored contact solver can run on.
+typedef enum b2SimdLevel
+{
+	b2_simdScalar,
+	b2_simdSSE2,
+	b2_simdNEON,
+	b2_simdAVX2,
+} b2SimdLevel;
+
+/// Get the contact solver instruction set. Unless set, x86 builds with
+/// BOX2D_SIMD_DISPATCH detect AVX2 on first use and fall back to SSE2.
+B2_API b2SimdLevel b2GetSimdLevel( void );
+
+/// Pick the contact solver instruction set for steps that start afterwards.
+/// Levels the build or the CPU lack fall back to the build's default.
+/// @return the level now in use
+B2_API b2SimdLevel b2SetSimdLevel( b2SimdLevel level );
+
 /**@}*/
 
 //! @cond
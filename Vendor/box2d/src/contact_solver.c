@@ -21,6 +21,8 @@
 // s(t) = s0 + dot(cB0 - cA0, normal) + dot(dpB - dpA + rot(dqB, rB0) - rot(dqA, rA0), normal)
 // s_base = s0 + dot(cB0 - cA0, normal)
 
+#if !defined( B2_CONTACT_KERNELS_ONLY )
+
 void b2PrepareOverflowContacts( b2StepContext* context )
 {
 	b2TracyCZoneNC( prepare_overflow_contact, "Prepare Overflow Contact", b2_colorYellow, true );
@@ -535,6 +537,8 @@ void b2StoreOverflowImpulses( b2StepContext* context )
 	b2TracyCZoneEnd( store_impulses );
 }
 
+#endif // !B2_CONTACT_KERNELS_ONLY
+
 #if defined( B2_SIMD_AVX2 )
 
 #include <immintrin.h>
@@ -2204,3 +2208,31 @@ void b2StoreImpulsesTask( int startIndex, int endIndex, b2StepContext* context )
 
 	b2TracyCZoneEnd( store_impulses );
 }
+
+#if defined( B2_SIMD_AVX2 )
+#define B2_KERNEL_LEVEL b2_simdAVX2
+#define B2_KERNEL_SHIFT 3
+#elif defined( B2_SIMD_NEON )
+#define B2_KERNEL_LEVEL b2_simdNEON
+#define B2_KERNEL_SHIFT 2
+#elif defined( B2_SIMD_SSE2 )
+#define B2_KERNEL_LEVEL b2_simdSSE2
+#define B2_KERNEL_SHIFT 2
+#else
+#define B2_KERNEL_LEVEL b2_simdScalar
+#define B2_KERNEL_SHIFT 2
+#endif
+
+_Static_assert( B2_SIMD_WIDTH == 1 << B2_KERNEL_SHIFT, "simd shift" );
+
+const b2ContactKernels b2_contactKernels = {
+	B2_KERNEL_LEVEL,
+	B2_SIMD_WIDTH,
+	B2_KERNEL_SHIFT,
+	b2GetContactConstraintSIMDByteCount,
+	b2PrepareContactsTask,
+	b2WarmStartContactsTask,
+	b2SolveContactsTask,
+	b2ApplyRestitutionTask,
+	b2StoreImpulsesTask,
+};
@@ -52,3 +52,27 @@ void b2WarmStartContactsTask( int startIndex, int endIndex, b2StepContext* conte
 void b2SolveContactsTask( int startIndex, int endIndex, b2StepContext* context, int colorIndex, bool useBias );
 void b2ApplyRestitutionTask( int startIndex, int endIndex, b2StepContext* context, int colorIndex );
 void b2StoreImpulsesTask( int startIndex, int endIndex, b2StepContext* context );
+
+// The graph-colored contact kernels of one SIMD build of contact_solver.c.
+// x86 builds with BOX2D_SIMD_DISPATCH have an AVX2 set next to the SSE2 one;
+// the solver picks one per step.
+typedef struct b2ContactKernels
+{
+	b2SimdLevel level;
+	int simdWidth;
+	int simdShift;
+	int ( *constraintByteCount )( void );
+	void ( *prepare )( int startIndex, int endIndex, b2StepContext* context );
+	void ( *warmStart )( int startIndex, int endIndex, b2StepContext* context, int colorIndex );
+	void ( *solve )( int startIndex, int endIndex, b2StepContext* context, int colorIndex, bool useBias );
+	void ( *applyRestitution )( int startIndex, int endIndex, b2StepContext* context, int colorIndex );
+	void ( *storeImpulses )( int startIndex, int endIndex, b2StepContext* context );
+} b2ContactKernels;
+
+extern const b2ContactKernels b2_contactKernels;
+
+#if defined( B2_SIMD_DISPATCH )
+extern const b2ContactKernels b2_contactKernelsAVX2;
+#endif
+
+const b2ContactKernels* b2GetContactKernels( void );
@@ -0,0 +1,23 @@
+// SPDX-FileCopyrightText: 2023 Erin Catto
+// SPDX-License-Identifier: MIT
+
+// AVX2 build of the graph-colored contact kernels for x86 builds that pick
+// the solver width at run time (BOX2D_SIMD_DISPATCH). Compile with the AVX2
+// flag (-mavx2, /arch:AVX2); nothing here runs unless the CPU has it.
+
+#if defined( BOX2D_SIMD_DISPATCH ) && !defined( BOX2D_AVX2 ) && ( defined( __x86_64__ ) || defined( _M_X64 ) || defined( __i386__ ) || defined( _M_IX86 ) )
+
+#define BOX2D_AVX2
+#define B2_CONTACT_KERNELS_ONLY
+
+#define b2GetContactConstraintSIMDByteCount b2GetContactConstraintSIMDByteCountAVX2
+#define b2PrepareContactsTask b2PrepareContactsTaskAVX2
+#define b2WarmStartContactsTask b2WarmStartContactsTaskAVX2
+#define b2SolveContactsTask b2SolveContactsTaskAVX2
+#define b2ApplyRestitutionTask b2ApplyRestitutionTaskAVX2
+#define b2StoreImpulsesTask b2StoreImpulsesTaskAVX2
+#define b2_contactKernels b2_contactKernelsAVX2
+
+#include "contact_solver.c"
+
+#endif
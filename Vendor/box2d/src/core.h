@@ -68,6 +68,10 @@
 		#else
 			#define B2_SIMD_SSE2
 			#define B2_SIMD_WIDTH 4
+			#if defined( BOX2D_SIMD_DISPATCH )
+				// contact_solver_avx2.c adds 8-wide kernels, picked at run time
+				#define B2_SIMD_DISPATCH
+			#endif
 		#endif
 	#elif defined( B2_CPU_ARM )
 		#define B2_SIMD_NEON
@@ -773,7 +773,10 @@ static void b2FinalizeBodiesTask( int startIndex, int endIndex, uint32_t threadI
 		else if ( island->constraintRemoveCount > 0 )
 		{
 			// body wants to sleep but its island needs splitting first
-			if ( body->sleepTime > taskContext->splitSleepTime )
+			// Ties go to the largest island id, as in the reduction across
+			// workers, so the pick does not depend on how bodies were split up.
+			if ( body->sleepTime > taskContext->splitSleepTime ||
+				 ( body->sleepTime == taskContext->splitSleepTime && body->islandId > taskContext->splitIslandId ) )
 			{
 				// pick the sleepiest candidate
 				taskContext->splitIslandId = body->islandId;
@@ -870,7 +873,7 @@ static void b2ExecuteBlock( b2SolverStage* stage, b2StepContext* context, b2Solv
 			break;
 
 		case b2_stagePrepareContacts:
-			b2PrepareContactsTask( startIndex, endIndex, context );
+			context->contactKernels->prepare( startIndex, endIndex, context );
 			break;
 
 		case b2_stageIntegrateVelocities:
@@ -880,7 +883,7 @@ static void b2ExecuteBlock( b2SolverStage* stage, b2StepContext* context, b2Solv
 		case b2_stageWarmStart:
 			if ( blockType == b2_graphContactBlock )
 			{
-				b2WarmStartContactsTask( startIndex, endIndex, context, stage->colorIndex );
+				context->contactKernels->warmStart( startIndex, endIndex, context, stage->colorIndex );
 			}
 			else if ( blockType == b2_graphJointBlock )
 			{
@@ -891,7 +894,7 @@ static void b2ExecuteBlock( b2SolverStage* stage, b2StepContext* context, b2Solv
 		case b2_stageSolve:
 			if ( blockType == b2_graphContactBlock )
 			{
-				b2SolveContactsTask( startIndex, endIndex, context, stage->colorIndex, true );
+				context->contactKernels->solve( startIndex, endIndex, context, stage->colorIndex, true );
 			}
 			else if ( blockType == b2_graphJointBlock )
 			{
@@ -906,7 +909,7 @@ static void b2ExecuteBlock( b2SolverStage* stage, b2StepContext* context, b2Solv
 		case b2_stageRelax:
 			if ( blockType == b2_graphContactBlock )
 			{
-				b2SolveContactsTask( startIndex, endIndex, context, stage->colorIndex, false );
+				context->contactKernels->solve( startIndex, endIndex, context, stage->colorIndex, false );
 			}
 			else if ( blockType == b2_graphJointBlock )
 			{
@@ -917,12 +920,12 @@ static void b2ExecuteBlock( b2SolverStage* stage, b2StepContext* context, b2Solv
 		case b2_stageRestitution:
 			if ( blockType == b2_graphContactBlock )
 			{
-				b2ApplyRestitutionTask( startIndex, endIndex, context, stage->colorIndex );
+				context->contactKernels->applyRestitution( startIndex, endIndex, context, stage->colorIndex );
 			}
 			break;
 
 		case b2_stageStoreImpulses:
-			b2StoreImpulsesTask( startIndex, endIndex, context );
+			context->contactKernels->storeImpulses( startIndex, endIndex, context );
 			break;
 	}
 }
@@ -1289,13 +1292,84 @@ static void b2BulletBodyTask( int startIndex, int endIndex, uint32_t threadIndex
 	b2TracyCZoneEnd( bullet_body_task );
 }
 
-#if B2_SIMD_WIDTH == 8
-#define B2_SIMD_SHIFT 3
-#elif B2_SIMD_WIDTH == 4
-#define B2_SIMD_SHIFT 2
+#if defined( B2_SIMD_DISPATCH )
+
+#if defined( _MSC_VER )
+#include <intrin.h>
+#endif
+
+static bool b2CpuHasAVX2( void )
+{
+#if defined( _MSC_VER )
+	int info[4];
+	__cpuid( info, 0 );
+	if ( info[0] < 7 )
+	{
+		return false;
+	}
+
+	// the OS must also save the YMM registers
+	__cpuid( info, 1 );
+	bool osxsave = ( info[2] & ( 1 << 27 ) ) != 0;
+	bool avx = ( info[2] & ( 1 << 28 ) ) != 0;
+	if ( osxsave == false || avx == false || ( _xgetbv( 0 ) & 6 ) != 6 )
+	{
+		return false;
+	}
+
+	__cpuidex( info, 7, 0 );
+	return ( info[1] & ( 1 << 5 ) ) != 0;
 #else
-#define B2_SIMD_SHIFT 0
+	__builtin_cpu_init();
+	return __builtin_cpu_supports( "avx2" ) != 0;
+#endif
+}
+
+#endif
+
+// b2SimdLevel in use, or -1 until the first step or b2SetSimdLevel
+static b2AtomicInt b2_simdLevel = { -1 };
+
+static b2SimdLevel b2SupportedSimdLevel( b2SimdLevel level )
+{
+#if defined( B2_SIMD_DISPATCH )
+	if ( level == b2_simdAVX2 && b2CpuHasAVX2() )
+	{
+		return b2_simdAVX2;
+	}
+#endif
+	B2_UNUSED( level );
+	return b2_contactKernels.level;
+}
+
+const b2ContactKernels* b2GetContactKernels( void )
+{
+	int level = b2AtomicLoadInt( &b2_simdLevel );
+	if ( level < 0 )
+	{
+		b2AtomicCompareExchangeInt( &b2_simdLevel, -1, b2SupportedSimdLevel( b2_simdAVX2 ) );
+		level = b2AtomicLoadInt( &b2_simdLevel );
+	}
+
+#if defined( B2_SIMD_DISPATCH )
+	if ( level == b2_simdAVX2 )
+	{
+		return &b2_contactKernelsAVX2;
+	}
 #endif
+	return &b2_contactKernels;
+}
+
+b2SimdLevel b2GetSimdLevel( void )
+{
+	return b2GetContactKernels()->level;
+}
+
+b2SimdLevel b2SetSimdLevel( b2SimdLevel level )
+{
+	b2AtomicStoreInt( &b2_simdLevel, b2SupportedSimdLevel( level ) );
+	return b2GetSimdLevel();
+}
 
 // Solve with graph coloring
 void b2Solve( b2World* world, b2StepContext* stepContext )
@@ -1321,6 +1395,10 @@ void b2Solve( b2World* world, b2StepContext* stepContext )
 
 	// Solve constraints using graph coloring
 	{
+		// One kernel set for the whole step; constraint layout depends on it
+		const b2ContactKernels* kernels = b2GetContactKernels();
+		stepContext->contactKernels = kernels;
+
 		// Prepare buffers for bullets
 		b2AtomicStoreInt( &stepContext->bulletBodyCount, 0 );
 		stepContext->bulletBodies = b2AllocateArenaItem( &world->arena, awakeBodyCount * sizeof( int ), "bullet bodies" );
@@ -1407,7 +1485,7 @@ void b2Solve( b2World* world, b2StepContext* stepContext )
 				activeColorIndices[c] = i;
 
 				// 4/8-way SIMD
-				int colorContactCountSIMD = colorContactCount > 0 ? ( ( colorContactCount - 1 ) >> B2_SIMD_SHIFT ) + 1 : 0;
+				int colorContactCountSIMD = colorContactCount > 0 ? ( ( colorContactCount - 1 ) >> kernels->simdShift ) + 1 : 0;
 
 				colorContactCounts[c] = colorContactCountSIMD;
 
@@ -1465,12 +1543,12 @@ void b2Solve( b2World* world, b2StepContext* stepContext )
 
 		// Gather contact pointers for easy parallel-for traversal. Some may be NULL due to SIMD remainders.
 		b2ContactSim** contacts =
-			b2AllocateArenaItem( &world->arena, B2_SIMD_WIDTH * simdContactCount * sizeof( b2ContactSim* ), "contact pointers" );
+			b2AllocateArenaItem( &world->arena, kernels->simdWidth * simdContactCount * sizeof( b2ContactSim* ), "contact pointers" );
 
 		// Gather joint pointers for easy parallel-for traversal.
 		b2JointSim** joints = b2AllocateArenaItem( &world->arena, awakeJointCount * sizeof( b2JointSim* ), "joint pointers" );
 
-		int simdConstraintSize = b2GetContactConstraintSIMDByteCount();
+		int simdConstraintSize = kernels->constraintByteCount();
 		b2ContactConstraintSIMD* simdContactConstraints =
 			b2AllocateArenaItem( &world->arena, simdContactCount * simdConstraintSize, "contact constraint" );
 
@@ -1502,14 +1580,14 @@ void b2Solve( b2World* world, b2StepContext* stepContext )
 
 					for ( int k = 0; k < colorContactCount; ++k )
 					{
-						contacts[B2_SIMD_WIDTH * contactBase + k] = color->contactSims.data + k;
+						contacts[kernels->simdWidth * contactBase + k] = color->contactSims.data + k;
 					}
 
 					// remainder
-					int colorContactCountSIMD = ( ( colorContactCount - 1 ) >> B2_SIMD_SHIFT ) + 1;
-					for ( int k = colorContactCount; k < B2_SIMD_WIDTH * colorContactCountSIMD; ++k )
+					int colorContactCountSIMD = ( ( colorContactCount - 1 ) >> kernels->simdShift ) + 1;
+					for ( int k = colorContactCount; k < kernels->simdWidth * colorContactCountSIMD; ++k )
 					{
-						contacts[B2_SIMD_WIDTH * contactBase + k] = NULL;
+						contacts[kernels->simdWidth * contactBase + k] = NULL;
 					}
 
 					contactBase += colorContactCountSIMD;
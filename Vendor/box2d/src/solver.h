@@ -120,6 +120,7 @@ typedef struct b2StepContext
 	b2ContactSim** contacts;
 
 	struct b2ContactConstraintSIMD* simdContactConstraints;
+	const struct b2ContactKernels* contactKernels;
 	int activeColorCount;
 	int workerCount;
 